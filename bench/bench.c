@@ -0,0 +1,660 @@
+/*
+ * OpenTyrian: A modern cross-platform port of Tyrian
+ * Copyright (C) 2007-2009  The OpenTyrian Development Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// Micro-benchmarks for the rendering kernels: sprite blitters, background rows, smoothie filters,
+// and scalers.  Synthetic data is always used; sprites from tyrian.shp are used as well when the
+// data directory can be found.
+//
+// Before benchmarking, the SIMD smoothie filters are checked against the scalar ones over a
+// sequence of frames, either synthetic or recorded.
+
+#include "../src/backgrnd.h"
+#include "../src/file.h"
+#include "../src/opentyr.h"
+#include "../src/palette.h"
+#include "../src/sprite.h"
+#include "../src/varz.h"
+#include "../src/video.h"
+#include "../src/video_scale.h"
+
+#include "SDL.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_MIN_SECONDS 0.25  // minimum time each benchmark runs for
+#define BENCH_MAX_RESULTS 64
+
+#define SYNTHETIC_SPRITE_TABLE EXTRA_SHAPES
+#define SYNTHETIC_SPRITE_SIZE 32
+#define SYNTHETIC_SPRITE2_COUNT 40  // enough for the 2x2 blitters to find index + 20
+#define SYNTHETIC_FRAME_COUNT 64  // frames the smoothie filter self-test runs through
+
+typedef void (*BenchFunction)(unsigned int param);
+
+typedef struct
+{
+	char name[48];
+	unsigned long long iterations;
+	unsigned long long pixels;  // per iteration
+	double seconds;
+}
+BenchResult;
+
+static void init_synthetic_data(void);
+static bool init_asset_data(void);
+static void free_bench_data(void);
+static bool check_smoothie_filters(const char *frames_path);
+static void run_smoothie_filter(unsigned int filter, SDL_Surface *dst, SDL_Surface *src);
+static void bench(const char *name, BenchFunction function, unsigned int param, unsigned long long pixels);
+static void write_json(FILE *f);
+
+static SDL_Surface *dst_surface, *src_surface;
+
+static Uint8 synthetic_sprite_data[SYNTHETIC_SPRITE_SIZE * SYNTHETIC_SPRITE_SIZE * 2];
+static Uint8 synthetic_sprite2_data[SYNTHETIC_SPRITE2_COUNT * 2 + 14 * 32];
+static Sprite2_array synthetic_sprite2s = { sizeof(synthetic_sprite2_data), synthetic_sprite2_data, 0, NULL };
+static unsigned long long synthetic_sprite2_pixels;
+
+static Uint8 tiles[12][24 * 28];
+static Uint8 *background_map[12];
+static JE_byte background_layer_map[12 + 15 * 8];  // background 3 rows, 15 cells apart
+
+static bool have_assets;
+static unsigned long long asset_sprite_pixels;
+static unsigned long long asset_sprite2_pixels;
+static unsigned int asset_sprite2_count;
+
+static Uint32 scaler_output[320 * 4 * 200 * 4];
+
+static BenchResult results[BENCH_MAX_RESULTS];
+static unsigned int result_count;
+
+static const char *const smoothie_filter_names[] = { "lava_filter", "water_filter", "iced_blur_filter", "blur_filter" };
+
+static const int blit_positions[8][2] =
+{
+	{ 10, 10 }, { 150, 20 }, { 270, 30 }, { 40, 90 }, { 140, 100 }, { 250, 110 }, { 60, 150 }, { 200, 160 },
+};
+
+static void run_blit_sprite(unsigned int variant)
+{
+	for (unsigned int i = 0; i < COUNTOF(blit_positions); ++i)
+	{
+		const int x = blit_positions[i][0], y = blit_positions[i][1];
+
+		switch (variant)
+		{
+		case 0: blit_sprite(dst_surface, x, y, SYNTHETIC_SPRITE_TABLE, 0); break;
+		case 1: blit_sprite_blend(dst_surface, x, y, SYNTHETIC_SPRITE_TABLE, 0); break;
+		case 2: blit_sprite_hv(dst_surface, x, y, SYNTHETIC_SPRITE_TABLE, 0, 7, 3); break;
+		case 3: blit_sprite_hv_unsafe(dst_surface, x, y, SYNTHETIC_SPRITE_TABLE, 0, 7, 3); break;
+		case 4: blit_sprite_hv_blend(dst_surface, x, y, SYNTHETIC_SPRITE_TABLE, 0, 7, 3); break;
+		case 5: blit_sprite_dark(dst_surface, x, y, SYNTHETIC_SPRITE_TABLE, 0, false); break;
+		}
+	}
+}
+
+static void run_blit_sprite2(unsigned int variant)
+{
+	for (unsigned int i = 0; i < COUNTOF(blit_positions); ++i)
+	{
+		const int x = blit_positions[i][0], y = blit_positions[i][1];
+
+		switch (variant)
+		{
+		case 0:  blit_sprite2(dst_surface, x, y, synthetic_sprite2s, 1); break;
+		case 1:  blit_sprite2_clip(dst_surface, x, y, synthetic_sprite2s, 1); break;
+		case 2:  blit_sprite2_blend(dst_surface, x, y, synthetic_sprite2s, 1); break;
+		case 3:  blit_sprite2_darken(dst_surface, x, y, synthetic_sprite2s, 1); break;
+		case 4:  blit_sprite2_filter(dst_surface, x, y, synthetic_sprite2s, 1, 0x70); break;
+		case 5:  blit_sprite2_filter_clip(dst_surface, x, y, synthetic_sprite2s, 1, 0x70); break;
+		case 6:  blit_sprite2x2(dst_surface, x, y, synthetic_sprite2s, 1); break;
+		case 7:  blit_sprite2x2_clip(dst_surface, x, y, synthetic_sprite2s, 1); break;
+		case 8:  blit_sprite2x2_blend(dst_surface, x, y, synthetic_sprite2s, 1); break;
+		case 9:  blit_sprite2x2_darken(dst_surface, x, y, synthetic_sprite2s, 1); break;
+		case 10: blit_sprite2x2_filter(dst_surface, x, y, synthetic_sprite2s, 1, 0x70); break;
+		case 11: blit_sprite2x2_filter_clip(dst_surface, x, y, synthetic_sprite2s, 1, 0x70); break;
+		}
+	}
+}
+
+static void run_asset_sprites(unsigned int param)
+{
+	(void)param;
+
+	for (unsigned int table = 0; table < 7; ++table)
+	{
+		for (unsigned int i = 0; i < sprite_table[table].count; ++i)
+		{
+			if (sprite_exists(table, i))
+				blit_sprite(dst_surface, blit_positions[i % 8][0], blit_positions[i % 8][1], table, i);
+		}
+	}
+}
+
+static void run_asset_sprite2s(unsigned int param)
+{
+	(void)param;
+
+	for (unsigned int i = 1; i <= asset_sprite2_count; ++i)
+		blit_sprite2(dst_surface, blit_positions[i % 8][0], blit_positions[i % 8][1], spriteSheet9, i);
+}
+
+static void run_background_row(unsigned int blend)
+{
+	for (int y = -14; y < 200; y += 28)
+	{
+		if (blend)
+			blit_background_row_blend(dst_surface, 16, y, background_map);
+		else
+			blit_background_row(dst_surface, 16, y, background_map);
+	}
+}
+
+static void run_background_layer(unsigned int param)
+{
+	(void)param;
+
+	draw_background_3(dst_surface);
+}
+
+static void run_filter(unsigned int filter)
+{
+	run_smoothie_filter(filter, dst_surface, src_surface);
+}
+
+static void bench_smoothie_filters(const char *kernels)
+{
+	for (unsigned int i = 0; i < COUNTOF(smoothie_filter_names); ++i)
+	{
+		char name[48];
+		snprintf(name, sizeof(name), "%s (%s)", smoothie_filter_names[i], kernels);
+		bench(name, run_filter, i, vga_width * vga_height);
+	}
+}
+
+static void run_scaler32(unsigned int i)
+{
+	scalers[i].scaler32(src_surface, scaler_output, scalers[i].width * 4, scalers[i].width, 0, vga_height);
+}
+
+static void run_scaler16(unsigned int i)
+{
+	scalers[i].scaler16(src_surface, scaler_output, scalers[i].width * 2, scalers[i].width, 0, vga_height);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *json_path = NULL;
+	const char *frames_path = NULL;
+	bool check_only = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+		{
+			custom_data_dir = argv[++i];
+		}
+		else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+		{
+			json_path = argv[++i];
+		}
+		else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+		{
+			frames_path = argv[++i];
+		}
+		else if (strcmp(argv[i], "-s") == 0)
+		{
+			check_only = true;
+		}
+		else
+		{
+			printf("Usage: %s [-t DIR] [-j FILE] [-r FILE] [-s]\n\n"
+			       "  -t DIR    Tyrian data directory to load real sprites from\n"
+			       "  -j FILE   Write results as JSON to FILE\n"
+			       "  -r FILE   Check the smoothie filters on recorded frames: consecutive\n"
+			       "            raw 320x200 8-bit frames, as in VGAScreen\n"
+			       "  -s        Only check the smoothie filters, without benchmarking\n", argv[0]);
+			return strcmp(argv[i], "-h") == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+
+	if (SDL_Init(0))
+	{
+		fprintf(stderr, "error: failed to initialize SDL: %s\n", SDL_GetError());
+		return EXIT_FAILURE;
+	}
+
+	// The scalers are single-threaded kernels here; the pool only picks the SIMD paths.
+	scaler_thread_count = 1;
+	init_scaler_threads();
+
+	init_synthetic_data();
+	have_assets = init_asset_data();
+
+	const bool filters_ok = check_smoothie_filters(frames_path);
+	if (!filters_ok || check_only)
+	{
+		free_bench_data();
+		deinit_scaler_threads();
+		SDL_Quit();
+		return filters_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	static const char *const sprite_names[] =
+	{
+		"blit_sprite", "blit_sprite_blend", "blit_sprite_hv", "blit_sprite_hv_unsafe", "blit_sprite_hv_blend", "blit_sprite_dark",
+	};
+	for (unsigned int i = 0; i < COUNTOF(sprite_names); ++i)
+		bench(sprite_names[i], run_blit_sprite, i, COUNTOF(blit_positions) * SYNTHETIC_SPRITE_SIZE * SYNTHETIC_SPRITE_SIZE);
+
+	static const char *const sprite2_names[] =
+	{
+		"blit_sprite2", "blit_sprite2_clip", "blit_sprite2_blend", "blit_sprite2_darken", "blit_sprite2_filter", "blit_sprite2_filter_clip",
+		"blit_sprite2x2", "blit_sprite2x2_clip", "blit_sprite2x2_blend", "blit_sprite2x2_darken", "blit_sprite2x2_filter", "blit_sprite2x2_filter_clip",
+	};
+	for (unsigned int i = 0; i < COUNTOF(sprite2_names); ++i)
+		bench(sprite2_names[i], run_blit_sprite2, i, COUNTOF(blit_positions) * synthetic_sprite2_pixels * (i >= 6 ? 4 : 1));
+
+	if (have_assets)
+	{
+		bench("blit_sprite (tyrian.shp)", run_asset_sprites, 0, asset_sprite_pixels);
+		bench("blit_sprite2 (tyrian.shp)", run_asset_sprite2s, 0, asset_sprite2_pixels);
+	}
+
+	bench("blit_background_row", run_background_row, 0, 8 * 12 * 24 * 28);
+	bench("blit_background_row_blend", run_background_row, 1, 8 * 12 * 24 * 28);
+	bench("draw_background_3 (strips)", run_background_layer, 0, 8 * 12 * 24 * 28);
+
+	// The scalar kernels are run too, for comparison, when there are SIMD ones.
+	const char *const simd_kernels = select_smoothie_filters(true);
+	bench_smoothie_filters(simd_kernels);
+	const char *const scalar_kernels = select_smoothie_filters(false);
+	if (strcmp(scalar_kernels, simd_kernels) != 0)
+		bench_smoothie_filters(scalar_kernels);
+	select_smoothie_filters(true);
+
+	for (unsigned int i = 0; i < scalers_count; ++i)
+	{
+		char name[48];
+		const unsigned long long pixels = (unsigned long long)scalers[i].width * scalers[i].height;
+
+		snprintf(name, sizeof(name), "%s (32-bit)", scalers[i].name);
+		bench(name, run_scaler32, i, pixels);
+
+		if (scalers[i].scaler16 != NULL)
+		{
+			snprintf(name, sizeof(name), "%s (16-bit)", scalers[i].name);
+			bench(name, run_scaler16, i, pixels);
+		}
+	}
+
+	if (json_path != NULL)
+	{
+		FILE *f = fopen(json_path, "w");
+		if (f == NULL)
+		{
+			fprintf(stderr, "error: failed to open '%s' for writing\n", json_path);
+			return EXIT_FAILURE;
+		}
+		write_json(f);
+		fclose(f);
+	}
+
+	free_bench_data();
+	deinit_scaler_threads();
+
+	SDL_Quit();
+
+	return EXIT_SUCCESS;
+}
+
+static void init_synthetic_data(void)
+{
+	VGAScreen = dst_surface = SDL_CreateRGBSurface(0, vga_width, vga_height, 8, 0, 0, 0, 0);
+	src_surface = SDL_CreateRGBSurface(0, vga_width, vga_height, 8, 0, 0, 0, 0);
+
+	// Noise with some structure, so that the scalers see both edges and flat areas.
+	Uint32 seed = 1;
+	for (int y = 0; y < vga_height; ++y)
+	{
+		Uint8 *const row = (Uint8 *)src_surface->pixels + y * src_surface->pitch;
+		for (int x = 0; x < vga_width; ++x)
+		{
+			seed = seed * 1103515245 + 12345;
+			row[x] = ((x / 8 + y / 8) & 1) ? (Uint8)(seed >> 16) : (Uint8)((x / 16) * 16 + 8);
+		}
+	}
+	memcpy(dst_surface->pixels, src_surface->pixels, dst_surface->pitch * dst_surface->h);
+
+	main_window_tex_format = SDL_AllocFormat(SDL_PIXELFORMAT_RGB888);
+	Palette synthetic_palette;
+	for (int i = 0; i < 256; ++i)
+	{
+		synthetic_palette[i].r = i;
+		synthetic_palette[i].g = (i * 3) & 0xff;
+		synthetic_palette[i].b = 255 - i;
+		synthetic_palette[i].a = 255;
+	}
+	set_palette(synthetic_palette, 0, 255);
+
+	// A filled circle in the table sprite format: 255 n skips n pixels, 254 ends a row early.
+	Uint8 *data = synthetic_sprite_data;
+	const int r = SYNTHETIC_SPRITE_SIZE / 2;
+	for (int y = 0; y < SYNTHETIC_SPRITE_SIZE; ++y)
+	{
+		int x = 0;
+		for (; x < SYNTHETIC_SPRITE_SIZE; ++x)
+		{
+			const int dx = x - r, dy = y - r;
+			if (dx * dx + dy * dy < r * r)
+				break;
+		}
+		if (x > 0)
+		{
+			*data++ = 255;
+			*data++ = x;
+		}
+		for (; x < SYNTHETIC_SPRITE_SIZE; ++x)
+		{
+			const int dx = x - r, dy = y - r;
+			if (dx * dx + dy * dy >= r * r)
+				break;
+			*data++ = 1 + (x * 7 + y) % 252;
+		}
+		if (x < SYNTHETIC_SPRITE_SIZE)
+			*data++ = 254;
+	}
+
+	Sprite *const cur_sprite = &sprite_table[SYNTHETIC_SPRITE_TABLE].sprite[0];
+	cur_sprite->width = SYNTHETIC_SPRITE_SIZE;
+	cur_sprite->height = SYNTHETIC_SPRITE_SIZE;
+	cur_sprite->size = data - synthetic_sprite_data;
+	cur_sprite->data = synthetic_sprite_data;
+	decode_sprite_spans(cur_sprite, NULL);
+	sprite_table[SYNTHETIC_SPRITE_TABLE].count = 1;
+
+	// A 12x14 diamond in the sheet format: each byte is an opaque count nibble and a transparent
+	// count nibble, a zero opaque count ends the row, and 0x0f ends the sprite.  All entries of the
+	// offset table share it.
+	data = synthetic_sprite2_data + SYNTHETIC_SPRITE2_COUNT * 2;
+	for (int i = 0; i < SYNTHETIC_SPRITE2_COUNT; ++i)
+	{
+		const Uint16 offset = SDL_SwapLE16((Uint16)(SYNTHETIC_SPRITE2_COUNT * 2));
+		memcpy(synthetic_sprite2_data + i * 2, &offset, sizeof(offset));
+	}
+	synthetic_sprite2_pixels = 0;
+	for (int y = 0; y < 14; ++y)
+	{
+		const int half = y < 7 ? y : 13 - y;
+		const int skip = 5 - half < 0 ? 0 : 5 - half,
+		          count = 12 - 2 * skip;
+		*data++ = (count << 4) | skip;
+		for (int x = 0; x < count; ++x)
+			*data++ = 1 + (x * 5 + y * 3) % 252;
+		*data++ = 12 - skip - count;
+		synthetic_sprite2_pixels += 12;
+	}
+	*data++ = 0x0f;
+	decode_sprite2_spans(&synthetic_sprite2s);
+
+	for (int t = 0; t < 12; ++t)
+	{
+		for (int i = 0; i < 24 * 28; ++i)
+			tiles[t][i] = (i % 24 + t) % 9 == 0 ? 0 : (Uint8)(t * 20 + i % 17);  // some transparent pixels
+		background_map[t] = (t % 5 == 4) ? NULL : tiles[t];
+	}
+
+	// A background 3 that does not scroll, with the same rows as above, 14 pixels down.
+	memcpy(megaData3.tiles, tiles, sizeof(tiles));
+	megaData3.tileCount = 12;
+	for (unsigned int i = 0; i < COUNTOF(background_layer_map); ++i)
+		background_layer_map[i] = (i % 15 < 12 && background_map[i % 15] != NULL) ? 1 + i % 15 : 0;
+	mapY3Pos = background_layer_map + 11;
+	mapX3bpPos = 1;
+	mapX3Pos = 16;
+	backPos3 = 14;
+	backMove3 = 0;
+	reset_background_strips();
+}
+
+static bool init_asset_data(void)
+{
+	if (!dir_file_exists(data_dir(), "tyrian.shp"))
+		return false;
+
+	JE_loadMainShapeTables("tyrian.shp");
+
+	asset_sprite_pixels = 0;
+	for (unsigned int table = 0; table < 7; ++table)
+		for (unsigned int i = 0; i < sprite_table[table].count; ++i)
+			if (sprite_exists(table, i))
+				asset_sprite_pixels += sprite(table, i)->width * sprite(table, i)->height;
+
+	asset_sprite2_count = spriteSheet9.count;
+
+	asset_sprite2_pixels = 0;
+	for (unsigned int i = 1; i <= asset_sprite2_count; ++i)
+	{
+		Uint16 offset;
+		memcpy(&offset, spriteSheet9.data + (i - 1) * 2, sizeof(offset));
+		for (const Uint8 *data = spriteSheet9.data + SDL_SwapLE16(offset); *data != 0x0f; ++data)
+		{
+			const unsigned int count = (*data & 0xf0) >> 4;
+			if (count == 0)  // end of a 12 pixel row
+				asset_sprite2_pixels += 12;
+			data += count;
+		}
+	}
+
+	return true;
+}
+
+static void free_bench_data(void)
+{
+	// The synthetic data is static, so only the decoded spans are freed.
+	Sprite *const cur_sprite = &sprite_table[SYNTHETIC_SPRITE_TABLE].sprite[0];
+	free(cur_sprite->spans.span);
+	memset(&cur_sprite->spans, 0, sizeof(cur_sprite->spans));
+	cur_sprite->data = NULL;
+	sprite_table[SYNTHETIC_SPRITE_TABLE].count = 0;
+
+	for (unsigned int i = 0; i < synthetic_sprite2s.count; ++i)
+		free(synthetic_sprite2s.spans[i].span);
+	free(synthetic_sprite2s.spans);
+	synthetic_sprite2s.spans = NULL;
+	synthetic_sprite2s.count = 0;
+
+	if (have_assets)
+		free_main_shape_tables();
+
+	SDL_FreeFormat(main_window_tex_format);
+	SDL_FreeSurface(dst_surface);
+	SDL_FreeSurface(src_surface);
+}
+
+static void run_smoothie_filter(unsigned int filter, SDL_Surface *dst, SDL_Surface *src)
+{
+	switch (filter)
+	{
+	case 0: lava_filter(dst, src); break;
+	case 1: water_filter(dst, src); break;
+	case 2: iced_blur_filter(dst, src); break;
+	case 3: blur_filter(dst, src); break;
+	}
+}
+
+/** Runs every smoothie filter over a sequence of frames with both the SIMD and the scalar kernels,
+ *  feeding each filter's output back in as the next frame's destination as the game does, and
+ *  checks that the outputs are identical.  Returns false on the first difference. */
+static bool check_smoothie_filters(const char *frames_path)
+{
+	const size_t frame_size = vga_width * vga_height;
+	Uint8 *frames;
+	unsigned int frame_count;
+
+	if (frames_path != NULL)
+	{
+		FILE *f = fopen(frames_path, "rb");
+		if (f == NULL)
+		{
+			fprintf(stderr, "error: failed to open '%s'\n", frames_path);
+			return false;
+		}
+
+		frame_count = ftell_eof(f) / frame_size;
+		if (frame_count < 2)
+		{
+			fprintf(stderr, "error: '%s' does not contain at least two %dx%d frames\n", frames_path, vga_width, vga_height);
+			fclose(f);
+			return false;
+		}
+
+		frames = malloc(frame_count * frame_size);
+		fread_u8_die(frames, frame_count * frame_size, f);
+		fclose(f);
+	}
+	else
+	{
+		// The synthetic source scrolls down a row per frame, like the background does.
+		frame_count = SYNTHETIC_FRAME_COUNT;
+		frames = malloc(frame_count * frame_size);
+
+		for (unsigned int i = 0; i < frame_count; ++i)
+			for (int y = 0; y < vga_height; ++y)
+				memcpy(frames + i * frame_size + y * vga_width,
+				       (Uint8 *)src_surface->pixels + ((y + vga_height - i % vga_height) % vga_height) * src_surface->pitch,
+				       vga_width);
+	}
+
+	SDL_Surface *const src = SDL_CreateRGBSurface(0, vga_width, vga_height, 8, 0, 0, 0, 0),
+	            *const simd_dst = SDL_CreateRGBSurface(0, vga_width, vga_height, 8, 0, 0, 0, 0),
+	            *const scalar_dst = SDL_CreateRGBSurface(0, vga_width, vga_height, 8, 0, 0, 0, 0);
+
+	const char *const simd_kernels = select_smoothie_filters(true);
+	bool passed = true;
+
+	for (unsigned int filter = 0; filter < COUNTOF(smoothie_filter_names) && passed; ++filter)
+	{
+		for (int y = 0; y < vga_height; ++y)
+		{
+			memcpy((Uint8 *)simd_dst->pixels + y * simd_dst->pitch, frames + y * vga_width, vga_width);
+			memcpy((Uint8 *)scalar_dst->pixels + y * scalar_dst->pitch, frames + y * vga_width, vga_width);
+		}
+
+		for (unsigned int i = 1; i < frame_count && passed; ++i)
+		{
+			for (int y = 0; y < vga_height; ++y)
+				memcpy((Uint8 *)src->pixels + y * src->pitch, frames + i * frame_size + y * vga_width, vga_width);
+
+			smoothie_data[1] = i % 16;  // water hue
+
+			select_smoothie_filters(true);
+			run_smoothie_filter(filter, simd_dst, src);
+			select_smoothie_filters(false);
+			run_smoothie_filter(filter, scalar_dst, src);
+
+			for (int y = 0; y < vga_height && passed; ++y)
+			{
+				const Uint8 *const simd_row = (Uint8 *)simd_dst->pixels + y * simd_dst->pitch,
+				            *const scalar_row = (Uint8 *)scalar_dst->pixels + y * scalar_dst->pitch;
+
+				for (int x = 0; x < vga_width; ++x)
+				{
+					if (simd_row[x] != scalar_row[x])
+					{
+						fprintf(stderr, "error: %s (%s) differs from scalar at frame %u, pixel %d,%d: %02x != %02x\n",
+						        smoothie_filter_names[filter], simd_kernels, i, x, y, simd_row[x], scalar_row[x]);
+						passed = false;
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	select_smoothie_filters(true);
+
+	if (passed)
+		printf("smoothie filters (%s) match scalar over %u %s frames\n\n", simd_kernels, frame_count, frames_path != NULL ? "recorded" : "synthetic");
+
+	SDL_FreeSurface(scalar_dst);
+	SDL_FreeSurface(simd_dst);
+	SDL_FreeSurface(src);
+	free(frames);
+
+	return passed;
+}
+
+/** Runs the function repeatedly for at least BENCH_MIN_SECONDS and records the result. */
+static void bench(const char *name, BenchFunction function, unsigned int param, unsigned long long pixels)
+{
+	const Uint64 frequency = SDL_GetPerformanceFrequency();
+
+	function(param);  // warm up
+
+	unsigned long long iterations = 0;
+	unsigned long long batch = 1;
+	const Uint64 start = SDL_GetPerformanceCounter();
+	Uint64 elapsed;
+	do
+	{
+		for (unsigned long long i = 0; i < batch; ++i)
+			function(param);
+		iterations += batch;
+		batch *= 2;
+
+		elapsed = SDL_GetPerformanceCounter() - start;
+	} while (elapsed < BENCH_MIN_SECONDS * frequency);
+
+	const double seconds = (double)elapsed / frequency;
+	const double ns_per_pixel = seconds * 1e9 / ((double)iterations * pixels);
+
+	printf("%-32s %10.3f ns/pixel %10.1f Mpixel/s\n", name, ns_per_pixel, 1e3 / ns_per_pixel);
+
+	if (result_count < COUNTOF(results))
+	{
+		BenchResult *const result = &results[result_count++];
+		snprintf(result->name, sizeof(result->name), "%s", name);
+		result->iterations = iterations;
+		result->pixels = pixels;
+		result->seconds = seconds;
+	}
+}
+
+static void write_json(FILE *f)
+{
+	fprintf(f, "{\n  \"have_assets\": %s,\n  \"benchmarks\": [\n", have_assets ? "true" : "false");
+
+	for (unsigned int i = 0; i < result_count; ++i)
+	{
+		const BenchResult *const result = &results[i];
+		const double ns_per_pixel = result->seconds * 1e9 / ((double)result->iterations * result->pixels);
+
+		fprintf(f, "    { \"name\": \"%s\", \"iterations\": %llu, \"pixels_per_iteration\": %llu, "
+		           "\"seconds\": %.6f, \"ns_per_pixel\": %.4f, \"mpixels_per_second\": %.2f }%s\n",
+		        result->name, result->iterations, result->pixels,
+		        result->seconds, ns_per_pixel, 1e3 / ns_per_pixel,
+		        i + 1 < result_count ? "," : "");
+	}
+
+	fprintf(f, "  ]\n}\n");
+}
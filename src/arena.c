@@ -0,0 +1,107 @@
+/*
+ * OpenTyrian: A modern cross-platform port of Tyrian
+ * Copyright (C) 2007-2009  The OpenTyrian Development Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#include "arena.h"
+
+#include "SDL.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGNMENT 16
+#define ARENA_BLOCK_SIZE (256 * 1024)  // smallest block; larger allocations get a block of their own
+
+#define ALIGN_UP(n) (((n) + (ARENA_ALIGNMENT - 1)) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+struct ArenaBlock
+{
+	ArenaBlock *next;
+	size_t size;
+};
+
+static void arena_add_block(Arena *arena, size_t size);
+
+void *arena_alloc(Arena *arena, size_t size)
+{
+	size = ALIGN_UP(MAX(size, 1));
+
+	if (arena->block == NULL || size > arena->block->size - arena->used)
+		arena_add_block(arena, MAX(size, ARENA_BLOCK_SIZE));
+
+	void *const p = (Uint8 *)arena->block + ALIGN_UP(sizeof(ArenaBlock)) + arena->used;
+	arena->used += size;
+	arena->total += size;
+
+	return p;
+}
+
+void *arena_calloc(Arena *arena, size_t count, size_t size)
+{
+	void *const p = arena_alloc(arena, count * size);
+	memset(p, 0, count * size);
+
+	return p;
+}
+
+/** Releases everything allocated from the arena.  If that took more than one block, they are
+ *  replaced by a single one that holds as much, so that an arena that is filled with about the
+ *  same amount each time, like a level's, settles on one contiguous block. */
+void arena_reset(Arena *arena)
+{
+	if (arena->block != NULL && arena->block->next != NULL)
+	{
+		const size_t total = arena->total;
+
+		arena_free(arena);
+		arena_add_block(arena, MAX(total, ARENA_BLOCK_SIZE));
+	}
+
+	arena->used = 0;
+	arena->total = 0;
+}
+
+void arena_free(Arena *arena)
+{
+	while (arena->block != NULL)
+	{
+		ArenaBlock *const next = arena->block->next;
+		free(arena->block);
+		arena->block = next;
+	}
+
+	arena->used = 0;
+	arena->total = 0;
+}
+
+static void arena_add_block(Arena *arena, size_t size)
+{
+	ArenaBlock *const block = malloc(ALIGN_UP(sizeof(ArenaBlock)) + size);
+	if (block == NULL)
+	{
+		fprintf(stderr, "error: failed to allocate %lu bytes\n", (unsigned long)size);
+		SDL_Quit();
+		exit(EXIT_FAILURE);
+	}
+
+	block->next = arena->block;
+	block->size = size;
+
+	arena->block = block;
+	arena->used = 0;
+}
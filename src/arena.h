@@ -0,0 +1,43 @@
+/*
+ * OpenTyrian: A modern cross-platform port of Tyrian
+ * Copyright (C) 2007-2009  The OpenTyrian Development Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "opentyr.h"
+
+#include <stddef.h>
+
+typedef struct ArenaBlock ArenaBlock;
+
+// Bump allocator for data that is all released at once, like the assets of a level.  Allocations
+// are not freed individually; arena_reset() releases everything allocated since the last reset.
+typedef struct
+{
+	ArenaBlock *block;  // newest block, which the older ones are chained behind
+	size_t used;        // in the newest block
+	size_t total;       // in all blocks since the last reset
+}
+Arena;
+
+void *arena_alloc(Arena *, size_t size);
+void *arena_calloc(Arena *, size_t count, size_t size);
+void arena_reset(Arena *);
+void arena_free(Arena *);
+
+#endif /* ARENA_H */
@@ -21,10 +21,23 @@
 #include "config.h"
 #include "mtrand.h"
 #include "opentyr.h"
+#include "profiler.h"
 #include "varz.h"
 #include "video.h"
 
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SMOOTHIE_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SMOOTHIE_USE_NEON
+#include <arm_neon.h>
+#endif
 
 /*Special Background 2 and Background 3*/
 
@@ -34,7 +47,7 @@ JE_word backMove, backMove2, backMove3;
 
 /*Main Maps*/
 JE_word mapX, mapY, mapX2, mapX3, mapY2, mapY3;
-JE_byte **mapYPos, **mapY2Pos, **mapY3Pos;
+JE_byte *mapYPos, *mapY2Pos, *mapY3Pos;
 JE_word mapXPos, oldMapXOfs, mapXOfs, mapX2Ofs, mapX2Pos, mapX3Pos, oldMapX3Ofs, mapX3Ofs, tempMapXOfs;
 intptr_t mapXbpPos, mapX2bpPos, mapX3bpPos;
 JE_byte map1YDelay, map1YDelayMax, map2YDelay, map2YDelayMax;
@@ -42,6 +55,30 @@ JE_byte map1YDelay, map1YDelayMax, map2YDelay, map2YDelayMax;
 JE_boolean  anySmoothies;
 JE_byte     smoothie_data[9]; /* [1..9] */
 
+// Each background row on screen is 12 tiles of 24x28 pixels.  Rows are composed once into strips,
+// cached per layer by the map cells they were composed from, so drawing a background is a few
+// wide row copies instead of a bounds and transparency check per pixel.  Map cells and tile
+// shapes do not change during a level, so strips stay valid until reset_background_strips().
+#define BACKGROUND_STRIP_COUNT 16  // a power of two, and twice the 8 rows on screen
+
+enum
+{
+	STRIP_ROW_EMPTY,   // all transparent
+	STRIP_ROW_OPAQUE,  // no transparent pixels
+	STRIP_ROW_MASKED,
+};
+
+typedef struct
+{
+	const JE_byte *map;  // first of the 12 map cells the strip was composed from; NULL if unused
+	Uint8 row_kind[28];
+	Uint8 pixels[28][12 * 24];
+} BackgroundStrip;
+
+static BackgroundStrip background_strips[3][BACKGROUND_STRIP_COUNT];
+
+static JE_DanCShape *const background_tiles[3] = { megaData1.tiles, megaData2.tiles, megaData3.tiles };
+
 void JE_darkenBackground(JE_word neat)  /* wild detail level */
 {
 	Uint8 *s = VGAScreen->pixels; /* screen pointer, 8-bit specific */
@@ -152,22 +189,189 @@ void blit_background_row_blend(SDL_Surface *surface, int x, int y, Uint8 **map)
 	}
 }
 
+void reset_background_strips(void)
+{
+	for (int layer = 0; layer < 3; layer++)
+		for (int i = 0; i < BACKGROUND_STRIP_COUNT; i++)
+			background_strips[layer][i].map = NULL;
+}
+
+/** Looks up the tiles of 12 map cells of a layer, for blit_background_row(). */
+static void decode_background_row(Uint8 *row[12], int layer, const JE_byte *map)
+{
+	for (int tile = 0; tile < 12; tile++)
+		row[tile] = map[tile] == 0 ? NULL : background_tiles[layer][map[tile] - 1];
+}
+
+static void compose_background_strip(BackgroundStrip *strip, int layer, const JE_byte *map)
+{
+	strip->map = map;
+	
+	Uint8 *row[12];
+	decode_background_row(row, layer, map);
+	
+	for (int tile = 0; tile < 12; tile++)
+	{
+		const Uint8 *data = row[tile];
+		
+		for (int y = 0; y < 28; y++)
+		{
+			if (data == NULL)
+				memset(&strip->pixels[y][tile * 24], 0, 24);
+			else
+				memcpy(&strip->pixels[y][tile * 24], data + y * 24, 24);
+		}
+	}
+	
+	for (int y = 0; y < 28; y++)
+	{
+		int transparent = 0;
+		for (int x = 0; x < 12 * 24; x++)
+			transparent += strip->pixels[y][x] == 0;
+		
+		strip->row_kind[y] = transparent == 12 * 24 ? STRIP_ROW_EMPTY :
+		                     transparent == 0 ? STRIP_ROW_OPAQUE :
+		                     STRIP_ROW_MASKED;
+	}
+}
+
+static const BackgroundStrip *get_background_strip(int layer, const JE_byte *map)
+{
+	BackgroundStrip *strip = &background_strips[layer][((uintptr_t)map / sizeof(*map)) & (BACKGROUND_STRIP_COUNT - 1)];
+	
+	if (strip->map != map)
+		compose_background_strip(strip, layer, map);
+	
+	return strip;
+}
+
+// Copies the non-transparent pixels of src over dst.
+static void copy_masked(Uint8 *dst, const Uint8 *src, int count)
+{
+	int i = 0;
+	
+#if defined(SMOOTHIE_USE_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= count; i += 16)
+	{
+		const __m128i s = _mm_loadu_si128((const __m128i *)(src + i)),
+		              d = _mm_loadu_si128((const __m128i *)(dst + i)),
+		              transparent = _mm_cmpeq_epi8(s, zero);
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_or_si128(_mm_and_si128(transparent, d), _mm_andnot_si128(transparent, s)));
+	}
+#elif defined(SMOOTHIE_USE_NEON)
+	for (; i + 16 <= count; i += 16)
+	{
+		const uint8x16_t s = vld1q_u8(src + i),
+		                 d = vld1q_u8(dst + i);
+		vst1q_u8(dst + i, vbslq_u8(vceqq_u8(s, vdupq_n_u8(0)), d, s));
+	}
+#endif
+	
+	for (; i < count; i++)
+		if (src[i] != 0)
+			dst[i] = src[i];
+}
+
+/** Draws the 12 tiles starting at map like blit_background_row(), from the layer's strip cache.
+ *  If the surface is known to be all transparent underneath, masked rows are copied whole. */
+static void blit_background_strip(SDL_Surface *surface, int x, int y, int layer, const JE_byte *map, bool dst_clear)
+{
+	assert(surface->format->BitsPerPixel == 8);
+	
+	// rows that would wrap around the edge of the surface
+	if (x < 0 || x + 12 * 24 > surface->pitch)
+	{
+		Uint8 *row[12];
+		decode_background_row(row, layer, map);
+		blit_background_row(surface, x, y, row);
+		return;
+	}
+	
+	const int row_begin = MAX(0, -y),
+	          row_end = MIN(28, surface->h - y);
+	if (row_begin >= row_end)
+		return;
+	
+	const BackgroundStrip *strip = get_background_strip(layer, map);
+	
+	for (int row = row_begin; row < row_end; row++)
+	{
+		Uint8 *pixels = (Uint8 *)surface->pixels + (y + row) * surface->pitch + x;
+		
+		switch (strip->row_kind[row])
+		{
+		case STRIP_ROW_EMPTY:
+			break;
+		case STRIP_ROW_MASKED:
+			if (!dst_clear)
+			{
+				copy_masked(pixels, strip->pixels[row], 12 * 24);
+				break;
+			}
+			// fall through
+		case STRIP_ROW_OPAQUE:
+			memcpy(pixels, strip->pixels[row], 12 * 24);
+			break;
+		}
+	}
+}
+
+static void blit_background_strip_blend(SDL_Surface *surface, int x, int y, int layer, const JE_byte *map)
+{
+	assert(surface->format->BitsPerPixel == 8);
+	
+	if (x < 0 || x + 12 * 24 > surface->pitch)
+	{
+		Uint8 *row[12];
+		decode_background_row(row, layer, map);
+		blit_background_row_blend(surface, x, y, row);
+		return;
+	}
+	
+	const int row_begin = MAX(0, -y),
+	          row_end = MIN(28, surface->h - y);
+	if (row_begin >= row_end)
+		return;
+	
+	const BackgroundStrip *strip = get_background_strip(layer, map);
+	
+	for (int row = row_begin; row < row_end; row++)
+	{
+		if (strip->row_kind[row] == STRIP_ROW_EMPTY)
+			continue;
+		
+		Uint8 *pixels = (Uint8 *)surface->pixels + (y + row) * surface->pitch + x;
+		const Uint8 *data = strip->pixels[row];
+		
+		for (int i = 0; i < 12 * 24; i++)
+			if (data[i] != 0)
+				pixels[i] = (data[i] & 0xf0) | (((pixels[i] & 0x0f) + (data[i] & 0x0f)) / 2);
+	}
+}
+
 void draw_background_1(SDL_Surface *surface)
 {
+	const Uint64 profile_start = profile_begin();
+	
 	SDL_FillRect(surface, NULL, 0);
 	
-	Uint8 **map = (Uint8 **)mapYPos + mapXbpPos - 12;
+	const JE_byte *map = mapYPos + mapXbpPos - 12;
 	
 	for (int i = -1; i < 7; i++)
 	{
-		blit_background_row(surface, mapXPos, (i * 28) + backPos, map);
+		blit_background_strip(surface, mapXPos, (i * 28) + backPos, 0, map, true);
 		
 		map += 14;
 	}
+	
+	profile_end(PROFILE_BACKGROUND, profile_start);
 }
 
 void draw_background_2(SDL_Surface *surface)
 {
+	const Uint64 profile_start = profile_begin();
+	
 	if (map2YDelayMax > 1 && backMove2 < 2)
 		backMove2 = (map2YDelay == 1) ? 1 : 0;
 	
@@ -176,11 +380,11 @@ void draw_background_2(SDL_Surface *surface)
 		// water effect combines background 1 and 2 by synchronizing the x coordinate
 		int x = smoothies[1] ? mapXPos : mapX2Pos;
 		
-		Uint8 **map = (Uint8 **)mapY2Pos + (smoothies[1] ? mapXbpPos : mapX2bpPos) - 12;
+		const JE_byte *map = mapY2Pos + (smoothies[1] ? mapXbpPos : mapX2bpPos) - 12;
 		
 		for (int i = -1; i < 7; i++)
 		{
-			blit_background_row(surface, x, (i * 28) + backPos2, map);
+			blit_background_strip(surface, x, (i * 28) + backPos2, 1, map, false);
 			
 			map += 14;
 		}
@@ -200,18 +404,22 @@ void draw_background_2(SDL_Surface *surface)
 			mapY2Pos -= 14;  /*Map Width*/
 		}
 	}
+	
+	profile_end(PROFILE_BACKGROUND, profile_start);
 }
 
 void draw_background_2_blend(SDL_Surface *surface)
 {
+	const Uint64 profile_start = profile_begin();
+	
 	if (map2YDelayMax > 1 && backMove2 < 2)
 		backMove2 = (map2YDelay == 1) ? 1 : 0;
 	
-	Uint8 **map = (Uint8 **)mapY2Pos + mapX2bpPos - 12;
+	const JE_byte *map = mapY2Pos + mapX2bpPos - 12;
 	
 	for (int i = -1; i < 7; i++)
 	{
-		blit_background_row_blend(surface, mapX2Pos, (i * 28) + backPos2, map);
+		blit_background_strip_blend(surface, mapX2Pos, (i * 28) + backPos2, 1, map);
 		
 		map += 14;
 	}
@@ -230,10 +438,14 @@ void draw_background_2_blend(SDL_Surface *surface)
 			mapY2Pos -= 14;  /*Map Width*/
 		}
 	}
+	
+	profile_end(PROFILE_BACKGROUND, profile_start);
 }
 
 void draw_background_3(SDL_Surface *surface)
 {
+	const Uint64 profile_start = profile_begin();
+	
 	/* Movement of background */
 	backPos3 += backMove3;
 	
@@ -244,14 +456,16 @@ void draw_background_3(SDL_Surface *surface)
 		mapY3Pos -= 15;   /*Map Width*/
 	}
 	
-	Uint8 **map = (Uint8 **)mapY3Pos + mapX3bpPos - 12;
+	const JE_byte *map = mapY3Pos + mapX3bpPos - 12;
 	
 	for (int i = -1; i < 7; i++)
 	{
-		blit_background_row(surface, mapX3Pos, (i * 28) + backPos3, map);
+		blit_background_strip(surface, mapX3Pos, (i * 28) + backPos3, 2, map, false);
 		
 		map += 15;
 	}
+	
+	profile_end(PROFILE_BACKGROUND, profile_start);
 }
 
 void JE_filterScreen(JE_shortint col, JE_shortint int_)
@@ -317,152 +531,404 @@ void JE_checkSmoothies(void)
 	anySmoothies = (processorType > 2 && (smoothies[1-1] || smoothies[2-1])) || (processorType > 1 && (smoothies[3-1] || smoothies[4-1] || smoothies[5-1]));
 }
 
-void lava_filter(SDL_Surface *dst, SDL_Surface *src)
+/* Smoothie filters
+ *
+ * Each filter has a scalar row kernel plus SIMD row kernels where the compiler supports them.  The
+ * SIMD kernels must produce exactly the same pixels as the scalar ones; the bench checks this. */
+
+typedef struct
 {
-	assert(src->format->BitsPerPixel == 8 && dst->format->BitsPerPixel == 8);
-	
-	/* we don't need to check for over-reading the pixel surfaces since we only
-	 * read from the top 185+1 scanlines, and there should be 320 */
-	
-	const int dst_pitch = dst->pitch;
-	Uint8 *dst_pixel = (Uint8 *)dst->pixels + (185 * dst_pitch);
-	const Uint8 * const dst_pixel_ll = (Uint8 *)dst->pixels;  // lower limit
-	
-	const int src_pitch = src->pitch;
-	const Uint8 *src_pixel = (Uint8 *)src->pixels + (185 * src->pitch);
-	const Uint8 * const src_pixel_ll = (Uint8 *)src->pixels;  // lower limit
-	
-	int w = 320 * 185 - 1;
-	
-	for (int y = 185 - 1; y >= 0; --y)
+	const char *name;
+	// Lava and water read the already-filtered row below from dst, so rows go bottom to top and
+	// each row goes right to left, as in the original 8-pixel group loop.
+	void (*lava_row)(Uint8 *dst, const Uint8 *src, int dst_pitch, int src_pitch, int y);
+	void (*water_row)(Uint8 *dst, const Uint8 *src, int dst_pitch, int y, Uint8 hue);
+	void (*iced_blur_row)(Uint8 *dst, const Uint8 *src);
+	void (*blur_row)(Uint8 *dst, const Uint8 *src);
+}
+SmoothieKernels;
+
+static const SmoothieKernels *smoothie_kernels = NULL;
+
+// The waver offset is shared by each group of 8 pixels and depends on the group's position in the
+// 320x185 gameplay area, regardless of pitch.
+static inline int lava_waver(int y, int x)
+{
+	const int w = y * 320 + x + 8 - 1;
+	return abs(((w >> 9) & 0x0f) - 8) - 1;
+}
+
+static inline int water_waver(int y, int x)
+{
+	const int w = y * 320 + x + 8 - 1;
+	return abs(((w >> 10) & 0x07) - 4) - 1;
+}
+
+static void lava_filter_row_scalar(Uint8 *dst, const Uint8 *src, int dst_pitch, int src_pitch, int y)
+{
+	for (int x = 320 - 8; x >= 0; x -= 8)
+	{
+		const int waver = lava_waver(y, x);
+		
+		for (int xi = 8 - 1; xi >= 0; --xi)
+		{
+			Uint8 * const dst_pixel = dst + x + xi;
+			const Uint8 * const src_pixel = src + x + xi;
+			
+			// value is average value of source pixel (2x), destination pixel above, and destination pixel below (all with waver)
+			// hue is red
+			Uint8 value = 0;
+			
+			// only near the top of the surfaces can the waver reach before the first pixel
+			if (y * src_pitch + x + xi + waver >= 0)
+				value += (*(src_pixel + waver) & 0x0f) * 2;
+			value += *(dst_pixel + waver + dst_pitch) & 0x0f;
+			if ((y - 1) * dst_pitch + x + xi + waver >= 0)
+				value += *(dst_pixel + waver - dst_pitch) & 0x0f;
+			
+			*dst_pixel = (value / 4) | 0x70;
+		}
+	}
+}
+
+static void water_filter_row_scalar(Uint8 *dst, const Uint8 *src, int dst_pitch, int y, Uint8 hue)
+{
+	for (int x = 320 - 8; x >= 0; x -= 8)
 	{
-		dst_pixel -= (dst_pitch - 320);  // in case pitch is not 320
-		src_pixel -= (src_pitch - 320);  // in case pitch is not 320
+		const int waver = water_waver(y, x);
 		
-		for (int x = 320 - 1; x >= 0; x -= 8)
+		for (int xi = 8 - 1; xi >= 0; --xi)
 		{
-			int waver = abs(((w >> 9) & 0x0f) - 8) - 1;
-			w -= 8;
+			Uint8 * const dst_pixel = dst + x + xi;
+			const Uint8 * const src_pixel = src + x + xi;
 			
-			for (int xi = 8 - 1; xi >= 0; --xi)
+			// pixel is copied from source if not blue
+			// otherwise, value is average of value of source pixel and destination pixel below (with waver)
+			if ((*src_pixel & 0x30) == 0)
 			{
-				--dst_pixel;
-				--src_pixel;
-				
-				// value is average value of source pixel (2x), destination pixel above, and destination pixel below (all with waver)
-				// hue is red
-				Uint8 value = 0;
-				
-				if (src_pixel + waver >= src_pixel_ll)
-					value += (*(src_pixel + waver) & 0x0f) * 2;
+				*dst_pixel = *src_pixel;
+			}
+			else
+			{
+				Uint8 value = *src_pixel & 0x0f;
 				value += *(dst_pixel + waver + dst_pitch) & 0x0f;
-				if (dst_pixel + waver - dst_pitch >= dst_pixel_ll)
-					value += *(dst_pixel + waver - dst_pitch) & 0x0f;
-				
-				*dst_pixel = (value / 4) | 0x70;
+				*dst_pixel = (value / 2) | hue;
 			}
 		}
 	}
 }
 
-void water_filter(SDL_Surface *dst, SDL_Surface *src)
+static void iced_blur_filter_row_scalar(Uint8 *dst, const Uint8 *src)
+{
+	for (int x = 0; x < 320; ++x)
+	{
+		// value is average value of source pixel and destination pixel
+		// hue is icy blue
+		
+		const Uint8 value = (src[x] & 0x0f) + (dst[x] & 0x0f);
+		dst[x] = (value / 2) | 0x80;
+	}
+}
+
+static void blur_filter_row_scalar(Uint8 *dst, const Uint8 *src)
+{
+	for (int x = 0; x < 320; ++x)
+	{
+		// value is average value of source pixel and destination pixel
+		// hue is source pixel hue
+		
+		const Uint8 value = (src[x] & 0x0f) + (dst[x] & 0x0f);
+		dst[x] = (value / 2) | (src[x] & 0xf0);
+	}
+}
+
+static const SmoothieKernels smoothie_kernels_scalar =
+{
+	"scalar",
+	lava_filter_row_scalar,
+	water_filter_row_scalar,
+	iced_blur_filter_row_scalar,
+	blur_filter_row_scalar,
+};
+
+// The SIMD kernels do 16 pixels (two waver groups) per iteration.  Sums of two or three low
+// nibbles fit in a byte, so they are added as bytes.
+
+#ifdef SMOOTHIE_USE_SSE2
+// Loads two 8-pixel groups, each offset by its own waver.
+static inline __m128i load_groups_sse2(const Uint8 *p, int waver_lo, int waver_hi)
+{
+	return _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)(p + waver_lo)),
+	                          _mm_loadl_epi64((const __m128i *)(p + 8 + waver_hi)));
+}
+
+// Shifting 16-bit lanes leaks bits between bytes, so the result is masked.
+static inline __m128i shift_right_nibbles_sse2(__m128i value, int shift)
+{
+	return _mm_and_si128(_mm_srl_epi16(value, _mm_cvtsi32_si128(shift)), _mm_set1_epi8(0x0f));
+}
+
+static void lava_filter_row_sse2(Uint8 *dst, const Uint8 *src, int dst_pitch, int src_pitch, int y)
+{
+	(void)src_pitch;
+	
+	const __m128i low_nibble = _mm_set1_epi8(0x0f);
+	
+	for (int x = 320 - 16; x >= 0; x -= 16)
+	{
+		const int waver_lo = lava_waver(y, x),
+		          waver_hi = lava_waver(y, x + 8);
+		
+		const __m128i source = _mm_and_si128(load_groups_sse2(src + x, waver_lo, waver_hi), low_nibble),
+		              below = _mm_and_si128(load_groups_sse2(dst + x + dst_pitch, waver_lo, waver_hi), low_nibble),
+		              above = _mm_and_si128(load_groups_sse2(dst + x - dst_pitch, waver_lo, waver_hi), low_nibble);
+		
+		const __m128i value = _mm_add_epi8(_mm_add_epi8(source, source), _mm_add_epi8(below, above));
+		
+		_mm_storeu_si128((__m128i *)(dst + x), _mm_or_si128(shift_right_nibbles_sse2(value, 2), _mm_set1_epi8(0x70)));
+	}
+}
+
+static void water_filter_row_sse2(Uint8 *dst, const Uint8 *src, int dst_pitch, int y, Uint8 hue)
+{
+	const __m128i low_nibble = _mm_set1_epi8(0x0f);
+	
+	for (int x = 320 - 16; x >= 0; x -= 16)
+	{
+		const __m128i source = _mm_loadu_si128((const __m128i *)(src + x)),
+		              below = load_groups_sse2(dst + x + dst_pitch, water_waver(y, x), water_waver(y, x + 8));
+		
+		const __m128i value = _mm_add_epi8(_mm_and_si128(source, low_nibble), _mm_and_si128(below, low_nibble));
+		const __m128i blended = _mm_or_si128(shift_right_nibbles_sse2(value, 1), _mm_set1_epi8((char)hue));
+		
+		const __m128i not_blue = _mm_cmpeq_epi8(_mm_and_si128(source, _mm_set1_epi8(0x30)), _mm_setzero_si128());
+		
+		_mm_storeu_si128((__m128i *)(dst + x), _mm_or_si128(_mm_and_si128(not_blue, source), _mm_andnot_si128(not_blue, blended)));
+	}
+}
+
+static void iced_blur_filter_row_sse2(Uint8 *dst, const Uint8 *src)
+{
+	const __m128i low_nibble = _mm_set1_epi8(0x0f);
+	
+	for (int x = 0; x < 320; x += 16)
+	{
+		const __m128i source = _mm_loadu_si128((const __m128i *)(src + x)),
+		              dest = _mm_loadu_si128((const __m128i *)(dst + x));
+		
+		const __m128i value = _mm_add_epi8(_mm_and_si128(source, low_nibble), _mm_and_si128(dest, low_nibble));
+		
+		_mm_storeu_si128((__m128i *)(dst + x), _mm_or_si128(shift_right_nibbles_sse2(value, 1), _mm_set1_epi8((char)0x80)));
+	}
+}
+
+static void blur_filter_row_sse2(Uint8 *dst, const Uint8 *src)
+{
+	const __m128i low_nibble = _mm_set1_epi8(0x0f);
+	
+	for (int x = 0; x < 320; x += 16)
+	{
+		const __m128i source = _mm_loadu_si128((const __m128i *)(src + x)),
+		              dest = _mm_loadu_si128((const __m128i *)(dst + x));
+		
+		const __m128i value = _mm_add_epi8(_mm_and_si128(source, low_nibble), _mm_and_si128(dest, low_nibble));
+		
+		_mm_storeu_si128((__m128i *)(dst + x), _mm_or_si128(shift_right_nibbles_sse2(value, 1), _mm_andnot_si128(low_nibble, source)));
+	}
+}
+
+static const SmoothieKernels smoothie_kernels_sse2 =
+{
+	"SSE2",
+	lava_filter_row_sse2,
+	water_filter_row_sse2,
+	iced_blur_filter_row_sse2,
+	blur_filter_row_sse2,
+};
+#endif /* SMOOTHIE_USE_SSE2 */
+
+#ifdef SMOOTHIE_USE_NEON
+// Loads two 8-pixel groups, each offset by its own waver.
+static inline uint8x16_t load_groups_neon(const Uint8 *p, int waver_lo, int waver_hi)
+{
+	return vcombine_u8(vld1_u8(p + waver_lo), vld1_u8(p + 8 + waver_hi));
+}
+
+static void lava_filter_row_neon(Uint8 *dst, const Uint8 *src, int dst_pitch, int src_pitch, int y)
+{
+	(void)src_pitch;
+	
+	const uint8x16_t low_nibble = vdupq_n_u8(0x0f);
+	
+	for (int x = 320 - 16; x >= 0; x -= 16)
+	{
+		const int waver_lo = lava_waver(y, x),
+		          waver_hi = lava_waver(y, x + 8);
+		
+		const uint8x16_t source = vandq_u8(load_groups_neon(src + x, waver_lo, waver_hi), low_nibble),
+		                 below = vandq_u8(load_groups_neon(dst + x + dst_pitch, waver_lo, waver_hi), low_nibble),
+		                 above = vandq_u8(load_groups_neon(dst + x - dst_pitch, waver_lo, waver_hi), low_nibble);
+		
+		const uint8x16_t value = vaddq_u8(vaddq_u8(source, source), vaddq_u8(below, above));
+		
+		vst1q_u8(dst + x, vorrq_u8(vshrq_n_u8(value, 2), vdupq_n_u8(0x70)));
+	}
+}
+
+static void water_filter_row_neon(Uint8 *dst, const Uint8 *src, int dst_pitch, int y, Uint8 hue)
+{
+	const uint8x16_t low_nibble = vdupq_n_u8(0x0f);
+	
+	for (int x = 320 - 16; x >= 0; x -= 16)
+	{
+		const uint8x16_t source = vld1q_u8(src + x),
+		                 below = load_groups_neon(dst + x + dst_pitch, water_waver(y, x), water_waver(y, x + 8));
+		
+		const uint8x16_t value = vaddq_u8(vandq_u8(source, low_nibble), vandq_u8(below, low_nibble));
+		const uint8x16_t blended = vorrq_u8(vshrq_n_u8(value, 1), vdupq_n_u8(hue));
+		
+		const uint8x16_t blue = vtstq_u8(source, vdupq_n_u8(0x30));
+		
+		vst1q_u8(dst + x, vbslq_u8(blue, blended, source));
+	}
+}
+
+static void iced_blur_filter_row_neon(Uint8 *dst, const Uint8 *src)
+{
+	const uint8x16_t low_nibble = vdupq_n_u8(0x0f);
+	
+	for (int x = 0; x < 320; x += 16)
+	{
+		const uint8x16_t value = vaddq_u8(vandq_u8(vld1q_u8(src + x), low_nibble), vandq_u8(vld1q_u8(dst + x), low_nibble));
+		
+		vst1q_u8(dst + x, vorrq_u8(vshrq_n_u8(value, 1), vdupq_n_u8(0x80)));
+	}
+}
+
+static void blur_filter_row_neon(Uint8 *dst, const Uint8 *src)
+{
+	const uint8x16_t low_nibble = vdupq_n_u8(0x0f);
+	
+	for (int x = 0; x < 320; x += 16)
+	{
+		const uint8x16_t source = vld1q_u8(src + x);
+		const uint8x16_t value = vaddq_u8(vandq_u8(source, low_nibble), vandq_u8(vld1q_u8(dst + x), low_nibble));
+		
+		vst1q_u8(dst + x, vorrq_u8(vshrq_n_u8(value, 1), vbicq_u8(source, low_nibble)));
+	}
+}
+
+static const SmoothieKernels smoothie_kernels_neon =
+{
+	"NEON",
+	lava_filter_row_neon,
+	water_filter_row_neon,
+	iced_blur_filter_row_neon,
+	blur_filter_row_neon,
+};
+#endif /* SMOOTHIE_USE_NEON */
+
+/** Picks the fastest smoothie filter kernels the CPU supports, or the scalar ones if simd is false.
+ *  Returns the name of the kernels picked. */
+const char *select_smoothie_filters(bool simd)
+{
+	smoothie_kernels = &smoothie_kernels_scalar;
+	
+	if (simd)
+	{
+#ifdef SMOOTHIE_USE_SSE2
+		if (SDL_HasSSE2())
+			smoothie_kernels = &smoothie_kernels_sse2;
+#endif
+#ifdef SMOOTHIE_USE_NEON
+		// the compiler only enables NEON when the target is known to have it
+		smoothie_kernels = &smoothie_kernels_neon;
+#endif
+	}
+	
+	return smoothie_kernels->name;
+}
+
+void lava_filter(SDL_Surface *dst, SDL_Surface *src)
 {
+	const Uint64 profile_start = profile_begin();
+	
 	assert(src->format->BitsPerPixel == 8 && dst->format->BitsPerPixel == 8);
 	
-	Uint8 hue = smoothie_data[1] << 4;
+	if (smoothie_kernels == NULL)
+		select_smoothie_filters(true);
 	
 	/* we don't need to check for over-reading the pixel surfaces since we only
 	 * read from the top 185+1 scanlines, and there should be 320 */
 	
-	const int dst_pitch = dst->pitch;
-	Uint8 *dst_pixel = (Uint8 *)dst->pixels + (185 * dst_pitch);
+	for (int y = 185 - 1; y >= 0; --y)
+	{
+		Uint8 * const dst_row = (Uint8 *)dst->pixels + (y * dst->pitch);
+		const Uint8 * const src_row = (Uint8 *)src->pixels + (y * src->pitch);
+		
+		// only the top two rows can reach before the first pixel, and only the scalar kernel checks
+		if (y < 2)
+			lava_filter_row_scalar(dst_row, src_row, dst->pitch, src->pitch, y);
+		else
+			smoothie_kernels->lava_row(dst_row, src_row, dst->pitch, src->pitch, y);
+	}
+	
+	profile_end(PROFILE_FILTERS, profile_start);
+}
+
+void water_filter(SDL_Surface *dst, SDL_Surface *src)
+{
+	const Uint64 profile_start = profile_begin();
+	
+	assert(src->format->BitsPerPixel == 8 && dst->format->BitsPerPixel == 8);
 	
-	const Uint8 *src_pixel = (Uint8 *)src->pixels + (185 * src->pitch);
+	if (smoothie_kernels == NULL)
+		select_smoothie_filters(true);
 	
-	int w = 320 * 185 - 1;
+	Uint8 hue = smoothie_data[1] << 4;
+	
+	/* we don't need to check for over-reading the pixel surfaces since we only
+	 * read from the top 185+1 scanlines, and there should be 320 */
 	
 	for (int y = 185 - 1; y >= 0; --y)
 	{
-		dst_pixel -= (dst_pitch - 320);  // in case pitch is not 320
-		src_pixel -= (src->pitch - 320);  // in case pitch is not 320
+		Uint8 * const dst_row = (Uint8 *)dst->pixels + (y * dst->pitch);
+		const Uint8 * const src_row = (Uint8 *)src->pixels + (y * src->pitch);
 		
-		for (int x = 320 - 1; x >= 0; x -= 8)
-		{
-			int waver = abs(((w >> 10) & 0x07) - 4) - 1;
-			w -= 8;
-			
-			for (int xi = 8 - 1; xi >= 0; --xi)
-			{
-				--dst_pixel;
-				--src_pixel;
-				
-				// pixel is copied from source if not blue
-				// otherwise, value is average of value of source pixel and destination pixel below (with waver)
-				if ((*src_pixel & 0x30) == 0)
-				{
-					*dst_pixel = *src_pixel;
-				}
-				else
-				{
-					Uint8 value = *src_pixel & 0x0f;
-					value += *(dst_pixel + waver + dst_pitch) & 0x0f;
-					*dst_pixel = (value / 2) | hue;
-				}
-			}
-		}
+		smoothie_kernels->water_row(dst_row, src_row, dst->pitch, y, hue);
 	}
+	
+	profile_end(PROFILE_FILTERS, profile_start);
 }
 
 void iced_blur_filter(SDL_Surface *dst, SDL_Surface *src)
 {
+	const Uint64 profile_start = profile_begin();
+	
 	assert(src->format->BitsPerPixel == 8 && dst->format->BitsPerPixel == 8);
 	
-	Uint8 *dst_pixel = dst->pixels;
-	const Uint8 *src_pixel = src->pixels;
+	if (smoothie_kernels == NULL)
+		select_smoothie_filters(true);
 	
 	for (int y = 0; y < 184; ++y)
-	{
-		for (int x = 0; x < 320; ++x)
-		{
-			// value is average value of source pixel and destination pixel
-			// hue is icy blue
-			
-			const Uint8 value = (*src_pixel & 0x0f) + (*dst_pixel & 0x0f);
-			*dst_pixel = (value / 2) | 0x80;
-			
-			++dst_pixel;
-			++src_pixel;
-		}
-		
-		dst_pixel += (dst->pitch - 320);  // in case pitch is not 320
-		src_pixel += (src->pitch - 320);  // in case pitch is not 320
-	}
+		smoothie_kernels->iced_blur_row((Uint8 *)dst->pixels + (y * dst->pitch), (Uint8 *)src->pixels + (y * src->pitch));
+	
+	profile_end(PROFILE_FILTERS, profile_start);
 }
 
 void blur_filter(SDL_Surface *dst, SDL_Surface *src)
 {
+	const Uint64 profile_start = profile_begin();
+	
 	assert(src->format->BitsPerPixel == 8 && dst->format->BitsPerPixel == 8);
 	
-	Uint8 *dst_pixel = dst->pixels;
-	const Uint8 *src_pixel = src->pixels;
+	if (smoothie_kernels == NULL)
+		select_smoothie_filters(true);
 	
 	for (int y = 0; y < 184; ++y)
-	{
-		for (int x = 0; x < 320; ++x)
-		{
-			// value is average value of source pixel and destination pixel
-			// hue is source pixel hue
-			
-			const Uint8 value = (*src_pixel & 0x0f) + (*dst_pixel & 0x0f);
-			*dst_pixel = (value / 2) | (*src_pixel & 0xf0);
-			
-			++dst_pixel;
-			++src_pixel;
-		}
-		
-		dst_pixel += (dst->pitch - 320);  // in case pitch is not 320
-		src_pixel += (src->pitch - 320);  // in case pitch is not 320
-	}
+		smoothie_kernels->blur_row((Uint8 *)dst->pixels + (y * dst->pitch), (Uint8 *)src->pixels + (y * src->pitch));
+	
+	profile_end(PROFILE_FILTERS, profile_start);
 }
 
 /* Background Starfield */
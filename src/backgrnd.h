@@ -28,7 +28,7 @@
 extern JE_word backPos, backPos2, backPos3;
 extern JE_word backMove, backMove2, backMove3;
 extern JE_word mapX, mapY, mapX2, mapX3, mapY2, mapY3;
-extern JE_byte **mapYPos, **mapY2Pos, **mapY3Pos;
+extern JE_byte *mapYPos, *mapY2Pos, *mapY3Pos;
 extern JE_word mapXPos, oldMapXOfs, mapXOfs, mapX2Ofs, mapX2Pos, mapX3Pos, oldMapX3Ofs, mapX3Ofs, tempMapXOfs;
 extern intptr_t mapXbpPos, mapX2bpPos, mapX3bpPos;
 extern JE_byte map1YDelay, map1YDelayMax, map2YDelay, map2YDelayMax;
@@ -42,6 +42,7 @@ void JE_darkenBackground(JE_word neat);
 void blit_background_row(SDL_Surface *surface, int x, int y, Uint8 **map);
 void blit_background_row_blend(SDL_Surface *surface, int x, int y, Uint8 **map);
 
+void reset_background_strips(void);
 void draw_background_1(SDL_Surface *surface);
 void draw_background_2(SDL_Surface *surface);
 void draw_background_2_blend(SDL_Surface *surface);
@@ -50,6 +51,7 @@ void draw_background_3(SDL_Surface *surface);
 void JE_filterScreen(JE_shortint col, JE_shortint generic_int);
 
 void JE_checkSmoothies(void);
+const char *select_smoothie_filters(bool simd);
 void lava_filter(SDL_Surface *dst, SDL_Surface *src);
 void water_filter(SDL_Surface *dst, SDL_Surface *src);
 void iced_blur_filter(SDL_Surface *dst, SDL_Surface *src);
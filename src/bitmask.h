@@ -0,0 +1,69 @@
+/*
+ * OpenTyrian: A modern cross-platform port of Tyrian
+ * Copyright (C) 2007-2009  The OpenTyrian Development Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef BITMASK_H
+#define BITMASK_H
+
+#include "opentyr.h"
+
+// Masks of one bit per slot, used to find the slots of a fixed array that are in use or free
+// without testing every slot.
+
+// returns the first slot from i up to end whose bit is set in mask ^ flip, or end
+static inline unsigned int next_masked_slot(const Uint64 *mask, Uint64 flip, unsigned int i, unsigned int end)
+{
+	while (i < end)
+	{
+		Uint64 bits = (mask[i / 64] ^ flip) >> (i % 64);
+
+		if (bits != 0)
+		{
+#if defined(__GNUC__)
+			i += __builtin_ctzll(bits);
+#else
+			for (; (bits & 1) == 0; bits >>= 1)
+				++i;
+#endif
+			return i < end ? i : end;
+		}
+		i = (i / 64 + 1) * 64;
+	}
+	return end;
+}
+
+// returns the first slot from i up to end whose bit is set, or end
+static inline unsigned int next_set_slot(const Uint64 *mask, unsigned int i, unsigned int end)
+{
+	return next_masked_slot(mask, 0, i, end);
+}
+
+// returns the first slot from i up to end whose bit is clear, or end
+static inline unsigned int next_clear_slot(const Uint64 *mask, unsigned int i, unsigned int end)
+{
+	return next_masked_slot(mask, ~(Uint64)0, i, end);
+}
+
+static inline void set_slot_bit(Uint64 *mask, unsigned int i, bool set)
+{
+	if (set)
+		mask[i / 64] |= (Uint64)1 << (i % 64);
+	else
+		mask[i / 64] &= ~((Uint64)1 << (i % 64));
+}
+
+#endif /* BITMASK_H */
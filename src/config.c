@@ -243,6 +243,10 @@ bool load_opentyrian_config(void)
 		const char *scaling_mode;
 		if (config_get_string_option(section, "scaling_mode", &scaling_mode))
 			set_scaling_mode_by_name(scaling_mode);
+		
+		const char *renderer;
+		if (config_get_string_option(section, "renderer", &renderer))
+			set_renderer_backend_by_name(renderer);
 	}
 
 	section = config_find_section(config, "keyboard", NULL);
@@ -300,6 +304,8 @@ bool save_opentyrian_config(void)
 	config_set_string_option(section, "scaler", scalers[scaler].name);
 	
 	config_set_string_option(section, "scaling_mode", scaling_mode_names[scaling_mode]);
+	
+	config_set_string_option(section, "renderer", renderer_backend_names[renderer_backend]);
 
 	section = config_find_or_add_section(config, "keyboard", NULL);
 	if (section == NULL)
@@ -1012,6 +1018,10 @@ void JE_saveConfiguration(void)
 	if (!configuration_loaded)
 		return;
 
+	// Headless runs shouldn't disturb the player's settings or save games.
+	if (headless)
+		return;
+
 	p = saveTemp;
 	for (z = 0; z < SAVE_FILES_NUM; z++)
 	{
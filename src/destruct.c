@@ -748,7 +748,7 @@ static void JE_introScreen(void)
 	while (!newkey)
 	{
 		service_SDL_events(false);
-		SDL_Delay(16);
+		sleep_ticks(16);
 	}
 
 	fade_black(15);
@@ -798,7 +798,7 @@ static enum de_mode_t JE_modeSelect(void)
 		do
 		{
 			service_SDL_events(false);
-			SDL_Delay(16);
+			sleep_ticks(16);
 		} while (!newkey);
 
 		/* See what was pressed */
@@ -1382,7 +1382,7 @@ static void JE_helpScreen(void)
 	do  /* wait until user hits a key */
 	{
 		service_SDL_events(true);
-		SDL_Delay(16);
+		sleep_ticks(16);
 	} while (!newkey);
 
 	fade_black(15);
@@ -1403,7 +1403,7 @@ static void JE_pauseScreen(void)
 	do  /* wait until user hits a key */
 	{
 		service_SDL_events(true);
-		SDL_Delay(16);
+		sleep_ticks(16);
 	} while (!newkey);
 
 	/* Restore current screen & volume*/
@@ -20,10 +20,16 @@
 
 #include "config.h"
 #include "file.h"
+#include "helptext.h"
 #include "lvllib.h"
 #include "lvlmast.h"
 #include "opentyr.h"
 
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 /* MAIN Weapons Data */
 JE_WeaponPortType weaponPort;
 JE_WeaponType     weapons[WEAP_NUM + 1]; /* [0..weapnum] */
@@ -51,139 +57,152 @@ JE_boolean bonusLevel;
 /* Tells if the game jumped back to Episode 1 */
 JE_boolean jumpBackToEpisode1;
 
+#define EPISODE_SECTION_MAX 256  // mainLevel is a byte
+
+// Where the sections of each episode's levels file start, found by one pass over the file so
+// that loading a level seeks to its section instead of decrypting every line before it.
+typedef struct
+{
+	const AssetFile *file;  // NULL until the file has been indexed
+	unsigned int count;
+	size_t pos[EPISODE_SECTION_MAX];  // section n starts after the n-th '*' line
+} EpisodeSectionIndex;
+
+static EpisodeSectionIndex episodeSections[EPISODE_MAX];
+
 void JE_loadItemDat(void)
 {
-	FILE *f = NULL;
+	AssetReader reader;
 	
 	if (episodeNum <= 3)
 	{
-		f = dir_fopen_die(data_dir(), "tyrian.hdt", "rb");
-		fread_s32_die(&episode1DataLoc, 1, f);
-		fseek(f, episode1DataLoc, SEEK_SET);
+		reader = asset_reader(asset_open_die("tyrian.hdt"));
+		asset_read_s32_die(&episode1DataLoc, 1, &reader);
+		asset_seek_die(&reader, episode1DataLoc);
 	}
 	else
 	{
 		// episode 4 stores item data in the level file
-		f = dir_fopen_die(data_dir(), levelFile, "rb");
-		fseek(f, lvlPos[lvlNum-1], SEEK_SET);
+		reader = asset_reader(asset_open_die(levelFile));
+		asset_seek_die(&reader, lvlPos[lvlNum-1]);
 	}
 
 	JE_word itemNum[7]; /* [1..7] */
-	fread_u16_die(itemNum, 7, f);
+	asset_read_u16_die(itemNum, 7, &reader);
 
 	const int weapons_bounds[2][2] = {{0, WEAP_END1}, {WEAP_START2, WEAP_NUM}};
 	for (int bank = 0; bank < 2; ++bank)
 	{
 		for (int i = weapons_bounds[bank][0]; i < weapons_bounds[bank][1] + 1; ++i)
 		{
-			fread_u16_die(&weapons[i].drain,           1, f);
-			fread_u8_die( &weapons[i].shotrepeat,      1, f);
-			fread_u8_die( &weapons[i].multi,           1, f);
-			fread_u16_die(&weapons[i].weapani,         1, f);
-			fread_u8_die( &weapons[i].max,             1, f);
-			fread_u8_die( &weapons[i].tx,              1, f);
-			fread_u8_die( &weapons[i].ty,              1, f);
-			fread_u8_die( &weapons[i].aim,             1, f);
-			fread_u8_die(  weapons[i].attack,          8, f);
-			fread_u8_die(  weapons[i].del,             8, f);
-			fread_s8_die(  weapons[i].sx,              8, f);
-			fread_s8_die(  weapons[i].sy,              8, f);
-			fread_s8_die(  weapons[i].bx,              8, f);
-			fread_s8_die(  weapons[i].by,              8, f);
-			fread_u16_die( weapons[i].sg,              8, f);
-			fread_s8_die( &weapons[i].acceleration,    1, f);
-			fread_s8_die( &weapons[i].accelerationx,   1, f);
-			fread_u8_die( &weapons[i].circlesize,      1, f);
-			fread_u8_die( &weapons[i].sound,           1, f);
-			fread_u8_die( &weapons[i].trail,           1, f);
-			fread_u8_die( &weapons[i].shipblastfilter, 1, f);
+			asset_read_u16_die(&weapons[i].drain,           1, &reader);
+			asset_read_u8_die( &weapons[i].shotrepeat,      1, &reader);
+			asset_read_u8_die( &weapons[i].multi,           1, &reader);
+			asset_read_u16_die(&weapons[i].weapani,         1, &reader);
+			asset_read_u8_die( &weapons[i].max,             1, &reader);
+			asset_read_u8_die( &weapons[i].tx,              1, &reader);
+			asset_read_u8_die( &weapons[i].ty,              1, &reader);
+			asset_read_u8_die( &weapons[i].aim,             1, &reader);
+			asset_read_u8_die(  weapons[i].attack,          8, &reader);
+			asset_read_u8_die(  weapons[i].del,             8, &reader);
+			asset_read_s8_die(  weapons[i].sx,              8, &reader);
+			asset_read_s8_die(  weapons[i].sy,              8, &reader);
+			asset_read_s8_die(  weapons[i].bx,              8, &reader);
+			asset_read_s8_die(  weapons[i].by,              8, &reader);
+			asset_read_u16_die( weapons[i].sg,              8, &reader);
+			asset_read_s8_die( &weapons[i].acceleration,    1, &reader);
+			asset_read_s8_die( &weapons[i].accelerationx,   1, &reader);
+			asset_read_u8_die( &weapons[i].circlesize,      1, &reader);
+			asset_read_u8_die( &weapons[i].sound,           1, &reader);
+			asset_read_u8_die( &weapons[i].trail,           1, &reader);
+			asset_read_u8_die( &weapons[i].shipblastfilter, 1, &reader);
 		}
 	}
 	
 	for (int i = 0; i < PORT_NUM + 1; ++i)
 	{
 		Uint8 nameLen;
-		fread_u8_die( &nameLen,                   1, f);
-		fread_die(    &weaponPort[i].name,    1, 30, f);
+		asset_read_u8_die( &nameLen,                   1, &reader);
+		memcpy(weaponPort[i].name, asset_read_die(&reader, 30), 30);
 		weaponPort[i].name[MIN(nameLen, 30)] = '\0';
-		fread_u8_die( &weaponPort[i].opnum,       1, f);
-		fread_u16_die( weaponPort[i].op[0],      11, f);
-		fread_u16_die( weaponPort[i].op[1],      11, f);
-		fread_u16_die(&weaponPort[i].cost,        1, f);
-		fread_u16_die(&weaponPort[i].itemgraphic, 1, f);
-		fread_u16_die(&weaponPort[i].poweruse,    1, f);
+		asset_read_u8_die( &weaponPort[i].opnum,       1, &reader);
+		asset_read_u16_die( weaponPort[i].op[0],      11, &reader);
+		asset_read_u16_die( weaponPort[i].op[1],      11, &reader);
+		asset_read_u16_die(&weaponPort[i].cost,        1, &reader);
+		asset_read_u16_die(&weaponPort[i].itemgraphic, 1, &reader);
+		asset_read_u16_die(&weaponPort[i].poweruse,    1, &reader);
 	}
 
 	for (int i = 0; i < SPECIAL_NUM + 1; ++i)
 	{
 		Uint8 nameLen;
-		fread_u8_die( &nameLen,                1, f);
-		fread_die(    &special[i].name,    1, 30, f);
+		asset_read_u8_die( &nameLen,                1, &reader);
+		memcpy(special[i].name, asset_read_die(&reader, 30), 30);
 		special[i].name[MIN(nameLen, 30)] = '\0';
-		fread_u16_die(&special[i].itemgraphic, 1, f);
-		fread_u8_die( &special[i].pwr,         1, f);
-		fread_u8_die( &special[i].stype,       1, f);
-		fread_u16_die(&special[i].wpn,         1, f);
+		asset_read_u16_die(&special[i].itemgraphic, 1, &reader);
+		asset_read_u8_die( &special[i].pwr,         1, &reader);
+		asset_read_u8_die( &special[i].stype,       1, &reader);
+		asset_read_u16_die(&special[i].wpn,         1, &reader);
 	}
 
 	for (int i = 0; i < POWER_NUM + 1; ++i)
 	{
 		Uint8 nameLen;
-		fread_u8_die( &nameLen,                 1, f);
-		fread_die(    &powerSys[i].name,    1, 30, f);
+		asset_read_u8_die( &nameLen,                 1, &reader);
+		memcpy(powerSys[i].name, asset_read_die(&reader, 30), 30);
 		powerSys[i].name[MIN(nameLen, 30)] = '\0';
-		fread_u16_die(&powerSys[i].itemgraphic, 1, f);
-		fread_u8_die( &powerSys[i].power,       1, f);
-		fread_s8_die( &powerSys[i].speed,       1, f);
-		fread_u16_die(&powerSys[i].cost,        1, f);
+		asset_read_u16_die(&powerSys[i].itemgraphic, 1, &reader);
+		asset_read_u8_die( &powerSys[i].power,       1, &reader);
+		asset_read_s8_die( &powerSys[i].speed,       1, &reader);
+		asset_read_u16_die(&powerSys[i].cost,        1, &reader);
 	}
 
 	for (int i = 0; i < SHIP_NUM + 1; ++i)
 	{
 		Uint8 nameLen;
-		fread_u8_die( &nameLen,                 1, f);
-		fread_die(    &ships[i].name,       1, 30, f);
+		asset_read_u8_die( &nameLen,                 1, &reader);
+		memcpy(ships[i].name, asset_read_die(&reader, 30), 30);
 		ships[i].name[MIN(nameLen, 30)] = '\0';
-		fread_u16_die(&ships[i].shipgraphic,    1, f);
-		fread_u16_die(&ships[i].itemgraphic,    1, f);
-		fread_u8_die( &ships[i].ani,            1, f);
-		fread_s8_die( &ships[i].spd,            1, f);
-		fread_u8_die( &ships[i].dmg,            1, f);
-		fread_u16_die(&ships[i].cost,           1, f);
-		fread_u8_die( &ships[i].bigshipgraphic, 1, f);
+		asset_read_u16_die(&ships[i].shipgraphic,    1, &reader);
+		asset_read_u16_die(&ships[i].itemgraphic,    1, &reader);
+		asset_read_u8_die( &ships[i].ani,            1, &reader);
+		asset_read_s8_die( &ships[i].spd,            1, &reader);
+		asset_read_u8_die( &ships[i].dmg,            1, &reader);
+		asset_read_u16_die(&ships[i].cost,           1, &reader);
+		asset_read_u8_die( &ships[i].bigshipgraphic, 1, &reader);
 	}
 
 	for (int i = 0; i < OPTION_NUM + 1; ++i)
 	{
 		Uint8 nameLen;
-		fread_u8_die(  &nameLen,                1, f);
-		fread_die(     &options[i].name,    1, 30, f);
+		asset_read_u8_die(  &nameLen,                1, &reader);
+		memcpy(options[i].name, asset_read_die(&reader, 30), 30);
 		options[i].name[MIN(nameLen, 30)] = '\0';
-		fread_u8_die(  &options[i].pwr,         1, f);
-		fread_u16_die( &options[i].itemgraphic, 1, f);
-		fread_u16_die( &options[i].cost,        1, f);
-		fread_u8_die(  &options[i].tr,          1, f);
-		fread_u8_die(  &options[i].option,      1, f);
-		fread_s8_die(  &options[i].opspd,       1, f);
-		fread_u8_die(  &options[i].ani,         1, f);
-		fread_u16_die(  options[i].gr,         20, f);
-		fread_u8_die(  &options[i].wport,       1, f);
-		fread_u16_die( &options[i].wpnum,       1, f);
-		fread_u8_die(  &options[i].ammo,        1, f);
-		fread_bool_die(&options[i].stop,           f);
-		fread_u8_die(  &options[i].icongr,      1, f);
+		asset_read_u8_die(  &options[i].pwr,         1, &reader);
+		asset_read_u16_die( &options[i].itemgraphic, 1, &reader);
+		asset_read_u16_die( &options[i].cost,        1, &reader);
+		asset_read_u8_die(  &options[i].tr,          1, &reader);
+		asset_read_u8_die(  &options[i].option,      1, &reader);
+		asset_read_s8_die(  &options[i].opspd,       1, &reader);
+		asset_read_u8_die(  &options[i].ani,         1, &reader);
+		asset_read_u16_die(  options[i].gr,         20, &reader);
+		asset_read_u8_die(  &options[i].wport,       1, &reader);
+		asset_read_u16_die( &options[i].wpnum,       1, &reader);
+		asset_read_u8_die(  &options[i].ammo,        1, &reader);
+		asset_read_bool_die(&options[i].stop,           &reader);
+		asset_read_u8_die(  &options[i].icongr,      1, &reader);
 	}
 
 	for (int i = 0; i < SHIELD_NUM + 1; ++i)
 	{
 		Uint8 nameLen;
-		fread_u8_die( &nameLen,                1, f);
-		fread_die(    &shields[i].name,    1, 30, f);
+		asset_read_u8_die( &nameLen,                1, &reader);
+		memcpy(shields[i].name, asset_read_die(&reader, 30), 30);
 		shields[i].name[MIN(nameLen, 30)] = '\0';
-		fread_u8_die( &shields[i].tpwr,        1, f);
-		fread_u8_die( &shields[i].mpwr,        1, f);
-		fread_u16_die(&shields[i].itemgraphic, 1, f);
-		fread_u16_die(&shields[i].cost,        1, f);
+		asset_read_u8_die( &shields[i].tpwr,        1, &reader);
+		asset_read_u8_die( &shields[i].mpwr,        1, &reader);
+		asset_read_u16_die(&shields[i].itemgraphic, 1, &reader);
+		asset_read_u16_die(&shields[i].cost,        1, &reader);
 	}
 
 	const int enemies_bounds[2][2] = {{0, ENEMY_END1}, {ENEMY_START2, ENEMY_NUM}};
@@ -191,38 +210,36 @@ void JE_loadItemDat(void)
 	{
 		for (int i = enemies_bounds[bank][0]; i < enemies_bounds[bank][1] + 1; ++i)
 		{
-			fread_u8_die( &enemyDat[i].ani,           1, f);
-			fread_u8_die(  enemyDat[i].tur,           3, f);
-			fread_u8_die(  enemyDat[i].freq,          3, f);
-			fread_s8_die( &enemyDat[i].xmove,         1, f);
-			fread_s8_die( &enemyDat[i].ymove,         1, f);
-			fread_s8_die( &enemyDat[i].xaccel,        1, f);
-			fread_s8_die( &enemyDat[i].yaccel,        1, f);
-			fread_s8_die( &enemyDat[i].xcaccel,       1, f);
-			fread_s8_die( &enemyDat[i].ycaccel,       1, f);
-			fread_s16_die(&enemyDat[i].startx,        1, f);
-			fread_s16_die(&enemyDat[i].starty,        1, f);
-			fread_s8_die( &enemyDat[i].startxc,       1, f);
-			fread_s8_die( &enemyDat[i].startyc,       1, f);
-			fread_u8_die( &enemyDat[i].armor,         1, f);
-			fread_u8_die( &enemyDat[i].esize,         1, f);
-			fread_u16_die( enemyDat[i].egraphic,     20, f);
-			fread_u8_die( &enemyDat[i].explosiontype, 1, f);
-			fread_u8_die( &enemyDat[i].animate,       1, f);
-			fread_u8_die( &enemyDat[i].shapebank,     1, f);
-			fread_s8_die( &enemyDat[i].xrev,          1, f);
-			fread_s8_die( &enemyDat[i].yrev,          1, f);
-			fread_u16_die(&enemyDat[i].dgr,           1, f);
-			fread_s8_die( &enemyDat[i].dlevel,        1, f);
-			fread_s8_die( &enemyDat[i].dani,          1, f);
-			fread_u8_die( &enemyDat[i].elaunchfreq,   1, f);
-			fread_u16_die(&enemyDat[i].elaunchtype,   1, f);
-			fread_s16_die(&enemyDat[i].value,         1, f);
-			fread_u16_die(&enemyDat[i].eenemydie,     1, f);
+			asset_read_u8_die( &enemyDat[i].ani,           1, &reader);
+			asset_read_u8_die(  enemyDat[i].tur,           3, &reader);
+			asset_read_u8_die(  enemyDat[i].freq,          3, &reader);
+			asset_read_s8_die( &enemyDat[i].xmove,         1, &reader);
+			asset_read_s8_die( &enemyDat[i].ymove,         1, &reader);
+			asset_read_s8_die( &enemyDat[i].xaccel,        1, &reader);
+			asset_read_s8_die( &enemyDat[i].yaccel,        1, &reader);
+			asset_read_s8_die( &enemyDat[i].xcaccel,       1, &reader);
+			asset_read_s8_die( &enemyDat[i].ycaccel,       1, &reader);
+			asset_read_s16_die(&enemyDat[i].startx,        1, &reader);
+			asset_read_s16_die(&enemyDat[i].starty,        1, &reader);
+			asset_read_s8_die( &enemyDat[i].startxc,       1, &reader);
+			asset_read_s8_die( &enemyDat[i].startyc,       1, &reader);
+			asset_read_u8_die( &enemyDat[i].armor,         1, &reader);
+			asset_read_u8_die( &enemyDat[i].esize,         1, &reader);
+			asset_read_u16_die( enemyDat[i].egraphic,     20, &reader);
+			asset_read_u8_die( &enemyDat[i].explosiontype, 1, &reader);
+			asset_read_u8_die( &enemyDat[i].animate,       1, &reader);
+			asset_read_u8_die( &enemyDat[i].shapebank,     1, &reader);
+			asset_read_s8_die( &enemyDat[i].xrev,          1, &reader);
+			asset_read_s8_die( &enemyDat[i].yrev,          1, &reader);
+			asset_read_u16_die(&enemyDat[i].dgr,           1, &reader);
+			asset_read_s8_die( &enemyDat[i].dlevel,        1, &reader);
+			asset_read_s8_die( &enemyDat[i].dani,          1, &reader);
+			asset_read_u8_die( &enemyDat[i].elaunchfreq,   1, &reader);
+			asset_read_u16_die(&enemyDat[i].elaunchtype,   1, &reader);
+			asset_read_s16_die(&enemyDat[i].value,         1, &reader);
+			asset_read_u16_die(&enemyDat[i].eenemydie,     1, &reader);
 		}
 	}
-	
-	fclose(f);
 }
 
 void JE_initEpisode(JE_byte newEpisode)
@@ -240,6 +257,39 @@ void JE_initEpisode(JE_byte newEpisode)
 	JE_loadItemDat();
 }
 
+size_t JE_episodeSectionPos(unsigned int section)
+{
+	const AssetFile *file = asset_open_die(episode_file);
+	
+	assert(episodeNum >= 1 && episodeNum <= EPISODE_MAX);
+	EpisodeSectionIndex *index = &episodeSections[episodeNum - 1];
+	
+	if (index->file != file)
+	{
+		AssetReader reader = asset_reader(file);
+		char s[256];
+		
+		index->file = file;
+		index->pos[0] = 0;
+		index->count = 1;
+		
+		while (reader.pos < reader.size && index->count < EPISODE_SECTION_MAX)
+		{
+			asset_read_encrypted_pascal_string(s, sizeof(s), &reader);
+			if (s[0] == '*')
+				index->pos[index->count++] = reader.pos;
+		}
+	}
+	
+	if (section >= index->count)
+	{
+		fprintf(stderr, "error: %s has no section %u\n", episode_file, section);
+		exit(EXIT_FAILURE);
+	}
+	
+	return index->pos[section];
+}
+
 void JE_scanForEpisodes(void)
 {
 	for (int i = 0; i < EPISODE_MAX; ++i)
@@ -165,6 +165,7 @@ extern JE_boolean jumpBackToEpisode1;
 
 void JE_loadItemDat(void);
 void JE_initEpisode(JE_byte newEpisode);
+size_t JE_episodeSectionPos(unsigned int section);
 unsigned int JE_findNextEpisode(void);
 void JE_scanForEpisodes(void);
 
@@ -16,6 +16,10 @@
  * along with this program; if not, write to the Free Software
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  */
+#if defined(TARGET_UNIX) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L  // for fileno()
+#endif
+
 #include "file.h"
 
 #include "opentyr.h"
@@ -28,8 +32,34 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(TARGET_WIN32)
+#include <io.h>
+#include <windows.h>
+#elif defined(TARGET_UNIX)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+typedef struct AssetEntry
+{
+	struct AssetEntry *next;
+	char *name;
+	bool mapped;
+	AssetFile asset;
+} AssetEntry;
+
+static void missing_data_die(const char *file);
+static AssetEntry *find_asset(const char *file);
+static bool map_asset(FILE *f, AssetFile *asset);
+static bool read_asset(FILE *f, AssetFile *asset);
+static void release_asset(AssetEntry *entry);
+
 const char *custom_data_dir = NULL;
 
+// assets are opened by the loading thread too
+static SDL_SpinLock assets_lock = 0;
+static AssetEntry *assets = NULL;
+
 // finds the Tyrian data directory
 const char *data_dir(void)
 {
@@ -97,16 +127,19 @@ FILE *dir_fopen_die(const char *dir, const char *file, const char *mode)
 	FILE *f = dir_fopen(dir, file, mode);
 
 	if (f == NULL)
-	{
-		fprintf(stderr, "error: failed to open '%s': %s\n", file, strerror(errno));
-		fprintf(stderr, "error: One or more of the required Tyrian " TYRIAN_VERSION " data files could not be found.\n"
-		                "       Please read the README file.\n");
-		JE_tyrianHalt(1);
-	}
+		missing_data_die(file);
 
 	return f;
 }
 
+static void missing_data_die(const char *file)
+{
+	fprintf(stderr, "error: failed to open '%s': %s\n", file, strerror(errno));
+	fprintf(stderr, "error: One or more of the required Tyrian " TYRIAN_VERSION " data files could not be found.\n"
+	                "       Please read the README file.\n");
+	JE_tyrianHalt(1);
+}
+
 // check if file can be opened for reading
 bool dir_file_exists(const char *dir, const char *file)
 {
@@ -116,6 +149,201 @@ bool dir_file_exists(const char *dir, const char *file)
 	return (f != NULL);
 }
 
+// opens a file in the data directory, mapping it on first use
+const AssetFile *asset_open(const char *file)
+{
+	SDL_AtomicLock(&assets_lock);
+	AssetEntry *entry = find_asset(file);
+	SDL_AtomicUnlock(&assets_lock);
+
+	if (entry != NULL)
+		return &entry->asset;
+
+	// the file is opened and mapped without holding the lock so that the
+	// loading thread does not stall the main thread on disk access
+	FILE *f = dir_fopen(data_dir(), file, "rb");
+	if (f == NULL)
+		return NULL;
+
+	entry = malloc(sizeof(*entry));
+	entry->mapped = map_asset(f, &entry->asset);
+	if (!entry->mapped && !read_asset(f, &entry->asset))
+	{
+		free(entry);
+		entry = NULL;
+	}
+
+	fclose(f);
+
+	if (entry == NULL)
+		return NULL;
+
+	SDL_AtomicLock(&assets_lock);
+	AssetEntry *existing = find_asset(file);
+	if (existing == NULL)
+	{
+		entry->name = malloc(strlen(file) + 1);
+		strcpy(entry->name, file);
+
+		entry->next = assets;
+		assets = entry;
+	}
+	SDL_AtomicUnlock(&assets_lock);
+
+	// another thread opened the same file first
+	if (existing != NULL)
+	{
+		release_asset(entry);
+		free(entry);
+		entry = existing;
+	}
+
+	return &entry->asset;
+}
+
+// die when asset_open fails
+const AssetFile *asset_open_die(const char *file)
+{
+	const AssetFile *asset = asset_open(file);
+
+	if (asset == NULL)
+		missing_data_die(file);
+
+	return asset;
+}
+
+// assets_lock must be held
+static AssetEntry *find_asset(const char *file)
+{
+	for (AssetEntry *entry = assets; entry != NULL; entry = entry->next)
+		if (strcmp(entry->name, file) == 0)
+			return entry;
+
+	return NULL;
+}
+
+static bool map_asset(FILE *f, AssetFile *asset)
+{
+#if defined(TARGET_WIN32)
+	HANDLE file = (HANDLE)_get_osfhandle(_fileno(f));
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 || (Uint64)size.QuadPart > SIZE_MAX)
+		return false;
+
+	HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+		return false;
+
+	// the view keeps the mapping open
+	void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (data == NULL)
+		return false;
+
+	asset->data = data;
+	asset->size = (size_t)size.QuadPart;
+	return true;
+#elif defined(TARGET_UNIX)
+	struct stat st;
+	if (fstat(fileno(f), &st) != 0 || st.st_size <= 0 || (Uint64)st.st_size > SIZE_MAX)
+		return false;
+
+	// the mapping stays valid after the file is closed
+	void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+	if (data == MAP_FAILED)
+		return false;
+
+	asset->data = data;
+	asset->size = (size_t)st.st_size;
+	return true;
+#else
+	(void)f;
+	(void)asset;
+	return false;
+#endif
+}
+
+// fallback for when the file cannot be mapped
+static bool read_asset(FILE *f, AssetFile *asset)
+{
+	long size = ftell_eof(f);
+	if (size < 0)
+		return false;
+
+	Uint8 *data = malloc(size > 0 ? size : 1);
+	if (fread(data, 1, size, f) != (size_t)size)
+	{
+		free(data);
+		return false;
+	}
+
+	asset->data = data;
+	asset->size = size;
+	return true;
+}
+
+static void release_asset(AssetEntry *entry)
+{
+	if (!entry->mapped)
+	{
+		free((void *)entry->asset.data);
+		return;
+	}
+
+#if defined(TARGET_WIN32)
+	UnmapViewOfFile(entry->asset.data);
+#elif defined(TARGET_UNIX)
+	munmap((void *)entry->asset.data, entry->asset.size);
+#endif
+}
+
+// returns false if pos is past the end
+bool asset_seek(AssetReader *reader, size_t pos)
+{
+	if (pos > reader->size)
+		return false;
+
+	reader->pos = pos;
+	return true;
+}
+
+void asset_seek_die(AssetReader *reader, size_t pos)
+{
+	if (!asset_seek(reader, pos))
+	{
+		fprintf(stderr, "error: An unexpected problem occurred while reading from a file.\n");
+		SDL_Quit();
+		exit(EXIT_FAILURE);
+	}
+}
+
+// returns a pointer to the next size bytes and skips over them, or NULL if there are not that many
+const Uint8 *asset_read(AssetReader *reader, size_t size)
+{
+	if (size > reader->size - reader->pos)
+		return NULL;
+
+	const Uint8 *data = reader->data + reader->pos;
+	reader->pos += size;
+	return data;
+}
+
+// returns a pointer to the next size bytes and skips over them
+const Uint8 *asset_read_die(AssetReader *reader, size_t size)
+{
+	const Uint8 *data = asset_read(reader, size);
+
+	if (data == NULL)
+	{
+		fprintf(stderr, "error: An unexpected problem occurred while reading from a file.\n");
+		SDL_Quit();
+		exit(EXIT_FAILURE);
+	}
+
+	return data;
+}
+
 // returns end-of-file position
 long ftell_eof(FILE *f)
 {
@@ -23,6 +23,7 @@
 
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 
 extern const char *custom_data_dir;
 
@@ -34,6 +35,37 @@ FILE *dir_fopen_die(const char *dir, const char *file, const char *mode);
 
 bool dir_file_exists(const char *dir, const char *file);
 
+// Read-only view of a whole data file.  A file is mapped into memory the first time it is
+// opened and stays mapped until exit, so pointers into it can be kept.
+typedef struct
+{
+	const Uint8 *data;
+	size_t size;
+} AssetFile;
+
+// Position in an AssetFile for sequential reads.
+typedef struct
+{
+	const Uint8 *data;
+	size_t size;
+	size_t pos;
+} AssetReader;
+
+const AssetFile *asset_open(const char *file);
+const AssetFile *asset_open_die(const char *file);
+
+static inline AssetReader asset_reader(const AssetFile *asset)
+{
+	AssetReader reader = { asset->data, asset->size, 0 };
+	return reader;
+}
+
+bool asset_seek(AssetReader *reader, size_t pos);
+void asset_seek_die(AssetReader *reader, size_t pos);
+
+const Uint8 *asset_read(AssetReader *reader, size_t size);
+const Uint8 *asset_read_die(AssetReader *reader, size_t size);
+
 long ftell_eof(FILE *f);
 
 void fread_die(void *buffer, size_t size, size_t count, FILE *stream);
@@ -108,6 +140,133 @@ static inline void fread_s32_die(Sint32 *buffer, size_t count, FILE *stream)
 #endif
 }
 
+// 8-bit read
+static inline bool asset_read_bool(bool *buffer, AssetReader *reader)
+{
+	const Uint8 *data = asset_read(reader, sizeof(Uint8));
+	if (data == NULL)
+		return false;
+
+	*buffer = *data != 0;
+	return true;
+}
+
+// 8-bit read
+static inline bool asset_read_u8(Uint8 *buffer, size_t count, AssetReader *reader)
+{
+	const Uint8 *data = asset_read(reader, count * sizeof(Uint8));
+	if (data == NULL)
+		return false;
+
+	memcpy(buffer, data, count * sizeof(Uint8));
+	return true;
+}
+
+// 8-bit read
+static inline bool asset_read_s8(Sint8 *buffer, size_t count, AssetReader *reader)
+{
+	const Uint8 *data = asset_read(reader, count * sizeof(Sint8));
+	if (data == NULL)
+		return false;
+
+	memcpy(buffer, data, count * sizeof(Sint8));
+	return true;
+}
+
+// 16-bit endian-swapping read
+static inline bool asset_read_u16(Uint16 *buffer, size_t count, AssetReader *reader)
+{
+	const Uint8 *data = asset_read(reader, count * sizeof(Uint16));
+	if (data == NULL)
+		return false;
+
+	memcpy(buffer, data, count * sizeof(Uint16));
+
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+	for (size_t i = 0; i < count; ++i)
+		buffer[i] = SDL_Swap16(buffer[i]);
+#endif
+	return true;
+}
+
+// 16-bit endian-swapping read
+static inline bool asset_read_s16(Sint16 *buffer, size_t count, AssetReader *reader)
+{
+	const Uint8 *data = asset_read(reader, count * sizeof(Sint16));
+	if (data == NULL)
+		return false;
+
+	memcpy(buffer, data, count * sizeof(Sint16));
+
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+	for (size_t i = 0; i < count; ++i)
+		buffer[i] = SDL_Swap16(buffer[i]);
+#endif
+	return true;
+}
+
+// 8-bit read that dies if read fails
+static inline void asset_read_bool_die(bool *buffer, AssetReader *reader)
+{
+	*buffer = *asset_read_die(reader, sizeof(Uint8)) != 0;
+}
+
+// 8-bit read that dies if read fails
+static inline void asset_read_u8_die(Uint8 *buffer, size_t count, AssetReader *reader)
+{
+	memcpy(buffer, asset_read_die(reader, count * sizeof(Uint8)), count * sizeof(Uint8));
+}
+
+// 8-bit read that dies if read fails
+static inline void asset_read_s8_die(Sint8 *buffer, size_t count, AssetReader *reader)
+{
+	memcpy(buffer, asset_read_die(reader, count * sizeof(Sint8)), count * sizeof(Sint8));
+}
+
+// 16-bit endian-swapping read that dies if read fails
+static inline void asset_read_u16_die(Uint16 *buffer, size_t count, AssetReader *reader)
+{
+	memcpy(buffer, asset_read_die(reader, count * sizeof(Uint16)), count * sizeof(Uint16));
+
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+	for (size_t i = 0; i < count; ++i)
+		buffer[i] = SDL_Swap16(buffer[i]);
+#endif
+}
+
+// 16-bit endian-swapping read that dies if read fails
+static inline void asset_read_s16_die(Sint16 *buffer, size_t count, AssetReader *reader)
+{
+	memcpy(buffer, asset_read_die(reader, count * sizeof(Sint16)), count * sizeof(Sint16));
+
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+	for (size_t i = 0; i < count; ++i)
+		buffer[i] = SDL_Swap16(buffer[i]);
+#endif
+}
+
+// 32-bit endian-swapping read that dies if read fails
+static inline void asset_read_u32_die(Uint32 *buffer, size_t count, AssetReader *reader)
+{
+	memcpy(buffer, asset_read_die(reader, count * sizeof(Uint32)), count * sizeof(Uint32));
+
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+	for (size_t i = 0; i < count; ++i)
+		buffer[i] = SDL_Swap32(buffer[i]);
+#endif
+}
+
+// 32-bit endian-swapping read that dies if read fails
+static inline void asset_read_s32_die(Sint32 *buffer, size_t count, AssetReader *reader)
+{
+	memcpy(buffer, asset_read_die(reader, count * sizeof(Sint32)), count * sizeof(Sint32));
+
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+	for (size_t i = 0; i < count; ++i)
+		buffer[i] = SDL_Swap32(buffer[i]);
+#endif
+}
+
 void fwrite_die(const void *buffer, size_t size, size_t count, FILE *stream);
 
 // 8-bit fwrite that dies if write fails
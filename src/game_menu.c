@@ -1637,7 +1637,7 @@ void JE_itemScreen(void)
 			network_update();
 			network_check();
 
-			SDL_Delay(16);
+			sleep_ticks(16);
 		}
 
 		network_state_reset();
@@ -1651,7 +1651,7 @@ void JE_itemScreen(void)
 			JE_showVGA();
 
 			network_check();
-			SDL_Delay(16);
+			sleep_ticks(16);
 		}
 	}
 #endif
@@ -2271,7 +2271,7 @@ void JE_initWeaponView(void)
 	power = 500;
 	lastPower = 500;
 
-	memset(shotAvail, 0, sizeof(shotAvail));
+	free_all_player_shots();
 
 	memset(shotRepeat, 1, sizeof(shotRepeat));
 	memset(shotMultiPos, 0, sizeof(shotMultiPos));
@@ -2652,7 +2652,7 @@ void JE_scaleInPicture(SDL_Surface *dst, const SDL_Surface *src)
 		JE_scaleBitmap(dst, src, 160 - i, 0, 160 + i - 1, 100 + roundf(i * 0.625f) - 1);
 		JE_showVGA();
 
-		SDL_Delay(1);
+		sleep_ticks(1);
 	}
 }
 
@@ -96,14 +96,8 @@ static void decrypt_string(char *s, size_t len)
 	}
 }
 
-void read_encrypted_pascal_string(char *s, size_t size, FILE *f)
+static void copy_encrypted_pascal_string(char *s, size_t size, char *buffer, Uint8 len)
 {
-	Uint8 len;
-	char buffer[255];
-
-	fread_u8_die(&len, 1, f);
-	fread_die(buffer, 1, len, f);
-
 	if (size == 0)
 		return;
 
@@ -116,6 +110,28 @@ void read_encrypted_pascal_string(char *s, size_t size, FILE *f)
 	s[len] = '\0';
 }
 
+void read_encrypted_pascal_string(char *s, size_t size, FILE *f)
+{
+	Uint8 len;
+	char buffer[255];
+
+	fread_u8_die(&len, 1, f);
+	fread_die(buffer, 1, len, f);
+
+	copy_encrypted_pascal_string(s, size, buffer, len);
+}
+
+void asset_read_encrypted_pascal_string(char *s, size_t size, AssetReader *reader)
+{
+	Uint8 len;
+	char buffer[255];
+
+	asset_read_u8_die(&len, 1, reader);
+	memcpy(buffer, asset_read_die(reader, len), len);
+
+	copy_encrypted_pascal_string(s, size, buffer, len);
+}
+
 void skip_pascal_string(FILE *f)
 {
 	Uint8 len;
@@ -19,6 +19,7 @@
 #ifndef HELPTEXT_H
 #define HELPTEXT_H
 
+#include "file.h"
 #include "opentyr.h"
 
 #include "SDL.h"
@@ -73,6 +74,7 @@ extern char superTyrianText[6][64];
 extern char menuInt[MENU_MAX+1][11][18];
 
 void read_encrypted_pascal_string(char *s, size_t size, FILE *f);
+void asset_read_encrypted_pascal_string(char *s, size_t size, AssetReader *reader);
 void skip_pascal_string(FILE *f);
 
 void JE_helpBox(SDL_Surface *screen, int x, int y, const char *message, unsigned int boxwidth);
@@ -22,6 +22,7 @@
 #include "joystick.h"
 #include "mouse.h"
 #include "network.h"
+#include "nortsong.h"
 #include "opentyr.h"
 #include "video.h"
 #include "video_scale.h"
@@ -65,7 +66,7 @@ void wait_input(JE_boolean keyboard, JE_boolean mouse, JE_boolean joystick)
 	service_SDL_events(false);
 	while (!((keyboard && keydown) || (mouse && mousedown) || (joystick && joydown)))
 	{
-		SDL_Delay(SDL_POLL_INTERVAL);
+		sleep_ticks(SDL_POLL_INTERVAL);
 		push_joysticks_as_keyboard();
 		service_SDL_events(false);
 
@@ -81,7 +82,7 @@ void wait_noinput(JE_boolean keyboard, JE_boolean mouse, JE_boolean joystick)
 	service_SDL_events(false);
 	while ((keyboard && keydown) || (mouse && mousedown) || (joystick && joydown))
 	{
-		SDL_Delay(SDL_POLL_INTERVAL);
+		sleep_ticks(SDL_POLL_INTERVAL);
 		poll_joysticks();
 		service_SDL_events(false);
 
@@ -147,6 +148,8 @@ void service_SDL_events(JE_boolean clear_new)
 		new_text = false;
 	}
 
+	video_present_pending();
+
 	while (SDL_PollEvent(&ev))
 	{
 		switch (ev.type)
@@ -169,6 +172,12 @@ void service_SDL_events(JE_boolean clear_new)
 				case SDL_WINDOWEVENT_RESIZED:
 					video_on_win_resize();
 					break;
+
+				case SDL_WINDOWEVENT_EXPOSED:
+				case SDL_WINDOWEVENT_SHOWN:
+				case SDL_WINDOWEVENT_RESTORED:
+					video_on_win_expose();
+					break;
 				}
 				break;
 
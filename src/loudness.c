@@ -23,13 +23,27 @@
 #include "nortsong.h"
 #include "opentyr.h"
 #include "params.h"
+#include "profiler.h"
 
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIX_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MIX_USE_NEON
+#include <arm_neon.h>
+#endif
+
 #define OUTPUT_QUALITY 4  // 44.1 kHz
 
+#define SAMPLE_RATE 11025  // of the sound effects
+#define MIX_BLOCK 256  // samples mixed at a time
+
 int audioSampleRate = 0;
 
 bool music_stopped = true;
@@ -37,6 +51,10 @@ unsigned int song_playing = 0;
 
 bool audio_disabled = false, music_disabled = false, samples_disabled = false;
 
+const char *render_audio_dir = NULL;
+unsigned int render_audio_song = 0;
+unsigned int render_audio_seconds = 600;
+
 static SDL_AudioDeviceID audioDevice = 0;
 
 static Uint8 musicVolume = 255;
@@ -67,15 +85,71 @@ static Uint32 *song_offset;
 static Uint16 song_count = 0;
 
 #define CHANNEL_COUNT 8
-static const Sint16 *channelSamples[CHANNEL_COUNT];
+static const Sint8 *channelSamples[CHANNEL_COUNT];
 static size_t channelSampleCount[CHANNEL_COUNT] = { 0 };
+static size_t channelPosition[CHANNEL_COUNT];  // in samples
+static Uint32 channelPositionFrac[CHANNEL_COUNT];  // Q0.16
 static Uint8 channelVolume[CHANNEL_COUNT];
 #define CHANNEL_VOLUME_LEVELS 8
 
+// Sound effect samples per output sample; Q16.16
+static Uint32 channelStep;
+
+static bool mixUseSse2 = false;
+
+// Requests from the game to the audio callback.  The game only writes at audioCommandHead and the
+// callback only reads at audioCommandTail, so neither has to lock the other out.
+typedef enum
+{
+	AUDIO_PLAY_SAMPLE,
+	AUDIO_SET_VOLUME,
+	AUDIO_PLAY_SONG,
+	AUDIO_STOP_SONG,
+	AUDIO_RESTART_SONG,
+	AUDIO_FADE_SONG,
+} AudioCommandType;
+
+typedef struct
+{
+	AudioCommandType type;
+	Uint64 ticks;  // performance counter when it was requested
+
+	// AUDIO_PLAY_SAMPLE
+	const Sint8 *samples;
+	size_t sampleCount;
+	Uint8 chan, vol;
+
+	// AUDIO_SET_VOLUME
+	Uint8 musicVolume, sampleVolume;
+} AudioCommand;
+
+#define AUDIO_COMMAND_COUNT 256  // one is always left empty
+static AudioCommand audioCommands[AUDIO_COMMAND_COUNT];
+static SDL_atomic_t audioCommandHead;
+static SDL_atomic_t audioCommandTail;
+
+// performance counter at the start of the last callback
+static Uint64 lastCallbackTicks;
+
+static void init_mixer(int sampleRate);
 static void audioCallback(void *userdata, Uint8 *stream, int size);
+static void mix_audio(Sint16 *samples, int samplesCount);
+static int resample_channel(size_t i, Sint16 *out, int count, Sint32 volumeFactor);
+static void mix_saturated(Sint16 *dst, const Sint16 *src, int count);
+
+static void push_audio_command(AudioCommand *command);
+static bool peek_audio_command(AudioCommand *command);
+static void pop_audio_command(void);
+static void run_audio_command(const AudioCommand *command);
+static void run_audio_commands(void);
 
 static void load_song(unsigned int song_num);
 
+static FILE *open_wav(const char *name);
+static void write_wav_samples(FILE *f, Sint16 *samples, int count);
+static void close_wav(FILE *f, Uint32 sampleCount);
+static void write_wav_header(FILE *f, Uint32 sampleCount);
+
 bool init_audio(void)
 {
 	if (audio_disabled)
@@ -109,7 +183,29 @@ bool init_audio(void)
 		return false;
 	}
 
-	audioSampleRate = got.freq;
+	init_mixer(got.freq);
+
+	adlib_init_tables();
+	opl_init();
+
+	SDL_AtomicSet(&audioCommandHead, 0);
+	SDL_AtomicSet(&audioCommandTail, 0);
+	lastCallbackTicks = SDL_GetPerformanceCounter();
+
+	SDL_PauseAudioDevice(audioDevice, 0); // unpause
+
+	return true;
+}
+
+static void init_mixer(int sampleRate)
+{
+	audioSampleRate = sampleRate;
+
+	channelStep = ((Uint32)SAMPLE_RATE << 16) / audioSampleRate;
+
+#ifdef MIX_USE_SSE2
+	mixUseSse2 = SDL_HasSSE2();
+#endif
 
 	samplesPerLdsUpdate = 2 * (audioSampleRate / ldsUpdate2Rate);
 	samplesPerLdsUpdateFrac = 2 * (audioSampleRate % ldsUpdate2Rate);
@@ -117,21 +213,48 @@ bool init_audio(void)
 	volumeFactorTable[0] = 0;
 	for (size_t i = 1; i < 256; ++i)
 		volumeFactorTable[i] = TO_FIXED(powf(10, (255 - i) * (-volumeRange / (20.0f * 255))));
-
-	opl_init();
-
-	SDL_PauseAudioDevice(audioDevice, 0); // unpause
-
-	return true;
 }
 
 static void audioCallback(void *userdata, Uint8 *stream, int size)
 {
 	(void)userdata;
 
+	const Uint64 profile_start = profile_begin();
+
 	Sint16 *const samples = (Sint16 *)stream;
 	const int samplesCount = size / sizeof (Sint16);
 
+	// Requests made since the last callback are spread over this one as they were spread over
+	// that time, so sounds start on the sample they should rather than on callback boundaries.
+	const Uint64 now = SDL_GetPerformanceCounter();
+	const Uint64 elapsed = MAX(now - lastCallbackTicks, 1);
+
+	int mixed = 0;
+	AudioCommand command;
+	while (peek_audio_command(&command) && command.ticks < now)
+	{
+		const Uint64 since = command.ticks > lastCallbackTicks ? command.ticks - lastCallbackTicks : 0;
+		const int start = (int)(since * samplesCount / elapsed);
+
+		if (start > mixed)
+		{
+			mix_audio(samples + mixed, start - mixed);
+			mixed = start;
+		}
+
+		run_audio_command(&command);
+		pop_audio_command();
+	}
+
+	mix_audio(samples + mixed, samplesCount - mixed);
+
+	lastCallbackTicks = now;
+
+	profile_end(PROFILE_AUDIO, profile_start);
+}
+
+static void mix_audio(Sint16 *samples, int samplesCount)
+{
 	if (!music_disabled && !music_stopped)
 	{
 		Sint16 *remaining = samples;
@@ -197,31 +320,95 @@ static void audioCallback(void *userdata, Uint8 *stream, int size)
 		for (int i = 0; i < CHANNEL_VOLUME_LEVELS; ++i)
 			sampleVolumeFactors[i] = sampleVolumeFactor * (i + 1) / CHANNEL_VOLUME_LEVELS;
 
-		// Mix music and channels
-		Sint16 *remaining = samples;
-		int remainingCount = samplesCount;
-		while (remainingCount > 0)
+		// Mix music and channels a block at a time
+		for (int start = 0; start < samplesCount; start += MIX_BLOCK)
 		{
-			Sint32 sample = *remaining * musicVolumeFactor;
+			Sint16 *const block = samples + start;
+			const int blockCount = MIN(MIX_BLOCK, samplesCount - start);
+
+			for (int j = 0; j < blockCount; ++j)
+			{
+				Sint32 sample = FIXED_TO_INT(block[j] * musicVolumeFactor);
+				block[j] = MIN(MAX(INT16_MIN, sample), INT16_MAX);
+			}
 
 			for (size_t i = 0; i < CHANNEL_COUNT; ++i)
 			{
-				if (channelSampleCount[i] > 0)
-				{
-					sample += *channelSamples[i] * sampleVolumeFactors[channelVolume[i]];
+				if (channelSampleCount[i] == 0)
+					continue;
 
-					channelSamples[i] += 1;
-					channelSampleCount[i] -= 1;
-				}
+				Sint16 channelBlock[MIX_BLOCK];
+				const int count = resample_channel(i, channelBlock, blockCount, sampleVolumeFactors[channelVolume[i]]);
+
+				mix_saturated(block, channelBlock, count);
 			}
+		}
+	}
+}
 
-			sample = FIXED_TO_INT(sample);
-			*remaining = MIN(MAX(INT16_MIN, sample), INT16_MAX);
+/** Produces up to count output samples of channel i, at volume, advancing it; stops the channel
+ *  when it runs out.  Returns the number of samples produced. */
+static int resample_channel(size_t i, Sint16 *out, int count, Sint32 volumeFactor)
+{
+	const Sint8 *const src = channelSamples[i];
+	const size_t srcCount = channelSampleCount[i];
+	size_t pos = channelPosition[i];
+	Uint32 frac = channelPositionFrac[i];
+
+	// the number of output samples before the position passes the end
+	const Uint64 remaining = ((Uint64)(srcCount - pos) << 16) - frac;
+	const Uint64 available = (remaining + channelStep - 1) / channelStep;
+	if ((Uint64)count >= available)
+	{
+		count = (int)available;
+		channelSampleCount[i] = 0;
+	}
 
-			remaining += 1;
-			remainingCount -= 1;
+	// linear interpolation, holding the last sample
+	for (int j = 0; j < count; ++j)
+	{
+		const Sint32 s0 = src[pos],
+		             s1 = src[pos + 1 < srcCount ? pos + 1 : pos];
+		const Sint32 sample = (s0 * (Sint32)(0x10000 - frac) + s1 * (Sint32)frac) >> 8;  // S16 range
+
+		out[j] = FIXED_TO_INT(sample * volumeFactor);
+
+		frac += channelStep;
+		pos += frac >> 16;
+		frac &= 0xffff;
+	}
+
+	channelPosition[i] = pos;
+	channelPositionFrac[i] = frac;
+
+	return count;
+}
+
+/** Adds src into dst, clamping to the Sint16 range. */
+static void mix_saturated(Sint16 *dst, const Sint16 *src, int count)
+{
+	int j = 0;
+
+#if defined(MIX_USE_SSE2)
+	if (mixUseSse2)
+	{
+		for (; j + 8 <= count; j += 8)
+		{
+			const __m128i a = _mm_loadu_si128((const __m128i *)&dst[j]),
+			              b = _mm_loadu_si128((const __m128i *)&src[j]);
+			_mm_storeu_si128((__m128i *)&dst[j], _mm_adds_epi16(a, b));
 		}
 	}
+#elif defined(MIX_USE_NEON)
+	for (; j + 8 <= count; j += 8)
+		vst1q_s16(&dst[j], vqaddq_s16(vld1q_s16(&dst[j]), vld1q_s16(&src[j])));
+#endif
+
+	for (; j < count; ++j)
+	{
+		const Sint32 sample = dst[j] + src[j];
+		dst[j] = MIN(MAX(INT16_MIN, sample), INT16_MAX);
+	}
 }
 
 void deinit_audio(void)
@@ -238,6 +425,9 @@ void deinit_audio(void)
 
 	SDL_QuitSubSystem(SDL_INIT_AUDIO);
 
+	SDL_AtomicSet(&audioCommandHead, 0);
+	SDL_AtomicSet(&audioCommandTail, 0);
+
 	memset(channelSampleCount, 0, sizeof channelSampleCount);
 
 	lds_free();
@@ -279,8 +469,10 @@ void play_song(unsigned int song_num)  // FKA NortSong.playSong
 
 	if (song_num != song_playing)
 	{
+		// The callback must be done with the old song before it is replaced.
 		SDL_LockAudioDevice(audioDevice);
 
+		run_audio_commands();
 		music_stopped = true;
 
 		SDL_UnlockAudioDevice(audioDevice);
@@ -290,11 +482,8 @@ void play_song(unsigned int song_num)  // FKA NortSong.playSong
 		song_playing = song_num;
 	}
 
-	SDL_LockAudioDevice(audioDevice);
-
-	music_stopped = false;
-
-	SDL_UnlockAudioDevice(audioDevice);
+	AudioCommand command = { .type = AUDIO_PLAY_SONG };
+	push_audio_command(&command);
 }
 
 void restart_song(void)  // FKA Player.selectSong(1)
@@ -302,13 +491,8 @@ void restart_song(void)  // FKA Player.selectSong(1)
 	if (audio_disabled)
 		return;
 
-	SDL_LockAudioDevice(audioDevice);
-
-	lds_rewind();
-
-	music_stopped = false;
-
-	SDL_UnlockAudioDevice(audioDevice);
+	AudioCommand command = { .type = AUDIO_RESTART_SONG };
+	push_audio_command(&command);
 }
 
 void stop_song(void)  // FKA Player.selectSong(0)
@@ -316,11 +500,8 @@ void stop_song(void)  // FKA Player.selectSong(0)
 	if (audio_disabled)
 		return;
 
-	SDL_LockAudioDevice(audioDevice);
-
-	music_stopped = true;
-
-	SDL_UnlockAudioDevice(audioDevice);
+	AudioCommand command = { .type = AUDIO_STOP_SONG };
+	push_audio_command(&command);
 }
 
 void fade_song(void)  // FKA Player.selectSong($C001)
@@ -328,11 +509,8 @@ void fade_song(void)  // FKA Player.selectSong($C001)
 	if (audio_disabled)
 		return;
 
-	SDL_LockAudioDevice(audioDevice);
-
-	lds_fade(1);
-
-	SDL_UnlockAudioDevice(audioDevice);
+	AudioCommand command = { .type = AUDIO_FADE_SONG };
+	push_audio_command(&command);
 }
 
 void set_volume(Uint8 musicVolume_, Uint8 sampleVolume_)  // FKA NortSong.setVol and Player.setVol
@@ -340,15 +518,16 @@ void set_volume(Uint8 musicVolume_, Uint8 sampleVolume_)  // FKA NortSong.setVol
 	if (audio_disabled)
 		return;
 
-	SDL_LockAudioDevice(audioDevice);
-
-	musicVolume = musicVolume_;
-	sampleVolume = sampleVolume_;
-
-	SDL_UnlockAudioDevice(audioDevice);
+	AudioCommand command =
+	{
+		.type = AUDIO_SET_VOLUME,
+		.musicVolume = musicVolume_,
+		.sampleVolume = sampleVolume_,
+	};
+	push_audio_command(&command);
 }
 
-void multiSamplePlay(const Sint16 *samples, size_t sampleCount, Uint8 chan, Uint8 vol)  // FKA Player.multiSamplePlay
+void multiSamplePlay(const Sint8 *samples, size_t sampleCount, Uint8 chan, Uint8 vol)  // FKA Player.multiSamplePlay
 {
 	assert(chan < CHANNEL_COUNT);
 	assert(vol < CHANNEL_VOLUME_LEVELS);
@@ -356,11 +535,267 @@ void multiSamplePlay(const Sint16 *samples, size_t sampleCount, Uint8 chan, Uint
 	if (audio_disabled || samples_disabled)
 		return;
 
-	SDL_LockAudioDevice(audioDevice);
+	AudioCommand command =
+	{
+		.type = AUDIO_PLAY_SAMPLE,
+		.samples = samples,
+		.sampleCount = sampleCount,
+		.chan = chan,
+		.vol = vol,
+	};
+	push_audio_command(&command);
+}
 
-	channelSamples[chan] = samples;
-	channelSampleCount[chan] = sampleCount;
-	channelVolume[chan] = vol;
+/** Queues a request for the audio callback, stamped with the current time.  Only the game thread
+ *  may call this. */
+static void push_audio_command(AudioCommand *command)
+{
+	command->ticks = SDL_GetPerformanceCounter();
+
+	const int head = SDL_AtomicGet(&audioCommandHead),
+	          next = (head + 1) % AUDIO_COMMAND_COUNT;
+
+	if (next == SDL_AtomicGet(&audioCommandTail))
+	{
+		// The callback has fallen far behind (or the device is paused), so do its work for it.
+		SDL_LockAudioDevice(audioDevice);
+		run_audio_commands();
+		SDL_UnlockAudioDevice(audioDevice);
+	}
+
+	audioCommands[head] = *command;
+
+	// publishes the command; SDL_AtomicSet is a full barrier
+	SDL_AtomicSet(&audioCommandHead, next);
+}
 
-	SDL_UnlockAudioDevice(audioDevice);
+/** Copies the oldest queued request, if there is one.  Only the callback (or the game thread while
+ *  it holds the device lock) may call this. */
+static bool peek_audio_command(AudioCommand *command)
+{
+	const int tail = SDL_AtomicGet(&audioCommandTail);
+
+	if (tail == SDL_AtomicGet(&audioCommandHead))
+		return false;
+
+	*command = audioCommands[tail];
+	return true;
+}
+
+static void pop_audio_command(void)
+{
+	const int tail = SDL_AtomicGet(&audioCommandTail);
+
+	SDL_AtomicSet(&audioCommandTail, (tail + 1) % AUDIO_COMMAND_COUNT);
+}
+
+static void run_audio_command(const AudioCommand *command)
+{
+	switch (command->type)
+	{
+	case AUDIO_PLAY_SAMPLE:
+		channelSamples[command->chan] = command->samples;
+		channelSampleCount[command->chan] = command->sampleCount;
+		channelPosition[command->chan] = 0;
+		channelPositionFrac[command->chan] = 0;
+		channelVolume[command->chan] = command->vol;
+		break;
+
+	case AUDIO_SET_VOLUME:
+		musicVolume = command->musicVolume;
+		sampleVolume = command->sampleVolume;
+		break;
+
+	case AUDIO_PLAY_SONG:
+		music_stopped = false;
+		break;
+
+	case AUDIO_STOP_SONG:
+		music_stopped = true;
+		break;
+
+	case AUDIO_RESTART_SONG:
+		lds_rewind();
+		music_stopped = false;
+		break;
+
+	case AUDIO_FADE_SONG:
+		lds_fade(1);
+		break;
+	}
+}
+
+/** Carries out every queued request at once. */
+static void run_audio_commands(void)
+{
+	AudioCommand command;
+	while (peek_audio_command(&command))
+	{
+		run_audio_command(&command);
+		pop_audio_command();
+	}
+}
+
+/** Renders songs and sound effects to WAV files in render_audio_dir without an audio device, as
+ *  fast as possible.  Returns false if any could not be written. */
+bool render_audio(bool xmas)
+{
+	init_mixer(SAMPLE_RATE * OUTPUT_QUALITY);
+
+	adlib_init_tables();
+	opl_init();
+
+	load_music();
+	loadSndFile(xmas);
+
+	if (render_audio_song > song_count)
+	{
+		fprintf(stderr, "error: there is no song %u\n", render_audio_song);
+		return false;
+	}
+
+	const Uint64 frequency = SDL_GetPerformanceFrequency();
+	// A WAV file cannot hold more than 4 GiB of samples.
+	const Uint32 maxSampleCount = (Uint32)MIN((Uint64)render_audio_seconds * (Uint64)audioSampleRate,
+	                                          (SDL_MAX_UINT32 - 36) / sizeof(Sint16));
+
+	Sint16 buffer[MIX_BLOCK * 16];
+	char name[32];
+
+	for (unsigned int song_num = 0; song_num < song_count; ++song_num)
+	{
+		if (render_audio_song != 0 && song_num + 1 != render_audio_song)
+			continue;
+
+		snprintf(name, sizeof(name), "song%02u.wav", song_num + 1);
+		FILE *f = open_wav(name);
+		if (f == NULL)
+			return false;
+
+		load_song(song_num);
+		music_stopped = false;
+		samplesUntilLdsUpdate = 0;
+		samplesUntilLdsUpdateFrac = 0;
+
+		const Uint64 start = SDL_GetPerformanceCounter();
+
+		// until the song ends or loops back
+		Uint32 sampleCount = 0;
+		while (playing && !songlooped && sampleCount < maxSampleCount)
+		{
+			const int count = MIN(COUNTOF(buffer), maxSampleCount - sampleCount);
+
+			mix_audio(buffer, count);
+			write_wav_samples(f, buffer, count);
+
+			sampleCount += count;
+		}
+
+		const Uint64 ticks = SDL_GetPerformanceCounter() - start;
+
+		close_wav(f, sampleCount);
+
+		printf("rendered %s: %.1f s in %.3f s\n", name,
+		       (double)sampleCount / audioSampleRate, (double)ticks / frequency);
+	}
+
+	// Sound effects are only rendered with all the songs.
+	if (render_audio_song == 0)
+	{
+		music_stopped = true;
+
+		for (unsigned int i = 0; i < SOUND_COUNT; ++i)
+		{
+			snprintf(name, sizeof(name), "sound%02u.wav", i + 1);
+			FILE *f = open_wav(name);
+			if (f == NULL)
+				return false;
+
+			channelSamples[0] = soundSamples[i];
+			channelSampleCount[0] = soundSampleCount[i];
+			channelPosition[0] = 0;
+			channelPositionFrac[0] = 0;
+			channelVolume[0] = CHANNEL_VOLUME_LEVELS - 1;
+
+			Uint32 sampleCount = 0;
+			while (channelSampleCount[0] > 0)
+			{
+				mix_audio(buffer, COUNTOF(buffer));
+				write_wav_samples(f, buffer, COUNTOF(buffer));
+
+				sampleCount += COUNTOF(buffer);
+			}
+
+			close_wav(f, sampleCount);
+		}
+
+		printf("rendered %d sounds\n", SOUND_COUNT);
+	}
+
+	lds_free();
+
+	return true;
+}
+
+static FILE *open_wav(const char *name)
+{
+	FILE *f = dir_fopen(render_audio_dir, name, "wb");
+	if (f == NULL)
+	{
+		fprintf(stderr, "error: failed to open '%s' in '%s' for writing\n", name, render_audio_dir);
+		return NULL;
+	}
+
+	// the sizes are filled in by close_wav
+	write_wav_header(f, 0);
+
+	return f;
+}
+
+static void write_wav_samples(FILE *f, Sint16 *samples, int count)
+{
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+	for (int i = 0; i < count; ++i)
+		samples[i] = SDL_Swap16(samples[i]);
+#endif
+
+	fwrite_die(samples, sizeof(Sint16), count, f);
+}
+
+static void close_wav(FILE *f, Uint32 sampleCount)
+{
+	fseek(f, 0, SEEK_SET);
+	write_wav_header(f, sampleCount);
+
+	fclose(f);
+}
+
+/** Writes the header of a mono 16-bit PCM WAV file at the current sample rate. */
+static void write_wav_header(FILE *f, Uint32 sampleCount)
+{
+	const Uint32 dataSize = sampleCount * sizeof(Sint16),
+	             riffSize = 36 + dataSize,
+	             formatSize = 16,
+	             sampleRate = audioSampleRate,
+	             byteRate = audioSampleRate * sizeof(Sint16);
+	const Uint16 format = 1,  // PCM
+	             channels = 1,
+	             blockAlign = sizeof(Sint16),
+	             bitsPerSample = 16;
+
+	fwrite_die("RIFF", 1, 4, f);
+	fwrite_u32_die(&riffSize, f);
+	fwrite_die("WAVE", 1, 4, f);
+
+	fwrite_die("fmt ", 1, 4, f);
+	fwrite_u32_die(&formatSize, f);
+	fwrite_u16_die(&format, f);
+	fwrite_u16_die(&channels, f);
+	fwrite_u32_die(&sampleRate, f);
+	fwrite_u32_die(&byteRate, f);
+	fwrite_u16_die(&blockAlign, f);
+	fwrite_u16_die(&bitsPerSample, f);
+
+	fwrite_die("data", 1, 4, f);
+	fwrite_u32_die(&dataSize, f);
 }
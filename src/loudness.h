@@ -30,6 +30,10 @@ extern unsigned int song_playing;
 
 extern bool audio_disabled, music_disabled, samples_disabled;
 
+extern const char *render_audio_dir;
+extern unsigned int render_audio_song;
+extern unsigned int render_audio_seconds;
+
 bool init_audio(void);
 void deinit_audio(void);
 
@@ -41,6 +45,8 @@ void fade_song(void);
 
 void set_volume(Uint8 musicVolume, Uint8 sampleVolume);
 
-void multiSamplePlay(const Sint16 *samples, size_t sampleCount, Uint8 chan, Uint8 vol);
+void multiSamplePlay(const Sint8 *samples, size_t sampleCount, Uint8 chan, Uint8 vol);
+
+bool render_audio(bool xmas);
 
 #endif /* LOUDNESS_H */
@@ -21,20 +21,302 @@
 #include "file.h"
 #include "opentyr.h"
 
+#include "SDL.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const AssetFile *open_level_asset(const char *file, bool die);
+static bool load_level_data(LevelData *level, const char *file, JE_longint pos, bool die);
+static int preload_thread_main(void *data);
+static void wait_for_preload(void);
+
 JE_LvlPosType lvlPos;
 
 char levelFile[13]; /* string [12] */
 JE_word lvlNum;
 
+// Only one level is loaded ahead, while the item screen is up.
+static LevelData staged_level;
+static bool staged_level_loaded = false;
+static SDL_Thread *preload_thread = NULL;
+
+// The enemy shape banks of the level being played are handed out of one arena while the next
+// level preloads into the other.
+static Arena level_arenas[2];
+static Arena *installed_level_arena = NULL;
+
 void JE_analyzeLevel(void)
 {
-	FILE *f = dir_fopen_die(data_dir(), levelFile, "rb");
+	const AssetFile *level_file = asset_open_die(levelFile);
+	AssetReader reader = asset_reader(level_file);
 	
-	fread_u16_die(&lvlNum, 1, f);
+	asset_read_u16_die(&lvlNum, 1, &reader);
 
-	fread_s32_die(lvlPos, lvlNum, f);
+	asset_read_s32_die(lvlPos, lvlNum, &reader);
 	
-	lvlPos[lvlNum] = ftell_eof(f);
-	
-	fclose(f);
+	lvlPos[lvlNum] = level_file->size;
+}
+
+// starts loading a level in the background, so that finish_level_load() need not wait for it
+void preload_level(const char *file, JE_longint pos)
+{
+	wait_for_preload();
+
+	if (staged_level_loaded && strcmp(staged_level.file, file) == 0 && staged_level.pos == pos)
+		return;
+
+	staged_level_loaded = false;
+	SDL_strlcpy(staged_level.file, file, sizeof(staged_level.file));
+	staged_level.pos = pos;
+
+	preload_thread = SDL_CreateThread(preload_thread_main, "preload", NULL);
+	if (preload_thread == NULL)
+		fprintf(stderr, "warning: failed to create level preload thread: %s\n", SDL_GetError());
+}
+
+// returns the level, loading it now unless it was preloaded
+const LevelData *finish_level_load(const char *file, JE_longint pos)
+{
+	wait_for_preload();
+
+	// A preload that failed is done again here, where the problem can be reported.
+	if (!staged_level_loaded || staged_level.load_failed || strcmp(staged_level.file, file) != 0 || staged_level.pos != pos)
+	{
+		SDL_strlcpy(staged_level.file, file, sizeof(staged_level.file));
+		staged_level.pos = pos;
+
+		load_level_data(&staged_level, file, pos, true);
+		staged_level.load_failed = false;
+		staged_level_loaded = true;
+	}
+
+	installed_level_arena = staged_level.arena;
+
+	return &staged_level;
+}
+
+// hands over an enemy shape bank that was loaded with the level, if there is one
+bool take_preloaded_enemy_shapes(Sprite2_array *sprite2s, unsigned int id)
+{
+	if (!staged_level_loaded || staged_level.load_failed || id < 1 || id > COUNTOF(staged_level.enemySpriteSheets))
+		return false;
+
+	Sprite2_array *preloaded = &staged_level.enemySpriteSheets[id - 1];
+	if (preloaded->data == NULL)
+		return false;
+
+	free_sprite2s(sprite2s);
+	*sprite2s = *preloaded;
+	memset(preloaded, 0, sizeof(*preloaded));
+
+	return true;
+}
+
+static int preload_thread_main(void *data)
+{
+	(void)data;
+
+	staged_level.load_failed = !load_level_data(&staged_level, staged_level.file, staged_level.pos, false);
+
+	return 0;
+}
+
+static void wait_for_preload(void)
+{
+	if (preload_thread == NULL)
+		return;
+
+	SDL_WaitThread(preload_thread, NULL);
+	preload_thread = NULL;
+
+	staged_level_loaded = true;
+}
+
+// Opens a data file for load_level_data(), which must not exit when it runs on the preload thread.
+static const AssetFile *open_level_asset(const char *file, bool die)
+{
+	return die ? asset_open_die(file) : asset_open(file);
+}
+
+// Reads a level into level.  If die, problems with the data files are reported and the game exits,
+// as elsewhere; otherwise, as on the preload thread, they only make it return false.
+static bool load_level_data(LevelData *level, const char *file, JE_longint pos, bool die)
+{
+	const AssetFile *const level_file = open_level_asset(file, die);
+	if (level_file == NULL)
+		return false;
+
+	AssetReader level_reader = asset_reader(level_file);
+	if (!asset_seek(&level_reader, pos))
+		goto read_error;
+
+	JE_byte map_file, char_shapeFile;
+	if (!asset_read_u8(&map_file, 1, &level_reader) ||  // unused
+	    !asset_read_u8(&char_shapeFile, 1, &level_reader) ||
+	    !asset_read_u16(&level->mapX,  1, &level_reader) ||
+	    !asset_read_u16(&level->mapX2, 1, &level_reader) ||
+	    !asset_read_u16(&level->mapX3, 1, &level_reader))
+		goto read_error;
+
+	if (!asset_read_u16(&level->enemyCount, 1, &level_reader))
+		goto read_error;
+	if (level->enemyCount > COUNTOF(level->enemies))
+		goto bad_data;
+	if (!asset_read_u16(level->enemies, level->enemyCount, &level_reader))
+		goto read_error;
+
+	if (!asset_read_u16(&level->eventCount, 1, &level_reader))
+		goto read_error;
+	if (level->eventCount >= COUNTOF(level->events))
+		goto bad_data;
+	for (unsigned int x = 0; x < level->eventCount; x++)
+	{
+		struct JE_EventRecType *event = &level->events[x];
+
+		if (!asset_read_u16(&event->eventtime, 1, &level_reader) ||
+		    !asset_read_u8( &event->eventtype, 1, &level_reader) ||
+		    !asset_read_s16(&event->eventdat,  1, &level_reader) ||
+		    !asset_read_s16(&event->eventdat2, 1, &level_reader) ||
+		    !asset_read_s8( &event->eventdat3, 1, &level_reader) ||
+		    !asset_read_s8( &event->eventdat5, 1, &level_reader) ||
+		    !asset_read_s8( &event->eventdat6, 1, &level_reader) ||
+		    !asset_read_u8( &event->eventdat4, 1, &level_reader))
+			goto read_error;
+	}
+	level->events[level->eventCount].eventtime = 65500;  /*Not needed but just in case*/
+
+	/* MAP SHAPE LOOKUP TABLE - Each map is directly after level */
+	JE_word mapSh[3][128]; /* [1..3, 0..127] */
+	for (int i = 0; i < 3; i++)
+	{
+		if (!asset_read_u16(mapSh[i], COUNTOF(mapSh[i]), &level_reader))
+			goto read_error;
+		for (int j = 0; j < 128; j++)
+		{
+			mapSh[i][j] = SDL_Swap16(mapSh[i][j]);
+		}
+	}
+
+	/* Read Shapes.DAT */
+	char shapes_file[13];
+	snprintf(shapes_file, sizeof(shapes_file), "shapes%c.dat", tolower((unsigned char)char_shapeFile));
+	const AssetFile *const shape_file = open_level_asset(shapes_file, die);
+	if (shape_file == NULL)
+		return false;
+	AssetReader shape_reader = asset_reader(shape_file);
+
+	// map cell values for each of the 128 entries of mapSh; shapes that several entries share
+	// are only stored once in the map's tiles
+	JE_byte ref[3][128] = { { 0 } }; /* [1..3, 0..127] */
+
+	JE_DanCShape *const tiles[3] = { level->megaData1.tiles, level->megaData2.tiles, level->megaData3.tiles };
+	JE_byte *const tileCount[3] = { &level->megaData1.tileCount, &level->megaData2.tileCount, &level->megaData3.tileCount };
+	const int shapeCount[3] = { 72, 71, 70 };
+
+	for (int i = 0; i < 3; i++)
+		*tileCount[i] = 0;
+
+	for (int z = 0; z < 600; z++)
+	{
+		JE_boolean shapeBlank;
+		if (!asset_read_bool(&shapeBlank, &shape_reader))
+			goto read_error;
+
+		// blank shapes draw nothing, so they are left out of the maps
+		if (shapeBlank)
+			continue;
+
+		const JE_byte *shape = asset_read(&shape_reader, sizeof(JE_DanCShape));
+		if (shape == NULL)
+			goto read_error;
+
+		for (int i = 0; i < 3; i++)
+		{
+			JE_byte tile = 0;
+
+			for (int x = 0; x < shapeCount[i]; ++x)
+			{
+				if (mapSh[i][x] != z+1)
+					continue;
+
+				if (tile == 0)
+				{
+					memcpy(tiles[i][*tileCount[i]], shape, sizeof(JE_DanCShape));
+					tile = ++*tileCount[i];
+				}
+				ref[i][x] = tile;
+			}
+		}
+	}
+
+	const JE_byte *mapBuf = asset_read(&level_reader, 14 * 300);
+	if (mapBuf == NULL)
+		goto read_error;
+	for (int y = 0; y < 300; y++)  /* MAP NUMBER 1 */
+		for (int x = 0; x < 14; x++)
+			level->megaData1.mainmap[y][x] = ref[0][*mapBuf++];
+
+	mapBuf = asset_read(&level_reader, 14 * 600);
+	if (mapBuf == NULL)
+		goto read_error;
+	for (int y = 0; y < 600; y++)  /* MAP NUMBER 2 */
+		for (int x = 0; x < 14; x++)
+			level->megaData2.mainmap[y][x] = ref[1][*mapBuf++];
+
+	mapBuf = asset_read(&level_reader, 15 * 600);
+	if (mapBuf == NULL)
+		goto read_error;
+	for (int y = 0; y < 600; y++)  /* MAP NUMBER 3 */
+		for (int x = 0; x < 15; x++)
+			level->megaData3.mainmap[y][x] = ref[2][*mapBuf++];
+
+	// enemy shape banks the events will ask for, so that there is no load in the middle of the level
+	for (unsigned int i = 0; i < COUNTOF(level->enemySpriteSheets); ++i)
+		free_sprite2s(&level->enemySpriteSheets[i]);
+
+	level->arena = installed_level_arena == &level_arenas[0] ? &level_arenas[1] : &level_arenas[0];
+	arena_reset(level->arena);
+
+	for (unsigned int x = 0; x < level->eventCount; x++)
+	{
+		const struct JE_EventRecType *event = &level->events[x];
+		if (event->eventtype != 5)  // load enemy shape banks
+			continue;
+
+		const int ids[] = { event->eventdat, event->eventdat2, event->eventdat3, event->eventdat4 };
+		for (unsigned int i = 0; i < COUNTOF(ids); ++i)
+		{
+			if (ids[i] > 0 && ids[i] <= (int)COUNTOF(shapeFile) && level->enemySpriteSheets[ids[i] - 1].data == NULL)
+			{
+				char sheet_file[13];
+				snprintf(sheet_file, sizeof(sheet_file), "newsh%c.shp", tolower((unsigned char)shapeFile[ids[i] - 1]));
+				const AssetFile *const sheet = open_level_asset(sheet_file, die);
+				if (sheet == NULL)
+					return false;
+
+				load_comp_shapes(&level->enemySpriteSheets[ids[i] - 1], sheet, level->arena);
+			}
+		}
+	}
+
+	return true;
+
+read_error:
+	if (!die)
+		return false;
+
+	fprintf(stderr, "error: An unexpected problem occurred while reading from a file.\n");
+	SDL_Quit();
+	exit(EXIT_FAILURE);
+
+bad_data:
+	if (!die)
+		return false;
+
+	fprintf(stderr, "error: Unexpected data was read from a file.\n");
+	SDL_Quit();
+	exit(EXIT_FAILURE);
 }
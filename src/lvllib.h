@@ -19,14 +19,47 @@
 #ifndef LVLLIB_H
 #define LVLLIB_H
 
+#include "lvlmast.h"
 #include "opentyr.h"
+#include "sprite.h"
+#include "varz.h"
 
 typedef JE_longint JE_LvlPosType[43]; /* [1..42 + 1] */
 
+// A level as JE_loadMap reads it from a level file, ready to be installed.
+typedef struct
+{
+	char file[13];
+	JE_longint pos;
+
+	JE_word mapX, mapX2, mapX3;
+
+	JE_word enemyCount;
+	JE_word enemies[40];
+
+	JE_word eventCount;
+	struct JE_EventRecType events[EVENT_MAXIMUM];
+
+	// The maps index their own tiles, so these are installed by copying them as they are.
+	struct JE_MegaDataType1 megaData1;
+	struct JE_MegaDataType2 megaData2;
+	struct JE_MegaDataType3 megaData3;
+
+	// enemy shape banks loaded by the level's events, by shape table id - 1
+	Sprite2_array enemySpriteSheets[36];
+	Arena *arena;  // owns the enemy shape banks
+
+	bool load_failed;  // on the preload thread, which leaves reporting it to finish_level_load()
+} LevelData;
+
 extern JE_LvlPosType lvlPos;
 extern char levelFile[13]; /* string [12] */
 extern JE_word lvlNum;
 
 void JE_analyzeLevel(void);
 
+void preload_level(const char *file, JE_longint pos);
+const LevelData *finish_level_load(const char *file, JE_longint pos);
+bool take_preloaded_enemy_shapes(Sprite2_array *sprite2s, unsigned int id);
+
 #endif /* LVLLIB_H */
@@ -160,7 +160,7 @@ void JE_outCharGlow(JE_word x, JE_word y, const char *s)
 					if (levelWarningDisplay)
 						JE_updateWarning(VGAScreen);
 
-					SDL_Delay(16);
+					sleep_ticks(16);
 				} while (!(getDelayTicks() == 0 || ESCPressed));
 
 				JE_showVGA();
@@ -263,7 +263,7 @@ void JE_helpSystem(JE_byte startTopic)
 		bool mouseMoved = false;
 		do
 		{
-			SDL_Delay(16);
+			sleep_ticks(16);
 
 			Uint16 oldMouseX = mouse_x;
 			Uint16 oldMouseY = mouse_y;
@@ -501,7 +501,7 @@ static bool helpSystemPage(Uint8 *topic, bool *restart)
 			JE_showVGA();
 			JE_mouseReplace();
 
-			SDL_Delay(16);
+			sleep_ticks(16);
 
 			push_joysticks_as_keyboard();
 			service_SDL_events(false);
@@ -736,7 +736,7 @@ bool JE_loadScreen(void)
 		bool mouseMoved = false;
 		do
 		{
-			SDL_Delay(16);
+			sleep_ticks(16);
 
 			Uint16 oldMouseX = mouse_x;
 			Uint16 oldMouseY = mouse_y;
@@ -1032,7 +1032,7 @@ void JE_nextEpisode(void)
 		{
 			NETWORK_KEEP_ALIVE();
 
-			SDL_Delay(16);
+			sleep_ticks(16);
 		} while (!JE_anyButton());
 	}
 
@@ -1245,7 +1245,7 @@ void JE_highScoreScreen(void)
 			JE_showVGA();
 			JE_mouseReplace();
 
-			SDL_Delay(16);
+			sleep_ticks(16);
 
 			push_joysticks_as_keyboard();
 			service_SDL_events(false);
@@ -1411,7 +1411,7 @@ void JE_doInGameSetup(void)
 			network_update();
 			network_check();
 
-			SDL_Delay(16);
+			sleep_ticks(16);
 		}
 	}
 #endif
@@ -1482,7 +1482,7 @@ void JE_doInGameSetup(void)
 				network_update();
 				network_check();
 
-				SDL_Delay(16);
+				sleep_ticks(16);
 			}
 		}
 		else
@@ -1501,7 +1501,7 @@ void JE_doInGameSetup(void)
 			service_SDL_events(false);
 
 			network_check();
-			SDL_Delay(16);
+			sleep_ticks(16);
 		}
 
 		VGAScreen = temp_surface; /* side-effect of game_screen */
@@ -1622,7 +1622,7 @@ JE_boolean JE_inGameSetup(void)
 		bool mouseMoved = false;
 		do
 		{
-			SDL_Delay(16);
+			sleep_ticks(16);
 
 			Uint16 oldMouseX = mouse_x;
 			Uint16 oldMouseY = mouse_y;
@@ -2006,7 +2006,7 @@ void JE_inGameHelp(void)
 		JE_showVGA();
 		JE_mouseReplace();
 
-		SDL_Delay(16);
+		sleep_ticks(16);
 
 		push_joysticks_as_keyboard();
 		service_SDL_events(false);
@@ -3312,8 +3312,8 @@ void JE_mainKeyboardInput(void)
 		debugHist = 1;
 		debugHistCount = 1;
 
-		/* YKS: clock ticks since midnight replaced by SDL_GetTicks */
-		lastDebugTime = SDL_GetTicks();
+		/* YKS: clock ticks since midnight replaced by get_ticks */
+		lastDebugTime = get_ticks();
 	}
 
 	/* {CHEAT-SKIP LEVEL} */
@@ -3428,7 +3428,7 @@ void JE_pauseGame(void)
 			network_update();
 			network_check();
 
-			SDL_Delay(16);
+			sleep_ticks(16);
 		}
 	}
 #endif
@@ -3480,7 +3480,7 @@ void JE_pauseGame(void)
 			service_SDL_events(false);
 
 			network_check();
-			SDL_Delay(16);
+			sleep_ticks(16);
 		}
 	}
 #endif
@@ -4731,13 +4731,13 @@ void JE_playerCollide(Player *this_player, JE_byte playerNum_)
 {
 	char tempStr[256];
 
-	for (int z = 0; z < 100; z++)
+	for (int z = next_enemy_in_use(0, 100); z < 100; z = next_enemy_in_use(z + 1, 100))
 	{
 		if (enemyAvail[z] != 1)
 		{
-			int enemy_screen_x = enemy[z].ex + enemy[z].mapoffset;
+			int enemy_screen_x = enemyHot.ex[z] + enemyHot.mapoffset[z];
 
-			if (abs(this_player->x - enemy_screen_x) < 12 && abs(this_player->y - enemy[z].ey) < 14)
+			if (abs(this_player->x - enemy_screen_x) < 12 && abs(this_player->y - enemyHot.ey[z]) < 14)
 			{   /*Collide*/
 				int evalue = enemy[z].evalue;
 				if (evalue > 29999)
@@ -4761,7 +4761,7 @@ void JE_playerCollide(Player *this_player, JE_byte playerNum_)
 							player[1].armor = 10;
 							player[1].is_alive = true;
 						}
-						enemyAvail[z] = 1;
+						set_enemy_avail(z, 1);
 						soundQueue[7] = S_POWERUP;
 					}
 					else if (superArcadeMode != SA_NONE && evalue > 30000)
@@ -4786,7 +4786,7 @@ void JE_playerCollide(Player *this_player, JE_byte playerNum_)
 						player[0].items.weapon[FRONT_WEAPON].id = tempW;
 						this_player->cash += 200;
 						soundQueue[7] = S_POWERUP;
-						enemyAvail[z] = 1;
+						set_enemy_avail(z, 1);
 					}
 					else if (evalue > 32100)
 					{
@@ -4807,14 +4807,14 @@ void JE_playerCollide(Player *this_player, JE_byte playerNum_)
 								snprintf(tempStr, sizeof(tempStr), "%s %s", miscText[64-1], special[evalue - 32100].name);
 							JE_drawTextWindow(tempStr);
 							soundQueue[7] = S_POWERUP;
-							enemyAvail[z] = 1;
+							set_enemy_avail(z, 1);
 						}
 					}
 					else if (evalue > 32000)
 					{
 						if (playerNum_ == 2)
 						{
-							enemyAvail[z] = 1;
+							set_enemy_avail(z, 1);
 							if (isNetworkGame)
 								snprintf(tempStr, sizeof(tempStr), "%s %s %s", JE_getName(2), miscTextB[4-1], options[evalue - 32000].name);
 							else
@@ -4843,7 +4843,7 @@ void JE_playerCollide(Player *this_player, JE_byte playerNum_)
 						}
 						else if (onePlayerAction)
 						{
-							enemyAvail[z] = 1;
+							set_enemy_avail(z, 1);
 							snprintf(tempStr, sizeof(tempStr), "%s %s", miscText[64-1], options[evalue - 32000].name);
 							JE_drawTextWindow(tempStr);
 
@@ -4870,7 +4870,7 @@ void JE_playerCollide(Player *this_player, JE_byte playerNum_)
 							JE_drawTextWindow(tempStr);
 							player[1].items.weapon[REAR_WEAPON].id = evalue - 31000;
 							shotMultiPos[SHOT_REAR] = 0;
-							enemyAvail[z] = 1;
+							set_enemy_avail(z, 1);
 							soundQueue[7] = S_POWERUP;
 						}
 						else if (onePlayerAction)
@@ -4879,7 +4879,7 @@ void JE_playerCollide(Player *this_player, JE_byte playerNum_)
 							JE_drawTextWindow(tempStr);
 							player[0].items.weapon[REAR_WEAPON].id = evalue - 31000;
 							shotMultiPos[SHOT_REAR] = 0;
-							enemyAvail[z] = 1;
+							set_enemy_avail(z, 1);
 							soundQueue[7] = S_POWERUP;
 
 							if (player[0].items.weapon[REAR_WEAPON].power == 0)  // does this ever happen?
@@ -4897,7 +4897,7 @@ void JE_playerCollide(Player *this_player, JE_byte playerNum_)
 							JE_drawTextWindow(tempStr);
 							player[0].items.weapon[FRONT_WEAPON].id = evalue - 30000;
 							shotMultiPos[SHOT_FRONT] = 0;
-							enemyAvail[z] = 1;
+							set_enemy_avail(z, 1);
 							soundQueue[7] = S_POWERUP;
 						}
 						else if (onePlayerAction)
@@ -4906,7 +4906,7 @@ void JE_playerCollide(Player *this_player, JE_byte playerNum_)
 							JE_drawTextWindow(tempStr);
 							player[0].items.weapon[FRONT_WEAPON].id = evalue - 30000;
 							shotMultiPos[SHOT_FRONT] = 0;
-							enemyAvail[z] = 1;
+							set_enemy_avail(z, 1);
 							soundQueue[7] = S_POWERUP;
 						}
 
@@ -4943,7 +4943,7 @@ void JE_playerCollide(Player *this_player, JE_byte playerNum_)
 						if (this_player->armor > 28)
 							this_player->armor = 28;
 					}
-					enemyAvail[z] = 1;
+					set_enemy_avail(z, 1);
 					VGAScreen = VGAScreenSeg; /* side-effect of game_screen */
 					JE_drawArmor();
 					VGAScreen = game_screen; /* side-effect of game_screen */
@@ -4956,13 +4956,13 @@ void JE_playerCollide(Player *this_player, JE_byte playerNum_)
 						play_song(30);  /*Zanac*/
 						bonusLevel = true;
 						nextLevel = evalue - 10000;
-						enemyAvail[z] = 1;
+						set_enemy_avail(z, 1);
 						displayTime = 150;
 					}
 				}
 				else if (enemy[z].scoreitem)
 				{
-					enemyAvail[z] = 1;
+					set_enemy_avail(z, 1);
 					soundQueue[7] = S_ITEM;
 					if (evalue == 1)
 					{
@@ -5000,7 +5000,7 @@ void JE_playerCollide(Player *this_player, JE_byte playerNum_)
 						// picked up orbiting asteroid killer
 						shotMultiPos[SHOT_MISC] = 0;
 						b = player_shot_create(0, SHOT_MISC, this_player->x, this_player->y, mouseX, mouseY, 104, playerNum_);
-						shotAvail[z] = 0;
+						set_shot_avail(z, 0);
 					}
 					else if (evalue == -4)
 					{
@@ -5030,7 +5030,7 @@ void JE_playerCollide(Player *this_player, JE_byte playerNum_)
 					{
 						this_player->cash += evalue;
 					}
-					JE_setupExplosion(enemy_screen_x, enemy[z].ey, 0, enemyDat[enemy[z].enemytype].explosiontype, true, false);
+					JE_setupExplosion(enemy_screen_x, enemyHot.ey[z], 0, enemyDat[enemy[z].enemytype].explosiontype, true, false);
 				}
 				else if (this_player->invulnerable_ticks == 0 && enemyAvail[z] == 0 &&
 				         (enemyDat[enemy[z].enemytype].explosiontype & 1) == 0) // explosiontype & 1 == 0: not ground enemy
@@ -5044,15 +5044,15 @@ void JE_playerCollide(Player *this_player, JE_byte playerNum_)
 					// player ship gets push-back from collision
 					if (enemy[z].armorleft > 0)
 					{
-						this_player->x_velocity += (enemy[z].exc * enemy[z].armorleft) / 2;
-						this_player->y_velocity += (enemy[z].eyc * enemy[z].armorleft) / 2;
+						this_player->x_velocity += (enemyHot.exc[z] * enemy[z].armorleft) / 2;
+						this_player->y_velocity += (enemyHot.eyc[z] * enemy[z].armorleft) / 2;
 					}
 
 					int armorleft2 = enemy[z].armorleft;
 					if (armorleft2 == 255)
 						armorleft2 = 30000;
 
-					temp = enemy[z].linknum;
+					temp = enemyHot.linknum[z];
 					if (temp == 0)
 						temp = 255;
 
@@ -5072,32 +5072,32 @@ void JE_playerCollide(Player *this_player, JE_byte playerNum_)
 						{
 							if (enemyAvail[temp2] != 1)
 							{
-								temp3 = enemy[temp2].linknum;
+								temp3 = enemyHot.linknum[temp2];
 								if (temp2 == b ||
 									(temp != 255 &&
 									 (temp == temp3 || temp - 100 == temp3 ||
 									  (temp3 > 40 && temp3 / 20 == temp / 20 && temp3 <= temp))))
 								{
-									int enemy_screen_x = enemy[temp2].ex + enemy[temp2].mapoffset;
+									int enemy_screen_x = enemyHot.ex[temp2] + enemyHot.mapoffset[temp2];
 
-									enemy[temp2].linknum = 0;
+									enemyHot.linknum[temp2] = 0;
 
-									enemyAvail[temp2] = 1;
+									set_enemy_avail(temp2, 1);
 
 									if (enemyDat[enemy[temp2].enemytype].esize == 1)
 									{
-										JE_setupExplosionLarge(enemy[temp2].enemyground, enemy[temp2].explonum, enemy_screen_x, enemy[temp2].ey);
+										JE_setupExplosionLarge(enemy[temp2].enemyground, enemy[temp2].explonum, enemy_screen_x, enemyHot.ey[temp2]);
 										soundQueue[6] = S_EXPLOSION_9;
 									}
 									else
 									{
-										JE_setupExplosion(enemy_screen_x, enemy[temp2].ey, 0, 1, false, false);
+										JE_setupExplosion(enemy_screen_x, enemyHot.ey[temp2], 0, 1, false, false);
 										soundQueue[5] = S_EXPLOSION_4;
 									}
 								}
 							}
 						}
-						enemyAvail[z] = 1;
+						set_enemy_avail(z, 1);
 					}
 				}
 			}
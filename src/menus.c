@@ -111,7 +111,7 @@ bool gameplaySelect(void)
 		bool mouseMoved = false;
 		do
 		{
-			SDL_Delay(16);
+			sleep_ticks(16);
 
 			Uint16 oldMouseX = mouse_x;
 			Uint16 oldMouseY = mouse_y;
@@ -307,7 +307,7 @@ bool episodeSelect(void)
 		bool mouseMoved = false;
 		do
 		{
-			SDL_Delay(16);
+			sleep_ticks(16);
 
 			Uint16 oldMouseX = mouse_x;
 			Uint16 oldMouseY = mouse_y;
@@ -495,7 +495,7 @@ bool difficultySelect(void)
 		bool mouseMoved = false;
 		do
 		{
-			SDL_Delay(16);
+			sleep_ticks(16);
 
 			Uint16 oldMouseX = mouse_x;
 			Uint16 oldMouseY = mouse_y;
@@ -737,7 +737,7 @@ bool timedBattleSelect(void)
 		bool mouseMoved = false;
 		do
 		{
-			SDL_Delay(16);
+			sleep_ticks(16);
 
 			Uint16 oldMouseX = mouse_x;
 			Uint16 oldMouseY = mouse_y;
@@ -27,12 +27,13 @@
 #include "params.h"
 #include "sndmast.h"
 #include "vga256d.h"
+#include "video.h"
 
 #include "SDL.h"
 
 JE_word frameCountMax;
 
-Sint16 *soundSamples[SOUND_COUNT] = { NULL }; /* [1..soundnum + 9] */  // FKA digiFx
+const Sint8 *soundSamples[SOUND_COUNT] = { NULL }; /* [1..soundnum + 9] */  // FKA digiFx
 size_t soundSampleCount[SOUND_COUNT] = { 0 }; /* [1..soundnum + 9] */  // FKA fxSize
 
 JE_word tyrMusicVolume, fxVolume;
@@ -48,33 +49,93 @@ static float delayPeriod = 0x4300 * ((12.0f / 14318180.0f) * 1000.0f);
 static Uint32 target = 0;
 static Uint32 target2 = 0;
 
+// Outside headless mode, the delays are kept on the performance counter instead, which is much
+// finer than SDL_GetTicks().
+static Uint64 counterFrequency = 0;
+static Uint64 targetCounter = 0;
+static Uint64 target2Counter = 0;
+
+// Sleeping can overshoot by about a millisecond, so the end of each wait is spun instead.
+#define SPIN_MICROSECONDS 2000
+
+bool frame_pacing_stats = false;
+
+// Frame times, from the end of one frame's wait to the end of the next, in 0.1 ms buckets.  The
+// last bucket also counts everything longer.
+#define FRAME_TIME_BUCKETS 500
+static Uint32 frameTimeHistogram[FRAME_TIME_BUCKETS];
+static Uint64 lastFrameCounter = 0;
+
+// When headless, time only passes when the game waits, so the simulation runs as fast as the CPU
+// allows while still seeing the same sequence of tick values on every run.
+static Uint32 headless_ticks = 0;
+
+static Uint64 next_target(Uint64 previous, int delay);
+static Uint32 counter_to_ticks(Uint64 counter);
+static void wait_until(Uint64 until);
+static void record_frame_time(void);
+
+/** Milliseconds since startup, or simulated milliseconds when headless.  Use instead of SDL_GetTicks() in game code. */
+Uint32 get_ticks(void)
+{
+	return headless ? headless_ticks : SDL_GetTicks();
+}
+
+/** Waits for the given number of milliseconds.  Use instead of SDL_Delay() in game code. */
+void sleep_ticks(Uint32 ticks)
+{
+	if (headless)
+		headless_ticks += ticks;
+	else
+		SDL_Delay(ticks);
+}
+
 void setDelay(int delay)  // FKA NortSong.frameCount
 {
-	target = SDL_GetTicks() + delay * delayPeriod;
+	if (headless)
+		target = get_ticks() + delay * delayPeriod;
+	else
+		targetCounter = next_target(targetCounter, delay);
 }
 
 void setDelay2(int delay)  // FKA NortSong.frameCount2
 {
-	target2 = SDL_GetTicks() + delay * delayPeriod;
+	if (headless)
+		target2 = get_ticks() + delay * delayPeriod;
+	else
+		target2Counter = next_target(target2Counter, delay);
 }
 
 Uint32 getDelayTicks(void)  // FKA NortSong.frameCount
 {
-	Sint32 delay = target - SDL_GetTicks();
+	if (!headless)
+		return counter_to_ticks(targetCounter);
+
+	Sint32 delay = target - get_ticks();
 	return MAX(0, delay);
 }
 
 Uint32 getDelayTicks2(void)  // FKA NortSong.frameCount2
 {
-	Sint32 delay = target2 - SDL_GetTicks();
+	if (!headless)
+		return counter_to_ticks(target2Counter);
+
+	Sint32 delay = target2 - get_ticks();
 	return MAX(0, delay);
 }
 
 void wait_delay(void)
 {
-	Sint32 delay = target - SDL_GetTicks();
+	if (!headless)
+	{
+		wait_until(targetCounter);
+		record_frame_time();
+		return;
+	}
+
+	Sint32 delay = target - get_ticks();
 	if (delay > 0)
-		SDL_Delay(delay);
+		sleep_ticks(delay);
 }
 
 void service_wait_delay(void)
@@ -83,11 +144,120 @@ void service_wait_delay(void)
 	{
 		service_SDL_events(false);
 
-		Sint32 delay = target - SDL_GetTicks();
+		if (!headless)
+		{
+			// sleep in polling intervals, then finish precisely
+			if (counter_to_ticks(targetCounter) <= SDL_POLL_INTERVAL + SPIN_MICROSECONDS / 1000)
+			{
+				wait_until(targetCounter);
+				record_frame_time();
+				return;
+			}
+
+			SDL_Delay(SDL_POLL_INTERVAL);
+			continue;
+		}
+
+		Sint32 delay = target - get_ticks();
 		if (delay <= 0)
 			return;
 
-		SDL_Delay(MIN(delay, SDL_POLL_INTERVAL));
+		sleep_ticks(MIN(delay, SDL_POLL_INTERVAL));
+	}
+}
+
+/** Returns when the next wait of delay frames should end. */
+static Uint64 next_target(Uint64 previous, int delay)
+{
+	if (counterFrequency == 0)
+		counterFrequency = SDL_GetPerformanceFrequency();
+
+	const Uint64 now = SDL_GetPerformanceCounter(),
+	             length = (Uint64)(delay * (double)delayPeriod * counterFrequency / 1000);
+
+	// Carry on from the last target if it was only just reached, so that the time between the end
+	// of one wait and the start of the next does not pile up into drift.  After a stall, start over.
+	if (previous != 0 && now >= previous && now - previous < length)
+		return previous + length;
+
+	return now + length;
+}
+
+/** Returns the milliseconds left until the given performance counter value. */
+static Uint32 counter_to_ticks(Uint64 counter)
+{
+	const Uint64 now = SDL_GetPerformanceCounter();
+
+	if (counter <= now || counterFrequency == 0)
+		return 0;
+
+	return (Uint32)((counter - now) * 1000 / counterFrequency);
+}
+
+/** Sleeps until shortly before the given performance counter value, then spins until it. */
+static void wait_until(Uint64 until)
+{
+	if (counterFrequency == 0)
+		return;
+
+	for (; ; )
+	{
+		const Uint64 now = SDL_GetPerformanceCounter();
+		if (now >= until)
+			return;
+
+		const Uint64 microseconds = (until - now) * 1000000 / counterFrequency;
+		if (microseconds > SPIN_MICROSECONDS + 1000)
+			SDL_Delay((Uint32)((microseconds - SPIN_MICROSECONDS) / 1000));
+	}
+}
+
+static void record_frame_time(void)
+{
+	if (!frame_pacing_stats)
+		return;
+
+	const Uint64 now = SDL_GetPerformanceCounter();
+
+	if (lastFrameCounter != 0)
+	{
+		const Uint64 bucket = (now - lastFrameCounter) * 10000 / counterFrequency;
+		++frameTimeHistogram[MIN(bucket, FRAME_TIME_BUCKETS - 1)];
+	}
+
+	lastFrameCounter = now;
+}
+
+/** Prints the distribution of frame times recorded by wait_delay() and service_wait_delay(). */
+void print_frame_pacing_stats(void)
+{
+	Uint32 count = 0;
+	for (int i = 0; i < FRAME_TIME_BUCKETS; ++i)
+		count += frameTimeHistogram[i];
+
+	if (count == 0)
+		return;
+
+	// the buckets the given fractions of frames fall into
+	const double fractions[] = { 0.01, 0.5, 0.99 };
+	int percentiles[COUNTOF(fractions)];
+	Uint32 seen = 0;
+	unsigned int next = 0;
+	for (int i = 0; i < FRAME_TIME_BUCKETS && next < COUNTOF(fractions); ++i)
+	{
+		seen += frameTimeHistogram[i];
+		while (next < COUNTOF(fractions) && seen >= fractions[next] * count)
+			percentiles[next++] = i;
+	}
+
+	printf("frame pacing: %u frames at %.3f ms per delay; p1 %.1f ms, p50 %.1f ms, p99 %.1f ms, jitter %.1f ms\n",
+	       count, delayPeriod, percentiles[0] / 10.0, percentiles[1] / 10.0, percentiles[2] / 10.0,
+	       (percentiles[2] - percentiles[0]) / 10.0);
+
+	for (int i = 0; i < FRAME_TIME_BUCKETS; ++i)
+	{
+		if (frameTimeHistogram[i] != 0)
+			printf("  %5.1f ms%s %u\n", i / 10.0, i == FRAME_TIME_BUCKETS - 1 ? "+" : " ", frameTimeHistogram[i]);
 	}
 }
 
@@ -104,34 +274,32 @@ void wait_delayorinput(void)
 			return;
 		}
 
-		Sint32 delay = target - SDL_GetTicks();
+		Sint32 delay = getDelayTicks();
 		if (delay <= 0)
 			return;
 
-		SDL_Delay(MIN(delay, SDL_POLL_INTERVAL));
+		sleep_ticks(MIN(delay, SDL_POLL_INTERVAL));
 	}
 }
 
 void loadSndFile(bool xmas)
 {
-	FILE *f;
-
-	f = dir_fopen_die(data_dir(), "tyrian.snd", "rb");
+	const AssetFile *snd_file = asset_open_die("tyrian.snd");
+	AssetReader reader = asset_reader(snd_file);
 
 	Uint16 sfxCount;
 	Uint32 sfxPositions[SFX_COUNT + 1];
 
 	// Read number of sounds.
-	fread_u16_die(&sfxCount, 1, f);
+	asset_read_u16_die(&sfxCount, 1, &reader);
 	if (sfxCount != SFX_COUNT)
 		goto die;
 
 	// Read positions of sounds.
-	fread_u32_die(sfxPositions, sfxCount, f);
+	asset_read_u32_die(sfxPositions, sfxCount, &reader);
 
 	// Determine end of last sound.
-	fseek(f, 0, SEEK_END);
-	sfxPositions[sfxCount] = ftell(f);
+	sfxPositions[sfxCount] = snd_file->size;
 
 	// Read samples.
 	for (size_t i = 0; i < sfxCount; ++i)
@@ -142,31 +310,27 @@ void loadSndFile(bool xmas)
 		if (soundSampleCount[i] > UINT16_MAX)
 			goto die;
 
-		free(soundSamples[i]);
-		soundSamples[i] = malloc(soundSampleCount[i]);
-
-		fseek(f, sfxPositions[i], SEEK_SET);
-		fread_u8_die((Uint8 *)soundSamples[i], soundSampleCount[i], f);
+		// The samples stay in the mapped file; the mixer resamples them as they play.
+		asset_seek_die(&reader, sfxPositions[i]);
+		soundSamples[i] = (const Sint8 *)asset_read_die(&reader, soundSampleCount[i]);
 	}
 
-	fclose(f);
-
-	f = dir_fopen_die(data_dir(), xmas ? "voicesc.snd" : "voices.snd", "rb");
+	snd_file = asset_open_die(xmas ? "voicesc.snd" : "voices.snd");
+	reader = asset_reader(snd_file);
 
 	Uint16 voiceCount;
 	Uint32 voicePositions[VOICE_COUNT + 1];
 
 	// Read number of sounds.
-	fread_u16_die(&voiceCount, 1, f);
+	asset_read_u16_die(&voiceCount, 1, &reader);
 	if (voiceCount != VOICE_COUNT)
 		goto die;
 
 	// Read positions of sounds.
-	fread_u32_die(voicePositions, voiceCount, f);
+	asset_read_u32_die(voicePositions, voiceCount, &reader);
 
 	// Determine end of last sound.
-	fseek(f, 0, SEEK_END);
-	voicePositions[voiceCount] = ftell(f);
+	voicePositions[voiceCount] = snd_file->size;
 
 	for (size_t vi = 0; vi < voiceCount; ++vi)
 	{
@@ -183,57 +347,10 @@ void loadSndFile(bool xmas)
 		if (soundSampleCount[i] > UINT16_MAX)
 			goto die;
 
-		free(soundSamples[i]);
-		soundSamples[i] = malloc(soundSampleCount[i]);
-
-		fseek(f, voicePositions[vi], SEEK_SET);
-		fread_u8_die((Uint8 *)soundSamples[i], soundSampleCount[i], f);
+		asset_seek_die(&reader, voicePositions[vi]);
+		soundSamples[i] = (const Sint8 *)asset_read_die(&reader, soundSampleCount[i]);
 	}
 
-	fclose(f);
-
-	// Convert samples to output sample format and rate.
-
-	SDL_AudioCVT cvt;
-	if (SDL_BuildAudioCVT(&cvt, AUDIO_S8, 1, 11025, AUDIO_S16SYS, 1, audioSampleRate) < 0)
-	{
-		fprintf(stderr, "error: Failed to build audio converter: %s\n", SDL_GetError());
-
-		for (int i = 0; i < SOUND_COUNT; ++i)
-			soundSampleCount[i] = 0;
-
-		return;
-	}
-
-	size_t maxSampleSize = 0;
-	for (size_t i = 0; i < SOUND_COUNT; ++i)
-		maxSampleSize = MAX(maxSampleSize, soundSampleCount[i]);
-
-	cvt.buf = malloc(maxSampleSize * cvt.len_mult);
-
-	for (size_t i = 0; i < SOUND_COUNT; ++i)
-	{
-		cvt.len = soundSampleCount[i];
-		memcpy(cvt.buf, soundSamples[i], cvt.len);
-
-		if (SDL_ConvertAudio(&cvt))
-		{
-			fprintf(stderr, "error: Failed to convert audio: %s\n", SDL_GetError());
-
-			soundSampleCount[i] = 0;
-
-			continue;
-		}
-
-		free(soundSamples[i]);
-		soundSamples[i] = malloc(cvt.len_cvt);
-
-		memcpy(soundSamples[i], cvt.buf, cvt.len_cvt);
-		soundSampleCount[i] = cvt.len_cvt / sizeof (Sint16);
-	}
-
-	free(cvt.buf);
-
 	return;
 
 die:
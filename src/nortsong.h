@@ -28,13 +28,18 @@
 
 extern JE_word frameCountMax;
 
-extern Sint16 *soundSamples[SOUND_COUNT];
+extern const Sint8 *soundSamples[SOUND_COUNT];
 extern size_t soundSampleCount[SOUND_COUNT];
 
 extern JE_word tyrMusicVolume, fxVolume;
 extern const JE_word fxPlayVol;
 extern JE_word tempVolume;
 
+extern bool frame_pacing_stats;
+
+Uint32 get_ticks(void);
+void sleep_ticks(Uint32 ticks);
+
 void setDelay(int delay);
 void setDelay2(int delay);
 Uint32 getDelayTicks(void);
@@ -44,6 +49,8 @@ void wait_delay(void);
 void service_wait_delay(void);
 void wait_delayorinput(void);
 
+void print_frame_pacing_stats(void);
+
 void setDelaySpeed(Uint16 speed);
 
 void JE_changeVolume(JE_word *music, int music_delta, JE_word *sample, int sample_delta);
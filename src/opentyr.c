@@ -40,6 +40,7 @@
 #include "palette.h"
 #include "params.h"
 #include "picload.h"
+#include "profiler.h"
 #include "sprite.h"
 #include "tyrian2.h"
 #include "varz.h"
@@ -325,7 +326,7 @@ void setupMenu(void)
 		int oldFullscreenDisplay = fullscreen_display;
 		do
 		{
-			SDL_Delay(16);
+			sleep_ticks(16);
 
 			Uint16 oldMouseX = mouse_x;
 			Uint16 oldMouseY = mouse_y;
@@ -770,9 +771,25 @@ int main(int argc, char *argv[])
 
 	JE_paramCheck(argc, argv);
 
-	if (!override_xmas) // arg handler may override
+	if (headless)
+	{
+		// Headless runs must not depend on the wall clock.
+		mt_srand(0);
+		if (!override_xmas)
+			xmas = false;
+	}
+	else if (!override_xmas) // arg handler may override
 		xmas = xmas_time();
 
+	if (render_audio_dir != NULL)
+	{
+		// No window or audio device; just write the audio out and exit.
+		const bool rendered = render_audio(xmas && dir_file_exists(data_dir(), "voicesc.snd"));
+
+		SDL_Quit();
+		return rendered ? 0 : EXIT_FAILURE;
+	}
+
 	JE_loadHelpText();
 	/*debuginfo("Help text complete");*/
 
@@ -780,6 +797,7 @@ int main(int argc, char *argv[])
 
 	JE_scanForEpisodes();
 
+	init_profiler();
 	init_video();
 	init_keyboard();
 	init_joysticks();
@@ -30,6 +30,12 @@
 #include <stdlib.h> // rand()
 #include <string.h> // memset()
 
+#if defined(__SSE2_MATH__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+// only where scalar double arithmetic is SSE2 too; x87 would round differently
+#define OPL_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 #define fltype double
 
  /*
@@ -140,66 +146,96 @@ typedef struct operator_struct {
 #endif
 } op_type;
 
+// tables shared by all chips, built by adlib_init_tables()
+static Bit16s wavtable[WAVEPREC*3];	// wave form table
+
+// vibrato/tremolo tables
+static Bit32s vib_table[VIBTAB_SIZE];
+static Bit32s trem_table[TREMTAB_SIZE*2];
+
+static Bit32s vibval_const[BLOCKBUF_SIZE];
+static Bit32s tremval_const[BLOCKBUF_SIZE];
+
+
+// queued work of the block fast path (see run_block)
+typedef struct {
+	op_type* op_pt;
+	bool vibrato;			// vibrato values are in block_vib, otherwise there is no vibrato
+	const Bit32s* trem;
+	Bits modulator;			// job whose output modulates this operator, or -1
+	bool feedback;			// modulated by its own feedback instead
+	Bits active;			// samples before the operator turned off
+} operator_job;
+
+typedef struct {
+	const op_type* cptr;
+	Bits out1, out2;		// jobs whose output is mixed, out2 may be -1
+	Bit32s scale;			// 1 or 2
+} channel_job;
+
+
 // per-chip variables
-static op_type op[MAXOPERATORS];
+struct OPLChip {
+	op_type op[MAXOPERATORS];
 
-static Bits int_samplerate;
+	Bits int_samplerate;
 
-static Bit8u status;
-static Bit32u opl_index;
+	Bit8u status;
+	Bit32u opl_index;
 #if defined(OPLTYPE_IS_OPL3)
-static Bit8u adlibreg[512];	// adlib register set (including second set)
-static Bit8u wave_sel[44];		// waveform selection
+	Bit8u adlibreg[512];	// adlib register set (including second set)
+	Bit8u wave_sel[44];		// waveform selection
 #else
-static Bit8u adlibreg[256];	// adlib register set
-static Bit8u wave_sel[22];		// waveform selection
+	Bit8u adlibreg[256];	// adlib register set
+	Bit8u wave_sel[22];		// waveform selection
 #endif
 
+	// vibrato/tremolo increment/counter
+	Bit32u vibtab_pos;
+	Bit32u vibtab_add;
+	Bit32u tremtab_pos;
+	Bit32u tremtab_add;
 
-						// vibrato/tremolo increment/counter
-static Bit32u vibtab_pos;
-static Bit32u vibtab_add;
-static Bit32u tremtab_pos;
-static Bit32u tremtab_add;
-
+	Bit32u generator_add;
 
-// enable an operator
-void enable_operator(Bitu regbase, op_type* op_pt, Bit32u act_type);
+	fltype recipsamp;	// inverse of sampling rate
 
-// functions to change parameters of an operator
-void change_frequency(Bitu chanbase, Bitu regbase, op_type* op_pt);
+	// calculated frequency multiplication values (depend on sampling rate)
+	fltype frqmul[16];
 
-void change_attackrate(Bitu regbase, op_type* op_pt);
-void change_decayrate(Bitu regbase, op_type* op_pt);
-void change_releaserate(Bitu regbase, op_type* op_pt);
-void change_sustainlevel(Bitu regbase, op_type* op_pt);
-void change_waveform(Bitu regbase, op_type* op_pt);
-void change_keepsustain(Bitu regbase, op_type* op_pt);
-void change_vibrato(Bitu regbase, op_type* op_pt);
-void change_feedback(Bitu chanbase, op_type* op_pt);
+	// vibrato value tables (used per-operator)
+	Bit32s vibval_var1[BLOCKBUF_SIZE];
+	Bit32s vibval_var2[BLOCKBUF_SIZE];
 
+	operator_job block_jobs[MAXOPERATORS];
+	Bits block_job_count;
+	channel_job block_channels[MAXOPERATORS];
+	Bits block_channel_count;
 
-static Bit32u generator_add;	// should be a chip parameter
+	Bit32s block_vib[MAXOPERATORS][BLOCKBUF_SIZE];
+	Bit32u block_wfpos[MAXOPERATORS][BLOCKBUF_SIZE];
+	fltype block_step_amp[MAXOPERATORS][BLOCKBUF_SIZE];
+	Bit32s block_out[MAXOPERATORS][BLOCKBUF_SIZE];
+};
 
-static fltype recipsamp;	// inverse of sampling rate
-static Bit16s wavtable[WAVEPREC*3];	// wave form table
+static OPLChip music_chip;
+OPLChip *opl_chip = &music_chip;
 
-// vibrato/tremolo tables
-static Bit32s vib_table[VIBTAB_SIZE];
-static Bit32s trem_table[TREMTAB_SIZE*2];
 
-static Bit32s vibval_const[BLOCKBUF_SIZE];
-static Bit32s tremval_const[BLOCKBUF_SIZE];
+// enable an operator
+void enable_operator(OPLChip* chip, Bitu regbase, op_type* op_pt, Bit32u act_type);
 
-// vibrato value tables (used per-operator)
-static Bit32s vibval_var1[BLOCKBUF_SIZE];
-static Bit32s vibval_var2[BLOCKBUF_SIZE];
-//static Bit32s vibval_var3[BLOCKBUF_SIZE];
-//static Bit32s vibval_var4[BLOCKBUF_SIZE];
+// functions to change parameters of an operator
+void change_frequency(OPLChip* chip, Bitu chanbase, Bitu regbase, op_type* op_pt);
 
-// vibrato/trmolo value table pointers
-static Bit32s *vibval1, *vibval2, *vibval3, *vibval4;
-static Bit32s *tremval1, *tremval2, *tremval3, *tremval4;
+void change_attackrate(OPLChip* chip, Bitu regbase, op_type* op_pt);
+void change_decayrate(OPLChip* chip, Bitu regbase, op_type* op_pt);
+void change_releaserate(OPLChip* chip, Bitu regbase, op_type* op_pt);
+void change_sustainlevel(OPLChip* chip, Bitu regbase, op_type* op_pt);
+void change_waveform(OPLChip* chip, Bitu regbase, op_type* op_pt);
+void change_keepsustain(OPLChip* chip, Bitu regbase, op_type* op_pt);
+void change_vibrato(OPLChip* chip, Bitu regbase, op_type* op_pt);
+void change_feedback(OPLChip* chip, Bitu chanbase, op_type* op_pt);
 
 
 // key scale level lookup table
@@ -211,9 +247,6 @@ static const fltype kslmul[4] = {
 static const fltype frqmul_tab[16] = {
 	0.5,1,2,3,4,5,6,7,8,9,10,10,12,12,15,15
 };
-// calculated frequency multiplication values (depend on sampling rate)
-static fltype frqmul[16];
-
 // key scale levels
 static Bit8u kslev[8][16];
 
@@ -295,17 +328,17 @@ static const fltype decrelconst[4] = {
 };
 
 
-void operator_advance(op_type* op_pt, Bit32s vib) {
+void operator_advance(OPLChip* chip, op_type* op_pt, Bit32s vib) {
 	op_pt->wfpos = op_pt->tcount;						// waveform position
 	
 	// advance waveform time
 	op_pt->tcount += op_pt->tinc;
 	op_pt->tcount += (Bit32s)(op_pt->tinc)*vib/FIXEDPT;
 
-	op_pt->generator_pos += generator_add;
+	op_pt->generator_pos += chip->generator_add;
 }
 
-void operator_advance_drums(op_type* op_pt1, Bit32s vib1, op_type* op_pt2, Bit32s vib2, op_type* op_pt3, Bit32s vib3) {
+void operator_advance_drums(OPLChip* chip, op_type* op_pt1, Bit32s vib1, op_type* op_pt2, Bit32s vib2, op_type* op_pt3, Bit32s vib3) {
 	Bit32u c1 = op_pt1->tcount/FIXEDPT;
 	Bit32u c3 = op_pt3->tcount/FIXEDPT;
 	Bit32u phasebit = (((c1 & 0x88) ^ ((c1<<5) & 0x80)) | ((c3 ^ (c3<<2)) & 0x20)) ? 0x02 : 0x00;
@@ -320,7 +353,7 @@ void operator_advance_drums(op_type* op_pt1, Bit32s vib1, op_type* op_pt2, Bit32
 	// advance waveform time
 	op_pt1->tcount += op_pt1->tinc;
 	op_pt1->tcount += (Bit32s)(op_pt1->tinc)*vib1/FIXEDPT;
-	op_pt1->generator_pos += generator_add;
+	op_pt1->generator_pos += chip->generator_add;
 
 	//Snare
 	inttm = ((1+snare_phase_bit) ^ noisebit)<<8;
@@ -328,7 +361,7 @@ void operator_advance_drums(op_type* op_pt1, Bit32s vib1, op_type* op_pt2, Bit32
 	// advance waveform time
 	op_pt2->tcount += op_pt2->tinc;
 	op_pt2->tcount += (Bit32s)(op_pt2->tinc)*vib2/FIXEDPT;
-	op_pt2->generator_pos += generator_add;
+	op_pt2->generator_pos += chip->generator_add;
 
 	//Cymbal
 	inttm = (1+phasebit)<<8;
@@ -336,7 +369,7 @@ void operator_advance_drums(op_type* op_pt1, Bit32s vib1, op_type* op_pt2, Bit32
 	// advance waveform time
 	op_pt3->tcount += op_pt3->tinc;
 	op_pt3->tcount += (Bit32s)(op_pt3->tinc)*vib3/FIXEDPT;
-	op_pt3->generator_pos += generator_add;
+	op_pt3->generator_pos += chip->generator_add;
 }
 
 
@@ -463,10 +496,10 @@ const optype_fptr opfuncs[6] = {
 	operator_off
 };
 
-void change_attackrate(Bitu regbase, op_type* op_pt) {
-	Bits attackrate = adlibreg[ARC_ATTR_DECR+regbase]>>4;
+void change_attackrate(OPLChip* chip, Bitu regbase, op_type* op_pt) {
+	Bits attackrate = chip->adlibreg[ARC_ATTR_DECR+regbase]>>4;
 	if (attackrate) {
-		fltype f = (fltype)(pow(FL2,(fltype)attackrate+(op_pt->toff>>2)-1)*attackconst[op_pt->toff&3]*recipsamp);
+		fltype f = (fltype)(pow(FL2,(fltype)attackrate+(op_pt->toff>>2)-1)*attackconst[op_pt->toff&3]*chip->recipsamp);
 		// attack rate coefficients
 		op_pt->a0 = (fltype)(0.0377*f);
 		op_pt->a1 = (fltype)(10.73*f+1);
@@ -502,11 +535,11 @@ void change_attackrate(Bitu regbase, op_type* op_pt) {
 	}
 }
 
-void change_decayrate(Bitu regbase, op_type* op_pt) {
-	Bits decayrate = adlibreg[ARC_ATTR_DECR+regbase]&15;
+void change_decayrate(OPLChip* chip, Bitu regbase, op_type* op_pt) {
+	Bits decayrate = chip->adlibreg[ARC_ATTR_DECR+regbase]&15;
 	// decaymul should be 1.0 when decayrate==0
 	if (decayrate) {
-		fltype f = (fltype)(-7.4493*decrelconst[op_pt->toff&3]*recipsamp);
+		fltype f = (fltype)(-7.4493*decrelconst[op_pt->toff&3]*chip->recipsamp);
 		op_pt->decaymul = (fltype)(pow(FL2,f*pow(FL2,(fltype)(decayrate+(op_pt->toff>>2)))));
 		Bits steps = (decayrate*4 + op_pt->toff) >> 2;
 		op_pt->env_step_d = (1<<(steps<=12?12-steps:0))-1;
@@ -516,11 +549,11 @@ void change_decayrate(Bitu regbase, op_type* op_pt) {
 	}
 }
 
-void change_releaserate(Bitu regbase, op_type* op_pt) {
-	Bits releaserate = adlibreg[ARC_SUSL_RELR+regbase]&15;
+void change_releaserate(OPLChip* chip, Bitu regbase, op_type* op_pt) {
+	Bits releaserate = chip->adlibreg[ARC_SUSL_RELR+regbase]&15;
 	// releasemul should be 1.0 when releaserate==0
 	if (releaserate) {
-		fltype f = (fltype)(-7.4493*decrelconst[op_pt->toff&3]*recipsamp);
+		fltype f = (fltype)(-7.4493*decrelconst[op_pt->toff&3]*chip->recipsamp);
 		op_pt->releasemul = (fltype)(pow(FL2,f*pow(FL2,(fltype)(releaserate+(op_pt->toff>>2)))));
 		Bits steps = (releaserate*4 + op_pt->toff) >> 2;
 		op_pt->env_step_r = (1<<(steps<=12?12-steps:0))-1;
@@ -530,8 +563,8 @@ void change_releaserate(Bitu regbase, op_type* op_pt) {
 	}
 }
 
-void change_sustainlevel(Bitu regbase, op_type* op_pt) {
-	Bits sustainlevel = adlibreg[ARC_SUSL_RELR+regbase]>>4;
+void change_sustainlevel(OPLChip* chip, Bitu regbase, op_type* op_pt) {
+	Bits sustainlevel = chip->adlibreg[ARC_SUSL_RELR+regbase]>>4;
 	// sustainlevel should be 0.0 when sustainlevel==15 (max)
 	if (sustainlevel<15) {
 		op_pt->sustain_level = (fltype)(pow(FL2,(fltype)sustainlevel * (-FL05)));
@@ -540,18 +573,18 @@ void change_sustainlevel(Bitu regbase, op_type* op_pt) {
 	}
 }
 
-void change_waveform(Bitu regbase, op_type* op_pt) {
+void change_waveform(OPLChip* chip, Bitu regbase, op_type* op_pt) {
 #if defined(OPLTYPE_IS_OPL3)
 	if (regbase>=ARC_SECONDSET) regbase -= (ARC_SECONDSET-22);	// second set starts at 22
 #endif
 	// waveform selection
-	op_pt->cur_wmask = wavemask[wave_sel[regbase]];
-	op_pt->cur_wform = &wavtable[waveform[wave_sel[regbase]]];
+	op_pt->cur_wmask = wavemask[chip->wave_sel[regbase]];
+	op_pt->cur_wform = &wavtable[waveform[chip->wave_sel[regbase]]];
 	// (might need to be adapted to waveform type here...)
 }
 
-void change_keepsustain(Bitu regbase, op_type* op_pt) {
-	op_pt->sus_keep = (adlibreg[ARC_TVS_KSR_MUL+regbase]&0x20)>0;
+void change_keepsustain(OPLChip* chip, Bitu regbase, op_type* op_pt) {
+	op_pt->sus_keep = (chip->adlibreg[ARC_TVS_KSR_MUL+regbase]&0x20)>0;
 	if (op_pt->op_state==OF_TYPE_SUS) {
 		if (!op_pt->sus_keep) op_pt->op_state = OF_TYPE_SUS_NOKEEP;
 	} else if (op_pt->op_state==OF_TYPE_SUS_NOKEEP) {
@@ -560,53 +593,53 @@ void change_keepsustain(Bitu regbase, op_type* op_pt) {
 }
 
 // enable/disable vibrato/tremolo LFO effects
-void change_vibrato(Bitu regbase, op_type* op_pt) {
-	op_pt->vibrato = (adlibreg[ARC_TVS_KSR_MUL+regbase]&0x40)!=0;
-	op_pt->tremolo = (adlibreg[ARC_TVS_KSR_MUL+regbase]&0x80)!=0;
+void change_vibrato(OPLChip* chip, Bitu regbase, op_type* op_pt) {
+	op_pt->vibrato = (chip->adlibreg[ARC_TVS_KSR_MUL+regbase]&0x40)!=0;
+	op_pt->tremolo = (chip->adlibreg[ARC_TVS_KSR_MUL+regbase]&0x80)!=0;
 }
 
 // change amount of self-feedback
-void change_feedback(Bitu chanbase, op_type* op_pt) {
-	Bits feedback = adlibreg[ARC_FEEDBACK+chanbase]&14;
+void change_feedback(OPLChip* chip, Bitu chanbase, op_type* op_pt) {
+	Bits feedback = chip->adlibreg[ARC_FEEDBACK+chanbase]&14;
 	if (feedback) op_pt->mfbi = (Bit32s)(pow(FL2,(fltype)((feedback>>1)+8)));
 	else op_pt->mfbi = 0;
 }
 
-void change_frequency(Bitu chanbase, Bitu regbase, op_type* op_pt) {
+void change_frequency(OPLChip* chip, Bitu chanbase, Bitu regbase, op_type* op_pt) {
 	// frequency
-	Bit32u frn = ((((Bit32u)adlibreg[ARC_KON_BNUM+chanbase])&3)<<8) + (Bit32u)adlibreg[ARC_FREQ_NUM+chanbase];
+	Bit32u frn = ((((Bit32u)chip->adlibreg[ARC_KON_BNUM+chanbase])&3)<<8) + (Bit32u)chip->adlibreg[ARC_FREQ_NUM+chanbase];
 	// block number/octave
-	Bit32u oct = ((((Bit32u)adlibreg[ARC_KON_BNUM+chanbase])>>2)&7);
+	Bit32u oct = ((((Bit32u)chip->adlibreg[ARC_KON_BNUM+chanbase])>>2)&7);
 	op_pt->freq_high = (Bit32s)((frn>>7)&7);
 
 	// keysplit
-	Bit32u note_sel = (adlibreg[8]>>6)&1;
+	Bit32u note_sel = (chip->adlibreg[8]>>6)&1;
 	op_pt->toff = ((frn>>9)&(note_sel^1)) | ((frn>>8)&note_sel);
 	op_pt->toff += (oct<<1);
 
 	// envelope scaling (KSR)
-	if (!(adlibreg[ARC_TVS_KSR_MUL+regbase]&0x10)) op_pt->toff >>= 2;
+	if (!(chip->adlibreg[ARC_TVS_KSR_MUL+regbase]&0x10)) op_pt->toff >>= 2;
 
 	// 20+a0+b0:
-	op_pt->tinc = (Bit32u)((((fltype)(frn<<oct))*frqmul[adlibreg[ARC_TVS_KSR_MUL+regbase]&15]));
+	op_pt->tinc = (Bit32u)((((fltype)(frn<<oct))*chip->frqmul[chip->adlibreg[ARC_TVS_KSR_MUL+regbase]&15]));
 	// 40+a0+b0:
-	fltype vol_in = (fltype)((fltype)(adlibreg[ARC_KSL_OUTLEV+regbase]&63) +
-							kslmul[adlibreg[ARC_KSL_OUTLEV+regbase]>>6]*kslev[oct][frn>>6]);
+	fltype vol_in = (fltype)((fltype)(chip->adlibreg[ARC_KSL_OUTLEV+regbase]&63) +
+							kslmul[chip->adlibreg[ARC_KSL_OUTLEV+regbase]>>6]*kslev[oct][frn>>6]);
 	op_pt->vol = (fltype)(pow(FL2,(fltype)(vol_in * -0.125 - 14)));
 
 	// operator frequency changed, care about features that depend on it
-	change_attackrate(regbase,op_pt);
-	change_decayrate(regbase,op_pt);
-	change_releaserate(regbase,op_pt);
+	change_attackrate(chip, regbase,op_pt);
+	change_decayrate(chip, regbase,op_pt);
+	change_releaserate(chip, regbase,op_pt);
 }
 
-void enable_operator(Bitu regbase, op_type* op_pt, Bit32u act_type) {
+void enable_operator(OPLChip* chip, Bitu regbase, op_type* op_pt, Bit32u act_type) {
 	// check if this is really an off-on transition
 	if (op_pt->act_state == OP_ACT_OFF) {
 		Bits wselbase = regbase;
 		if (wselbase>=ARC_SECONDSET) wselbase -= (ARC_SECONDSET-22);	// second set starts at 22
 
-		op_pt->tcount = wavestart[wave_sel[wselbase]]*FIXEDPT;
+		op_pt->tcount = wavestart[chip->wave_sel[wselbase]]*FIXEDPT;
 
 		// start with attack mode
 		op_pt->op_state = OF_TYPE_ATT;
@@ -624,55 +657,13 @@ void disable_operator(op_type* op_pt, Bit32u act_type) {
 	}
 }
 
-void adlib_init(Bit32u samplerate) {
+// builds the tables shared by all chips; must be called before the first chip is initialized
+void adlib_init_tables(void) {
 	Bits i, j, oct;
 
-	int_samplerate = samplerate;
-
-	generator_add = (Bit32u)(INTFREQU*FIXEDPT/int_samplerate);
-
-
-	memset((void *)adlibreg,0,sizeof(adlibreg));
-	memset((void *)op,0,sizeof(op_type)*MAXOPERATORS);
-	memset((void *)wave_sel,0,sizeof(wave_sel));
-
-	for (i=0;i<MAXOPERATORS;i++) {
-		op[i].op_state = OF_TYPE_OFF;
-		op[i].act_state = OP_ACT_OFF;
-		op[i].amp = 0.0;
-		op[i].step_amp = 0.0;
-		op[i].vol = 0.0;
-		op[i].tcount = 0;
-		op[i].tinc = 0;
-		op[i].toff = 0;
-		op[i].cur_wmask = wavemask[0];
-		op[i].cur_wform = &wavtable[waveform[0]];
-		op[i].freq_high = 0;
-
-		op[i].generator_pos = 0;
-		op[i].cur_env_step = 0;
-		op[i].env_step_a = 0;
-		op[i].env_step_d = 0;
-		op[i].env_step_r = 0;
-		op[i].step_skip_pos_a = 0;
-		op[i].env_step_skip_a = 0;
-
-#if defined(OPLTYPE_IS_OPL3)
-		op[i].is_4op = false;
-		op[i].is_4op_attached = false;
-		op[i].left_pan = 1;
-		op[i].right_pan = 1;
-#endif
-	}
-
-	recipsamp = 1.0 / (fltype)int_samplerate;
-	for (i=15;i>=0;i--) {
-		frqmul[i] = (fltype)(frqmul_tab[i]*INTFREQU/(fltype)WAVEPREC*(fltype)FIXEDPT*recipsamp);
-	}
-
-	status = 0;
-	opl_index = 0;
-
+	static bool tables_built = false;
+	if (tables_built) return;
+	tables_built = true;
 
 	// create vibrato table
 	vib_table[0] = 8;
@@ -681,10 +672,6 @@ void adlib_init(Bit32u samplerate) {
 	vib_table[3] = -4;
 	for (i=4; i<VIBTAB_SIZE; i++) vib_table[i] = vib_table[i-4]*-1;
 
-	// vibrato at ~6.1 ?? (opl3 docs say 6.1, opl4 docs say 6.0, y8950 docs say 6.4)
-	vibtab_add = (Bit32u)(VIBTAB_SIZE*FIXEDPT_LFO/8192*INTFREQU/int_samplerate);
-	vibtab_pos = 0;
-
 	for (i=0; i<BLOCKBUF_SIZE; i++) vibval_const[i] = 0;
 
 
@@ -703,53 +690,118 @@ void adlib_init(Bit32u samplerate) {
 		trem_table[TREMTAB_SIZE+i] = (Bit32s)(pow(FL2,trem_val2)*FIXEDPT);
 	}
 
-	// tremolo at 3.7hz
-	tremtab_add = (Bit32u)((fltype)TREMTAB_SIZE * TREM_FREQ * FIXEDPT_LFO / (fltype)int_samplerate);
-	tremtab_pos = 0;
-
 	for (i=0; i<BLOCKBUF_SIZE; i++) tremval_const[i] = FIXEDPT;
 
 
-	static Bitu initfirstime = 0;
-	if (!initfirstime) {
-		initfirstime = 1;
+	// create waveform tables
+	for (i=0;i<(WAVEPREC>>1);i++) {
+		wavtable[(i<<1)  +WAVEPREC]	= (Bit16s)(16384*sin((fltype)((i<<1)  )*PI*2/WAVEPREC));
+		wavtable[(i<<1)+1+WAVEPREC]	= (Bit16s)(16384*sin((fltype)((i<<1)+1)*PI*2/WAVEPREC));
+		wavtable[i]					= wavtable[(i<<1)  +WAVEPREC];
+		// alternative: (zero-less)
+/*		wavtable[(i<<1)  +WAVEPREC]	= (Bit16s)(16384*sin((fltype)((i<<2)+1)*PI/WAVEPREC));
+		wavtable[(i<<1)+1+WAVEPREC]	= (Bit16s)(16384*sin((fltype)((i<<2)+3)*PI/WAVEPREC));
+		wavtable[i]					= wavtable[(i<<1)-1+WAVEPREC]; */
+	}
+	for (i=0;i<(WAVEPREC>>3);i++) {
+		wavtable[i+(WAVEPREC<<1)]		= wavtable[i+(WAVEPREC>>3)]-16384;
+		wavtable[i+((WAVEPREC*17)>>3)]	= wavtable[i+(WAVEPREC>>2)]+16384;
+	}
 
-		// create waveform tables
-		for (i=0;i<(WAVEPREC>>1);i++) {
-			wavtable[(i<<1)  +WAVEPREC]	= (Bit16s)(16384*sin((fltype)((i<<1)  )*PI*2/WAVEPREC));
-			wavtable[(i<<1)+1+WAVEPREC]	= (Bit16s)(16384*sin((fltype)((i<<1)+1)*PI*2/WAVEPREC));
-			wavtable[i]					= wavtable[(i<<1)  +WAVEPREC];
-			// alternative: (zero-less)
-/*			wavtable[(i<<1)  +WAVEPREC]	= (Bit16s)(16384*sin((fltype)((i<<2)+1)*PI/WAVEPREC));
-			wavtable[(i<<1)+1+WAVEPREC]	= (Bit16s)(16384*sin((fltype)((i<<2)+3)*PI/WAVEPREC));
-			wavtable[i]					= wavtable[(i<<1)-1+WAVEPREC]; */
-		}
-		for (i=0;i<(WAVEPREC>>3);i++) {
-			wavtable[i+(WAVEPREC<<1)]		= wavtable[i+(WAVEPREC>>3)]-16384;
-			wavtable[i+((WAVEPREC*17)>>3)]	= wavtable[i+(WAVEPREC>>2)]+16384;
+	// key scale level table verified ([table in book]*8/3)
+	kslev[7][0] = 0;	kslev[7][1] = 24;	kslev[7][2] = 32;	kslev[7][3] = 37;
+	kslev[7][4] = 40;	kslev[7][5] = 43;	kslev[7][6] = 45;	kslev[7][7] = 47;
+	kslev[7][8] = 48;
+	for (i=9;i<16;i++) kslev[7][i] = (Bit8u)(i+41);
+	for (j=6;j>=0;j--) {
+		for (i=0;i<16;i++) {
+			oct = (Bits)kslev[j+1][i]-8;
+			if (oct < 0) oct = 0;
+			kslev[j][i] = (Bit8u)oct;
 		}
+	}
+}
 
-		// key scale level table verified ([table in book]*8/3)
-		kslev[7][0] = 0;	kslev[7][1] = 24;	kslev[7][2] = 32;	kslev[7][3] = 37;
-		kslev[7][4] = 40;	kslev[7][5] = 43;	kslev[7][6] = 45;	kslev[7][7] = 47;
-		kslev[7][8] = 48;
-		for (i=9;i<16;i++) kslev[7][i] = (Bit8u)(i+41);
-		for (j=6;j>=0;j--) {
-			for (i=0;i<16;i++) {
-				oct = (Bits)kslev[j+1][i]-8;
-				if (oct < 0) oct = 0;
-				kslev[j][i] = (Bit8u)oct;
-			}
+// resets a chip; only the rates depend on the sample rate, so they are all that is recomputed
+void adlib_init(OPLChip* chip, Bit32u samplerate) {
+	Bits i;
+
+	if (chip->int_samplerate != (Bits)samplerate) {
+		chip->int_samplerate = samplerate;
+
+		chip->generator_add = (Bit32u)(INTFREQU*FIXEDPT/chip->int_samplerate);
+
+		chip->recipsamp = 1.0 / (fltype)chip->int_samplerate;
+		for (i=15;i>=0;i--) {
+			chip->frqmul[i] = (fltype)(frqmul_tab[i]*INTFREQU/(fltype)WAVEPREC*(fltype)FIXEDPT*chip->recipsamp);
 		}
+
+		// vibrato at ~6.1 ?? (opl3 docs say 6.1, opl4 docs say 6.0, y8950 docs say 6.4)
+		chip->vibtab_add = (Bit32u)(VIBTAB_SIZE*FIXEDPT_LFO/8192*INTFREQU/chip->int_samplerate);
+
+		// tremolo at 3.7hz
+		chip->tremtab_add = (Bit32u)((fltype)TREMTAB_SIZE * TREM_FREQ * FIXEDPT_LFO / (fltype)chip->int_samplerate);
+	}
+
+	memset((void *)chip->adlibreg,0,sizeof(chip->adlibreg));
+	memset((void *)chip->op,0,sizeof(op_type)*MAXOPERATORS);
+	memset((void *)chip->wave_sel,0,sizeof(chip->wave_sel));
+
+	for (i=0;i<MAXOPERATORS;i++) {
+		chip->op[i].op_state = OF_TYPE_OFF;
+		chip->op[i].act_state = OP_ACT_OFF;
+		chip->op[i].amp = 0.0;
+		chip->op[i].step_amp = 0.0;
+		chip->op[i].vol = 0.0;
+		chip->op[i].tcount = 0;
+		chip->op[i].tinc = 0;
+		chip->op[i].toff = 0;
+		chip->op[i].cur_wmask = wavemask[0];
+		chip->op[i].cur_wform = &wavtable[waveform[0]];
+		chip->op[i].freq_high = 0;
+
+		chip->op[i].generator_pos = 0;
+		chip->op[i].cur_env_step = 0;
+		chip->op[i].env_step_a = 0;
+		chip->op[i].env_step_d = 0;
+		chip->op[i].env_step_r = 0;
+		chip->op[i].step_skip_pos_a = 0;
+		chip->op[i].env_step_skip_a = 0;
+
+#if defined(OPLTYPE_IS_OPL3)
+		chip->op[i].is_4op = false;
+		chip->op[i].is_4op_attached = false;
+		chip->op[i].left_pan = 1;
+		chip->op[i].right_pan = 1;
+#endif
 	}
 
+	chip->status = 0;
+	chip->opl_index = 0;
+
+	chip->vibtab_pos = 0;
+	chip->tremtab_pos = 0;
+
+	chip->block_job_count = 0;
+	chip->block_channel_count = 0;
 }
 
+// allocates a chip for use alongside the others, e.g. on another thread
+OPLChip* adlib_create(Bit32u samplerate) {
+	OPLChip* chip = calloc(1, sizeof(OPLChip));
+	if (chip != NULL) adlib_init(chip, samplerate);
+	return chip;
+}
+
+void adlib_destroy(OPLChip* chip) {
+	free(chip);
+}
 
 
-void adlib_write(Bitu idx, Bit8u val) {
+
+void adlib_write(OPLChip* chip, Bitu idx, Bit8u val) {
 	Bit32u second_set = idx&0x100;
-	adlibreg[idx] = val;
+	chip->adlibreg[idx] = val;
 
 	switch (idx&0xf0) {
 	case ARC_CONTROL:
@@ -762,26 +814,26 @@ void adlib_write(Bitu idx, Bit8u val) {
 			// IRQ reset, timer mask/start
 			if (val&0x80) {
 				// clear IRQ bits in status register
-				status &= ~0x60;
+				chip->status &= ~0x60;
 			} else {
-				status = 0;
+				chip->status = 0;
 			}
 			break;
 #if defined(OPLTYPE_IS_OPL3)
 		case 0x04|ARC_SECONDSET:
 			// 4op enable/disable switches for each possible channel
-			op[0].is_4op = (val&1)>0;
-			op[3].is_4op_attached = op[0].is_4op;
-			op[1].is_4op = (val&2)>0;
-			op[4].is_4op_attached = op[1].is_4op;
-			op[2].is_4op = (val&4)>0;
-			op[5].is_4op_attached = op[2].is_4op;
-			op[18].is_4op = (val&8)>0;
-			op[21].is_4op_attached = op[18].is_4op;
-			op[19].is_4op = (val&16)>0;
-			op[22].is_4op_attached = op[19].is_4op;
-			op[20].is_4op = (val&32)>0;
-			op[23].is_4op_attached = op[20].is_4op;
+			chip->op[0].is_4op = (val&1)>0;
+			chip->op[3].is_4op_attached = chip->op[0].is_4op;
+			chip->op[1].is_4op = (val&2)>0;
+			chip->op[4].is_4op_attached = chip->op[1].is_4op;
+			chip->op[2].is_4op = (val&4)>0;
+			chip->op[5].is_4op_attached = chip->op[2].is_4op;
+			chip->op[18].is_4op = (val&8)>0;
+			chip->op[21].is_4op_attached = chip->op[18].is_4op;
+			chip->op[19].is_4op = (val&16)>0;
+			chip->op[22].is_4op_attached = chip->op[19].is_4op;
+			chip->op[20].is_4op = (val&32)>0;
+			chip->op[23].is_4op_attached = chip->op[20].is_4op;
 			break;
 		case 0x05|ARC_SECONDSET:
 			break;
@@ -804,21 +856,21 @@ void adlib_write(Bitu idx, Bit8u val) {
 			Bitu chanbase = second_set?(modop-18+ARC_SECONDSET):modop;
 
 			// change tremolo/vibrato and sustain keeping of this operator
-			op_type* op_ptr = &op[modop+((num<3) ? 0 : 9)];
-			change_keepsustain(regbase,op_ptr);
-			change_vibrato(regbase,op_ptr);
+			op_type* op_ptr = &chip->op[modop+((num<3) ? 0 : 9)];
+			change_keepsustain(chip, regbase,op_ptr);
+			change_vibrato(chip, regbase,op_ptr);
 
 			// change frequency calculations of this operator as
 			// key scale rate and frequency multiplicator can be changed
 #if defined(OPLTYPE_IS_OPL3)
-			if ((adlibreg[0x105]&1) && (op[modop].is_4op_attached)) {
+			if ((chip->adlibreg[0x105]&1) && (chip->op[modop].is_4op_attached)) {
 				// operator uses frequency of channel
-				change_frequency(chanbase-3,regbase,op_ptr);
+				change_frequency(chip, chanbase-3,regbase,op_ptr);
 			} else {
-				change_frequency(chanbase,regbase,op_ptr);
+				change_frequency(chip, chanbase,regbase,op_ptr);
 			}
 #else
-			change_frequency(chanbase,base,op_ptr);
+			change_frequency(chip, chanbase,base,op_ptr);
 #endif
 		}
 		}
@@ -834,17 +886,17 @@ void adlib_write(Bitu idx, Bit8u val) {
 
 			// change frequency calculations of this operator as
 			// key scale level and output rate can be changed
-			op_type* op_ptr = &op[modop+((num<3) ? 0 : 9)];
+			op_type* op_ptr = &chip->op[modop+((num<3) ? 0 : 9)];
 #if defined(OPLTYPE_IS_OPL3)
 			Bitu regbase = base+second_set;
-			if ((adlibreg[0x105]&1) && (op[modop].is_4op_attached)) {
+			if ((chip->adlibreg[0x105]&1) && (chip->op[modop].is_4op_attached)) {
 				// operator uses frequency of channel
-				change_frequency(chanbase-3,regbase,op_ptr);
+				change_frequency(chip, chanbase-3,regbase,op_ptr);
 			} else {
-				change_frequency(chanbase,regbase,op_ptr);
+				change_frequency(chip, chanbase,regbase,op_ptr);
 			}
 #else
-			change_frequency(chanbase,base,op_ptr);
+			change_frequency(chip, chanbase,base,op_ptr);
 #endif
 		}
 		}
@@ -858,9 +910,9 @@ void adlib_write(Bitu idx, Bit8u val) {
 			Bitu regbase = base+second_set;
 
 			// change attack rate and decay rate of this operator
-			op_type* op_ptr = &op[regbase2op[second_set?(base+22):base]];
-			change_attackrate(regbase,op_ptr);
-			change_decayrate(regbase,op_ptr);
+			op_type* op_ptr = &chip->op[regbase2op[second_set?(base+22):base]];
+			change_attackrate(chip, regbase,op_ptr);
+			change_decayrate(chip, regbase,op_ptr);
 		}
 		}
 		break;
@@ -873,9 +925,9 @@ void adlib_write(Bitu idx, Bit8u val) {
 			Bitu regbase = base+second_set;
 
 			// change sustain level and release rate of this operator
-			op_type* op_ptr = &op[regbase2op[second_set?(base+22):base]];
-			change_releaserate(regbase,op_ptr);
-			change_sustainlevel(regbase,op_ptr);
+			op_type* op_ptr = &chip->op[regbase2op[second_set?(base+22):base]];
+			change_releaserate(chip, regbase,op_ptr);
+			change_sustainlevel(chip, regbase,op_ptr);
 		}
 		}
 		break;
@@ -885,20 +937,20 @@ void adlib_write(Bitu idx, Bit8u val) {
 		if (base<9) {
 			Bits opbase = second_set?(base+18):base;
 #if defined(OPLTYPE_IS_OPL3)
-			if ((adlibreg[0x105]&1) && op[opbase].is_4op_attached) break;
+			if ((chip->adlibreg[0x105]&1) && chip->op[opbase].is_4op_attached) break;
 #endif
 			// regbase of modulator:
 			Bits modbase = modulatorbase[base]+second_set;
 
 			Bitu chanbase = base+second_set;
 
-			change_frequency(chanbase,modbase,&op[opbase]);
-			change_frequency(chanbase,modbase+3,&op[opbase+9]);
+			change_frequency(chip, chanbase,modbase,&chip->op[opbase]);
+			change_frequency(chip, chanbase,modbase+3,&chip->op[opbase+9]);
 #if defined(OPLTYPE_IS_OPL3)
 			// for 4op channels all four operators are modified to the frequency of the channel
-			if ((adlibreg[0x105]&1) && op[second_set?(base+18):base].is_4op) {
-				change_frequency(chanbase,modbase+8,&op[opbase+3]);
-				change_frequency(chanbase,modbase+3+8,&op[opbase+3+9]);
+			if ((chip->adlibreg[0x105]&1) && chip->op[second_set?(base+18):base].is_4op) {
+				change_frequency(chip, chanbase,modbase+8,&chip->op[opbase+3]);
+				change_frequency(chip, chanbase,modbase+3+8,&chip->op[opbase+3+9]);
 			}
 #endif
 		}
@@ -911,37 +963,37 @@ void adlib_write(Bitu idx, Bit8u val) {
 #endif
 
 			if ((val&0x30) == 0x30) {		// BassDrum active
-				enable_operator(16,&op[6],OP_ACT_PERC);
-				change_frequency(6,16,&op[6]);
-				enable_operator(16+3,&op[6+9],OP_ACT_PERC);
-				change_frequency(6,16+3,&op[6+9]);
+				enable_operator(chip, 16,&chip->op[6],OP_ACT_PERC);
+				change_frequency(chip, 6,16,&chip->op[6]);
+				enable_operator(chip, 16+3,&chip->op[6+9],OP_ACT_PERC);
+				change_frequency(chip, 6,16+3,&chip->op[6+9]);
 			} else {
-				disable_operator(&op[6],OP_ACT_PERC);
-				disable_operator(&op[6+9],OP_ACT_PERC);
+				disable_operator(&chip->op[6],OP_ACT_PERC);
+				disable_operator(&chip->op[6+9],OP_ACT_PERC);
 			}
 			if ((val&0x28) == 0x28) {		// Snare active
-				enable_operator(17+3,&op[16],OP_ACT_PERC);
-				change_frequency(7,17+3,&op[16]);
+				enable_operator(chip, 17+3,&chip->op[16],OP_ACT_PERC);
+				change_frequency(chip, 7,17+3,&chip->op[16]);
 			} else {
-				disable_operator(&op[16],OP_ACT_PERC);
+				disable_operator(&chip->op[16],OP_ACT_PERC);
 			}
 			if ((val&0x24) == 0x24) {		// TomTom active
-				enable_operator(18,&op[8],OP_ACT_PERC);
-				change_frequency(8,18,&op[8]);
+				enable_operator(chip, 18,&chip->op[8],OP_ACT_PERC);
+				change_frequency(chip, 8,18,&chip->op[8]);
 			} else {
-				disable_operator(&op[8],OP_ACT_PERC);
+				disable_operator(&chip->op[8],OP_ACT_PERC);
 			}
 			if ((val&0x22) == 0x22) {		// Cymbal active
-				enable_operator(18+3,&op[8+9],OP_ACT_PERC);
-				change_frequency(8,18+3,&op[8+9]);
+				enable_operator(chip, 18+3,&chip->op[8+9],OP_ACT_PERC);
+				change_frequency(chip, 8,18+3,&chip->op[8+9]);
 			} else {
-				disable_operator(&op[8+9],OP_ACT_PERC);
+				disable_operator(&chip->op[8+9],OP_ACT_PERC);
 			}
 			if ((val&0x21) == 0x21) {		// Hihat active
-				enable_operator(17,&op[7],OP_ACT_PERC);
-				change_frequency(7,17,&op[7]);
+				enable_operator(chip, 17,&chip->op[7],OP_ACT_PERC);
+				change_frequency(chip, 7,17,&chip->op[7]);
 			} else {
-				disable_operator(&op[7],OP_ACT_PERC);
+				disable_operator(&chip->op[7],OP_ACT_PERC);
 			}
 
 			break;
@@ -951,33 +1003,33 @@ void adlib_write(Bitu idx, Bit8u val) {
 		if (base<9) {
 			Bits opbase = second_set?(base+18):base;
 #if defined(OPLTYPE_IS_OPL3)
-			if ((adlibreg[0x105]&1) && op[opbase].is_4op_attached) break;
+			if ((chip->adlibreg[0x105]&1) && chip->op[opbase].is_4op_attached) break;
 #endif
 			// regbase of modulator:
 			Bits modbase = modulatorbase[base]+second_set;
 
 			if (val&32) {
 				// operator switched on
-				enable_operator(modbase,&op[opbase],OP_ACT_NORMAL);		// modulator (if 2op)
-				enable_operator(modbase+3,&op[opbase+9],OP_ACT_NORMAL);	// carrier (if 2op)
+				enable_operator(chip, modbase,&chip->op[opbase],OP_ACT_NORMAL);		// modulator (if 2op)
+				enable_operator(chip, modbase+3,&chip->op[opbase+9],OP_ACT_NORMAL);	// carrier (if 2op)
 #if defined(OPLTYPE_IS_OPL3)
 				// for 4op channels all four operators are switched on
-				if ((adlibreg[0x105]&1) && op[opbase].is_4op) {
+				if ((chip->adlibreg[0x105]&1) && chip->op[opbase].is_4op) {
 					// turn on chan+3 operators as well
-					enable_operator(modbase+8,&op[opbase+3],OP_ACT_NORMAL);
-					enable_operator(modbase+3+8,&op[opbase+3+9],OP_ACT_NORMAL);
+					enable_operator(chip, modbase+8,&chip->op[opbase+3],OP_ACT_NORMAL);
+					enable_operator(chip, modbase+3+8,&chip->op[opbase+3+9],OP_ACT_NORMAL);
 				}
 #endif
 			} else {
 				// operator switched off
-				disable_operator(&op[opbase],OP_ACT_NORMAL);
-				disable_operator(&op[opbase+9],OP_ACT_NORMAL);
+				disable_operator(&chip->op[opbase],OP_ACT_NORMAL);
+				disable_operator(&chip->op[opbase+9],OP_ACT_NORMAL);
 #if defined(OPLTYPE_IS_OPL3)
 				// for 4op channels all four operators are switched off
-				if ((adlibreg[0x105]&1) && op[opbase].is_4op) {
+				if ((chip->adlibreg[0x105]&1) && chip->op[opbase].is_4op) {
 					// turn off chan+3 operators as well
-					disable_operator(&op[opbase+3],OP_ACT_NORMAL);
-					disable_operator(&op[opbase+3+9],OP_ACT_NORMAL);
+					disable_operator(&chip->op[opbase+3],OP_ACT_NORMAL);
+					disable_operator(&chip->op[opbase+3+9],OP_ACT_NORMAL);
 				}
 #endif
 			}
@@ -986,14 +1038,14 @@ void adlib_write(Bitu idx, Bit8u val) {
 
 			// change frequency calculations of modulator and carrier (2op) as
 			// the frequency of the channel has changed
-			change_frequency(chanbase,modbase,&op[opbase]);
-			change_frequency(chanbase,modbase+3,&op[opbase+9]);
+			change_frequency(chip, chanbase,modbase,&chip->op[opbase]);
+			change_frequency(chip, chanbase,modbase+3,&chip->op[opbase+9]);
 #if defined(OPLTYPE_IS_OPL3)
 			// for 4op channels all four operators are modified to the frequency of the channel
-			if ((adlibreg[0x105]&1) && op[second_set?(base+18):base].is_4op) {
+			if ((chip->adlibreg[0x105]&1) && chip->op[second_set?(base+18):base].is_4op) {
 				// change frequency calculations of chan+3 operators as well
-				change_frequency(chanbase,modbase+8,&op[opbase+3]);
-				change_frequency(chanbase,modbase+3+8,&op[opbase+3+9]);
+				change_frequency(chip, chanbase,modbase+8,&chip->op[opbase+3]);
+				change_frequency(chip, chanbase,modbase+3+8,&chip->op[opbase+3+9]);
 			}
 #endif
 		}
@@ -1005,11 +1057,11 @@ void adlib_write(Bitu idx, Bit8u val) {
 		if (base<9) {
 			Bits opbase = second_set?(base+18):base;
 			Bitu chanbase = base+second_set;
-			change_feedback(chanbase,&op[opbase]);
+			change_feedback(chip, chanbase,&chip->op[opbase]);
 #if defined(OPLTYPE_IS_OPL3)
 			// OPL3 panning
-			op[opbase].left_pan = ((val&0x10)>>4);
-			op[opbase].right_pan = ((val&0x20)>>5);
+			chip->op[opbase].left_pan = ((val&0x10)>>4);
+			chip->op[opbase].right_pan = ((val&0x20)>>5);
 #endif
 		}
 		}
@@ -1022,16 +1074,16 @@ void adlib_write(Bitu idx, Bit8u val) {
 #if defined(OPLTYPE_IS_OPL3)
 			Bits wselbase = second_set?(base+22):base;	// for easier mapping onto wave_sel[]
 			// change waveform
-			if (adlibreg[0x105]&1) wave_sel[wselbase] = val&7;	// opl3 mode enabled, all waveforms accessible
-			else wave_sel[wselbase] = val&3;
-			op_type* op_ptr = &op[regbase2modop[wselbase]+((num<3) ? 0 : 9)];
-			change_waveform(wselbase,op_ptr);
+			if (chip->adlibreg[0x105]&1) chip->wave_sel[wselbase] = val&7;	// opl3 mode enabled, all waveforms accessible
+			else chip->wave_sel[wselbase] = val&3;
+			op_type* op_ptr = &chip->op[regbase2modop[wselbase]+((num<3) ? 0 : 9)];
+			change_waveform(chip, wselbase,op_ptr);
 #else
-			if (adlibreg[0x01]&0x20) {
+			if (chip->adlibreg[0x01]&0x20) {
 				// wave selection enabled, change waveform
-				wave_sel[base] = val&3;
-				op_type* op_ptr = &op[regbase2modop[base]+((num<3) ? 0 : 9)];
-				change_waveform(base,op_ptr);
+				chip->wave_sel[base] = val&3;
+				op_type* op_ptr = &chip->op[regbase2modop[base]+((num<3) ? 0 : 9)];
+				change_waveform(chip, base,op_ptr);
 			}
 #endif
 		}
@@ -1043,29 +1095,29 @@ void adlib_write(Bitu idx, Bit8u val) {
 }
 
 
-Bitu adlib_reg_read(Bitu port) {
+Bitu adlib_reg_read(OPLChip* chip, Bitu port) {
 #if defined(OPLTYPE_IS_OPL3)
 	// opl3-detection routines require ret&6 to be zero
 	if ((port&1)==0) {
-		return status;
+		return chip->status;
 	}
 	return 0x00;
 #else
 	// opl2-detection routines require ret&6 to be 6
 	if ((port&1)==0) {
-		return status|6;
+		return chip->status|6;
 	}
 	return 0xff;
 #endif
 }
 
-void adlib_write_index(Bitu port, Bit8u val) {
+void adlib_write_index(OPLChip* chip, Bitu port, Bit8u val) {
 	(void) port;
-	opl_index = val;
+	chip->opl_index = val;
 #if defined(OPLTYPE_IS_OPL3)
 	if ((port&3)!=0) {
 		// possibly second set
-		if (((adlibreg[0x105]&1)!=0) || (opl_index==5)) opl_index |= ARC_SECONDSET;
+		if (((chip->adlibreg[0x105]&1)!=0) || (chip->opl_index==5)) chip->opl_index |= ARC_SECONDSET;
 	}
 #endif
 }
@@ -1090,7 +1142,7 @@ OPL_INLINE static void clipit16(Bit32s ival, Bit16s* outval) {
 #undef CHANVAL_OUT
 #if defined(OPLTYPE_IS_OPL3)
 #define CHANVAL_OUT									\
-	if (adlibreg[0x105]&1) {						\
+	if (chip->adlibreg[0x105]&1) {						\
 		outbufl[i] += chanval*cptr[0].left_pan;		\
 		outbufr[i] += chanval*cptr[0].right_pan;	\
 	} else {										\
@@ -1101,7 +1153,339 @@ OPL_INLINE static void clipit16(Bit32s ival, Bit16s* outval) {
 	outbufl[i] += chanval;
 #endif
 
-void adlib_getsample(Bit16s* sndptr, Bits numsamples) {
+// Block fast path
+//
+// Within one call to adlib_getsample nothing but the operators themselves change their state,
+// and an operator only depends on the other operators of its channel through their output at the
+// same sample.  So instead of running each channel sample by sample, the channels queue their
+// operators and get mixed once the whole block has been run an operator at a time: first the
+// waveform positions, then the envelope, then the output.  The arithmetic is the same as in
+// operator_advance, opfuncs and operator_output, in the same order, so the output is
+// bit-identical.
+//
+// Feedback makes an operator's output depend on its previous sample, so the operators with
+// feedback are run side by side, which lets their latency overlap.  The rest are independent
+// from sample to sample and are run four samples at a time.
+
+// queues an operator for the current block and returns its job
+static Bits queue_operator(OPLChip* chip, op_type* op_pt, const Bit32s* vib, const Bit32s* trem, Bits modulator, bool feedback, Bits count) {
+	Bits job = chip->block_job_count++;
+	operator_job* job_pt = &chip->block_jobs[job];
+
+	job_pt->op_pt = op_pt;
+	job_pt->vibrato = (vib != vibval_const);
+	if (job_pt->vibrato) memcpy(chip->block_vib[job], vib, count*sizeof(Bit32s));	// vib tables get reused by the next channel
+	job_pt->trem = trem;
+	job_pt->modulator = modulator;
+	job_pt->feedback = feedback && (op_pt->mfbi != 0);	// no feedback amount is the same as no modulation
+	return job;
+}
+
+// queues a channel to be mixed as (out1 + out2) * scale
+static void queue_channel(OPLChip* chip, const op_type* cptr, Bits out1, Bits out2, Bit32s scale) {
+	channel_job* channel = &chip->block_channels[chip->block_channel_count++];
+	channel->cptr = cptr;
+	channel->out1 = out1;
+	channel->out2 = out2;
+	channel->scale = scale;
+}
+
+// waveform positions of a block, as operator_advance() does them
+static void operator_advance_block(OPLChip* chip, Bits job, Bits count) {
+	op_type* op_pt = chip->block_jobs[job].op_pt;
+	Bit32u* wfpos = chip->block_wfpos[job];
+	Bit32u tcount = op_pt->tcount;
+	const Bit32u tinc = op_pt->tinc;
+
+	if (!chip->block_jobs[job].vibrato) {
+		// evenly spaced
+		for (Bits i=0; i<count; i++) wfpos[i] = tcount + (Bit32u)i*tinc;
+		tcount += (Bit32u)count*tinc;
+	} else {
+		const Bit32s* vib = chip->block_vib[job];
+		for (Bits i=0; i<count; i++) {
+			wfpos[i] = tcount;
+			tcount += tinc;
+			tcount += (Bit32s)(tinc)*vib[i]/FIXEDPT;
+		}
+	}
+
+	op_pt->wfpos = wfpos[count-1];
+	op_pt->tcount = tcount;
+}
+
+// decay of operator_decay() until the state changes, returns the next sample
+static Bits operator_decay_run(OPLChip* chip, op_type* op_pt, Bits i, Bits count, fltype* step_amp) {
+	fltype amp = op_pt->amp, cur_step_amp = op_pt->step_amp;
+	const fltype sustain_level = op_pt->sustain_level, decaymul = op_pt->decaymul;
+	Bit32u generator_pos = op_pt->generator_pos;
+	Bits cur_env_step = op_pt->cur_env_step;
+	Bit32u op_state = OF_TYPE_DEC;
+
+	while (i<count && op_state == OF_TYPE_DEC) {
+		generator_pos += chip->generator_add;
+		if (amp > sustain_level) amp *= decaymul;
+
+		Bit32u num_steps_add = generator_pos/FIXEDPT;
+		for (Bit32u ct=0; ct<num_steps_add; ct++) {
+			cur_env_step++;
+			if ((cur_env_step & op_pt->env_step_d)==0) {
+				if (amp <= sustain_level) {
+					if (op_pt->sus_keep) {
+						op_state = OF_TYPE_SUS;
+						amp = sustain_level;
+					} else {
+						op_state = OF_TYPE_SUS_NOKEEP;
+					}
+				}
+				cur_step_amp = amp;
+			}
+		}
+		generator_pos -= num_steps_add*FIXEDPT;
+
+		step_amp[i++] = cur_step_amp;
+	}
+
+	op_pt->amp = amp;
+	op_pt->step_amp = cur_step_amp;
+	op_pt->generator_pos = generator_pos;
+	op_pt->cur_env_step = cur_env_step;
+	op_pt->op_state = op_state;
+	return i;
+}
+
+// release of operator_release() until the state changes, returns the next sample
+static Bits operator_release_run(OPLChip* chip, op_type* op_pt, Bits i, Bits count, fltype* step_amp) {
+	fltype amp = op_pt->amp, cur_step_amp = op_pt->step_amp;
+	const fltype releasemul = op_pt->releasemul;
+	Bit32u generator_pos = op_pt->generator_pos;
+	Bits cur_env_step = op_pt->cur_env_step;
+	const Bit32u start_state = op_pt->op_state;
+	Bit32u op_state = start_state;
+
+	while (i<count && op_state == start_state) {
+		generator_pos += chip->generator_add;
+		if (amp > 0.00000001) amp *= releasemul;
+
+		Bit32u num_steps_add = generator_pos/FIXEDPT;
+		for (Bit32u ct=0; ct<num_steps_add; ct++) {
+			cur_env_step++;
+			if ((cur_env_step & op_pt->env_step_r)==0) {
+				if (amp <= 0.00000001) {
+					amp = 0.0;
+					if (op_state == OF_TYPE_REL) op_state = OF_TYPE_OFF;
+				}
+				cur_step_amp = amp;
+			}
+		}
+		generator_pos -= num_steps_add*FIXEDPT;
+
+		if (op_state != OF_TYPE_OFF) step_amp[i] = cur_step_amp;
+		i++;
+	}
+
+	op_pt->amp = amp;
+	op_pt->step_amp = cur_step_amp;
+	op_pt->generator_pos = generator_pos;
+	op_pt->cur_env_step = cur_env_step;
+	op_pt->op_state = op_state;
+	return i;
+}
+
+// envelope of a block, as opfuncs do it
+static void operator_envelope_block(OPLChip* chip, Bits job, Bits count) {
+	op_type* op_pt = chip->block_jobs[job].op_pt;
+	fltype* step_amp = chip->block_step_amp[job];
+
+	if (op_pt->op_state == OF_TYPE_OFF) {
+		op_pt->generator_pos += (Bit32u)count*chip->generator_add;
+		chip->block_jobs[job].active = 0;
+		return;
+	}
+
+	if (op_pt->op_state == OF_TYPE_SUS) {
+		// sustain only counts steps and never changes state
+		Bit32u generator_pos = op_pt->generator_pos + (Bit32u)count*chip->generator_add;
+		Bit32u num_steps_add = generator_pos/FIXEDPT;
+		op_pt->cur_env_step += num_steps_add;
+		op_pt->generator_pos = generator_pos - num_steps_add*FIXEDPT;
+
+		for (Bits i=0; i<count; i++) step_amp[i] = op_pt->step_amp;
+		chip->block_jobs[job].active = count;
+		return;
+	}
+
+	// attack, decay and release can change state on any sample
+	for (Bits i=0; i<count; ) {
+		switch (op_pt->op_state) {
+		case OF_TYPE_DEC:
+			i = operator_decay_run(chip, op_pt, i, count, step_amp);
+			break;
+		case OF_TYPE_REL:
+		case OF_TYPE_SUS_NOKEEP:
+			i = operator_release_run(chip, op_pt, i, count, step_amp);
+			break;
+		default:
+			op_pt->generator_pos += chip->generator_add;
+			opfuncs[op_pt->op_state](op_pt);
+			step_amp[i++] = op_pt->step_amp;
+			break;
+		}
+
+		// only release turns an operator off, and then the sample it did so in has no output
+		if (op_pt->op_state == OF_TYPE_OFF) {
+			op_pt->generator_pos += (Bit32u)(count-i)*chip->generator_add;
+			chip->block_jobs[job].active = i-1;
+			return;
+		}
+	}
+	chip->block_jobs[job].active = count;
+}
+
+// output of a block without feedback, as operator_output() does it
+static void operator_output_block(OPLChip* chip, Bits job, Bits count) {
+	op_type* op_pt = chip->block_jobs[job].op_pt;
+	const Bits active = chip->block_jobs[job].active;
+	const Bit32s* modulator = (chip->block_jobs[job].modulator >= 0) ? chip->block_out[chip->block_jobs[job].modulator] : NULL;
+	const Bit32s* trem = chip->block_jobs[job].trem;
+	const Bit32u* wfpos = chip->block_wfpos[job];
+	const fltype* step_amp = chip->block_step_amp[job];
+	const Bit16s* wform = op_pt->cur_wform;
+	const Bit32u wmask = op_pt->cur_wmask;
+	Bit32s* out = chip->block_out[job];
+	Bits i = 0;
+
+#if defined(OPL_USE_SSE2)
+	const __m128i mask = _mm_set1_epi32((int)wmask);
+	const __m128d vol = _mm_set1_pd(op_pt->vol), sixteenth = _mm_set1_pd(1.0/16.0);	// exact, so the same as /16.0
+	for (; i+4<=active; i+=4) {
+		__m128i pos = _mm_loadu_si128((const __m128i*)&wfpos[i]);
+		if (modulator != NULL) pos = _mm_add_epi32(pos, _mm_slli_epi32(_mm_loadu_si128((const __m128i*)&modulator[i]), 16));
+		Bit32u idx[4];
+		_mm_storeu_si128((__m128i*)idx, _mm_and_si128(_mm_srli_epi32(pos, 16), mask));
+
+		const __m128i w = _mm_setr_epi32(wform[idx[0]], wform[idx[1]], wform[idx[2]], wform[idx[3]]);
+		const __m128i t = _mm_loadu_si128((const __m128i*)&trem[i]);
+
+		__m128d lo = _mm_mul_pd(_mm_loadu_pd(&step_amp[i]), vol);
+		__m128d hi = _mm_mul_pd(_mm_loadu_pd(&step_amp[i+2]), vol);
+		lo = _mm_mul_pd(_mm_mul_pd(_mm_mul_pd(lo, _mm_cvtepi32_pd(w)), _mm_cvtepi32_pd(t)), sixteenth);
+		hi = _mm_mul_pd(_mm_mul_pd(_mm_mul_pd(hi, _mm_cvtepi32_pd(_mm_srli_si128(w, 8))), _mm_cvtepi32_pd(_mm_srli_si128(t, 8))), sixteenth);
+
+		_mm_storeu_si128((__m128i*)&out[i], _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo), _mm_cvttpd_epi32(hi)));
+	}
+#endif
+	for (; i<active; i++) {
+		Bit32s mod = (modulator != NULL) ? modulator[i]*FIXEDPT : 0;
+		Bit32u idx = (Bit32u)((wfpos[i]+mod)/FIXEDPT);
+		out[i] = (Bit32s)(step_amp[i]*op_pt->vol*wform[idx&wmask]*trem[i]/16.0);
+	}
+
+	if (active > 0) {
+		op_pt->lastcval = (active >= 2) ? out[active-2] : op_pt->cval;
+		op_pt->cval = out[active-1];
+	}
+
+	// an operator that is off keeps its last output
+	for (i=active; i<count; i++) out[i] = op_pt->cval;
+}
+
+// output of a block for all operators with feedback, as operator_output() does it
+static void feedback_output_block(OPLChip* chip, const Bits* jobs, Bits job_count, Bits count) {
+	// local copies, so that writing the output does not make the compiler reload them
+	Bit32s cval[MAXOPERATORS], lastcval[MAXOPERATORS], mfbi[MAXOPERATORS];
+	fltype vol[MAXOPERATORS];
+	for (Bits j=0; j<job_count; j++) {
+		const op_type* op_pt = chip->block_jobs[jobs[j]].op_pt;
+		cval[j] = op_pt->cval;
+		lastcval[j] = op_pt->lastcval;
+		mfbi[j] = op_pt->mfbi;
+		vol[j] = op_pt->vol;
+	}
+
+	for (Bits i=0; i<count; i++) {
+		for (Bits j=0; j<job_count; j++) {
+			const Bits job = jobs[j];
+
+			if (i < chip->block_jobs[job].active) {
+				const op_type* op_pt = chip->block_jobs[job].op_pt;
+				Bit32s fb = (lastcval[j]+cval[j])*mfbi[j]/2;
+				lastcval[j] = cval[j];
+				Bit32u idx = (Bit32u)((chip->block_wfpos[job][i]+fb)/FIXEDPT);
+				cval[j] = (Bit32s)(chip->block_step_amp[job][i]*vol[j]*op_pt->cur_wform[idx&op_pt->cur_wmask]*chip->block_jobs[job].trem[i]/16.0);
+			}
+			chip->block_out[job][i] = cval[j];
+		}
+	}
+
+	for (Bits j=0; j<job_count; j++) {
+		op_type* op_pt = chip->block_jobs[jobs[j]].op_pt;
+		op_pt->cval = cval[j];
+		op_pt->lastcval = lastcval[j];
+	}
+}
+
+// mixes a channel into the output
+static void channel_output_block(OPLChip* chip, const channel_job* channel, Bits count, Bit32s* outbufl, Bit32s* outbufr) {
+	const Bit32s* out1 = chip->block_out[channel->out1];
+	const Bit32s* out2 = (channel->out2 >= 0) ? chip->block_out[channel->out2] : NULL;
+	const Bit32s scale = channel->scale;
+	Bits i = 0;
+
+#if defined(OPLTYPE_IS_OPL3)
+	if (chip->adlibreg[0x105]&1) {
+		for (; i<count; i++) {
+			Bit32s chanval = (out1[i] + (out2 != NULL ? out2[i] : 0))*scale;
+			outbufl[i] += chanval*channel->cptr[0].left_pan;
+			outbufr[i] += chanval*channel->cptr[0].right_pan;
+		}
+		return;
+	}
+#else
+	(void)outbufr;
+#endif
+#if defined(OPL_USE_SSE2)
+	for (; i+4<=count; i+=4) {
+		__m128i chanval = _mm_loadu_si128((const __m128i*)&out1[i]);
+		if (out2 != NULL) chanval = _mm_add_epi32(chanval, _mm_loadu_si128((const __m128i*)&out2[i]));
+		if (scale == 2) chanval = _mm_add_epi32(chanval, chanval);
+		_mm_storeu_si128((__m128i*)&outbufl[i], _mm_add_epi32(_mm_loadu_si128((const __m128i*)&outbufl[i]), chanval));
+	}
+#endif
+	for (; i<count; i++) {
+		Bit32s chanval = (out1[i] + (out2 != NULL ? out2[i] : 0))*scale;
+		outbufl[i] += chanval;
+	}
+}
+
+// runs the queued operators over the block and mixes the queued channels
+static void run_block(OPLChip* chip, Bits count, Bit32s* outbufl, Bit32s* outbufr) {
+	Bits feedback_jobs[MAXOPERATORS];
+	Bits feedback_job_count = 0;
+
+	for (Bits job=0; job<chip->block_job_count; job++) {
+		operator_advance_block(chip, job, count);
+		operator_envelope_block(chip, job, count);
+		if (chip->block_jobs[job].feedback) feedback_jobs[feedback_job_count++] = job;
+	}
+
+	// operators with feedback are never modulated by another, so they can go first
+	feedback_output_block(chip, feedback_jobs, feedback_job_count, count);
+
+	// modulators are always queued before what they modulate
+	for (Bits job=0; job<chip->block_job_count; job++) {
+		if (!chip->block_jobs[job].feedback) operator_output_block(chip, job, count);
+	}
+
+	for (Bits c=0; c<chip->block_channel_count; c++) {
+		channel_output_block(chip, &chip->block_channels[c], count, outbufl, outbufr);
+	}
+
+	chip->block_job_count = 0;
+	chip->block_channel_count = 0;
+}
+
+void adlib_getsample(OPLChip* chip, Bit16s* sndptr, Bits numsamples) {
 	Bits i, endsamples;
 	op_type* cptr;
 
@@ -1109,12 +1493,18 @@ void adlib_getsample(Bit16s* sndptr, Bits numsamples) {
 #if defined(OPLTYPE_IS_OPL3)
 	// second output buffer (right channel for opl3 stereo)
 	Bit32s outbufr[BLOCKBUF_SIZE];
+#else
+	Bit32s* const outbufr = NULL;
 #endif
 
 	// vibrato/tremolo lookup tables (global, to possibly be used by all operators)
 	Bit32s vib_lut[BLOCKBUF_SIZE];
 	Bit32s trem_lut[BLOCKBUF_SIZE];
 
+	// vibrato/trmolo value table pointers
+	Bit32s *vibval1, *vibval2, *vibval3, *vibval4;
+	Bit32s *tremval1, *tremval2, *tremval3, *tremval4;
+
 	Bits samples_to_process = numsamples;
 
 	for (Bits cursmp=0; cursmp<samples_to_process; cursmp+=endsamples) {
@@ -1124,32 +1514,32 @@ void adlib_getsample(Bit16s* sndptr, Bits numsamples) {
 		memset((void*)&outbufl,0,endsamples*sizeof(Bit32s));
 #if defined(OPLTYPE_IS_OPL3)
 		// clear second output buffer (opl3 stereo)
-		if (adlibreg[0x105]&1) memset((void*)&outbufr,0,endsamples*sizeof(Bit32s));
+		if (chip->adlibreg[0x105]&1) memset((void*)&outbufr,0,endsamples*sizeof(Bit32s));
 #endif
 
 		// calculate vibrato/tremolo lookup tables
-		Bit32s vib_tshift = ((adlibreg[ARC_PERC_MODE]&0x40)==0) ? 1 : 0;	// 14cents/7cents switching
+		Bit32s vib_tshift = ((chip->adlibreg[ARC_PERC_MODE]&0x40)==0) ? 1 : 0;	// 14cents/7cents switching
 		for (i=0;i<endsamples;i++) {
 			// cycle through vibrato table
-			vibtab_pos += vibtab_add;
-			if (vibtab_pos/FIXEDPT_LFO>=VIBTAB_SIZE) vibtab_pos-=VIBTAB_SIZE*FIXEDPT_LFO;
-			vib_lut[i] = vib_table[vibtab_pos/FIXEDPT_LFO]>>vib_tshift;		// 14cents (14/100 of a semitone) or 7cents
+			chip->vibtab_pos += chip->vibtab_add;
+			if (chip->vibtab_pos/FIXEDPT_LFO>=VIBTAB_SIZE) chip->vibtab_pos-=VIBTAB_SIZE*FIXEDPT_LFO;
+			vib_lut[i] = vib_table[chip->vibtab_pos/FIXEDPT_LFO]>>vib_tshift;		// 14cents (14/100 of a semitone) or 7cents
 
 			// cycle through tremolo table
-			tremtab_pos += tremtab_add;
-			if (tremtab_pos/FIXEDPT_LFO>=TREMTAB_SIZE) tremtab_pos-=TREMTAB_SIZE*FIXEDPT_LFO;
-			if (adlibreg[ARC_PERC_MODE]&0x80) trem_lut[i] = trem_table[tremtab_pos/FIXEDPT_LFO];
-			else trem_lut[i] = trem_table[TREMTAB_SIZE+tremtab_pos/FIXEDPT_LFO];
+			chip->tremtab_pos += chip->tremtab_add;
+			if (chip->tremtab_pos/FIXEDPT_LFO>=TREMTAB_SIZE) chip->tremtab_pos-=TREMTAB_SIZE*FIXEDPT_LFO;
+			if (chip->adlibreg[ARC_PERC_MODE]&0x80) trem_lut[i] = trem_table[chip->tremtab_pos/FIXEDPT_LFO];
+			else trem_lut[i] = trem_table[TREMTAB_SIZE+chip->tremtab_pos/FIXEDPT_LFO];
 		}
 
-		if (adlibreg[ARC_PERC_MODE]&0x20) {
+		if (chip->adlibreg[ARC_PERC_MODE]&0x20) {
 			//BassDrum
-			cptr = &op[6];
-			if (adlibreg[ARC_FEEDBACK+6]&1) {
+			cptr = &chip->op[6];
+			if (chip->adlibreg[ARC_FEEDBACK+6]&1) {
 				// additive synthesis
 				if (cptr[9].op_state != OF_TYPE_OFF) {
 					if (cptr[9].vibrato) {
-						vibval1 = vibval_var1;
+						vibval1 = chip->vibval_var1;
 						for (i=0;i<endsamples;i++)
 							vibval1[i] = (Bit32s)((vib_lut[i]*cptr[9].freq_high/8)*FIXEDPT*VIBFAC);
 					} else vibval1 = vibval_const;
@@ -1157,25 +1547,19 @@ void adlib_getsample(Bit16s* sndptr, Bits numsamples) {
 					else tremval1 = tremval_const;
 
 					// calculate channel output
-					for (i=0;i<endsamples;i++) {
-						operator_advance(&cptr[9],vibval1[i]);
-						opfuncs[cptr[9].op_state](&cptr[9]);
-						operator_output(&cptr[9],0,tremval1[i]);
-						
-						Bit32s chanval = cptr[9].cval*2;
-						CHANVAL_OUT
-					}
+					Bits job1 = queue_operator(chip, &cptr[9], vibval1, tremval1, -1, false, endsamples);
+					queue_channel(chip, cptr, job1, -1, 2);
 				}
 			} else {
 				// frequency modulation
 				if ((cptr[9].op_state != OF_TYPE_OFF) || (cptr[0].op_state != OF_TYPE_OFF)) {
 					if ((cptr[0].vibrato) && (cptr[0].op_state != OF_TYPE_OFF)) {
-						vibval1 = vibval_var1;
+						vibval1 = chip->vibval_var1;
 						for (i=0;i<endsamples;i++)
 							vibval1[i] = (Bit32s)((vib_lut[i]*cptr[0].freq_high/8)*FIXEDPT*VIBFAC);
 					} else vibval1 = vibval_const;
 					if ((cptr[9].vibrato) && (cptr[9].op_state != OF_TYPE_OFF)) {
-						vibval2 = vibval_var2;
+						vibval2 = chip->vibval_var2;
 						for (i=0;i<endsamples;i++)
 							vibval2[i] = (Bit32s)((vib_lut[i]*cptr[9].freq_high/8)*FIXEDPT*VIBFAC);
 					} else vibval2 = vibval_const;
@@ -1185,26 +1569,17 @@ void adlib_getsample(Bit16s* sndptr, Bits numsamples) {
 					else tremval2 = tremval_const;
 
 					// calculate channel output
-					for (i=0;i<endsamples;i++) {
-						operator_advance(&cptr[0],vibval1[i]);
-						opfuncs[cptr[0].op_state](&cptr[0]);
-						operator_output(&cptr[0],(cptr[0].lastcval+cptr[0].cval)*cptr[0].mfbi/2,tremval1[i]);
-
-						operator_advance(&cptr[9],vibval2[i]);
-						opfuncs[cptr[9].op_state](&cptr[9]);
-						operator_output(&cptr[9],cptr[0].cval*FIXEDPT,tremval2[i]);
-						
-						Bit32s chanval = cptr[9].cval*2;
-						CHANVAL_OUT
-					}
+					Bits job1 = queue_operator(chip, &cptr[0], vibval1, tremval1, -1, true, endsamples);
+					Bits job2 = queue_operator(chip, &cptr[9], vibval2, tremval2, job1, false, endsamples);
+					queue_channel(chip, cptr, job2, -1, 2);
 				}
 			}
 
 			//TomTom (j=8)
-			if (op[8].op_state != OF_TYPE_OFF) {
-				cptr = &op[8];
+			if (chip->op[8].op_state != OF_TYPE_OFF) {
+				cptr = &chip->op[8];
 				if (cptr[0].vibrato) {
-					vibval3 = vibval_var1;
+					vibval3 = chip->vibval_var1;
 					for (i=0;i<endsamples;i++)
 						vibval3[i] = (Bit32s)((vib_lut[i]*cptr[0].freq_high/8)*FIXEDPT*VIBFAC);
 				} else vibval3 = vibval_const;
@@ -1213,26 +1588,21 @@ void adlib_getsample(Bit16s* sndptr, Bits numsamples) {
 				else tremval3 = tremval_const;
 
 				// calculate channel output
-				for (i=0;i<endsamples;i++) {
-					operator_advance(&cptr[0],vibval3[i]);
-					opfuncs[cptr[0].op_state](&cptr[0]);		//TomTom
-					operator_output(&cptr[0],0,tremval3[i]);
-					Bit32s chanval = cptr[0].cval*2;
-					CHANVAL_OUT
-				}
+				Bits job1 = queue_operator(chip, &cptr[0], vibval3, tremval3, -1, false, endsamples);
+				queue_channel(chip, cptr, job1, -1, 2);
 			}
 
 			//Snare/Hihat (j=7), Cymbal (j=8)
-			if ((op[7].op_state != OF_TYPE_OFF) || (op[16].op_state != OF_TYPE_OFF) ||
-				(op[17].op_state != OF_TYPE_OFF)) {
-				cptr = &op[7];
+			if ((chip->op[7].op_state != OF_TYPE_OFF) || (chip->op[16].op_state != OF_TYPE_OFF) ||
+				(chip->op[17].op_state != OF_TYPE_OFF)) {
+				cptr = &chip->op[7];
 				if ((cptr[0].vibrato) && (cptr[0].op_state != OF_TYPE_OFF)) {
-					vibval1 = vibval_var1;
+					vibval1 = chip->vibval_var1;
 					for (i=0;i<endsamples;i++)
 						vibval1[i] = (Bit32s)((vib_lut[i]*cptr[0].freq_high/8)*FIXEDPT*VIBFAC);
 				} else vibval1 = vibval_const;
 				if ((cptr[9].vibrato) && (cptr[9].op_state == OF_TYPE_OFF)) {
-					vibval2 = vibval_var2;
+					vibval2 = chip->vibval_var2;
 					for (i=0;i<endsamples;i++)
 						vibval2[i] = (Bit32s)((vib_lut[i]*cptr[9].freq_high/8)*FIXEDPT*VIBFAC);
 				} else vibval2 = vibval_const;
@@ -1242,9 +1612,9 @@ void adlib_getsample(Bit16s* sndptr, Bits numsamples) {
 				if (cptr[9].tremolo) tremval2 = trem_lut;	// tremolo enabled, use table
 				else tremval2 = tremval_const;
 
-				cptr = &op[8];
+				cptr = &chip->op[8];
 				if ((cptr[9].vibrato) && (cptr[9].op_state == OF_TYPE_OFF)) {
-					vibval4 = vibval_var2;
+					vibval4 = chip->vibval_var2;
 					for (i=0;i<endsamples;i++)
 						vibval4[i] = (Bit32s)((vib_lut[i]*cptr[9].freq_high/8)*FIXEDPT*VIBFAC);
 				} else vibval4 = vibval_const;
@@ -1254,18 +1624,18 @@ void adlib_getsample(Bit16s* sndptr, Bits numsamples) {
 
 				// calculate channel output
 				for (i=0;i<endsamples;i++) {
-					operator_advance_drums(&op[7],vibval1[i],&op[7+9],vibval2[i],&op[8+9],vibval4[i]);
+					operator_advance_drums(chip, &chip->op[7],vibval1[i],&chip->op[7+9],vibval2[i],&chip->op[8+9],vibval4[i]);
 
-					opfuncs[op[7].op_state](&op[7]);			//Hihat
-					operator_output(&op[7],0,tremval1[i]);
+					opfuncs[chip->op[7].op_state](&chip->op[7]);			//Hihat
+					operator_output(&chip->op[7],0,tremval1[i]);
 
-					opfuncs[op[7+9].op_state](&op[7+9]);		//Snare
-					operator_output(&op[7+9],0,tremval2[i]);
+					opfuncs[chip->op[7+9].op_state](&chip->op[7+9]);		//Snare
+					operator_output(&chip->op[7+9],0,tremval2[i]);
 
-					opfuncs[op[8+9].op_state](&op[8+9]);		//Cymbal
-					operator_output(&op[8+9],0,tremval4[i]);
+					opfuncs[chip->op[8+9].op_state](&chip->op[8+9]);		//Cymbal
+					operator_output(&chip->op[8+9],0,tremval4[i]);
 
-					Bit32s chanval = (op[7].cval + op[7+9].cval + op[8+9].cval)*2;
+					Bit32s chanval = (chip->op[7].cval + chip->op[7+9].cval + chip->op[8+9].cval)*2;
 					CHANVAL_OUT
 				}
 			}
@@ -1273,35 +1643,35 @@ void adlib_getsample(Bit16s* sndptr, Bits numsamples) {
 
 		Bitu max_channel = NUM_CHANNELS;
 #if defined(OPLTYPE_IS_OPL3)
-		if ((adlibreg[0x105]&1)==0) max_channel = NUM_CHANNELS/2;
+		if ((chip->adlibreg[0x105]&1)==0) max_channel = NUM_CHANNELS/2;
 #endif
 		for (Bits cur_ch=max_channel-1; cur_ch>=0; cur_ch--) {
 			// skip drum/percussion operators
-			if ((adlibreg[ARC_PERC_MODE]&0x20) && (cur_ch >= 6) && (cur_ch < 9)) continue;
+			if ((chip->adlibreg[ARC_PERC_MODE]&0x20) && (cur_ch >= 6) && (cur_ch < 9)) continue;
 
 			Bitu k = cur_ch;
 #if defined(OPLTYPE_IS_OPL3)
 			if (cur_ch < 9) {
-				cptr = &op[cur_ch];
+				cptr = &chip->op[cur_ch];
 			} else {
-				cptr = &op[cur_ch+9];	// second set is operator18-operator35
+				cptr = &chip->op[cur_ch+9];	// second set is operator18-operator35
 				k += (-9+256);		// second set uses registers 0x100 onwards
 			}
 			// check if this operator is part of a 4-op
-			if ((adlibreg[0x105]&1) && cptr->is_4op_attached) continue;
+			if ((chip->adlibreg[0x105]&1) && cptr->is_4op_attached) continue;
 #else
-			cptr = &op[cur_ch];
+			cptr = &chip->op[cur_ch];
 #endif
 
 			// check for FM/AM
-			if (adlibreg[ARC_FEEDBACK+k]&1) {
+			if (chip->adlibreg[ARC_FEEDBACK+k]&1) {
 #if defined(OPLTYPE_IS_OPL3)
-				if ((adlibreg[0x105]&1) && cptr->is_4op) {
-					if (adlibreg[ARC_FEEDBACK+k+3]&1) {
+				if ((chip->adlibreg[0x105]&1) && cptr->is_4op) {
+					if (chip->adlibreg[ARC_FEEDBACK+k+3]&1) {
 						// AM-AM-style synthesis (op1[fb] + (op2 * op3) + op4)
 						if (cptr[0].op_state != OF_TYPE_OFF) {
 							if (cptr[0].vibrato) {
-								vibval1 = vibval_var1;
+								vibval1 = chip->vibval_var1;
 								for (i=0;i<endsamples;i++)
 									vibval1[i] = (Bit32s)((vib_lut[i]*cptr[0].freq_high/8)*FIXEDPT*VIBFAC);
 							} else vibval1 = vibval_const;
@@ -1309,19 +1679,13 @@ void adlib_getsample(Bit16s* sndptr, Bits numsamples) {
 							else tremval1 = tremval_const;
 
 							// calculate channel output
-							for (i=0;i<endsamples;i++) {
-								operator_advance(&cptr[0],vibval1[i]);
-								opfuncs[cptr[0].op_state](&cptr[0]);
-								operator_output(&cptr[0],(cptr[0].lastcval+cptr[0].cval)*cptr[0].mfbi/2,tremval1[i]);
-
-								Bit32s chanval = cptr[0].cval;
-								CHANVAL_OUT
-							}
+							Bits job1 = queue_operator(chip, &cptr[0], vibval1, tremval1, -1, true, endsamples);
+							queue_channel(chip, cptr, job1, -1, 1);
 						}
 
 						if ((cptr[3].op_state != OF_TYPE_OFF) || (cptr[9].op_state != OF_TYPE_OFF)) {
 							if ((cptr[9].vibrato) && (cptr[9].op_state != OF_TYPE_OFF)) {
-								vibval1 = vibval_var1;
+								vibval1 = chip->vibval_var1;
 								for (i=0;i<endsamples;i++)
 									vibval1[i] = (Bit32s)((vib_lut[i]*cptr[9].freq_high/8)*FIXEDPT*VIBFAC);
 							} else vibval1 = vibval_const;
@@ -1331,18 +1695,9 @@ void adlib_getsample(Bit16s* sndptr, Bits numsamples) {
 							else tremval2 = tremval_const;
 
 							// calculate channel output
-							for (i=0;i<endsamples;i++) {
-								operator_advance(&cptr[9],vibval1[i]);
-								opfuncs[cptr[9].op_state](&cptr[9]);
-								operator_output(&cptr[9],0,tremval1[i]);
-
-								operator_advance(&cptr[3],0);
-								opfuncs[cptr[3].op_state](&cptr[3]);
-								operator_output(&cptr[3],cptr[9].cval*FIXEDPT,tremval2[i]);
-
-								Bit32s chanval = cptr[3].cval;
-								CHANVAL_OUT
-							}
+							Bits job1 = queue_operator(chip, &cptr[9], vibval1, tremval1, -1, false, endsamples);
+							Bits job2 = queue_operator(chip, &cptr[3], vibval_const, tremval2, job1, false, endsamples);
+							queue_channel(chip, cptr, job2, -1, 1);
 						}
 
 						if (cptr[3+9].op_state != OF_TYPE_OFF) {
@@ -1350,20 +1705,14 @@ void adlib_getsample(Bit16s* sndptr, Bits numsamples) {
 							else tremval1 = tremval_const;
 
 							// calculate channel output
-							for (i=0;i<endsamples;i++) {
-								operator_advance(&cptr[3+9],0);
-								opfuncs[cptr[3+9].op_state](&cptr[3+9]);
-								operator_output(&cptr[3+9],0,tremval1[i]);
-
-								Bit32s chanval = cptr[3+9].cval;
-								CHANVAL_OUT
-							}
+							Bits job1 = queue_operator(chip, &cptr[3+9], vibval_const, tremval1, -1, false, endsamples);
+							queue_channel(chip, cptr, job1, -1, 1);
 						}
 					} else {
 						// AM-FM-style synthesis (op1[fb] + (op2 * op3 * op4))
 						if (cptr[0].op_state != OF_TYPE_OFF) {
 							if (cptr[0].vibrato) {
-								vibval1 = vibval_var1;
+								vibval1 = chip->vibval_var1;
 								for (i=0;i<endsamples;i++)
 									vibval1[i] = (Bit32s)((vib_lut[i]*cptr[0].freq_high/8)*FIXEDPT*VIBFAC);
 							} else vibval1 = vibval_const;
@@ -1371,19 +1720,13 @@ void adlib_getsample(Bit16s* sndptr, Bits numsamples) {
 							else tremval1 = tremval_const;
 
 							// calculate channel output
-							for (i=0;i<endsamples;i++) {
-								operator_advance(&cptr[0],vibval1[i]);
-								opfuncs[cptr[0].op_state](&cptr[0]);
-								operator_output(&cptr[0],(cptr[0].lastcval+cptr[0].cval)*cptr[0].mfbi/2,tremval1[i]);
-
-								Bit32s chanval = cptr[0].cval;
-								CHANVAL_OUT
-							}
+							Bits job1 = queue_operator(chip, &cptr[0], vibval1, tremval1, -1, true, endsamples);
+							queue_channel(chip, cptr, job1, -1, 1);
 						}
 
 						if ((cptr[9].op_state != OF_TYPE_OFF) || (cptr[3].op_state != OF_TYPE_OFF) || (cptr[3+9].op_state != OF_TYPE_OFF)) {
 							if ((cptr[9].vibrato) && (cptr[9].op_state != OF_TYPE_OFF)) {
-								vibval1 = vibval_var1;
+								vibval1 = chip->vibval_var1;
 								for (i=0;i<endsamples;i++)
 									vibval1[i] = (Bit32s)((vib_lut[i]*cptr[9].freq_high/8)*FIXEDPT*VIBFAC);
 							} else vibval1 = vibval_const;
@@ -1395,22 +1738,10 @@ void adlib_getsample(Bit16s* sndptr, Bits numsamples) {
 							else tremval3 = tremval_const;
 
 							// calculate channel output
-							for (i=0;i<endsamples;i++) {
-								operator_advance(&cptr[9],vibval1[i]);
-								opfuncs[cptr[9].op_state](&cptr[9]);
-								operator_output(&cptr[9],0,tremval1[i]);
-
-								operator_advance(&cptr[3],0);
-								opfuncs[cptr[3].op_state](&cptr[3]);
-								operator_output(&cptr[3],cptr[9].cval*FIXEDPT,tremval2[i]);
-
-								operator_advance(&cptr[3+9],0);
-								opfuncs[cptr[3+9].op_state](&cptr[3+9]);
-								operator_output(&cptr[3+9],cptr[3].cval*FIXEDPT,tremval3[i]);
-
-								Bit32s chanval = cptr[3+9].cval;
-								CHANVAL_OUT
-							}
+							Bits job1 = queue_operator(chip, &cptr[9], vibval1, tremval1, -1, false, endsamples);
+							Bits job2 = queue_operator(chip, &cptr[3], vibval_const, tremval2, job1, false, endsamples);
+							Bits job3 = queue_operator(chip, &cptr[3+9], vibval_const, tremval3, job2, false, endsamples);
+							queue_channel(chip, cptr, job3, -1, 1);
 						}
 					}
 					continue;
@@ -1419,12 +1750,12 @@ void adlib_getsample(Bit16s* sndptr, Bits numsamples) {
 				// 2op additive synthesis
 				if ((cptr[9].op_state == OF_TYPE_OFF) && (cptr[0].op_state == OF_TYPE_OFF)) continue;
 				if ((cptr[0].vibrato) && (cptr[0].op_state != OF_TYPE_OFF)) {
-					vibval1 = vibval_var1;
+					vibval1 = chip->vibval_var1;
 					for (i=0;i<endsamples;i++)
 						vibval1[i] = (Bit32s)((vib_lut[i]*cptr[0].freq_high/8)*FIXEDPT*VIBFAC);
 				} else vibval1 = vibval_const;
 				if ((cptr[9].vibrato) && (cptr[9].op_state != OF_TYPE_OFF)) {
-					vibval2 = vibval_var2;
+					vibval2 = chip->vibval_var2;
 					for (i=0;i<endsamples;i++)
 						vibval2[i] = (Bit32s)((vib_lut[i]*cptr[9].freq_high/8)*FIXEDPT*VIBFAC);
 				} else vibval2 = vibval_const;
@@ -1434,33 +1765,22 @@ void adlib_getsample(Bit16s* sndptr, Bits numsamples) {
 				else tremval2 = tremval_const;
 
 				// calculate channel output
-				for (i=0;i<endsamples;i++) {
-					// carrier1
-					operator_advance(&cptr[0],vibval1[i]);
-					opfuncs[cptr[0].op_state](&cptr[0]);
-					operator_output(&cptr[0],(cptr[0].lastcval+cptr[0].cval)*cptr[0].mfbi/2,tremval1[i]);
-
-					// carrier2
-					operator_advance(&cptr[9],vibval2[i]);
-					opfuncs[cptr[9].op_state](&cptr[9]);
-					operator_output(&cptr[9],0,tremval2[i]);
-
-					Bit32s chanval = cptr[9].cval + cptr[0].cval;
-					CHANVAL_OUT
-				}
+				Bits job1 = queue_operator(chip, &cptr[0], vibval1, tremval1, -1, true, endsamples);
+				Bits job2 = queue_operator(chip, &cptr[9], vibval2, tremval2, -1, false, endsamples);
+				queue_channel(chip, cptr, job2, job1, 1);
 			} else {
 #if defined(OPLTYPE_IS_OPL3)
-				if ((adlibreg[0x105]&1) && cptr->is_4op) {
-					if (adlibreg[ARC_FEEDBACK+k+3]&1) {
+				if ((chip->adlibreg[0x105]&1) && cptr->is_4op) {
+					if (chip->adlibreg[ARC_FEEDBACK+k+3]&1) {
 						// FM-AM-style synthesis ((op1[fb] * op2) + (op3 * op4))
 						if ((cptr[0].op_state != OF_TYPE_OFF) || (cptr[9].op_state != OF_TYPE_OFF)) {
 							if ((cptr[0].vibrato) && (cptr[0].op_state != OF_TYPE_OFF)) {
-								vibval1 = vibval_var1;
+								vibval1 = chip->vibval_var1;
 								for (i=0;i<endsamples;i++)
 									vibval1[i] = (Bit32s)((vib_lut[i]*cptr[0].freq_high/8)*FIXEDPT*VIBFAC);
 							} else vibval1 = vibval_const;
 							if ((cptr[9].vibrato) && (cptr[9].op_state != OF_TYPE_OFF)) {
-								vibval2 = vibval_var2;
+								vibval2 = chip->vibval_var2;
 								for (i=0;i<endsamples;i++)
 									vibval2[i] = (Bit32s)((vib_lut[i]*cptr[9].freq_high/8)*FIXEDPT*VIBFAC);
 							} else vibval2 = vibval_const;
@@ -1470,18 +1790,9 @@ void adlib_getsample(Bit16s* sndptr, Bits numsamples) {
 							else tremval2 = tremval_const;
 
 							// calculate channel output
-							for (i=0;i<endsamples;i++) {
-								operator_advance(&cptr[0],vibval1[i]);
-								opfuncs[cptr[0].op_state](&cptr[0]);
-								operator_output(&cptr[0],(cptr[0].lastcval+cptr[0].cval)*cptr[0].mfbi/2,tremval1[i]);
-
-								operator_advance(&cptr[9],vibval2[i]);
-								opfuncs[cptr[9].op_state](&cptr[9]);
-								operator_output(&cptr[9],cptr[0].cval*FIXEDPT,tremval2[i]);
-
-								Bit32s chanval = cptr[9].cval;
-								CHANVAL_OUT
-							}
+							Bits job1 = queue_operator(chip, &cptr[0], vibval1, tremval1, -1, true, endsamples);
+							Bits job2 = queue_operator(chip, &cptr[9], vibval2, tremval2, job1, false, endsamples);
+							queue_channel(chip, cptr, job2, -1, 1);
 						}
 
 						if ((cptr[3].op_state != OF_TYPE_OFF) || (cptr[3+9].op_state != OF_TYPE_OFF)) {
@@ -1491,18 +1802,9 @@ void adlib_getsample(Bit16s* sndptr, Bits numsamples) {
 							else tremval2 = tremval_const;
 
 							// calculate channel output
-							for (i=0;i<endsamples;i++) {
-								operator_advance(&cptr[3],0);
-								opfuncs[cptr[3].op_state](&cptr[3]);
-								operator_output(&cptr[3],0,tremval1[i]);
-
-								operator_advance(&cptr[3+9],0);
-								opfuncs[cptr[3+9].op_state](&cptr[3+9]);
-								operator_output(&cptr[3+9],cptr[3].cval*FIXEDPT,tremval2[i]);
-
-								Bit32s chanval = cptr[3+9].cval;
-								CHANVAL_OUT
-							}
+							Bits job1 = queue_operator(chip, &cptr[3], vibval_const, tremval1, -1, false, endsamples);
+							Bits job2 = queue_operator(chip, &cptr[3+9], vibval_const, tremval2, job1, false, endsamples);
+							queue_channel(chip, cptr, job2, -1, 1);
 						}
 
 					} else {
@@ -1510,12 +1812,12 @@ void adlib_getsample(Bit16s* sndptr, Bits numsamples) {
 						if ((cptr[0].op_state != OF_TYPE_OFF) || (cptr[9].op_state != OF_TYPE_OFF) || 
 							(cptr[3].op_state != OF_TYPE_OFF) || (cptr[3+9].op_state != OF_TYPE_OFF)) {
 							if ((cptr[0].vibrato) && (cptr[0].op_state != OF_TYPE_OFF)) {
-								vibval1 = vibval_var1;
+								vibval1 = chip->vibval_var1;
 								for (i=0;i<endsamples;i++)
 									vibval1[i] = (Bit32s)((vib_lut[i]*cptr[0].freq_high/8)*FIXEDPT*VIBFAC);
 							} else vibval1 = vibval_const;
 							if ((cptr[9].vibrato) && (cptr[9].op_state != OF_TYPE_OFF)) {
-								vibval2 = vibval_var2;
+								vibval2 = chip->vibval_var2;
 								for (i=0;i<endsamples;i++)
 									vibval2[i] = (Bit32s)((vib_lut[i]*cptr[9].freq_high/8)*FIXEDPT*VIBFAC);
 							} else vibval2 = vibval_const;
@@ -1529,26 +1831,11 @@ void adlib_getsample(Bit16s* sndptr, Bits numsamples) {
 							else tremval4 = tremval_const;
 
 							// calculate channel output
-							for (i=0;i<endsamples;i++) {
-								operator_advance(&cptr[0],vibval1[i]);
-								opfuncs[cptr[0].op_state](&cptr[0]);
-								operator_output(&cptr[0],(cptr[0].lastcval+cptr[0].cval)*cptr[0].mfbi/2,tremval1[i]);
-
-								operator_advance(&cptr[9],vibval2[i]);
-								opfuncs[cptr[9].op_state](&cptr[9]);
-								operator_output(&cptr[9],cptr[0].cval*FIXEDPT,tremval2[i]);
-
-								operator_advance(&cptr[3],0);
-								opfuncs[cptr[3].op_state](&cptr[3]);
-								operator_output(&cptr[3],cptr[9].cval*FIXEDPT,tremval3[i]);
-
-								operator_advance(&cptr[3+9],0);
-								opfuncs[cptr[3+9].op_state](&cptr[3+9]);
-								operator_output(&cptr[3+9],cptr[3].cval*FIXEDPT,tremval4[i]);
-
-								Bit32s chanval = cptr[3+9].cval;
-								CHANVAL_OUT
-							}
+							Bits job1 = queue_operator(chip, &cptr[0], vibval1, tremval1, -1, true, endsamples);
+							Bits job2 = queue_operator(chip, &cptr[9], vibval2, tremval2, job1, false, endsamples);
+							Bits job3 = queue_operator(chip, &cptr[3], vibval_const, tremval3, job2, false, endsamples);
+							Bits job4 = queue_operator(chip, &cptr[3+9], vibval_const, tremval4, job3, false, endsamples);
+							queue_channel(chip, cptr, job4, -1, 1);
 						}
 					}
 					continue;
@@ -1557,12 +1844,12 @@ void adlib_getsample(Bit16s* sndptr, Bits numsamples) {
 				// 2op frequency modulation
 				if ((cptr[9].op_state == OF_TYPE_OFF) && (cptr[0].op_state == OF_TYPE_OFF)) continue;
 				if ((cptr[0].vibrato) && (cptr[0].op_state != OF_TYPE_OFF)) {
-					vibval1 = vibval_var1;
+					vibval1 = chip->vibval_var1;
 					for (i=0;i<endsamples;i++)
 						vibval1[i] = (Bit32s)((vib_lut[i]*cptr[0].freq_high/8)*FIXEDPT*VIBFAC);
 				} else vibval1 = vibval_const;
 				if ((cptr[9].vibrato) && (cptr[9].op_state != OF_TYPE_OFF)) {
-					vibval2 = vibval_var2;
+					vibval2 = chip->vibval_var2;
 					for (i=0;i<endsamples;i++)
 						vibval2[i] = (Bit32s)((vib_lut[i]*cptr[9].freq_high/8)*FIXEDPT*VIBFAC);
 				} else vibval2 = vibval_const;
@@ -1572,25 +1859,16 @@ void adlib_getsample(Bit16s* sndptr, Bits numsamples) {
 				else tremval2 = tremval_const;
 
 				// calculate channel output
-				for (i=0;i<endsamples;i++) {
-					// modulator
-					operator_advance(&cptr[0],vibval1[i]);
-					opfuncs[cptr[0].op_state](&cptr[0]);
-					operator_output(&cptr[0],(cptr[0].lastcval+cptr[0].cval)*cptr[0].mfbi/2,tremval1[i]);
-
-					// carrier
-					operator_advance(&cptr[9],vibval2[i]);
-					opfuncs[cptr[9].op_state](&cptr[9]);
-					operator_output(&cptr[9],cptr[0].cval*FIXEDPT,tremval2[i]);
-
-					Bit32s chanval = cptr[9].cval;
-					CHANVAL_OUT
-				}
+				Bits job1 = queue_operator(chip, &cptr[0], vibval1, tremval1, -1, true, endsamples);
+				Bits job2 = queue_operator(chip, &cptr[9], vibval2, tremval2, job1, false, endsamples);
+				queue_channel(chip, cptr, job2, -1, 1);
 			}
 		}
 
+		run_block(chip, endsamples, outbufl, outbufr);
+
 #if defined(OPLTYPE_IS_OPL3)
-		if (adlibreg[0x105]&1) {
+		if (chip->adlibreg[0x105]&1) {
 			// convert to 16bit samples (stereo)
 			for (i=0;i<endsamples;i++) {
 				clipit16(outbufl[i],sndptr++);
@@ -36,16 +36,25 @@ typedef int16_t		Bit16s;
 typedef uint8_t		Bit8u;
 typedef int8_t		Bit8s;
 
+// An emulated chip.  Chips share nothing that changes, so each can run on its own thread.
+typedef struct OPLChip OPLChip;
+
+// the chip that plays the music
+extern OPLChip *opl_chip;
+
 // general functions
-void adlib_init(Bit32u samplerate);
-void adlib_write(Bitu idx, Bit8u val);
-void adlib_getsample(Bit16s* sndptr, Bits numsamples);
+void adlib_init_tables(void);
+OPLChip* adlib_create(Bit32u samplerate);
+void adlib_destroy(OPLChip* chip);
+void adlib_init(OPLChip* chip, Bit32u samplerate);
+void adlib_write(OPLChip* chip, Bitu idx, Bit8u val);
+void adlib_getsample(OPLChip* chip, Bit16s* sndptr, Bits numsamples);
 
-Bitu adlib_reg_read(Bitu port);
-void adlib_write_index(Bitu port, Bit8u val);
+Bitu adlib_reg_read(OPLChip* chip, Bitu port);
+void adlib_write_index(OPLChip* chip, Bitu port, Bit8u val);
 
-#define opl_init() adlib_init(audioSampleRate)
-#define opl_write(reg, val) adlib_write(reg, val)
-#define opl_update(buf, num) adlib_getsample(buf, num)
+#define opl_init() adlib_init(opl_chip, audioSampleRate)
+#define opl_write(reg, val) adlib_write(opl_chip, reg, val)
+#define opl_update(buf, num) adlib_getsample(opl_chip, buf, num)
 
 #endif /* OPL_H */
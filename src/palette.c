@@ -34,6 +34,7 @@ int palette_count;
 
 static Palette palette;
 Uint32 rgb_palette[256], yuv_palette[256];
+uint palette_generation = 0;  // incremented whenever rgb_palette changes
 
 Palette colors;
 
@@ -73,6 +74,8 @@ void set_palette(Palette colors, unsigned int first_color, unsigned int last_col
 		rgb_palette[i] = SDL_MapRGB(main_window_tex_format, palette[i].r, palette[i].g, palette[i].b);
 		yuv_palette[i] = rgb_to_yuv(palette[i].r, palette[i].g, palette[i].b);
 	}
+	
+	++palette_generation;
 }
 
 void set_colors(SDL_Color color, unsigned int first_color, unsigned int last_color)
@@ -83,6 +86,8 @@ void set_colors(SDL_Color color, unsigned int first_color, unsigned int last_col
 		rgb_palette[i] = SDL_MapRGB(main_window_tex_format, palette[i].r, palette[i].g, palette[i].b);
 		yuv_palette[i] = rgb_to_yuv(palette[i].r, palette[i].g, palette[i].b);
 	}
+	
+	++palette_generation;
 }
 
 void init_step_fade_palette(int diff[256][3], Palette colors, unsigned int first_color, unsigned int last_color)
@@ -124,6 +129,8 @@ void step_fade_palette(int diff[256][3], int steps, unsigned int first_color, un
 		rgb_palette[i] = SDL_MapRGB(main_window_tex_format, palette[i].r, palette[i].g, palette[i].b);
 		yuv_palette[i] = rgb_to_yuv(palette[i].r, palette[i].g, palette[i].b);
 	}
+	
+	++palette_generation;
 }
 
 void fade_palette(Palette colors, int steps, unsigned int first_color, unsigned int last_color)
@@ -29,6 +29,7 @@ extern Palette palettes[];
 extern int palette_count;
 
 extern Uint32 rgb_palette[256], yuv_palette[256];
+extern uint palette_generation;
 
 extern Palette colors; // TODO: get rid of this
 
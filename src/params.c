@@ -23,8 +23,12 @@
 #include "joystick.h"
 #include "loudness.h"
 #include "network.h"
+#include "nortsong.h"
 #include "opentyr.h"
+#include "profiler.h"
 #include "varz.h"
+#include "video.h"
+#include "video_scale.h"
 #include "xmas.h"
 
 #include <assert.h>
@@ -58,6 +62,20 @@ void JE_paramCheck(int argc, char *argv[])
 		{ 'p', 'p', "net-port",          true },
 		{ 'd', 'd', "net-delay",         true },
 		
+		{ 258, 0,   "scaler-threads",    true },
+		{ 267, 0,   "render-thread",     false },
+		
+		{ 259, 0,   "headless",          false },
+		{ 260, 0,   "headless-frames",   true },
+		
+		{ 261, 0,   "profile-csv",       true },
+		{ 262, 0,   "profile-overlay",   false },
+		{ 266, 0,   "frame-pacing",      false },
+		
+		{ 263, 0,   "render-audio",      true },
+		{ 264, 0,   "render-song",       true },
+		{ 265, 0,   "render-seconds",    true },
+		
 		{ 'X', 'X', "xmas",              false },
 		{ 'c', 'c', "constant",          false },
 		{ 'k', 'k', "death",             false },
@@ -98,7 +116,21 @@ void JE_paramCheck(int argc, char *argv[])
 			       "  --net-player-number=NUMBER   Sets local player number in a networked game\n"
 			       "                               (1 or 2)\n"
 			       "  -p, --net-port=PORT          Local port to bind (default is 1333)\n"
-			       "  -d, --net-delay=FRAMES       Set lag-compensation delay (default is 1)\n", argv[0]);
+			       "  -d, --net-delay=FRAMES       Set lag-compensation delay (default is 1)\n\n"
+			       "  --scaler-threads=COUNT       Set number of threads used for scaling\n"
+			       "                               (default is one per CPU)\n"
+			       "  --render-thread              Scale frames on a separate thread\n\n"
+			       "  --headless                   Run without window, audio, or real-time\n"
+			       "                               pacing; print a hash of all frames on exit\n"
+			       "  --headless-frames=COUNT      Exit after COUNT frames when headless\n\n"
+			       "  --profile-csv=FILE           Write per-frame zone timings to FILE\n"
+			       "  --profile-overlay            Show rolling zone timings on screen\n"
+			       "  --frame-pacing               Print a histogram of frame times on exit\n\n"
+			       "  --render-audio=DIR           Write the songs and sounds to WAV files in DIR\n"
+			       "                               and exit\n"
+			       "  --render-song=NUMBER         Only write song NUMBER\n"
+			       "  --render-seconds=SECONDS     Stop songs that have not looped after SECONDS\n"
+			       "                               (default is 600)\n", argv[0]);
 			exit(0);
 			break;
 			
@@ -190,6 +222,80 @@ void JE_paramCheck(int argc, char *argv[])
 			}
 			break;
 		}
+		case 258: // --scaler-threads
+		{
+			int temp = atoi(option.arg);
+			if (temp >= 1)
+				scaler_thread_count = temp;
+			else
+			{
+				fprintf(stderr, "%s: error: invalid scaler thread count\n", argv[0]);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		}
+		case 267: // --render-thread
+			render_thread_enabled = true;
+			break;
+			
+		case 259: // --headless
+			headless = true;
+			audio_disabled = true;
+			ignore_joystick = true;
+			break;
+			
+		case 260: // --headless-frames
+		{
+			int temp = atoi(option.arg);
+			if (temp >= 1)
+				headless_frame_limit = temp;
+			else
+			{
+				fprintf(stderr, "%s: error: invalid headless frame count\n", argv[0]);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		}
+		case 261: // --profile-csv
+			profiler_csv_path = option.arg;
+			break;
+			
+		case 262: // --profile-overlay
+			profiler_overlay = true;
+			break;
+			
+		case 266: // --frame-pacing
+			frame_pacing_stats = true;
+			break;
+			
+		case 263: // --render-audio
+			render_audio_dir = option.arg;
+			break;
+			
+		case 264: // --render-song
+		{
+			int temp = atoi(option.arg);
+			if (temp >= 1)
+				render_audio_song = temp;
+			else
+			{
+				fprintf(stderr, "%s: error: invalid song number\n", argv[0]);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		}
+		case 265: // --render-seconds
+		{
+			int temp = atoi(option.arg);
+			if (temp >= 1)
+				render_audio_seconds = temp;
+			else
+			{
+				fprintf(stderr, "%s: error: invalid render length\n", argv[0]);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		}
 		case 'X':
 			override_xmas = true;
 			xmas = true;
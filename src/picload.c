@@ -25,13 +25,13 @@
 #include "video.h"
 
 #include <string.h>
-#include <stdlib.h>
 
 void JE_loadPic(SDL_Surface *screen, JE_byte PCXnumber, JE_boolean storepal)
 {
 	PCXnumber--;
 
-	FILE *f = dir_fopen_die(data_dir(), "tyrian.pic", "rb");
+	const AssetFile *pic_file = asset_open_die("tyrian.pic");
+	AssetReader reader = asset_reader(pic_file);
 
 	static bool first = true;
 	if (first)
@@ -39,20 +39,17 @@ void JE_loadPic(SDL_Surface *screen, JE_byte PCXnumber, JE_boolean storepal)
 		first = false;
 
 		Uint16 temp;
-		fread_u16_die(&temp, 1, f);
+		asset_read_u16_die(&temp, 1, &reader);
 
-		fread_s32_die(pcxpos, PCX_NUM, f);
-		pcxpos[PCX_NUM] = ftell_eof(f);
+		asset_read_s32_die(pcxpos, PCX_NUM, &reader);
+		pcxpos[PCX_NUM] = pic_file->size;
 	}
 
 	unsigned int size = pcxpos[PCXnumber + 1] - pcxpos[PCXnumber];
-	Uint8 *buffer = malloc(size);
 
-	fseek(f, pcxpos[PCXnumber], SEEK_SET);
-	fread_u8_die(buffer, size, f);
-	fclose(f);
+	asset_seek_die(&reader, pcxpos[PCXnumber]);
+	const Uint8 *p = asset_read_die(&reader, size);
 
-	Uint8 *p = buffer;
 	Uint8 *s; /* screen pointer, 8-bit specific */
 
 	s = (Uint8 *)screen->pixels;
@@ -77,8 +74,6 @@ void JE_loadPic(SDL_Surface *screen, JE_byte PCXnumber, JE_boolean storepal)
 		}
 	}
 
-	free(buffer);
-
 	memcpy(colors, palettes[pcxpal[PCXnumber]], sizeof(colors));
 
 	if (storepal)
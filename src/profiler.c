@@ -0,0 +1,216 @@
+/*
+ * OpenTyrian: A modern cross-platform port of Tyrian
+ * Copyright (C) 2007-2009  The OpenTyrian Development Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#include "profiler.h"
+
+#include "font.h"
+
+#include "SDL.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PROFILE_HISTORY 256  // frames of history for the overlay statistics
+#define PROFILE_OVERLAY_INTERVAL 30  // frames between overlay statistics updates
+
+// Column 0 is the whole frame, the rest are the zones.
+#define PROFILE_COLUMN_COUNT (1 + PROFILE_ZONE_COUNT)
+
+static const char *const column_names[PROFILE_COLUMN_COUNT] =
+{
+	"frame",
+	"background",
+	"enemies",
+	"player_shots",
+	"enemy_shots",
+	"explosions",
+	"filters",
+	"scale_and_flip",
+	"audio",
+};
+
+static int compare_Uint64(const void *a, const void *b);
+static void update_overlay_text(void);
+
+bool profiler_enabled = false;
+bool profiler_overlay = false;
+const char *profiler_csv_path = NULL;
+
+static FILE *csv_file = NULL;
+
+static Uint64 counter_frequency;
+static Uint64 last_frame_end;
+static unsigned long frame_number;
+
+static Uint64 zone_ticks[PROFILE_ZONE_COUNT];  // for the current frame
+
+// The audio callback runs on its own thread, so it accumulates separately.
+static SDL_SpinLock audio_ticks_lock = 0;
+static Uint64 audio_ticks;
+
+static Uint64 history[PROFILE_COLUMN_COUNT][PROFILE_HISTORY];  // in nanoseconds
+static unsigned int history_count;
+
+static char overlay_text[PROFILE_COLUMN_COUNT][3][12];  // min, avg, p99
+
+void init_profiler(void)
+{
+	if (profiler_csv_path != NULL || profiler_overlay)
+		profiler_enabled = true;
+
+	if (!profiler_enabled)
+		return;
+
+	counter_frequency = SDL_GetPerformanceFrequency();
+	last_frame_end = SDL_GetPerformanceCounter();
+
+	if (profiler_csv_path != NULL)
+	{
+		csv_file = fopen(profiler_csv_path, "w");
+		if (csv_file == NULL)
+		{
+			fprintf(stderr, "error: failed to open '%s' for writing profile\n", profiler_csv_path);
+		}
+		else
+		{
+			fprintf(csv_file, "frame_number");
+			for (int i = 0; i < PROFILE_COLUMN_COUNT; ++i)
+				fprintf(csv_file, ",%s_ns", column_names[i]);
+			fprintf(csv_file, "\n");
+		}
+	}
+}
+
+void deinit_profiler(void)
+{
+	if (csv_file != NULL)
+	{
+		fclose(csv_file);
+		csv_file = NULL;
+	}
+
+	profiler_enabled = false;
+}
+
+void profile_end_zone(ProfileZone zone, Uint64 start)
+{
+	const Uint64 ticks = SDL_GetPerformanceCounter() - start;
+
+	if (zone == PROFILE_AUDIO)
+	{
+		SDL_AtomicLock(&audio_ticks_lock);
+		audio_ticks += ticks;
+		SDL_AtomicUnlock(&audio_ticks_lock);
+	}
+	else
+	{
+		zone_ticks[zone] += ticks;
+	}
+}
+
+/** Records the zone totals for the frame just shown and starts a new frame. */
+void profile_end_frame(void)
+{
+	if (!profiler_enabled)
+		return;
+
+	const Uint64 now = SDL_GetPerformanceCounter();
+
+	SDL_AtomicLock(&audio_ticks_lock);
+	zone_ticks[PROFILE_AUDIO] = audio_ticks;
+	audio_ticks = 0;
+	SDL_AtomicUnlock(&audio_ticks_lock);
+
+	Uint64 ns[PROFILE_COLUMN_COUNT];
+	ns[0] = (now - last_frame_end) * 1000000000 / counter_frequency;
+	for (int i = 0; i < PROFILE_ZONE_COUNT; ++i)
+		ns[1 + i] = zone_ticks[i] * 1000000000 / counter_frequency;
+
+	last_frame_end = now;
+	memset(zone_ticks, 0, sizeof(zone_ticks));
+
+	if (csv_file != NULL)
+	{
+		fprintf(csv_file, "%lu", frame_number);
+		for (int i = 0; i < PROFILE_COLUMN_COUNT; ++i)
+			fprintf(csv_file, ",%llu", (unsigned long long)ns[i]);
+		fprintf(csv_file, "\n");
+	}
+
+	const unsigned int slot = frame_number % PROFILE_HISTORY;
+	for (int i = 0; i < PROFILE_COLUMN_COUNT; ++i)
+		history[i][slot] = ns[i];
+	if (history_count < PROFILE_HISTORY)
+		++history_count;
+
+	++frame_number;
+
+	if (profiler_overlay && frame_number % PROFILE_OVERLAY_INTERVAL == 0)
+		update_overlay_text();
+}
+
+static int compare_Uint64(const void *a, const void *b)
+{
+	const Uint64 x = *(const Uint64 *)a,
+	             y = *(const Uint64 *)b;
+	return (x > y) - (x < y);
+}
+
+static void update_overlay_text(void)
+{
+	Uint64 sorted[PROFILE_HISTORY];
+
+	for (int i = 0; i < PROFILE_COLUMN_COUNT; ++i)
+	{
+		memcpy(sorted, history[i], history_count * sizeof(*sorted));
+		qsort(sorted, history_count, sizeof(*sorted), compare_Uint64);
+
+		Uint64 sum = 0;
+		for (unsigned int j = 0; j < history_count; ++j)
+			sum += sorted[j];
+
+		const Uint64 min = sorted[0],
+		             avg = sum / history_count,
+		             p99 = sorted[(history_count * 99) / 100];
+
+		// in microseconds
+		snprintf(overlay_text[i][0], sizeof(overlay_text[i][0]), "%lu", (unsigned long)(min / 1000));
+		snprintf(overlay_text[i][1], sizeof(overlay_text[i][1]), "%lu", (unsigned long)(avg / 1000));
+		snprintf(overlay_text[i][2], sizeof(overlay_text[i][2]), "%lu", (unsigned long)(p99 / 1000));
+	}
+}
+
+/** Draws the rolling min/avg/p99 zone times, in microseconds, over the top of the screen. */
+void profile_draw_overlay(SDL_Surface *surface)
+{
+	static const char *const headings[3] = { "min", "avg", "p99" };
+
+	draw_font_hv_full_shadow(surface, 4, 4, "zone (us)", small_font, left_aligned, 15, 2, false, 1);
+	for (int j = 0; j < 3; ++j)
+		draw_font_hv_full_shadow(surface, 110 + j * 30, 4, headings[j], small_font, right_aligned, 15, 2, false, 1);
+
+	for (int i = 0; i < PROFILE_COLUMN_COUNT; ++i)
+	{
+		const int y = 14 + i * 8;
+
+		draw_font_hv_full_shadow(surface, 4, y, column_names[i], small_font, left_aligned, 15, 2, false, 1);
+		for (int j = 0; j < 3; ++j)
+			draw_font_hv_full_shadow(surface, 110 + j * 30, y, overlay_text[i][j], small_font, right_aligned, 15, 2, false, 1);
+	}
+}
@@ -0,0 +1,64 @@
+/*
+ * OpenTyrian: A modern cross-platform port of Tyrian
+ * Copyright (C) 2007-2009  The OpenTyrian Development Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "SDL.h"
+
+#include <stdbool.h>
+
+typedef enum
+{
+	PROFILE_BACKGROUND,
+	PROFILE_ENEMIES,
+	PROFILE_PLAYER_SHOTS,
+	PROFILE_ENEMY_SHOTS,
+	PROFILE_EXPLOSIONS,
+	PROFILE_FILTERS,
+	PROFILE_SCALE_AND_FLIP,
+	PROFILE_AUDIO,  // may be ended from the audio thread
+	PROFILE_ZONE_COUNT
+} ProfileZone;
+
+extern bool profiler_enabled;
+extern bool profiler_overlay;
+extern const char *profiler_csv_path;
+
+void init_profiler(void);
+void deinit_profiler(void);
+
+/** Returns the start of a zone, to be passed to profile_end().  Cheap when profiling is disabled. */
+static inline Uint64 profile_begin(void)
+{
+	return profiler_enabled ? SDL_GetPerformanceCounter() : 0;
+}
+
+void profile_end_zone(ProfileZone zone, Uint64 start);
+
+/** Adds the time since start to the zone's total for the current frame. */
+static inline void profile_end(ProfileZone zone, Uint64 start)
+{
+	if (profiler_enabled)
+		profile_end_zone(zone, start);
+}
+
+void profile_end_frame(void);
+void profile_draw_overlay(SDL_Surface *surface);
+
+#endif /* PROFILER_H */
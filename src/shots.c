@@ -19,22 +19,34 @@
 #include "shots.h"
 
 #include "player.h"
+#include "profiler.h"
 #include "sprite.h"
 #include "video.h"
 #include "varz.h"
 
+#include <string.h>
+
 // I'm pretty sure the last extra entry is never used.
 PlayerShotDataType playerShotData[MAX_PWEAPON + 1]; /* [1..MaxPWeapon+1] */
 JE_byte shotAvail[MAX_PWEAPON]; /* [1..MaxPWeapon] */   /*0:Avail 1-255:Duration left*/
+Uint64 shotInUse[(MAX_PWEAPON + 63) / 64];
+
+void free_all_player_shots(void)
+{
+	memset(shotAvail, 0, sizeof(shotAvail));
+	memset(shotInUse, 0, sizeof(shotInUse));
+}
 
 void simulate_player_shots(void)
 {
+	const Uint64 profile_start = profile_begin();
+
 	/* Player Shot Images */
-	for (int z = 0; z < MAX_PWEAPON; z++)
+	for (int z = next_player_shot_in_use(0); z < MAX_PWEAPON; z = next_player_shot_in_use(z + 1))
 	{
 		if (shotAvail[z] != 0)
 		{
-			shotAvail[z]--;
+			set_shot_avail(z, shotAvail[z] - 1);
 			if (z != MAX_PWEAPON - 1)
 			{
 				PlayerShotDataType* shot = &playerShotData[z];
@@ -75,7 +87,7 @@ void simulate_player_shots(void)
 				if (shot->shotX < 0 || shot->shotX > 140 ||
 				    shot->shotY < 0 || shot->shotY > 170)
 				{
-					shotAvail[z] = 0;
+					set_shot_avail(z, 0);
 					goto draw_player_shot_loop_end;
 				}
 
@@ -110,6 +122,7 @@ draw_player_shot_loop_end:
 			;
 		}
 	}
+	profile_end(PROFILE_PLAYER_SHOTS, profile_start);
 }
 
 static const JE_word linkMultiGr[17] /* [0..16] */ =
@@ -168,7 +181,7 @@ bool player_shot_move_and_draw(
 {
 	PlayerShotDataType* shot = &playerShotData[shot_id];
 
-	shotAvail[shot_id]--;
+	set_shot_avail(shot_id, shotAvail[shot_id] - 1);
 	if (shot_id != MAX_PWEAPON - 1)
 	{
 		shot->shotXM += shot->shotXC;
@@ -222,7 +235,7 @@ bool player_shot_move_and_draw(
 		if (shot->shotX < -34 || shot->shotX > 290 ||
 			shot->shotY < -15 || shot->shotY > 190)
 		{
-			shotAvail[shot_id] = 0;
+			set_shot_avail(shot_id, 0);
 			return false;
 		}
 
@@ -242,12 +255,12 @@ bool player_shot_move_and_draw(
 
 				if (enemyAvail[shot->aimAtEnemy - 1] != 1)
 				{
-					if (shot->shotX < enemy[shot->aimAtEnemy - 1].ex)
+					if (shot->shotX < enemyHot.ex[shot->aimAtEnemy - 1])
 						shot->shotXM++;
 					else
 						shot->shotXM--;
 
-					if (shot->shotY < enemy[shot->aimAtEnemy - 1].ey)
+					if (shot->shotY < enemyHot.ey[shot->aimAtEnemy - 1])
 						shot->shotYM++;
 					else
 						shot->shotYM--;
@@ -326,9 +339,7 @@ JE_integer player_shot_create(JE_word portNum, uint bay_i, JE_word PX, JE_word P
 	/*Rot*/
 	for (int multi_i = 1; multi_i <= weapon->multi; multi_i++)
 	{
-		for (shot_id = 0; shot_id < MAX_PWEAPON; shot_id++)
-			if (shotAvail[shot_id] == 0)
-				break;
+		shot_id = next_clear_slot(shotInUse, 0, MAX_PWEAPON);
 		if (shot_id == MAX_PWEAPON)
 			return MAX_PWEAPON;
 
@@ -424,9 +435,9 @@ JE_integer player_shot_create(JE_word portNum, uint bay_i, JE_word PX, JE_word P
 
 		shot->shotGr = weapon->sg[shotMultiPos[bay_i]-1];
 		if (shot->shotGr == 0)
-			shotAvail[shot_id] = 0;
+			set_shot_avail(shot_id, 0);
 		else
-			shotAvail[shot_id] = del;
+			set_shot_avail(shot_id, del);
 
 		if (del > 100 && del < 120)
 			shot->shotAniMax = (del - 100 + 1);
@@ -480,11 +491,11 @@ JE_integer player_shot_create(JE_word portNum, uint bay_i, JE_word PX, JE_word P
 			uint best_dist = 65000;
 			JE_byte closest_enemy = 0;
 			/*Find Closest Enemy*/
-			for (x = 0; x < 100; x++)
+			for (x = next_enemy_in_use(0, 100); x < 100; x = next_enemy_in_use(x + 1, 100))
 			{
 				if (enemyAvail[x] != 1 && !enemy[x].scoreitem)
 				{
-					y = abs(enemy[x].ex - shot->shotX) + abs(enemy[x].ey - shot->shotY);
+					y = abs(enemyHot.ex[x] - shot->shotX) + abs(enemyHot.ey[x] - shot->shotY);
 					if (y < best_dist)
 					{
 						best_dist = y;
@@ -18,6 +18,7 @@
  */
 #ifndef SHOTS_H
 #define SHOTS_H
+#include "bitmask.h"
 #include "opentyr.h"
 
 typedef struct {
@@ -33,6 +34,22 @@ typedef struct {
 #define MAX_PWEAPON     81 /* 81*/
 extern PlayerShotDataType playerShotData[MAX_PWEAPON + 1];
 extern JE_byte shotAvail[MAX_PWEAPON];
+extern Uint64 shotInUse[(MAX_PWEAPON + 63) / 64];  /* bit per slot that is not free in shotAvail */
+
+void free_all_player_shots(void);
+
+// shotAvail is only changed through this, so that shotInUse stays in step with it
+static inline void set_shot_avail(unsigned int i, JE_byte avail)
+{
+	shotAvail[i] = avail;
+	set_slot_bit(shotInUse, i, avail != 0);
+}
+
+// returns the first player shot slot from i on that is not free, or MAX_PWEAPON
+static inline unsigned int next_player_shot_in_use(unsigned int i)
+{
+	return next_set_slot(shotInUse, i, MAX_PWEAPON);
+}
 
 /** Used in the shop to show weapon previews. */
 void simulate_player_shots(void);
@@ -25,6 +25,7 @@
 #include <assert.h>
 #include <ctype.h>
 #include <stdlib.h>
+#include <string.h>
 
 Sprite_array sprite_table[SPRITE_TABLES_MAX];
 
@@ -44,21 +45,256 @@ Sprite2_array spriteSheet11;
 Sprite2_array spriteSheet12;
 Sprite2_array spriteSheetT2000;
 
+// Holds the main shape tables, which stay loaded for the whole session.
+static Arena session_arena;
+
+static void *sprite_alloc(Arena *, size_t size);
+static void finish_sprite_spans(SpriteSpans *, SpriteSpan *span, unsigned int count, const Uint8 *pixels, size_t pixel_count, Arena *);
+static void free_sprite_spans(SpriteSpans *);
+
+static void add_span_pixel(SpriteSpan *span, unsigned int *count, Uint8 *pixels, size_t *pixel_count, int x, int y, Uint8 pixel)
+{
+	SpriteSpan *last = *count > 0 ? &span[*count - 1] : NULL;
+	
+	if (last == NULL || last->y != y || last->x + last->length != x)
+	{
+		last = &span[(*count)++];
+		last->x = x;
+		last->y = y;
+		last->length = 0;
+		last->pixels = *pixel_count;
+	}
+	
+	last->length += 1;
+	pixels[(*pixel_count)++] = pixel;
+}
+
+/** Decodes a sprite from the table format into spans. */
+void decode_sprite_spans(Sprite *cur_sprite, Arena *arena)
+{
+	// Every opaque pixel takes at least a byte, so neither can outnumber the data.
+	SpriteSpan *span = malloc(MAX(cur_sprite->size, 1) * sizeof(*span));
+	Uint8 *pixels = malloc(MAX(cur_sprite->size, 1));
+	unsigned int count = 0;
+	size_t pixel_count = 0;
+	
+	const Uint8 *data = cur_sprite->data;
+	const Uint8 * const data_ul = data + cur_sprite->size;
+	
+	const unsigned int width = cur_sprite->width;
+	unsigned int x_offset = 0;
+	int y = 0;
+	
+	// Same walk as the format was originally drawn with.  Anything that would cross the end of a
+	// row moves to the start of the next one instead.
+	for (; data < data_ul; ++data)
+	{
+		switch (*data)
+		{
+		case 255:  // transparent pixels
+			if (++data == data_ul)
+				break;
+			x_offset += *data;  // next byte tells how many
+			break;
+			
+		case 254:  // next pixel row
+			x_offset = width;
+			break;
+			
+		case 253:  // 1 transparent pixel
+			x_offset++;
+			break;
+			
+		default:  // set a pixel
+			add_span_pixel(span, &count, pixels, &pixel_count, x_offset, y, *data);
+			x_offset++;
+			break;
+		}
+		if (data == data_ul)
+			break;
+		if (x_offset >= width)
+		{
+			x_offset = 0;
+			y += 1;
+		}
+	}
+	
+	finish_sprite_spans(&cur_sprite->spans, span, count, pixels, pixel_count, arena);
+	
+	free(span);
+	free(pixels);
+}
+
+/** Decodes every sprite in a sheet into spans. */
+void decode_sprite2_spans(Sprite2_array *sprite2s)
+{
+	const Uint8 *const data_ul = sprite2s->data + sprite2s->size;
+	
+	// The sheet starts with a table of offsets to each sprite's data; the nearest data bounds it.
+	size_t table_end = sprite2s->size;
+	sprite2s->count = 0;
+	while (sprite2s->count * 2 + 2 <= table_end)
+	{
+		const size_t offset = SDL_SwapLE16(((Uint16 *)sprite2s->data)[sprite2s->count]);
+		sprite2s->count += 1;
+		if (offset >= sprite2s->count * 2 && offset < table_end)
+			table_end = offset;
+	}
+	
+	sprite2s->spans = sprite2s->arena != NULL
+		? arena_calloc(sprite2s->arena, MAX(sprite2s->count, 1), sizeof(*sprite2s->spans))
+		: calloc(MAX(sprite2s->count, 1), sizeof(*sprite2s->spans));
+	
+	// Every opaque pixel takes a byte, so neither can outnumber the data.
+	SpriteSpan *span = malloc(MAX(sprite2s->size, 1) * sizeof(*span));
+	Uint8 *pixels = malloc(MAX(sprite2s->size, 1));
+	
+	for (unsigned int i = 0; i < sprite2s->count; ++i)
+	{
+		unsigned int count = 0;
+		size_t pixel_count = 0;
+		
+		const size_t offset = SDL_SwapLE16(((Uint16 *)sprite2s->data)[i]);
+		const Uint8 *data = sprite2s->data + MIN(offset, sprite2s->size);
+		
+		// Same walk as the format was originally drawn with.  The end of a row goes back 12 pixels
+		// from wherever the row left off.
+		int x = 0, y = 0;
+		for (; data < data_ul && *data != 0x0f; ++data)
+		{
+			x += *data & 0x0f;                         // second nibble: transparent pixel count
+			unsigned int fill_count = (*data & 0xf0) >> 4; // first nibble: opaque pixel count
+			
+			if (fill_count == 0) // move to next pixel row
+			{
+				y += 1;
+				x -= 12;
+			}
+			else
+			{
+				while (fill_count-- && data + 1 < data_ul)
+				{
+					++data;
+					add_span_pixel(span, &count, pixels, &pixel_count, x, y, *data);
+					x += 1;
+				}
+			}
+		}
+		
+		finish_sprite_spans(&sprite2s->spans[i], span, count, pixels, pixel_count, sprite2s->arena);
+	}
+	
+	free(span);
+	free(pixels);
+}
+
+static void *sprite_alloc(Arena *arena, size_t size)
+{
+	return arena != NULL ? arena_alloc(arena, size) : malloc(size);
+}
+
+static void finish_sprite_spans(SpriteSpans *spans, SpriteSpan *span, unsigned int count, const Uint8 *pixels, size_t pixel_count, Arena *arena)
+{
+	spans->count = count;
+	spans->span = sprite_alloc(arena, MAX(count * sizeof(*span) + pixel_count, 1));
+	memcpy(spans->span, span, count * sizeof(*span));
+	
+	Uint8 *const spans_pixels = (Uint8 *)(spans->span + count);
+	memcpy(spans_pixels, pixels, pixel_count);
+	spans->pixels = spans_pixels;
+}
+
+static void free_sprite_spans(SpriteSpans *spans)
+{
+	free(spans->span);
+	spans->span = NULL;
+	spans->pixels = NULL;
+	spans->count = 0;
+}
+
+/** Finds where a span goes on a surface that the unclipped blitters treat as one long row of
+ *  pixels.  Returns false once spans are past the end of the surface. */
+static inline bool clip_span_linear(SDL_Surface *surface, Uint8 *origin, const SpriteSpans *spans, const SpriteSpan *span, Uint8 **dst, const Uint8 **src, int *length)
+{
+	const Uint8 * const pixels_ll = (Uint8 *)surface->pixels,  // lower limit
+	            * const pixels_ul = (Uint8 *)surface->pixels + (surface->h * surface->pitch);  // upper limit
+	
+	Uint8 *begin = origin + (span->y * surface->pitch) + span->x;
+	const Uint8 *end = begin + span->length;
+	*src = spans->pixels + span->pixels;
+	
+	if (begin >= pixels_ul)
+		return false;
+	if (begin < pixels_ll)
+	{
+		*src += pixels_ll - begin;
+		begin = (Uint8 *)pixels_ll;
+	}
+	if (end > pixels_ul)
+		end = pixels_ul;
+	
+	*dst = begin;
+	*length = MAX(end - begin, 0);
+	return true;
+}
+
+/** Finds where a span goes on a surface, clipped to each edge.  Returns false once spans are below
+ *  the bottom of the surface. */
+static inline bool clip_span(SDL_Surface *surface, int x, int y, const SpriteSpans *spans, const SpriteSpan *span, Uint8 **dst, const Uint8 **src, int *length)
+{
+	y += span->y;
+	if (y >= surface->h)
+		return false;
+	
+	int begin = x + span->x,
+	    end = begin + span->length;
+	*src = spans->pixels + span->pixels;
+	
+	if (y < 0)
+	{
+		*dst = (Uint8 *)surface->pixels;
+		*length = 0;
+		return true;
+	}
+	if (begin < 0)
+	{
+		*src -= begin;
+		begin = 0;
+	}
+	if (end > surface->pitch)
+		end = surface->pitch;
+	
+	*dst = (Uint8 *)surface->pixels + (y * surface->pitch) + begin;
+	*length = MAX(end - begin, 0);
+	return true;
+}
+
+/** Returns NULL for an index outside the sheet so a bad index from level data draws nothing. */
+static inline const SpriteSpans *get_sprite2_spans(Sprite2_array sprite2s, unsigned int index)
+{
+	assert(index >= 1 && index <= sprite2s.count);
+	if (index == 0 || index > sprite2s.count)
+		return NULL;
+	return &sprite2s.spans[index - 1];
+}
+
 void load_sprites_file(unsigned int table, const char *filename)
 {
 	free_sprites(table);
 	
 	FILE *f = dir_fopen_die(data_dir(), filename, "rb");
 	
-	load_sprites(table, f);
+	load_sprites(table, f, NULL);
 	
 	fclose(f);
 }
 
-void load_sprites(unsigned int table, FILE *f)
+void load_sprites(unsigned int table, FILE *f, Arena *arena)
 {
 	free_sprites(table);
 	
+	sprite_table[table].arena = arena;
+	
 	Uint16 temp;
 	fread_u16_die(&temp, 1, f);
 	
@@ -79,14 +315,19 @@ void load_sprites(unsigned int table, FILE *f)
 		fread_u16_die(&cur_sprite->height, 1, f);
 		fread_u16_die(&cur_sprite->size,   1, f);
 		
-		cur_sprite->data = malloc(cur_sprite->size);
+		cur_sprite->data = sprite_alloc(arena, cur_sprite->size);
 		
 		fread_u8_die(cur_sprite->data, cur_sprite->size, f);
+		
+		decode_sprite_spans(cur_sprite, arena);
 	}
 }
 
+/** Forgets the sprites in a table, freeing them unless an arena owns them. */
 void free_sprites(unsigned int table)
 {
+	const bool owned = sprite_table[table].arena == NULL;
+	
 	for (unsigned int i = 0; i < sprite_table[table].count; ++i)
 	{
 		Sprite * const cur_sprite = sprite(table, i);
@@ -95,11 +336,18 @@ void free_sprites(unsigned int table)
 		cur_sprite->height = 0;
 		cur_sprite->size   = 0;
 		
-		free(cur_sprite->data);
+		if (owned)
+		{
+			free(cur_sprite->data);
+			free_sprite_spans(&cur_sprite->spans);
+		}
 		cur_sprite->data = NULL;
+		cur_sprite->spans.span = NULL;
+		cur_sprite->spans.pixels = NULL;
 	}
 	
 	sprite_table[table].count = 0;
+	sprite_table[table].arena = NULL;
 }
 
 // does not clip on left or right edges of surface
@@ -111,54 +359,20 @@ void blit_sprite(SDL_Surface *surface, int x, int y, unsigned int table, unsigne
 		return;
 	}
 	
-	const Sprite * const cur_sprite = sprite(table, index);
-	
-	const Uint8 *data = cur_sprite->data;
-	const Uint8 * const data_ul = data + cur_sprite->size;
-	
-	const unsigned int width = cur_sprite->width;
-	unsigned int x_offset = 0;
+	const SpriteSpans * const spans = &sprite(table, index)->spans;
 	
 	assert(surface->format->BitsPerPixel == 8);
-	Uint8 *             pixels =    (Uint8 *)surface->pixels + (y * surface->pitch) + x;
-	const Uint8 * const pixels_ll = (Uint8 *)surface->pixels,  // lower limit
-	            * const pixels_ul = (Uint8 *)surface->pixels + (surface->h * surface->pitch);  // upper limit
+	Uint8 * const origin = (Uint8 *)surface->pixels + (y * surface->pitch) + x;
 	
-	for (; data < data_ul; ++data)
+	for (unsigned int i = 0; i < spans->count; ++i)
 	{
-		switch (*data)
-		{
-		case 255:  // transparent pixels
-			data++;  // next byte tells how many
-			pixels += *data;
-			x_offset += *data;
-			break;
-			
-		case 254:  // next pixel row
-			pixels += width - x_offset;
-			x_offset = width;
-			break;
-			
-		case 253:  // 1 transparent pixel
-			pixels++;
-			x_offset++;
-			break;
-			
-		default:  // set a pixel
-			if (pixels >= pixels_ul)
-				return;
-			if (pixels >= pixels_ll)
-				*pixels = *data;
-			
-			pixels++;
-			x_offset++;
-			break;
-		}
-		if (x_offset >= width)
-		{
-			pixels += surface->pitch - x_offset;
-			x_offset = 0;
-		}
+		Uint8 *pixels;
+		const Uint8 *data;
+		int length;
+		if (!clip_span_linear(surface, origin, spans, &spans->span[i], &pixels, &data, &length))
+			return;
+		
+		memcpy(pixels, data, length);
 	}
 }
 
@@ -171,54 +385,21 @@ void blit_sprite_blend(SDL_Surface *surface, int x, int y, unsigned int table, u
 		return;
 	}
 	
-	const Sprite * const cur_sprite = sprite(table, index);
-	
-	const Uint8 *data = cur_sprite->data;
-	const Uint8 * const data_ul = data + cur_sprite->size;
-	
-	const unsigned int width = cur_sprite->width;
-	unsigned int x_offset = 0;
+	const SpriteSpans * const spans = &sprite(table, index)->spans;
 	
 	assert(surface->format->BitsPerPixel == 8);
-	Uint8 *             pixels =    (Uint8 *)surface->pixels + (y * surface->pitch) + x;
-	const Uint8 * const pixels_ll = (Uint8 *)surface->pixels,  // lower limit
-	            * const pixels_ul = (Uint8 *)surface->pixels + (surface->h * surface->pitch);  // upper limit
+	Uint8 * const origin = (Uint8 *)surface->pixels + (y * surface->pitch) + x;
 	
-	for (; data < data_ul; ++data)
+	for (unsigned int i = 0; i < spans->count; ++i)
 	{
-		switch (*data)
-		{
-		case 255:  // transparent pixels
-			data++;  // next byte tells how many
-			pixels += *data;
-			x_offset += *data;
-			break;
-			
-		case 254:  // next pixel row
-			pixels += width - x_offset;
-			x_offset = width;
-			break;
-			
-		case 253:  // 1 transparent pixel
-			pixels++;
-			x_offset++;
-			break;
-			
-		default:  // set a pixel
-			if (pixels >= pixels_ul)
-				return;
-			if (pixels >= pixels_ll)
-				*pixels = (*data & 0xf0) | (((*pixels & 0x0f) + (*data & 0x0f)) / 2);
-			
-			pixels++;
-			x_offset++;
-			break;
-		}
-		if (x_offset >= width)
-		{
-			pixels += surface->pitch - x_offset;
-			x_offset = 0;
-		}
+		Uint8 *pixels;
+		const Uint8 *data;
+		int length;
+		if (!clip_span_linear(surface, origin, spans, &spans->span[i], &pixels, &data, &length))
+			return;
+		
+		for (int j = 0; j < length; ++j)
+			pixels[j] = (data[j] & 0xf0) | (((pixels[j] & 0x0f) + (data[j] & 0x0f)) / 2);
 	}
 }
 
@@ -235,54 +416,21 @@ void blit_sprite_hv_unsafe(SDL_Surface *surface, int x, int y, unsigned int tabl
 	
 	hue <<= 4;
 	
-	const Sprite * const cur_sprite = sprite(table, index);
-	
-	const Uint8 *data = cur_sprite->data;
-	const Uint8 * const data_ul = data + cur_sprite->size;
-	
-	const unsigned int width = cur_sprite->width;
-	unsigned int x_offset = 0;
+	const SpriteSpans * const spans = &sprite(table, index)->spans;
 	
 	assert(surface->format->BitsPerPixel == 8);
-	Uint8 *             pixels =    (Uint8 *)surface->pixels + (y * surface->pitch) + x;
-	const Uint8 * const pixels_ll = (Uint8 *)surface->pixels,  // lower limit
-	            * const pixels_ul = (Uint8 *)surface->pixels + (surface->h * surface->pitch);  // upper limit
+	Uint8 * const origin = (Uint8 *)surface->pixels + (y * surface->pitch) + x;
 	
-	for (; data < data_ul; ++data)
+	for (unsigned int i = 0; i < spans->count; ++i)
 	{
-		switch (*data)
-		{
-		case 255:  // transparent pixels
-			data++;  // next byte tells how many
-			pixels += *data;
-			x_offset += *data;
-			break;
-			
-		case 254:  // next pixel row
-			pixels += width - x_offset;
-			x_offset = width;
-			break;
-			
-		case 253:  // 1 transparent pixel
-			pixels++;
-			x_offset++;
-			break;
-			
-		default:  // set a pixel
-			if (pixels >= pixels_ul)
-				return;
-			if (pixels >= pixels_ll)
-				*pixels = hue | ((*data & 0x0f) + value);
-			
-			pixels++;
-			x_offset++;
-			break;
-		}
-		if (x_offset >= width)
-		{
-			pixels += surface->pitch - x_offset;
-			x_offset = 0;
-		}
+		Uint8 *pixels;
+		const Uint8 *data;
+		int length;
+		if (!clip_span_linear(surface, origin, spans, &spans->span[i], &pixels, &data, &length))
+			return;
+		
+		for (int j = 0; j < length; ++j)
+			pixels[j] = hue | ((data[j] & 0x0f) + value);
 	}
 }
 
@@ -297,59 +445,26 @@ void blit_sprite_hv(SDL_Surface *surface, int x, int y, unsigned int table, unsi
 	
 	hue <<= 4;
 	
-	const Sprite * const cur_sprite = sprite(table, index);
-	
-	const Uint8 *data = cur_sprite->data;
-	const Uint8 * const data_ul = data + cur_sprite->size;
-	
-	const unsigned int width = cur_sprite->width;
-	unsigned int x_offset = 0;
+	const SpriteSpans * const spans = &sprite(table, index)->spans;
 	
 	assert(surface->format->BitsPerPixel == 8);
-	Uint8 *             pixels =    (Uint8 *)surface->pixels + (y * surface->pitch) + x;
-	const Uint8 * const pixels_ll = (Uint8 *)surface->pixels,  // lower limit
-	            * const pixels_ul = (Uint8 *)surface->pixels + (surface->h * surface->pitch);  // upper limit
+	Uint8 * const origin = (Uint8 *)surface->pixels + (y * surface->pitch) + x;
 	
-	for (; data < data_ul; ++data)
+	for (unsigned int i = 0; i < spans->count; ++i)
 	{
-		switch (*data)
+		Uint8 *pixels;
+		const Uint8 *data;
+		int length;
+		if (!clip_span_linear(surface, origin, spans, &spans->span[i], &pixels, &data, &length))
+			return;
+		
+		for (int j = 0; j < length; ++j)
 		{
-		case 255:  // transparent pixels
-			data++;  // next byte tells how many
-			pixels += *data;
-			x_offset += *data;
-			break;
-			
-		case 254:  // next pixel row
-			pixels += width - x_offset;
-			x_offset = width;
-			break;
+			Uint8 temp_value = (data[j] & 0x0f) + value;
+			if (temp_value > 0xf)
+				temp_value = (temp_value >= 0x1f) ? 0x0 : 0xf;
 			
-		case 253:  // 1 transparent pixel
-			pixels++;
-			x_offset++;
-			break;
-			
-		default:  // set a pixel
-			if (pixels >= pixels_ul)
-				return;
-			if (pixels >= pixels_ll)
-			{
-				Uint8 temp_value = (*data & 0x0f) + value;
-				if (temp_value > 0xf)
-					temp_value = (temp_value >= 0x1f) ? 0x0 : 0xf;
-				
-				*pixels = hue | temp_value;
-			}
-			
-			pixels++;
-			x_offset++;
-			break;
-		}
-		if (x_offset >= width)
-		{
-			pixels += surface->pitch - x_offset;
-			x_offset = 0;
+			pixels[j] = hue | temp_value;
 		}
 	}
 }
@@ -365,59 +480,26 @@ void blit_sprite_hv_blend(SDL_Surface *surface, int x, int y, unsigned int table
 	
 	hue <<= 4;
 	
-	const Sprite * const cur_sprite = sprite(table, index);
-	
-	const Uint8 *data = cur_sprite->data;
-	const Uint8 * const data_ul = data + cur_sprite->size;
-	
-	const unsigned int width = cur_sprite->width;
-	unsigned int x_offset = 0;
+	const SpriteSpans * const spans = &sprite(table, index)->spans;
 	
 	assert(surface->format->BitsPerPixel == 8);
-	Uint8 *             pixels =    (Uint8 *)surface->pixels + (y * surface->pitch) + x;
-	const Uint8 * const pixels_ll = (Uint8 *)surface->pixels,  // lower limit
-	            * const pixels_ul = (Uint8 *)surface->pixels + (surface->h * surface->pitch);  // upper limit
+	Uint8 * const origin = (Uint8 *)surface->pixels + (y * surface->pitch) + x;
 	
-	for (; data < data_ul; ++data)
+	for (unsigned int i = 0; i < spans->count; ++i)
 	{
-		switch (*data)
+		Uint8 *pixels;
+		const Uint8 *data;
+		int length;
+		if (!clip_span_linear(surface, origin, spans, &spans->span[i], &pixels, &data, &length))
+			return;
+		
+		for (int j = 0; j < length; ++j)
 		{
-		case 255:  // transparent pixels
-			data++;  // next byte tells how many
-			pixels += *data;
-			x_offset += *data;
-			break;
-			
-		case 254:  // next pixel row
-			pixels += width - x_offset;
-			x_offset = width;
-			break;
+			Uint8 temp_value = (data[j] & 0x0f) + value;
+			if (temp_value > 0xf)
+				temp_value = (temp_value >= 0x1f) ? 0x0 : 0xf;
 			
-		case 253:  // 1 transparent pixel
-			pixels++;
-			x_offset++;
-			break;
-			
-		default:  // set a pixel
-			if (pixels >= pixels_ul)
-				return;
-			if (pixels >= pixels_ll)
-			{
-				Uint8 temp_value = (*data & 0x0f) + value;
-				if (temp_value > 0xf)
-					temp_value = (temp_value >= 0x1f) ? 0x0 : 0xf;
-				
-				*pixels = hue | (((*pixels & 0x0f) + temp_value) / 2);
-			}
-			
-			pixels++;
-			x_offset++;
-			break;
-		}
-		if (x_offset >= width)
-		{
-			pixels += surface->pitch - x_offset;
-			x_offset = 0;
+			pixels[j] = hue | (((pixels[j] & 0x0f) + temp_value) / 2);
 		}
 	}
 }
@@ -431,54 +513,24 @@ void blit_sprite_dark(SDL_Surface *surface, int x, int y, unsigned int table, un
 		return;
 	}
 	
-	const Sprite * const cur_sprite = sprite(table, index);
-	
-	const Uint8 *data = cur_sprite->data;
-	const Uint8 * const data_ul = data + cur_sprite->size;
-	
-	const unsigned int width = cur_sprite->width;
-	unsigned int x_offset = 0;
+	const SpriteSpans * const spans = &sprite(table, index)->spans;
 	
 	assert(surface->format->BitsPerPixel == 8);
-	Uint8 *             pixels =    (Uint8 *)surface->pixels + (y * surface->pitch) + x;
-	const Uint8 * const pixels_ll = (Uint8 *)surface->pixels,  // lower limit
-	            * const pixels_ul = (Uint8 *)surface->pixels + (surface->h * surface->pitch);  // upper limit
+	Uint8 * const origin = (Uint8 *)surface->pixels + (y * surface->pitch) + x;
 	
-	for (; data < data_ul; ++data)
+	for (unsigned int i = 0; i < spans->count; ++i)
 	{
-		switch (*data)
-		{
-		case 255:  // transparent pixels
-			data++;  // next byte tells how many
-			pixels += *data;
-			x_offset += *data;
-			break;
-			
-		case 254:  // next pixel row
-			pixels += width - x_offset;
-			x_offset = width;
-			break;
-			
-		case 253:  // 1 transparent pixel
-			pixels++;
-			x_offset++;
-			break;
-			
-		default:  // set a pixel
-			if (pixels >= pixels_ul)
-				return;
-			if (pixels >= pixels_ll)
-				*pixels = black ? 0x00 : ((*pixels & 0xf0) | ((*pixels & 0x0f) / 2));
-			
-			pixels++;
-			x_offset++;
-			break;
-		}
-		if (x_offset >= width)
-		{
-			pixels += surface->pitch - x_offset;
-			x_offset = 0;
-		}
+		Uint8 *pixels;
+		const Uint8 *data;
+		int length;
+		if (!clip_span_linear(surface, origin, spans, &spans->span[i], &pixels, &data, &length))
+			return;
+		
+		if (black)
+			memset(pixels, 0x00, length);
+		else
+			for (int j = 0; j < length; ++j)
+				pixels[j] = (pixels[j] & 0xf0) | ((pixels[j] & 0x0f) / 2);
 	}
 }
 
@@ -493,250 +545,187 @@ void JE_loadCompShapes(Sprite2_array *sprite2s, char s)
 	
 	sprite2s->size = ftell_eof(f);
 	
-	JE_loadCompShapesB(sprite2s, f);
+	JE_loadCompShapesB(sprite2s, f, NULL);
 	
 	fclose(f);
 }
 
-void JE_loadCompShapesB(Sprite2_array *sprite2s, FILE *f)
+/** Loads a sprite sheet from an opened data file into an arena, or on the heap if \p arena is
+ *  NULL.  Cannot fail, so it is safe to use off the main thread. */
+void load_comp_shapes(Sprite2_array *sprite2s, const AssetFile *asset, Arena *arena)
+{
+	free_sprite2s(sprite2s);
+
+	sprite2s->arena = arena;
+	sprite2s->size = asset->size;
+	sprite2s->data = sprite_alloc(arena, sprite2s->size);
+	memcpy(sprite2s->data, asset->data, sprite2s->size);
+
+	decode_sprite2_spans(sprite2s);
+}
+
+void JE_loadCompShapesB(Sprite2_array *sprite2s, FILE *f, Arena *arena)
 {
 	assert(sprite2s->data == NULL);
 
-	sprite2s->data = malloc(sprite2s->size);
+	sprite2s->arena = arena;
+	sprite2s->data = sprite_alloc(arena, sprite2s->size);
 	fread_u8_die(sprite2s->data, sprite2s->size, f);
+
+	decode_sprite2_spans(sprite2s);
 }
 
+/** Forgets a sprite sheet, freeing it unless an arena owns it. */
 void free_sprite2s(Sprite2_array *sprite2s)
 {
-	free(sprite2s->data);
+	const bool owned = sprite2s->arena == NULL;
+
+	if (sprite2s->spans != NULL && owned)
+	{
+		for (unsigned int i = 0; i < sprite2s->count; ++i)
+			free_sprite_spans(&sprite2s->spans[i]);
+		free(sprite2s->spans);
+	}
+	sprite2s->spans = NULL;
+	sprite2s->count = 0;
+
+	if (owned)
+		free(sprite2s->data);
 	sprite2s->data = NULL;
 
 	sprite2s->size = 0;
+	sprite2s->arena = NULL;
 }
 
 // does not clip on left or right edges of surface
 void blit_sprite2(SDL_Surface *surface, int x, int y, Sprite2_array sprite2s, unsigned int index)
 {
-	assert(surface->format->BitsPerPixel == 8);
-	Uint8 *             pixels =    (Uint8 *)surface->pixels + (y * surface->pitch) + x;
-	const Uint8 * const pixels_ll = (Uint8 *)surface->pixels,  // lower limit
-	            * const pixels_ul = (Uint8 *)surface->pixels + (surface->h * surface->pitch);  // upper limit
+	const SpriteSpans * const spans = get_sprite2_spans(sprite2s, index);
+	if (spans == NULL)
+		return;
 	
-	const Uint8 *data = sprite2s.data + SDL_SwapLE16(((Uint16 *)sprite2s.data)[index - 1]);
+	assert(surface->format->BitsPerPixel == 8);
+	Uint8 * const origin = (Uint8 *)surface->pixels + (y * surface->pitch) + x;
 	
-	for (; *data != 0x0f; ++data)
+	for (unsigned int i = 0; i < spans->count; ++i)
 	{
-		pixels += *data & 0x0f;                   // second nibble: transparent pixel count
-		unsigned int count = (*data & 0xf0) >> 4; // first nibble: opaque pixel count
+		Uint8 *pixels;
+		const Uint8 *data;
+		int length;
+		if (!clip_span_linear(surface, origin, spans, &spans->span[i], &pixels, &data, &length))
+			return;
 		
-		if (count == 0) // move to next pixel row
-		{
-			pixels += VGAScreen->pitch - 12;
-		}
-		else
-		{
-			while (count--)
-			{
-				++data;
-				
-				if (pixels >= pixels_ul)
-					return;
-				if (pixels >= pixels_ll)
-					*pixels = *data;
-				
-				++pixels;
-			}
-		}
+		memcpy(pixels, data, length);
 	}
 }
 
 void blit_sprite2_clip(SDL_Surface *surface, int x, int y, Sprite2_array sprite2s, unsigned int index)
 {
-	assert(surface->format->BitsPerPixel == 8);
+	const SpriteSpans * const spans = get_sprite2_spans(sprite2s, index);
+	if (spans == NULL)
+		return;
 
-	const Uint8 *data = sprite2s.data + SDL_SwapLE16(((Uint16 *)sprite2s.data)[index - 1]);
+	assert(surface->format->BitsPerPixel == 8);
 
-	for (; *data != 0x0f; ++data)
+	for (unsigned int i = 0; i < spans->count; ++i)
 	{
-		if (y >= surface->h)
+		Uint8 *pixels;
+		const Uint8 *data;
+		int length;
+		if (!clip_span(surface, x, y, spans, &spans->span[i], &pixels, &data, &length))
 			return;
 
-		Uint8 skip_count = *data & 0x0f;
-		Uint8 fill_count = (*data >> 4) & 0x0f;
-
-		x += skip_count;
-
-		if (fill_count == 0) // move to next pixel row
-		{
-			y += 1;
-			x -= 12;
-		}
-		else if (y >= 0)
-		{
-			Uint8 *const pixel_row = (Uint8 *)surface->pixels + (y * surface->pitch);
-			do
-			{
-				++data;
-
-				if (x >= 0 && x < surface->pitch)
-					pixel_row[x] = *data;
-				x += 1;
-			} while (--fill_count);
-		}
-		else
-		{
-			data += fill_count;
-			x += fill_count;
-		}
+		memcpy(pixels, data, length);
 	}
 }
 
 // does not clip on left or right edges of surface
 void blit_sprite2_blend(SDL_Surface *surface,  int x, int y, Sprite2_array sprite2s, unsigned int index)
 {
-	assert(surface->format->BitsPerPixel == 8);
-	Uint8 *             pixels =    (Uint8 *)surface->pixels + (y * surface->pitch) + x;
-	const Uint8 * const pixels_ll = (Uint8 *)surface->pixels,  // lower limit
-	            * const pixels_ul = (Uint8 *)surface->pixels + (surface->h * surface->pitch);  // upper limit
+	const SpriteSpans * const spans = get_sprite2_spans(sprite2s, index);
+	if (spans == NULL)
+		return;
 	
-	const Uint8 *data = sprite2s.data + SDL_SwapLE16(((Uint16 *)sprite2s.data)[index - 1]);
+	assert(surface->format->BitsPerPixel == 8);
+	Uint8 * const origin = (Uint8 *)surface->pixels + (y * surface->pitch) + x;
 	
-	for (; *data != 0x0f; ++data)
+	for (unsigned int i = 0; i < spans->count; ++i)
 	{
-		pixels += *data & 0x0f;                   // second nibble: transparent pixel count
-		unsigned int count = (*data & 0xf0) >> 4; // first nibble: opaque pixel count
+		Uint8 *pixels;
+		const Uint8 *data;
+		int length;
+		if (!clip_span_linear(surface, origin, spans, &spans->span[i], &pixels, &data, &length))
+			return;
 		
-		if (count == 0) // move to next pixel row
-		{
-			pixels += VGAScreen->pitch - 12;
-		}
-		else
-		{
-			while (count--)
-			{
-				++data;
-				
-				if (pixels >= pixels_ul)
-					return;
-				if (pixels >= pixels_ll)
-					*pixels = (((*data & 0x0f) + (*pixels & 0x0f)) / 2) | (*data & 0xf0);
-				
-				++pixels;
-			}
-		}
+		for (int j = 0; j < length; ++j)
+			pixels[j] = (((data[j] & 0x0f) + (pixels[j] & 0x0f)) / 2) | (data[j] & 0xf0);
 	}
 }
 
 // does not clip on left or right edges of surface
 void blit_sprite2_darken(SDL_Surface *surface, int x, int y, Sprite2_array sprite2s, unsigned int index)
 {
-	assert(surface->format->BitsPerPixel == 8);
-	Uint8 *             pixels =    (Uint8 *)surface->pixels + (y * surface->pitch) + x;
-	const Uint8 * const pixels_ll = (Uint8 *)surface->pixels,  // lower limit
-	            * const pixels_ul = (Uint8 *)surface->pixels + (surface->h * surface->pitch);  // upper limit
+	const SpriteSpans * const spans = get_sprite2_spans(sprite2s, index);
+	if (spans == NULL)
+		return;
 	
-	const Uint8 *data = sprite2s.data + SDL_SwapLE16(((Uint16 *)sprite2s.data)[index - 1]);
+	assert(surface->format->BitsPerPixel == 8);
+	Uint8 * const origin = (Uint8 *)surface->pixels + (y * surface->pitch) + x;
 	
-	for (; *data != 0x0f; ++data)
+	for (unsigned int i = 0; i < spans->count; ++i)
 	{
-		pixels += *data & 0x0f;                   // second nibble: transparent pixel count
-		unsigned int count = (*data & 0xf0) >> 4; // first nibble: opaque pixel count
+		Uint8 *pixels;
+		const Uint8 *data;
+		int length;
+		if (!clip_span_linear(surface, origin, spans, &spans->span[i], &pixels, &data, &length))
+			return;
 		
-		if (count == 0) // move to next pixel row
-		{
-			pixels += VGAScreen->pitch - 12;
-		}
-		else
-		{
-			while (count--)
-			{
-				++data;
-				
-				if (pixels >= pixels_ul)
-					return;
-				if (pixels >= pixels_ll)
-					*pixels = ((*pixels & 0x0f) / 2) + (*pixels & 0xf0);
-				
-				++pixels;
-			}
-		}
+		for (int j = 0; j < length; ++j)
+			pixels[j] = ((pixels[j] & 0x0f) / 2) + (pixels[j] & 0xf0);
 	}
 }
 
 // does not clip on left or right edges of surface
 void blit_sprite2_filter(SDL_Surface *surface, int x, int y, Sprite2_array sprite2s, unsigned int index, Uint8 filter)
 {
-	assert(surface->format->BitsPerPixel == 8);
-	Uint8 *             pixels =    (Uint8 *)surface->pixels + (y * surface->pitch) + x;
-	const Uint8 * const pixels_ll = (Uint8 *)surface->pixels,  // lower limit
-	            * const pixels_ul = (Uint8 *)surface->pixels + (surface->h * surface->pitch);  // upper limit
+	const SpriteSpans * const spans = get_sprite2_spans(sprite2s, index);
+	if (spans == NULL)
+		return;
 	
-	const Uint8 *data = sprite2s.data + SDL_SwapLE16(((Uint16 *)sprite2s.data)[index - 1]);
+	assert(surface->format->BitsPerPixel == 8);
+	Uint8 * const origin = (Uint8 *)surface->pixels + (y * surface->pitch) + x;
 	
-	for (; *data != 0x0f; ++data)
+	for (unsigned int i = 0; i < spans->count; ++i)
 	{
-		pixels += *data & 0x0f;                   // second nibble: transparent pixel count
-		unsigned int count = (*data & 0xf0) >> 4; // first nibble: opaque pixel count
+		Uint8 *pixels;
+		const Uint8 *data;
+		int length;
+		if (!clip_span_linear(surface, origin, spans, &spans->span[i], &pixels, &data, &length))
+			return;
 		
-		if (count == 0) // move to next pixel row
-		{
-			pixels += VGAScreen->pitch - 12;
-		}
-		else
-		{
-			while (count--)
-			{
-				++data;
-				
-				if (pixels >= pixels_ul)
-					return;
-				if (pixels >= pixels_ll)
-					*pixels = filter | (*data & 0x0f);
-				
-				++pixels;
-			}
-		}
+		for (int j = 0; j < length; ++j)
+			pixels[j] = filter | (data[j] & 0x0f);
 	}
 }
 
 void blit_sprite2_filter_clip(SDL_Surface *surface, int x, int y, Sprite2_array sprite2s, unsigned int index, Uint8 filter)
 {
-	assert(surface->format->BitsPerPixel == 8);
+	const SpriteSpans * const spans = get_sprite2_spans(sprite2s, index);
+	if (spans == NULL)
+		return;
 
-	const Uint8 *data = sprite2s.data + SDL_SwapLE16(((Uint16 *)sprite2s.data)[index - 1]);
+	assert(surface->format->BitsPerPixel == 8);
 
-	for (; *data != 0x0f; ++data)
+	for (unsigned int i = 0; i < spans->count; ++i)
 	{
-		if (y >= surface->h)
+		Uint8 *pixels;
+		const Uint8 *data;
+		int length;
+		if (!clip_span(surface, x, y, spans, &spans->span[i], &pixels, &data, &length))
 			return;
 
-		Uint8 skip_count = *data & 0x0f;
-		Uint8 fill_count = (*data >> 4) & 0x0f;
-
-		x += skip_count;
-
-		if (fill_count == 0) // move to next pixel row
-		{
-			y += 1;
-			x -= 12;
-		}
-		else if (y >= 0)
-		{
-			Uint8 *const pixel_row = (Uint8 *)surface->pixels + (y * surface->pitch);
-			do
-			{
-				++data;
-
-				if (x >= 0 && x < surface->pitch)
-					pixel_row[x] = filter | (*data & 0x0f);;
-				x += 1;
-			} while (--fill_count);
-		}
-		else
-		{
-			data += fill_count;
-			x += fill_count;
-		}
+		for (int j = 0; j < length; ++j)
+			pixels[j] = filter | (data[j] & 0x0f);
 	}
 }
 
@@ -815,37 +804,37 @@ void JE_loadMainShapeTables(const char *shpfile)
 	for (i = 0; i < 7; i++)
 	{
 		fseek(f, shpPos[i], SEEK_SET);
-		load_sprites(i, f);
+		load_sprites(i, f, &session_arena);
 	}
 	
 	// player shot sprites
 	spriteSheet8.size = shpPos[i + 1] - shpPos[i];
-	JE_loadCompShapesB(&spriteSheet8, f);
+	JE_loadCompShapesB(&spriteSheet8, f, &session_arena);
 	i++;
 	
 	// player ship sprites
 	spriteSheet9.size = shpPos[i + 1] - shpPos[i];
-	JE_loadCompShapesB(&spriteSheet9 , f);
+	JE_loadCompShapesB(&spriteSheet9 , f, &session_arena);
 	i++;
 	
 	// power-up sprites
 	spriteSheet10.size = shpPos[i + 1] - shpPos[i];
-	JE_loadCompShapesB(&spriteSheet10, f);
+	JE_loadCompShapesB(&spriteSheet10, f, &session_arena);
 	i++;
 	
 	// coins, datacubes, etc sprites
 	spriteSheet11.size = shpPos[i + 1] - shpPos[i];
-	JE_loadCompShapesB(&spriteSheet11, f);
+	JE_loadCompShapesB(&spriteSheet11, f, &session_arena);
 	i++;
 	
 	// more player shot sprites
 	spriteSheet12.size = shpPos[i + 1] - shpPos[i];
-	JE_loadCompShapesB(&spriteSheet12, f);
+	JE_loadCompShapesB(&spriteSheet12, f, &session_arena);
 	i++;
 
 	// tyrian 2000 ship sprites
 	spriteSheetT2000.size = shpPos[i + 1] - shpPos[i];
-	JE_loadCompShapesB(&spriteSheetT2000, f);
+	JE_loadCompShapesB(&spriteSheetT2000, f, &session_arena);
 	
 	fclose(f);
 }
@@ -860,4 +849,7 @@ void free_main_shape_tables(void)
 	free_sprite2s(&spriteSheet10);
 	free_sprite2s(&spriteSheet11);
 	free_sprite2s(&spriteSheet12);
+	free_sprite2s(&spriteSheetT2000);
+	
+	arena_free(&session_arena);
 }
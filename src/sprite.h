@@ -19,6 +19,8 @@
 #ifndef SPRITE_H
 #define SPRITE_H
 
+#include "arena.h"
+#include "file.h"
 #include "opentyr.h"
 
 #include "SDL.h"
@@ -38,11 +40,31 @@
 #define SPRITE_TABLES_MAX        8
 #define SPRITES_PER_TABLE_MAX  152
 
+// A run of opaque pixels in one row of a sprite.
+typedef struct
+{
+	Sint16 x, y;  // of the first pixel, relative to where the sprite is drawn
+	Uint16 length;
+	Uint16 pixels;  // index of the first pixel in SpriteSpans.pixels
+}
+SpriteSpan;
+
+// Sprites decoded at load time into runs, so that blitters copy or transform whole runs instead of
+// interpreting the compressed format a pixel at a time.  Spans are in drawing order.
+typedef struct
+{
+	unsigned int count;
+	SpriteSpan *span;  // also owns pixels
+	const Uint8 *pixels;
+}
+SpriteSpans;
+
 typedef struct
 {
 	Uint16 width, height;
 	Uint16 size;
 	Uint8 *data;
+	SpriteSpans spans;
 }
 Sprite;
 
@@ -50,6 +72,7 @@ typedef struct
 {
 	unsigned int count;
 	Sprite sprite[SPRITES_PER_TABLE_MAX];
+	Arena *arena;  // owns the sprites' data and spans, if not NULL
 }
 Sprite_array;
 
@@ -75,8 +98,10 @@ static inline Uint16 get_sprite_height(unsigned int table, unsigned int index)
 	return (sprite_exists(table, index) ? sprite(table, index)->height : 0);
 }
 
+void decode_sprite_spans(Sprite *, Arena *);
+
 void load_sprites_file(unsigned int table, const char *filename);
-void load_sprites(unsigned int table, FILE *f);
+void load_sprites(unsigned int table, FILE *f, Arena *);
 void free_sprites(unsigned int table);
 
 void blit_sprite(SDL_Surface *, int x, int y, unsigned int table, unsigned int index); // JE_newDrawCShapeNum
@@ -90,6 +115,9 @@ typedef struct
 {
 	size_t size;
 	Uint8 *data;
+	unsigned int count;
+	SpriteSpans *spans;  // [count], decoded from data
+	Arena *arena;  // owns data and spans, if not NULL
 }
 Sprite2_array;
 
@@ -114,8 +142,11 @@ extern Sprite2_array spriteSheet11;  // fka eShapes5
 extern Sprite2_array spriteSheet12;  // fka shapesW2
 extern Sprite2_array spriteSheetT2000; // fka shapesT2k
 
+void decode_sprite2_spans(Sprite2_array *);
+
 void JE_loadCompShapes(Sprite2_array *, char s);
-void JE_loadCompShapesB(Sprite2_array *, FILE *f);
+void load_comp_shapes(Sprite2_array *, const AssetFile *, Arena *);
+void JE_loadCompShapesB(Sprite2_array *, FILE *f, Arena *);
 void free_sprite2s(Sprite2_array *);
 
 void blit_sprite2(SDL_Surface *, int x, int y, Sprite2_array, unsigned int index);
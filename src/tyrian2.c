@@ -42,6 +42,7 @@
 #include "pcxload.h"
 #include "pcxmast.h"
 #include "picload.h"
+#include "profiler.h"
 #include "shots.h"
 #include "sprite.h"
 #include "vga256d.h"
@@ -162,8 +163,8 @@ inline static void blit_enemy(SDL_Surface *surface, unsigned int i, signed int x
 		return;
 	}
 	
-	const int x = enemy[i].ex + x_offset + tempMapXOfs,
-	          y = enemy[i].ey + y_offset;
+	const int x = enemyHot.ex[i] + x_offset + tempMapXOfs,
+	          y = enemyHot.ey[i] + y_offset;
 	const unsigned int index = enemy[i].egr[enemy[i].enemycycle - 1] + sprite_offset;
 
 	if (enemy[i].filter != 0)
@@ -174,43 +175,45 @@ inline static void blit_enemy(SDL_Surface *surface, unsigned int i, signed int x
 
 void JE_drawEnemy(int enemyOffset) // actually does a whole lot more than just drawing
 {
+	const Uint64 profile_start = profile_begin();
+
 	player[0].x -= 25;
 
-	for (int i = enemyOffset - 25; i < enemyOffset; i++)
+	for (int i = next_enemy_in_use(enemyOffset - 25, enemyOffset); i < enemyOffset; i = next_enemy_in_use(i + 1, enemyOffset))
 	{
 		if (enemyAvail[i] != 1)
 		{
-			enemy[i].mapoffset = tempMapXOfs;
+			enemyHot.mapoffset[i] = tempMapXOfs;
 
 			if (enemy[i].xaccel && enemy[i].xaccel - 89u > mt_rand() % 11)
 			{
-				if (player[0].x > enemy[i].ex)
+				if (player[0].x > enemyHot.ex[i])
 				{
-					if (enemy[i].exc < enemy[i].xaccel - 89)
-						enemy[i].exc++;
+					if (enemyHot.exc[i] < enemy[i].xaccel - 89)
+						enemyHot.exc[i]++;
 				}
 				else
 				{
-					if (enemy[i].exc >= 0 || -enemy[i].exc < enemy[i].xaccel - 89)
-						enemy[i].exc--;
+					if (enemyHot.exc[i] >= 0 || -enemyHot.exc[i] < enemy[i].xaccel - 89)
+						enemyHot.exc[i]--;
 				}
 			}
 
 			if (enemy[i].yaccel && enemy[i].yaccel - 89u > mt_rand() % 11)
 			{
-				if (player[0].y > enemy[i].ey)
+				if (player[0].y > enemyHot.ey[i])
 				{
-					if (enemy[i].eyc < enemy[i].yaccel - 89)
-						enemy[i].eyc++;
+					if (enemyHot.eyc[i] < enemy[i].yaccel - 89)
+						enemyHot.eyc[i]++;
 				}
 				else
 				{
-					if (enemy[i].eyc >= 0 || -enemy[i].eyc < enemy[i].yaccel - 89)
-						enemy[i].eyc--;
+					if (enemyHot.eyc[i] >= 0 || -enemyHot.eyc[i] < enemy[i].yaccel - 89)
+						enemyHot.eyc[i]--;
 				}
 			}
 
- 			if (enemy[i].ex + tempMapXOfs > -29 && enemy[i].ex + tempMapXOfs < 300)
+ 			if (enemyHot.ex[i] + tempMapXOfs > -29 && enemyHot.ex[i] + tempMapXOfs < 300)
 			{
 				if (enemy[i].aniactive == 1)
 				{
@@ -225,14 +228,14 @@ void JE_drawEnemy(int enemyOffset) // actually does a whole lot more than just d
 				if (enemy[i].egr[enemy[i].enemycycle - 1] == 999)
 					goto enemy_gone;
 
-				if (enemy[i].size == 1) // 2x2 enemy
+				if (enemyHot.size[i] == 1) // 2x2 enemy
 				{
-					if (enemy[i].ey > -13)
+					if (enemyHot.ey[i] > -13)
 					{
 						blit_enemy(VGAScreen, i, -6, -7, 0);
 						blit_enemy(VGAScreen, i,  6, -7, 1);
 					}
-					if (enemy[i].ey > -26 && enemy[i].ey < 182)
+					if (enemyHot.ey[i] > -26 && enemyHot.ey[i] < 182)
 					{
 						blit_enemy(VGAScreen, i, -6,  7, 19);
 						blit_enemy(VGAScreen, i,  6,  7, 20);
@@ -240,7 +243,7 @@ void JE_drawEnemy(int enemyOffset) // actually does a whole lot more than just d
 				}
 				else
 				{
-					if (enemy[i].ey > -13)
+					if (enemyHot.ey[i] > -13)
 						blit_enemy(VGAScreen, i, 0, 0, 0);
 				}
 
@@ -251,7 +254,7 @@ void JE_drawEnemy(int enemyOffset) // actually does a whole lot more than just d
 			{
 				if (--enemy[i].exccw <= 0)
 				{
-					if (enemy[i].exc == enemy[i].exrev)
+					if (enemyHot.exc[i] == enemy[i].exrev)
 					{
 						enemy[i].excc = -enemy[i].excc;
 						enemy[i].exrev = -enemy[i].exrev;
@@ -259,9 +262,9 @@ void JE_drawEnemy(int enemyOffset) // actually does a whole lot more than just d
 					}
 					else
 					{
-						enemy[i].exc += enemy[i].exccadd;
+						enemyHot.exc[i] += enemy[i].exccadd;
 						enemy[i].exccw = enemy[i].exccwmax;
-						if (enemy[i].exc == enemy[i].exrev)
+						if (enemyHot.exc[i] == enemy[i].exrev)
 						{
 							enemy[i].excc = -enemy[i].excc;
 							enemy[i].exrev = -enemy[i].exrev;
@@ -275,7 +278,7 @@ void JE_drawEnemy(int enemyOffset) // actually does a whole lot more than just d
 			{
 				if (--enemy[i].eyccw <= 0)
 				{
-					if (enemy[i].eyc == enemy[i].eyrev)
+					if (enemyHot.eyc[i] == enemy[i].eyrev)
 					{
 						enemy[i].eycc = -enemy[i].eycc;
 						enemy[i].eyrev = -enemy[i].eyrev;
@@ -283,9 +286,9 @@ void JE_drawEnemy(int enemyOffset) // actually does a whole lot more than just d
 					}
 					else
 					{
-						enemy[i].eyc += enemy[i].eyccadd;
+						enemyHot.eyc[i] += enemy[i].eyccadd;
 						enemy[i].eyccw = enemy[i].eyccwmax;
-						if (enemy[i].eyc == enemy[i].eyrev)
+						if (enemyHot.eyc[i] == enemy[i].eyrev)
 						{
 							enemy[i].eycc = -enemy[i].eycc;
 							enemy[i].eyrev = -enemy[i].eyrev;
@@ -295,49 +298,49 @@ void JE_drawEnemy(int enemyOffset) // actually does a whole lot more than just d
 				}
 			}
 
-			enemy[i].ey += enemy[i].fixedmovey;
+			enemyHot.ey[i] += enemy[i].fixedmovey;
 
-			enemy[i].ex += enemy[i].exc;
-			if (enemy[i].ex < -80 || enemy[i].ex > 340)
+			enemyHot.ex[i] += enemyHot.exc[i];
+			if (enemyHot.ex[i] < -80 || enemyHot.ex[i] > 340)
 				goto enemy_gone;
 
-			enemy[i].ey += enemy[i].eyc;
-			if (enemy[i].ey < -112 || enemy[i].ey > 190)
+			enemyHot.ey[i] += enemyHot.eyc[i];
+			if (enemyHot.ey[i] < -112 || enemyHot.ey[i] > 190)
 				goto enemy_gone;
 
 			goto enemy_still_exists;
 
 enemy_gone:
 			/* enemy[i].egr[10] &= 0x00ff; <MXD> madness? */
-			enemyAvail[i] = 1;
+			set_enemy_avail(i, 1);
 			goto draw_enemy_end;
 
 enemy_still_exists:
 
 			/*X bounce*/
-			if (enemy[i].ex <= enemy[i].xminbounce || enemy[i].ex >= enemy[i].xmaxbounce)
-				enemy[i].exc = -enemy[i].exc;
+			if (enemyHot.ex[i] <= enemy[i].xminbounce || enemyHot.ex[i] >= enemy[i].xmaxbounce)
+				enemyHot.exc[i] = -enemyHot.exc[i];
 
 			/*Y bounce*/
-			if (enemy[i].ey <= enemy[i].yminbounce || enemy[i].ey >= enemy[i].ymaxbounce)
-				enemy[i].eyc = -enemy[i].eyc;
+			if (enemyHot.ey[i] <= enemy[i].yminbounce || enemyHot.ey[i] >= enemy[i].ymaxbounce)
+				enemyHot.eyc[i] = -enemyHot.eyc[i];
 
 			/* Evalue != 0 - score item at boundary */
 			if (enemy[i].scoreitem)
 			{
-				if (enemy[i].ex < -5)
-					enemy[i].ex++;
-				if (enemy[i].ex > 245)
-					enemy[i].ex--;
+				if (enemyHot.ex[i] < -5)
+					enemyHot.ex[i]++;
+				if (enemyHot.ex[i] > 245)
+					enemyHot.ex[i]--;
 			}
 
-			enemy[i].ey += tempBackMove;
+			enemyHot.ey[i] += tempBackMove;
 
-			if (enemy[i].ex <= -24 || enemy[i].ex >= 296)
+			if (enemyHot.ex[i] <= -24 || enemyHot.ex[i] >= 296)
 				goto draw_enemy_end;
 
-			tempX = enemy[i].ex;
-			tempY = enemy[i].ey;
+			tempX = enemyHot.ex[i];
+			tempY = enemyHot.ey[i];
 
 			temp = enemy[i].enemytype;
 
@@ -373,13 +376,13 @@ enemy_still_exists:
 								enemy[i].eshotwait[j-1] = (enemy[i].eshotwait[j-1] / 2) + 1;
 						}
 
-						if (galagaMode && (enemy[i].eyc == 0 || (mt_rand() % 400) >= galagaShotFreq))
+						if (galagaMode && (enemyHot.eyc[i] == 0 || (mt_rand() % 400) >= galagaShotFreq))
 							goto draw_enemy_end;
 
 						switch (temp3)
 						{
 						case 252: /* Savara Boss DualMissile */
-							if (enemy[i].ey > 20)
+							if (enemyHot.ey[i] > 20)
 							{
 								JE_setupExplosion(tempX - 8 + tempMapXOfs, tempY - 20 - backMove * 8, -2, 6, false, false);
 								JE_setupExplosion(tempX + 4 + tempMapXOfs, tempY - 20 - backMove * 8, -2, 6, false, false);
@@ -430,15 +433,11 @@ enemy_still_exists:
 						/*Rot*/
 							for (int tempCount = weapons[temp3].multi; tempCount > 0; tempCount--)
 							{
-								for (b = 0; b < ENEMY_SHOT_MAX; b++)
-								{
-									if (enemyShotAvail[b] == 1)
-										break;
-								}
+								b = next_clear_slot(enemyShotInUse, 0, ENEMY_SHOT_MAX);
 								if (b == ENEMY_SHOT_MAX)
 									goto draw_enemy_end;
 
-								enemyShotAvail[b] = !enemyShotAvail[b];
+								set_enemy_shot_avail(b, false);
 
 								if (weapons[temp3].sound > 0)
 								{
@@ -552,7 +551,7 @@ enemy_still_exists:
 					if (enemy[i].launchspecial != 0)
 					{
 						/*Type  1 : Must be inline with player*/
-						if (abs(enemy[i].ey - player[0].y) > 5)
+						if (abs(enemyHot.ey[i] - player[0].y) > 5)
 							goto draw_enemy_end;
 					}
 
@@ -572,16 +571,16 @@ enemy_still_exists:
 					{
 						struct JE_SingleEnemyType* e = &enemy[b-1];
 
-						e->ex = tempX;
-						e->ey = tempY + enemyDat[e->enemytype].startyc;
-						if (e->size == 0)
-							e->ey -= 7;
+						enemyHot.ex[b-1] = tempX;
+						enemyHot.ey[b-1] = tempY + enemyDat[e->enemytype].startyc;
+						if (enemyHot.size[b-1] == 0)
+							enemyHot.ey[b-1] -= 7;
 
 						if (e->launchtype > 0 && e->launchfreq == 0)
 						{
 							if (e->launchtype > 90)
 							{
-								e->ex += mt_rand() % ((e->launchtype - 90) * 4) - (e->launchtype - 90) * 2;
+								enemyHot.ex[b-1] += mt_rand() % ((e->launchtype - 90) * 4) - (e->launchtype - 90) * 2;
 							}
 							else
 							{
@@ -592,8 +591,8 @@ enemy_still_exists:
 								if (tempI5 == 0)
 									tempI5 = 1;
 								const int longest_side = MAX(abs(target_x), abs(tempI5));
-								e->exc = roundf(((float)target_x / longest_side) * e->launchtype);
-								e->eyc = roundf(((float)tempI5 / longest_side) * e->launchtype);
+								enemyHot.exc[b-1] = roundf(((float)target_x / longest_side) * e->launchtype);
+								enemyHot.eyc[b-1] = roundf(((float)tempI5 / longest_side) * e->launchtype);
 							}
 						}
 
@@ -604,9 +603,9 @@ enemy_still_exists:
 						soundQueue[temp] = randomEnemyLaunchSounds[(mt_rand() % 3)];
 
 						if (enemy[i].launchspecial == 1 &&
-						    enemy[i].linknum < 100)
+						    enemyHot.linknum[i] < 100)
 						{
-							e->linknum = enemy[i].linknum;
+							enemyHot.linknum[b-1] = enemyHot.linknum[i];
 						}
 					}
 				}
@@ -617,6 +616,8 @@ draw_enemy_end:
 	}
 
 	player[0].x += 25;
+
+	profile_end(PROFILE_ENEMIES, profile_start);
 }
 
 void JE_main(void)
@@ -1025,13 +1026,12 @@ start_level_first:
 		JE_loadItemDat();
 	}
 
-	memset(enemyAvail,       1, sizeof(enemyAvail));
-	for (uint i = 0; i < COUNTOF(enemyShotAvail); i++)
-		enemyShotAvail[i] = 1;
+	free_all_enemies();
+	free_all_enemy_shots();
 
 	/*Initialize Shots*/
 	memset(playerShotData,   0, sizeof(playerShotData));
-	memset(shotAvail,        0, sizeof(shotAvail));
+	free_all_player_shots();
 	memset(shotMultiPos,     0, sizeof(shotMultiPos));
 	memset(shotRepeat,       1, sizeof(shotRepeat));
 
@@ -1039,7 +1039,7 @@ start_level_first:
 
 	memset(globalFlags,      0, sizeof(globalFlags));
 
-	memset(explosions,       0, sizeof(explosions));
+	free_all_explosions();
 	memset(rep_explosions,   0, sizeof(rep_explosions));
 
 	/* --- Clear Sound Queue --- */
@@ -1048,6 +1048,7 @@ start_level_first:
 
 	memset(enemySpriteSheetIds, 0, sizeof(enemySpriteSheetIds));
 	memset(enemy,               0, sizeof(enemy));
+	memset(&enemyHot,           0, sizeof(enemyHot));
 
 	memset(SFCurrentCode,    0, sizeof(SFCurrentCode));
 	memset(SFExecuted,       0, sizeof(SFExecuted));
@@ -1438,7 +1439,9 @@ level_loop:
 	}
 
 	/* Player Shot Images */
-	for (int z = 0; z < MAX_PWEAPON; z++)
+	Uint64 profile_start = profile_begin();
+	build_enemy_grid();
+	for (int z = next_player_shot_in_use(0); z < MAX_PWEAPON; z = next_player_shot_in_use(z + 1))
 	{
 		if (shotAvail[z] != 0)
 		{
@@ -1454,7 +1457,23 @@ level_loop:
 				goto draw_player_shot_loop_end;
 			}
 
-			for (b = 0; b < 100; b++)
+			// Only the enemies near the shot can be hit, except by the Zinglon, which hits whole columns.
+			// They are still tried in slot order.
+			Uint64 near_shot[2];
+			const Uint64 *candidates = NULL;
+			if (z != MAX_PWEAPON - 1)
+			{
+				const int reach_x = is_special ? tempX2 : 0,
+				          reach_y = is_special ? tempY2 : 0;
+
+				// covers the bounds of both sizes of enemy below
+				find_enemies_near(near_shot,
+				                  tempShotX + reach_x - (25 + reach_x), tempShotY + reach_y + 12 - (29 + reach_y),
+				                  tempShotX + reach_x + (25 + reach_x), tempShotY + reach_y + 12 + (29 + reach_y));
+				candidates = near_shot;
+			}
+
+			for (b = next_enemy_in(candidates, 0, 100); b < 100; b = next_enemy_in(candidates, b + 1, 100))
 			{
 				if (enemyAvail[b] == 0)
 				{
@@ -1463,7 +1482,7 @@ level_loop:
 					if (z == MAX_PWEAPON - 1)
 					{
 						temp = 25 - abs(zinglonDuration - 25);
-						collided = abs(enemy[b].ex + enemy[b].mapoffset - (player[0].x + 7)) < temp;
+						collided = abs(enemyHot.ex[b] + enemyHot.mapoffset[b] - (player[0].x + 7)) < temp;
 						temp2 = 9;
 						chain = 0;
 						damage = 10;
@@ -1471,18 +1490,18 @@ level_loop:
 					else if (is_special)
 					{
 						collided = ((enemy[b].enemycycle == 0) &&
-						            (abs(enemy[b].ex + enemy[b].mapoffset - tempShotX - tempX2) < (25 + tempX2)) &&
-						            (abs(enemy[b].ey - tempShotY - 12 - tempY2)                 < (29 + tempY2))) ||
+						            (abs(enemyHot.ex[b] + enemyHot.mapoffset[b] - tempShotX - tempX2) < (25 + tempX2)) &&
+						            (abs(enemyHot.ey[b] - tempShotY - 12 - tempY2)                 < (29 + tempY2))) ||
 						           ((enemy[b].enemycycle > 0) &&
-						            (abs(enemy[b].ex + enemy[b].mapoffset - tempShotX - tempX2) < (13 + tempX2)) &&
-						            (abs(enemy[b].ey - tempShotY - 6 - tempY2)                  < (15 + tempY2)));
+						            (abs(enemyHot.ex[b] + enemyHot.mapoffset[b] - tempShotX - tempX2) < (13 + tempX2)) &&
+						            (abs(enemyHot.ey[b] - tempShotY - 6 - tempY2)                  < (15 + tempY2)));
 					}
 					else
 					{
 						collided = ((enemy[b].enemycycle == 0) &&
-						            (abs(enemy[b].ex + enemy[b].mapoffset - tempShotX) < 25) && (abs(enemy[b].ey - tempShotY - 12) < 29)) ||
+						            (abs(enemyHot.ex[b] + enemyHot.mapoffset[b] - tempShotX) < 25) && (abs(enemyHot.ey[b] - tempShotY - 12) < 29)) ||
 						           ((enemy[b].enemycycle > 0) &&
-						            (abs(enemy[b].ex + enemy[b].mapoffset - tempShotX) < 13) && (abs(enemy[b].ey - tempShotY - 6) < 15));
+						            (abs(enemyHot.ex[b] + enemyHot.mapoffset[b] - tempShotX) < 13) && (abs(enemyHot.ey[b] - tempShotY - 6) < 15));
 					}
 
 					if (collided)
@@ -1491,7 +1510,7 @@ level_loop:
 						{
 							shotMultiPos[SHOT_MISC] = 0;
 							b = player_shot_create(0, SHOT_MISC, tempShotX, tempShotY, mouseX, mouseY, chain, playerNum);
-							shotAvail[z] = 0;
+							set_shot_avail(z, 0);
 							goto draw_player_shot_loop_end;
 						}
 
@@ -1515,7 +1534,7 @@ level_loop:
 
 						int armorleft = enemy[b].armorleft;
 
-						temp = enemy[b].linknum;
+						temp = enemyHot.linknum[b];
 						if (temp == 0)
 							temp = 255;
 
@@ -1528,9 +1547,9 @@ level_loop:
 							if (enemy[b].enemyground)
 								enemy[b].filter = temp2;
 
-							for (unsigned int e = 0; e < COUNTOF(enemy); e++)
+							for (unsigned int e = next_enemy_in_use(0, COUNTOF(enemy)); e < COUNTOF(enemy); e = next_enemy_in_use(e + 1, COUNTOF(enemy)))
 							{
-								if (enemy[e].linknum == temp &&
+								if (enemyHot.linknum[e] == temp &&
 								    enemyAvail[e] != 1 &&
 								    enemy[e].enemyground != 0)
 								{
@@ -1566,7 +1585,7 @@ level_loop:
 								{
 									if (enemyAvail[temp3] != 1)
 									{
-										int linknum = enemy[temp3].linknum;
+										int linknum = enemyHot.linknum[temp3];
 										if (
 										     (temp3 == b) ||
 										     (
@@ -1604,7 +1623,7 @@ level_loop:
 											}
 											else
 											{
-												enemyAvail[temp3] = 1;
+												set_enemy_avail(temp3, 1);
 												enemyKilled++;
 											}
 
@@ -1613,8 +1632,8 @@ level_loop:
 											if (enemy[temp3].armorleft > (unsigned char)enemy[temp3].edlevel)
 												enemy[temp3].armorleft = enemy[temp3].edlevel;
 
-											tempX = enemy[temp3].ex + enemy[temp3].mapoffset;
-											tempY = enemy[temp3].ey;
+											tempX = enemyHot.ex[temp3] + enemyHot.mapoffset[temp3];
+											tempY = enemyHot.ey[temp3];
 
 											if (enemyDat[enemy[temp3].enemytype].esize != 1)
 												JE_setupExplosion(tempX, tempY - 6, 0, 1, false, false);
@@ -1635,13 +1654,13 @@ level_loop:
 							{
 								if (enemyAvail[temp2] != 1)
 								{
-									temp3 = enemy[temp2].linknum;
+									temp3 = enemyHot.linknum[temp2];
 									if ((temp2 == b) || (temp == 254) ||
 									    ((temp != 255) && ((temp == temp3) || (temp - 100 == temp3) ||
 									                       ((temp3 > 40) && (temp3 / 20 == temp / 20) && (temp3 <= temp)))))
 									{
 
-										int enemy_screen_x = enemy[temp2].ex + enemy[temp2].mapoffset;
+										int enemy_screen_x = enemyHot.ex[temp2] + enemyHot.mapoffset[temp2];
 
 										if (enemy[temp2].special)
 										{
@@ -1677,8 +1696,8 @@ level_loop:
 												else
 													enemy[b-1].scoreitem = false;
 
-												enemy[b-1].ex = enemy[temp2].ex;
-												enemy[b-1].ey = enemy[temp2].ey;
+												enemyHot.ex[b-1] = enemyHot.ex[temp2];
+												enemyHot.ey[b-1] = enemyHot.ey[temp2];
 											}
 											b = temp_b;
 										}
@@ -1699,7 +1718,7 @@ level_loop:
 										if ((enemy[temp2].edlevel == -1) && (temp == temp3))
 										{
 											enemy[temp2].edlevel = 0;
-											enemyAvail[temp2] = 2;
+											set_enemy_avail(temp2, 2);
 											enemy[temp2].egr[1-1] = enemy[temp2].edgr;
 											enemy[temp2].ani = 1;
 											enemy[temp2].aniactive = 0;
@@ -1710,18 +1729,18 @@ level_loop:
 										}
 										else
 										{
-											enemyAvail[temp2] = 1;
+											set_enemy_avail(temp2, 1);
 											enemyKilled++;
 										}
 
 										if (enemyDat[enemy[temp2].enemytype].esize == 1)
 										{
-											JE_setupExplosionLarge(enemy[temp2].enemyground, enemy[temp2].explonum, enemy_screen_x, enemy[temp2].ey);
+											JE_setupExplosionLarge(enemy[temp2].enemyground, enemy[temp2].explonum, enemy_screen_x, enemyHot.ey[temp2]);
 											soundQueue[6] = S_EXPLOSION_9;
 										}
 										else
 										{
-											JE_setupExplosion(enemy_screen_x, enemy[temp2].ey, 0, 1, false, false);
+											JE_setupExplosion(enemy_screen_x, enemyHot.ey[temp2], 0, 1, false, false);
 											soundQueue[6] = S_EXPLOSION_8;
 										}
 									}
@@ -1737,7 +1756,7 @@ level_loop:
 						{
 							if (damage <= armorleft)
 							{
-								shotAvail[z] = 0;
+								set_shot_avail(z, 0);
 								goto draw_player_shot_loop_end;
 							}
 							else
@@ -1753,6 +1772,7 @@ draw_player_shot_loop_end:
 			;
 		}
 	}
+	profile_end(PROFILE_PLAYER_SHOTS, profile_start);
 
 	/* Player movement indicators for shots that track your ship */
 	for (uint i = 0; i < COUNTOF(player); ++i)
@@ -1776,7 +1796,8 @@ draw_player_shot_loop_end:
 	{    /*MAIN DRAWING IS STOPPED STARTING HERE*/
 
 		/* Draw Enemy Shots */
-		for (int z = 0; z < ENEMY_SHOT_MAX; z++)
+		profile_start = profile_begin();
+		for (int z = next_enemy_shot_in_use(0); z < ENEMY_SHOT_MAX; z = next_enemy_shot_in_use(z + 1))
 		{
 			if (enemyShotAvail[z] == 0)
 			{
@@ -1816,7 +1837,7 @@ draw_player_shot_loop_end:
 
 				if (enemyShot[z].duration-- == 0 || enemyShot[z].sy > 190 || enemyShot[z].sy <= -14 || enemyShot[z].sx > 275 || enemyShot[z].sx <= 0)
 				{
-					enemyShotAvail[z] = true;
+					set_enemy_shot_avail(z, true);
 				}
 				else  // check if shot collided with player
 				{
@@ -1832,7 +1853,7 @@ draw_player_shot_loop_end:
 							tempY = enemyShot[z].sy;
 							temp = enemyShot[z].sdmg;
 
-							enemyShotAvail[z] = true;
+							set_enemy_shot_avail(z, true);
 
 							JE_setupExplosion(tempX, tempY, 0, 0, false, false);
 
@@ -1866,6 +1887,7 @@ draw_player_shot_loop_end:
 
 			}
 		}
+		profile_end(PROFILE_ENEMY_SHOTS, profile_start);
 	}
 
 	if (background3over == 1)
@@ -1896,6 +1918,7 @@ draw_player_shot_loop_end:
 	}
 
 	/*-------------------------- Sequenced Explosions -------------------------*/
+	profile_start = profile_begin();
 	enemyStillExploding = false;
 	for (int i = 0; i < MAX_REPEATING_EXPLOSIONS; i++)
 	{
@@ -1938,7 +1961,7 @@ draw_player_shot_loop_end:
 	}
 
 	/*---------------------------- Draw Explosions ----------------------------*/
-	for (int j = 0; j < MAX_EXPLOSIONS; j++)
+	for (int j = next_explosion_in_use(0); j < MAX_EXPLOSIONS; j = next_explosion_in_use(j + 1))
 	{
 		if (explosions[j].ttl != 0)
 		{
@@ -1957,7 +1980,7 @@ draw_player_shot_loop_end:
 
 			if (explosions[j].y > 200 - 14)
 			{
-				explosions[j].ttl = 0;
+				set_explosion_ttl(j, 0);
 			}
 			else
 			{
@@ -1966,10 +1989,11 @@ draw_player_shot_loop_end:
 				else
 					blit_sprite2(VGAScreen, explosions[j].x, explosions[j].y, explosionSpriteSheet, explosions[j].sprite + 1);
 
-				explosions[j].ttl--;
+				set_explosion_ttl(j, explosions[j].ttl - 1);
 			}
 		}
 	}
+	profile_end(PROFILE_EXPLOSIONS, profile_start);
 
 	if (!portConfigChange)
 		portConfigDone = true;
@@ -2005,7 +2029,7 @@ draw_player_shot_loop_end:
 			if (b > 0)
 			{
 				enemy[b-1].enemydie = 560 + (mt_rand() % 3) + 1;
-				enemy[b-1].eyc -= backMove3;
+				enemyHot.eyc[b-1] -= backMove3;
 				enemy[b-1].armorleft = 4;
 			}
 			armorShipDelay = 500;
@@ -2084,7 +2108,7 @@ draw_player_shot_loop_end:
 	}
 
 	/*-------      DEbug      ---------*/
-	debugTime = SDL_GetTicks();
+	debugTime = get_ticks();
 	tempW = lastmouse_but;
 	tempX = mouse_x;
 	tempY = mouse_y;
@@ -2400,18 +2424,32 @@ draw_player_shot_loop_end:
 }
 
 /* --- Load Level/Map Data --- */
-void JE_loadMap(void)
+// starts loading the level of the section's next ]L command while the item screen is up
+static void preload_next_level(AssetReader ep_reader)
 {
-	JE_DanCShape shape;
-
-	JE_word x, y;
-	JE_integer yy;
-	JE_word mapSh[3][128]; /* [1..3, 0..127] */
-	JE_byte *ref[3][128]; /* [1..3, 0..127] */
 	char s[256];
 
-	JE_byte mapBuf[15 * 600]; /* [1..15 * 600] */
-	JE_word bufLoc;
+	while (ep_reader.pos < ep_reader.size)
+	{
+		asset_read_encrypted_pascal_string(s, sizeof(s), &ep_reader);
+
+		if (s[0] == '*')  // next section
+			break;
+
+		if (s[0] == ']' && s[1] == 'L' && strlen(s) > 25)
+		{
+			const unsigned int file_num = atoi(s + 25);  // as lvlFileNum below
+			if (file_num >= 1 && (file_num - 1) * 2 < COUNTOF(lvlPos))
+				preload_level(levelFile, lvlPos[(file_num - 1) * 2]);
+			break;
+		}
+	}
+}
+
+void JE_loadMap(void)
+{
+	JE_word y;
+	char s[256];
 
 	char buffer[256];
 	int i;
@@ -2438,22 +2476,13 @@ new_game:
 	{
 		do
 		{
-			FILE *ep_f = dir_fopen_die(data_dir(), episode_file, "rb");
+			AssetReader ep_reader = asset_reader(asset_open_die(episode_file));
 
 			jumpSection = false;
 			loadLevelOk = false;
 
 			/* Seek Section # Mainlevel */
-			int x = 0;
-			while (x < mainLevel)
-			{
-				read_encrypted_pascal_string(s, sizeof(s), ep_f);
-				if (s[0] == '*')
-				{
-					x++;
-					s[0] = ' ';
-				}
-			}
+			asset_seek_die(&ep_reader, JE_episodeSectionPos(mainLevel));
 
 			ESCPressed = false;
 
@@ -2461,8 +2490,6 @@ new_game:
 			{
 				if (gameLoaded)
 				{
-					fclose(ep_f);
-
 					if (mainLevel == 0)  // if quit itemscreen
 						return;          // back to title screen
 					else
@@ -2470,7 +2497,7 @@ new_game:
 				}
 
 				strcpy(s, " ");
-				read_encrypted_pascal_string(s, sizeof(s), ep_f);
+				asset_read_encrypted_pascal_string(s, sizeof(s), &ep_reader);
 
 				if (s[0] == ']')
 				{
@@ -2610,7 +2637,7 @@ new_game:
 
 						for (int i = 0; i < 9; ++i)
 						{
-							read_encrypted_pascal_string(s, sizeof(s), ep_f);
+							asset_read_encrypted_pascal_string(s, sizeof(s), &ep_reader);
 
 							char buf[256];
 							strncpy(buf, (strlen(s) > 8) ? s + 8 : "", sizeof(buf));
@@ -2621,6 +2648,8 @@ new_game:
 							itemAvailMax[i] = j;
 						}
 
+						preload_next_level(ep_reader);
+
 						JE_itemScreen();
 						break;
 
@@ -2665,13 +2694,13 @@ new_game:
 						{
 							do
 							{
-								read_encrypted_pascal_string(s, sizeof(s), ep_f);
+								asset_read_encrypted_pascal_string(s, sizeof(s), &ep_reader);
 							} while (s[0] != '#');
 						}
 
 						do
 						{
-							read_encrypted_pascal_string(s, sizeof(s), ep_f);
+							asset_read_encrypted_pascal_string(s, sizeof(s), &ep_reader);
 							strcpy(levelWarningText[levelWarningLines], s);
 							levelWarningLines++;
 						} while (s[0] != '#');
@@ -2963,7 +2992,7 @@ new_game:
 
 								do
 								{
-									read_encrypted_pascal_string(s, sizeof(s), ep_f);
+									asset_read_encrypted_pascal_string(s, sizeof(s), &ep_reader);
 
 									if (s[0] != '#')
 									{
@@ -2989,7 +3018,7 @@ new_game:
 					case 'h':
 						if (initialDifficulty > DIFFICULTY_NORMAL)
 						{
-							read_encrypted_pascal_string(s, sizeof(s), ep_f);
+							asset_read_encrypted_pascal_string(s, sizeof(s), &ep_reader);
 						}
 						break;
 
@@ -3032,8 +3061,6 @@ new_game:
 
 			} while (!(loadLevelOk || jumpSection));
 
-			fclose(ep_f);
-
 		} while (!loadLevelOk);
 	}
 
@@ -3042,158 +3069,22 @@ new_game:
 	else
 		fade_black(50);
 
-	FILE *level_f = dir_fopen_die(data_dir(), levelFile, "rb");
-	fseek(level_f, lvlPos[(lvlFileNum-1) * 2], SEEK_SET);
-
-	JE_char char_mapFile;
-	JE_char char_shapeFile;
-	fread_die(&char_mapFile,   1, 1, level_f);
-	fread_die(&char_shapeFile, 1, 1, level_f);
-	fread_u16_die(&mapX,  1, level_f);
-	fread_u16_die(&mapX2, 1, level_f);
-	fread_u16_die(&mapX3, 1, level_f);
-
-	fread_u16_die(&levelEnemyMax, 1, level_f);
-	fread_u16_die(levelEnemy, levelEnemyMax, level_f);
-
-	fread_u16_die(&maxEvent, 1, level_f);
-	for (x = 0; x < maxEvent; x++)
-	{
-		fread_u16_die(&eventRec[x].eventtime, 1, level_f);
-		fread_u8_die( &eventRec[x].eventtype, 1, level_f);
-		fread_s16_die(&eventRec[x].eventdat,  1, level_f);
-		fread_s16_die(&eventRec[x].eventdat2, 1, level_f);
-		fread_s8_die( &eventRec[x].eventdat3, 1, level_f);
-		fread_s8_die( &eventRec[x].eventdat5, 1, level_f);
-		fread_s8_die( &eventRec[x].eventdat6, 1, level_f);
-		fread_u8_die( &eventRec[x].eventdat4, 1, level_f);
-	}
-	eventRec[x].eventtime = 65500;  /*Not needed but just in case*/
-
-	/*debuginfo('Level loaded.');*/
-
-	/*debuginfo('Loading Map');*/
-
-	/* MAP SHAPE LOOKUP TABLE - Each map is directly after level */
-	for (temp = 0; temp < 3; temp++)
-	{
-		fread_u16_die(mapSh[temp], sizeof(*mapSh) / sizeof(JE_word), level_f);
-		for (temp2 = 0; temp2 < 128; temp2++)
-		{
-			mapSh[temp][temp2] = SDL_Swap16(mapSh[temp][temp2]);
-		}
-	}
-
-	/* Read Shapes.DAT */
-	sprintf(tempStr, "shapes%c.dat", tolower((unsigned char)char_shapeFile));
-	FILE *shpFile = dir_fopen_die(data_dir(), tempStr, "rb");
-
-	for (int z = 0; z < 600; z++)
-	{
-		JE_boolean shapeBlank;
-		fread_bool_die(&shapeBlank, shpFile);
-
-		if (shapeBlank)
-			memset(shape, 0, sizeof(shape));
-		else
-			fread_u8_die(shape, sizeof(shape), shpFile);
-
-		/* Match 1 */
-		for (int x = 0; x <= 71; ++x)
-		{
-			if (mapSh[0][x] == z+1)
-			{
-				memcpy(megaData1.shapes[x].sh, shape, sizeof(JE_DanCShape));
-
-				ref[0][x] = megaData1.shapes[x].sh;
-			}
-		}
-
-		/* Match 2 */
-		for (int x = 0; x <= 71; ++x)
-		{
-			if (mapSh[1][x] == z+1)
-			{
-				if (x != 71 && !shapeBlank)
-				{
-					memcpy(megaData2.shapes[x].sh, shape, sizeof(JE_DanCShape));
-
-					y = 1;
-					for (yy = 0; yy < (24 * 28) >> 1; yy++)
-						if (shape[yy] == 0)
-							y = 0;
-
-					megaData2.shapes[x].fill = y;
-					ref[1][x] = megaData2.shapes[x].sh;
-				}
-				else
-				{
-					ref[1][x] = NULL;
-				}
-			}
-		}
-
-		/*Match 3*/
-		for (int x = 0; x <= 71; ++x)
-		{
-			if (mapSh[2][x] == z+1)
-			{
-				if (x < 70 && !shapeBlank)
-				{
-					memcpy(megaData3.shapes[x].sh, shape, sizeof(JE_DanCShape));
+	const LevelData *level = finish_level_load(levelFile, lvlPos[(lvlFileNum-1) * 2]);
 
-					y = 1;
-					for (yy = 0; yy < (24 * 28) >> 1; yy++)
-						if (shape[yy] == 0)
-							y = 0;
+	mapX  = level->mapX;
+	mapX2 = level->mapX2;
+	mapX3 = level->mapX3;
 
-					megaData3.shapes[x].fill = y;
-					ref[2][x] = megaData3.shapes[x].sh;
-				}
-				else
-				{
-					ref[2][x] = NULL;
-				}
-			}
-		}
-	}
+	levelEnemyMax = level->enemyCount;
+	memcpy(levelEnemy, level->enemies, levelEnemyMax * sizeof(*levelEnemy));
 
-	fclose(shpFile);
+	maxEvent = level->eventCount;
+	memcpy(eventRec, level->events, (maxEvent + 1) * sizeof(*eventRec));
 
-	fread_u8_die(mapBuf, 14 * 300, level_f);
-	bufLoc = 0;              /* MAP NUMBER 1 */
-	for (y = 0; y < 300; y++)
-	{
-		for (x = 0; x < 14; x++)
-		{
-			megaData1.mainmap[y][x] = ref[0][mapBuf[bufLoc]];
-			bufLoc++;
-		}
-	}
-
-	fread_u8_die(mapBuf, 14 * 600, level_f);
-	bufLoc = 0;              /* MAP NUMBER 2 */
-	for (y = 0; y < 600; y++)
-	{
-		for (x = 0; x < 14; x++)
-		{
-			megaData2.mainmap[y][x] = ref[1][mapBuf[bufLoc]];
-			bufLoc++;
-		}
-	}
-
-	fread_u8_die(mapBuf, 15 * 600, level_f);
-	bufLoc = 0;              /* MAP NUMBER 3 */
-	for (y = 0; y < 600; y++)
-	{
-		for (x = 0; x < 15; x++)
-		{
-			megaData3.mainmap[y][x] = ref[2][mapBuf[bufLoc]];
-			bufLoc++;
-		}
-	}
-
-	fclose(level_f);
+	memcpy(&megaData1, &level->megaData1, sizeof(megaData1));
+	memcpy(&megaData2, &level->megaData2, sizeof(megaData2));
+	memcpy(&megaData3, &level->megaData3, sizeof(megaData3));
+	reset_background_strips();
 
 	/* Note: The map data is automatically calculated with the correct mapsh
 	value and then the pointer is calculated using the formula (MAPSH-1)*168.
@@ -3257,7 +3148,7 @@ void networkStartScreen(void)
 			network_update();
 			network_check();
 
-			SDL_Delay(16);
+			sleep_ticks(16);
 		}
 
 		JE_initEpisode(SDLNet_Read16(&packet_in[0]->data[4]));
@@ -3279,7 +3170,7 @@ void networkStartScreen(void)
 		JE_showVGA();
 
 		network_check();
-		SDL_Delay(16);
+		sleep_ticks(16);
 	}
 }
 #endif /* WITH_NETWORK */
@@ -3385,13 +3276,13 @@ bool titleScreen(void)
 		JE_showVGA();
 		JE_mouseReplace();
 
-		const Uint32 idleStartTick = SDL_GetTicks();
+		const Uint32 idleStartTick = get_ticks();
 
 		bool mouseMoved = false;
 		do
 		{
 			// Play demo after idle for 30 seconds.
-			if (SDL_GetTicks() - idleStartTick > 30000)
+			if (get_ticks() - idleStartTick > 30000)
 			{
 				fade_black(15);
 
@@ -3399,7 +3290,7 @@ bool titleScreen(void)
 				return true;
 			}
 
-			SDL_Delay(16);
+			sleep_ticks(16);
 
 			Uint16 oldMouseX = mouse_x;
 			Uint16 oldMouseY = mouse_y;
@@ -3892,7 +3783,7 @@ Sint16 JE_newEnemy(int enemyOffset, Uint16 eDatI, Sint16 uniqueShapeTableI)
 	{
 		if (enemyAvail[i] == 1)
 		{
-			enemyAvail[i] = JE_makeEnemy(&enemy[i], eDatI, uniqueShapeTableI);
+			set_enemy_avail(i, JE_makeEnemy(i, eDatI, uniqueShapeTableI));
 			return i + 1;
 		}
 	}
@@ -3900,8 +3791,10 @@ Sint16 JE_newEnemy(int enemyOffset, Uint16 eDatI, Sint16 uniqueShapeTableI)
 	return 0;
 }
 
-uint JE_makeEnemy(struct JE_SingleEnemyType *enemy, Uint16 eDatI, Sint16 uniqueShapeTableI)
+uint JE_makeEnemy(unsigned int slot, Uint16 eDatI, Sint16 uniqueShapeTableI)
 {
+	struct JE_SingleEnemyType *this_enemy = &enemy[slot];
+
 	uint avail;
 
 	JE_byte shapeTableI;
@@ -3935,146 +3828,146 @@ uint JE_makeEnemy(struct JE_SingleEnemyType *enemy, Uint16 eDatI, Sint16 uniqueS
 	}
 	
 	if (sprite2s != NULL)
-		enemy->sprite2s = sprite2s;
+		this_enemy->sprite2s = sprite2s;
 	else
 		// Use shape table value from previous enemy that occupied the enemy slot. (Ex. APPROACH.)
 		fprintf(stderr, "warning: ignoring sprite from unloaded shape table %d\n", shapeTableI);
 
-	enemy->enemydatofs = &enemyDat[eDatI];
+	this_enemy->enemydatofs = &enemyDat[eDatI];
 
-	enemy->mapoffset = 0;
+	enemyHot.mapoffset[slot] = 0;
 
 	for (uint i = 0; i < 3; ++i)
 	{
-		enemy->eshotmultipos[i] = 0;
+		this_enemy->eshotmultipos[i] = 0;
 	}
 
-	enemy->enemyground = (enemyDat[eDatI].explosiontype & 1) == 0;
-	enemy->explonum = enemyDat[eDatI].explosiontype >> 1;
+	this_enemy->enemyground = (enemyDat[eDatI].explosiontype & 1) == 0;
+	this_enemy->explonum = enemyDat[eDatI].explosiontype >> 1;
 
-	enemy->launchfreq = enemyDat[eDatI].elaunchfreq;
-	enemy->launchwait = enemyDat[eDatI].elaunchfreq;
+	this_enemy->launchfreq = enemyDat[eDatI].elaunchfreq;
+	this_enemy->launchwait = enemyDat[eDatI].elaunchfreq;
 
 	// T2000 ... Account for the second enemy bank only if we're creating something from it
 	if (eDatI > 1000)
 	{
-		enemy->launchtype = enemyDat[eDatI].elaunchtype;
-		enemy->launchspecial = 0;
+		this_enemy->launchtype = enemyDat[eDatI].elaunchtype;
+		this_enemy->launchspecial = 0;
 	}
 	else
 	{
-		enemy->launchtype = enemyDat[eDatI].elaunchtype % 1000;
-		enemy->launchspecial = enemyDat[eDatI].elaunchtype / 1000;
+		this_enemy->launchtype = enemyDat[eDatI].elaunchtype % 1000;
+		this_enemy->launchspecial = enemyDat[eDatI].elaunchtype / 1000;
 	}
 
-	enemy->xaccel = enemyDat[eDatI].xaccel;
-	enemy->yaccel = enemyDat[eDatI].yaccel;
+	this_enemy->xaccel = enemyDat[eDatI].xaccel;
+	this_enemy->yaccel = enemyDat[eDatI].yaccel;
 
-	enemy->xminbounce = -10000;
-	enemy->xmaxbounce = 10000;
-	enemy->yminbounce = -10000;
-	enemy->ymaxbounce = 10000;
+	this_enemy->xminbounce = -10000;
+	this_enemy->xmaxbounce = 10000;
+	this_enemy->yminbounce = -10000;
+	this_enemy->ymaxbounce = 10000;
 	/*Far enough away to be impossible to reach*/
 
 	for (uint i = 0; i < 3; ++i)
 	{
-		enemy->tur[i] = enemyDat[eDatI].tur[i];
+		this_enemy->tur[i] = enemyDat[eDatI].tur[i];
 	}
 
-	enemy->ani = enemyDat[eDatI].ani;
-	enemy->animin = 1;
+	this_enemy->ani = enemyDat[eDatI].ani;
+	this_enemy->animin = 1;
 
 	switch (enemyDat[eDatI].animate)
 	{
 	case 0:
-		enemy->enemycycle = 1;
-		enemy->aniactive = 0;
-		enemy->animax = 0;
-		enemy->aniwhenfire = 0;
+		this_enemy->enemycycle = 1;
+		this_enemy->aniactive = 0;
+		this_enemy->animax = 0;
+		this_enemy->aniwhenfire = 0;
 		break;
 	case 1:
-		enemy->enemycycle = 0;
-		enemy->aniactive = 1;
-		enemy->animax = 0;
-		enemy->aniwhenfire = 0;
+		this_enemy->enemycycle = 0;
+		this_enemy->aniactive = 1;
+		this_enemy->animax = 0;
+		this_enemy->aniwhenfire = 0;
 		break;
 	case 2:
-		enemy->enemycycle = 1;
-		enemy->aniactive = 2;
-		enemy->animax = enemy->ani;
-		enemy->aniwhenfire = 2;
+		this_enemy->enemycycle = 1;
+		this_enemy->aniactive = 2;
+		this_enemy->animax = this_enemy->ani;
+		this_enemy->aniwhenfire = 2;
 		break;
 	}
 
 	if (enemyDat[eDatI].startxc != 0)
-		enemy->ex = enemyDat[eDatI].startx + (mt_rand() % (enemyDat[eDatI].startxc * 2)) - enemyDat[eDatI].startxc + 1;
+		enemyHot.ex[slot] = enemyDat[eDatI].startx + (mt_rand() % (enemyDat[eDatI].startxc * 2)) - enemyDat[eDatI].startxc + 1;
 	else
-		enemy->ex = enemyDat[eDatI].startx + 1;
+		enemyHot.ex[slot] = enemyDat[eDatI].startx + 1;
 
 	if (enemyDat[eDatI].startyc != 0)
-		enemy->ey = enemyDat[eDatI].starty + (mt_rand() % (enemyDat[eDatI].startyc * 2)) - enemyDat[eDatI].startyc + 1;
+		enemyHot.ey[slot] = enemyDat[eDatI].starty + (mt_rand() % (enemyDat[eDatI].startyc * 2)) - enemyDat[eDatI].startyc + 1;
 	else
-		enemy->ey = enemyDat[eDatI].starty + 1;
-
-	enemy->exc = enemyDat[eDatI].xmove;
-	enemy->eyc = enemyDat[eDatI].ymove;
-	enemy->excc = enemyDat[eDatI].xcaccel;
-	enemy->eycc = enemyDat[eDatI].ycaccel;
-	enemy->exccw = abs(enemy->excc);
-	enemy->exccwmax = enemy->exccw;
-	enemy->eyccw = abs(enemy->eycc);
-	enemy->eyccwmax = enemy->eyccw;
-	enemy->exccadd = (enemy->excc > 0) ? 1 : -1;
-	enemy->eyccadd = (enemy->eycc > 0) ? 1 : -1;
-	enemy->special = false;
-	enemy->iced = 0;
+		enemyHot.ey[slot] = enemyDat[eDatI].starty + 1;
+
+	enemyHot.exc[slot] = enemyDat[eDatI].xmove;
+	enemyHot.eyc[slot] = enemyDat[eDatI].ymove;
+	this_enemy->excc = enemyDat[eDatI].xcaccel;
+	this_enemy->eycc = enemyDat[eDatI].ycaccel;
+	this_enemy->exccw = abs(this_enemy->excc);
+	this_enemy->exccwmax = this_enemy->exccw;
+	this_enemy->eyccw = abs(this_enemy->eycc);
+	this_enemy->eyccwmax = this_enemy->eyccw;
+	this_enemy->exccadd = (this_enemy->excc > 0) ? 1 : -1;
+	this_enemy->eyccadd = (this_enemy->eycc > 0) ? 1 : -1;
+	this_enemy->special = false;
+	this_enemy->iced = 0;
 
 	if (enemyDat[eDatI].xrev == 0)
-		enemy->exrev = 100;
+		this_enemy->exrev = 100;
 	else if (enemyDat[eDatI].xrev == -99)
-		enemy->exrev = 0;
+		this_enemy->exrev = 0;
 	else
-		enemy->exrev = enemyDat[eDatI].xrev;
+		this_enemy->exrev = enemyDat[eDatI].xrev;
 
 	if (enemyDat[eDatI].yrev == 0)
-		enemy->eyrev = 100;
+		this_enemy->eyrev = 100;
 	else if (enemyDat[eDatI].yrev == -99)
-		enemy->eyrev = 0;
+		this_enemy->eyrev = 0;
 	else
-		enemy->eyrev = enemyDat[eDatI].yrev;
+		this_enemy->eyrev = enemyDat[eDatI].yrev;
 
-	enemy->exca = (enemy->xaccel > 0) ? 1 : -1;
-	enemy->eyca = (enemy->yaccel > 0) ? 1 : -1;
+	this_enemy->exca = (this_enemy->xaccel > 0) ? 1 : -1;
+	this_enemy->eyca = (this_enemy->yaccel > 0) ? 1 : -1;
 
-	enemy->enemytype = eDatI;
+	this_enemy->enemytype = eDatI;
 
 	for (uint i = 0; i < 3; ++i)
 	{
-		if (enemy->tur[i] == 252)
-			enemy->eshotwait[i] = 1;
-		else if (enemy->tur[i] > 0)
-			enemy->eshotwait[i] = 20;
+		if (this_enemy->tur[i] == 252)
+			this_enemy->eshotwait[i] = 1;
+		else if (this_enemy->tur[i] > 0)
+			this_enemy->eshotwait[i] = 20;
 		else
-			enemy->eshotwait[i] = 255;
+			this_enemy->eshotwait[i] = 255;
 	}
 	for (uint i = 0; i < 20; ++i)
-		enemy->egr[i] = enemyDat[eDatI].egraphic[i];
-	enemy->size = enemyDat[eDatI].esize;
-	enemy->linknum = 0;
-	enemy->edamaged = enemyDat[eDatI].dani < 0;
-	enemy->enemydie = enemyDat[eDatI].eenemydie;
+		this_enemy->egr[i] = enemyDat[eDatI].egraphic[i];
+	enemyHot.size[slot] = enemyDat[eDatI].esize;
+	enemyHot.linknum[slot] = 0;
+	this_enemy->edamaged = enemyDat[eDatI].dani < 0;
+	this_enemy->enemydie = enemyDat[eDatI].eenemydie;
 
-	enemy->freq[1-1] = enemyDat[eDatI].freq[1-1];
-	enemy->freq[2-1] = enemyDat[eDatI].freq[2-1];
-	enemy->freq[3-1] = enemyDat[eDatI].freq[3-1];
+	this_enemy->freq[1-1] = enemyDat[eDatI].freq[1-1];
+	this_enemy->freq[2-1] = enemyDat[eDatI].freq[2-1];
+	this_enemy->freq[3-1] = enemyDat[eDatI].freq[3-1];
 
-	enemy->edani   = enemyDat[eDatI].dani;
-	enemy->edgr    = enemyDat[eDatI].dgr;
-	enemy->edlevel = enemyDat[eDatI].dlevel;
+	this_enemy->edani   = enemyDat[eDatI].dani;
+	this_enemy->edgr    = enemyDat[eDatI].dgr;
+	this_enemy->edlevel = enemyDat[eDatI].dlevel;
 
-	enemy->fixedmovey = 0;
+	this_enemy->fixedmovey = 0;
 
-	enemy->filter = 0x00;
+	this_enemy->filter = 0x00;
 
 	int tempValue = 0;
 	if (enemyDat[eDatI].value > 1 && enemyDat[eDatI].value < 10000)
@@ -4112,11 +4005,11 @@ uint JE_makeEnemy(struct JE_SingleEnemyType *enemy, Uint16 eDatI, Sint16 uniqueS
 		}
 		if (tempValue > 10000)
 			tempValue = 10000;
-		enemy->evalue = tempValue;
+		this_enemy->evalue = tempValue;
 	}
 	else
 	{
-		enemy->evalue = enemyDat[eDatI].value;
+		this_enemy->evalue = enemyDat[eDatI].value;
 	}
 
 	int tempArmor = 1;
@@ -4170,20 +4063,20 @@ uint JE_makeEnemy(struct JE_SingleEnemyType *enemy, Uint16 eDatI, Sint16 uniqueS
 			tempArmor = 255;
 		}
 
-		enemy->armorleft = tempArmor;
+		this_enemy->armorleft = tempArmor;
 
 		avail = 0;
-		enemy->scoreitem = false;
+		this_enemy->scoreitem = false;
 	}
 	else
 	{
 		avail = 2;
-		enemy->armorleft = 255;
-		if (enemy->evalue != 0)
-			enemy->scoreitem = true;
+		this_enemy->armorleft = 255;
+		if (this_enemy->evalue != 0)
+			this_enemy->scoreitem = true;
 	}
 
-	if (!enemy->scoreitem)
+	if (!this_enemy->scoreitem)
 	{
 		totalEnemy++;  /*Destruction ratio*/
 	}
@@ -4212,7 +4105,7 @@ void JE_createNewEventEnemy(JE_byte enemyTypeOfs, JE_word enemyOffset, Sint16 un
 
 	tempW = eventRec[eventLoc-1].eventdat + enemyTypeOfs;
 
-	enemyAvail[b-1] = JE_makeEnemy(&enemy[b-1], tempW, uniqueShapeTableI);
+	set_enemy_avail(b-1, JE_makeEnemy(b-1, tempW, uniqueShapeTableI));
 
 	// When T2000 gives an X position of -200, what it actually wants is a random X position...
 	if (eventRec[eventLoc-1].eventdat2 == -200)
@@ -4226,39 +4119,39 @@ void JE_createNewEventEnemy(JE_byte enemyTypeOfs, JE_word enemyOffset, Sint16 un
 		switch (enemyOffset)
 		{
 		case 0:
-			enemy[b-1].ex = eventRec[eventLoc-1].eventdat2 - (mapX - 1) * 24;
-			enemy[b-1].ey -= backMove2;
+			enemyHot.ex[b-1] = eventRec[eventLoc-1].eventdat2 - (mapX - 1) * 24;
+			enemyHot.ey[b-1] -= backMove2;
 			break;
 		case 25:
 		case 75:
-			enemy[b-1].ex = eventRec[eventLoc-1].eventdat2 - (mapX - 1) * 24 - 12;
-			enemy[b-1].ey -= backMove;
+			enemyHot.ex[b-1] = eventRec[eventLoc-1].eventdat2 - (mapX - 1) * 24 - 12;
+			enemyHot.ey[b-1] -= backMove;
 			break;
 		case 50:
 			if (background3x1)
-				enemy[b-1].ex = eventRec[eventLoc-1].eventdat2 - (mapX - 1) * 24 - 12;
+				enemyHot.ex[b-1] = eventRec[eventLoc-1].eventdat2 - (mapX - 1) * 24 - 12;
 			else
-				enemy[b-1].ex = eventRec[eventLoc-1].eventdat2 - mapX3 * 24 - 24 * 2 + 6;
-			enemy[b-1].ey -= backMove3;
+				enemyHot.ex[b-1] = eventRec[eventLoc-1].eventdat2 - mapX3 * 24 - 24 * 2 + 6;
+			enemyHot.ey[b-1] -= backMove3;
 
 			if (background3x1b)
-				enemy[b-1].ex -= 6;
+				enemyHot.ex[b-1] -= 6;
 			break;
 		}
-		enemy[b-1].ey = -28;
+		enemyHot.ey[b-1] = -28;
 		if (background3x1b && enemyOffset == 50)
-			enemy[b-1].ey += 4;
+			enemyHot.ey[b-1] += 4;
 	}
 
-	if (smallEnemyAdjust && enemy[b-1].size == 0)
+	if (smallEnemyAdjust && enemyHot.size[b-1] == 0)
 	{
-		enemy[b-1].ex -= 10;
-		enemy[b-1].ey -= 7;
+		enemyHot.ex[b-1] -= 10;
+		enemyHot.ey[b-1] -= 7;
 	}
 
-	enemy[b-1].ey += eventRec[eventLoc-1].eventdat5;
-	enemy[b-1].eyc += eventRec[eventLoc-1].eventdat3;
-	enemy[b-1].linknum = eventRec[eventLoc-1].eventdat4;
+	enemyHot.ey[b-1] += eventRec[eventLoc-1].eventdat5;
+	enemyHot.eyc[b-1] += eventRec[eventLoc-1].eventdat3;
+	enemyHot.linknum[b-1] = eventRec[eventLoc-1].eventdat4;
 	enemy[b-1].fixedmovey = eventRec[eventLoc-1].eventdat6;
 }
 
@@ -4289,7 +4182,7 @@ bool JE_searchFor/*enemy*/(JE_byte PLType, JE_byte* out_index)
 
 	for (int i = 0; i < 100; i++)
 	{
-		if (enemyAvail[i] == 0 && enemy[i].linknum == PLType)
+		if (enemyAvail[i] == 0 && enemyHot.linknum[i] == PLType)
 		{
 			found_id = i;
 			if (galagaMode)
@@ -4382,7 +4275,8 @@ void JE_eventSystem(void)
 					if (newEnemyShapeTables[i] > 0)
 					{
 						assert(newEnemyShapeTables[i] <= COUNTOF(shapeFile));
-						JE_loadCompShapes(&enemySpriteSheets[i], shapeFile[newEnemyShapeTables[i] - 1]);
+						if (!take_preloaded_enemy_shapes(&enemySpriteSheets[i], newEnemyShapeTables[i]))
+							JE_loadCompShapes(&enemySpriteSheets[i], shapeFile[newEnemyShapeTables[i] - 1]);
 					}
 					else
 						free_sprite2s(&enemySpriteSheets[i]);
@@ -4449,15 +4343,15 @@ void JE_eventSystem(void)
 			JE_createNewEventEnemy(0, temp, 0);
 			JE_createNewEventEnemy(1, temp, 0);
 			if (b > 0)
-				enemy[b-1].ex += 24;
+				enemyHot.ex[b-1] += 24;
 			JE_createNewEventEnemy(2, temp, 0);
 			if (b > 0)
-				enemy[b-1].ey -= 28;
+				enemyHot.ey[b-1] -= 28;
 			JE_createNewEventEnemy(3, temp, 0);
 			if (b > 0)
 			{
-				enemy[b-1].ex += 24;
-				enemy[b-1].ey -= 28;
+				enemyHot.ex[b-1] += 24;
+				enemyHot.ey[b-1] -= 28;
 			}
 			break;
 		}
@@ -4488,13 +4382,13 @@ void JE_eventSystem(void)
 	case 17: /* Ground Bottom */
 		JE_createNewEventEnemy(0, 25, 0);
 		if (b > 0)
-			enemy[b-1].ey = 190 + eventRec[eventLoc-1].eventdat5;
+			enemyHot.ey[b-1] = 190 + eventRec[eventLoc-1].eventdat5;
 		break;
 
 	case 18: /* Sky Enemy on Bottom */
 		JE_createNewEventEnemy(0, 0, 0);
 		if (b > 0)
-			enemy[b-1].ey = 190 + eventRec[eventLoc-1].eventdat5;
+			enemyHot.ey[b-1] = 190 + eventRec[eventLoc-1].eventdat5;
 		break;
 
 	case 19: /* Enemy Global Move */
@@ -4543,13 +4437,13 @@ void JE_eventSystem(void)
 
 		for (int i = initial_i; i < max_i; i++)
 		{
-			if (all_enemies || enemy[i].linknum == eventRec[eventLoc-1].eventdat4)
+			if (all_enemies || enemyHot.linknum[i] == eventRec[eventLoc-1].eventdat4)
 			{
 				if (eventRec[eventLoc-1].eventdat != -99)
-					enemy[i].exc = eventRec[eventLoc-1].eventdat;
+					enemyHot.exc[i] = eventRec[eventLoc-1].eventdat;
 
 				if (eventRec[eventLoc-1].eventdat2 != -99)
-					enemy[i].eyc = eventRec[eventLoc-1].eventdat2;
+					enemyHot.eyc[i] = eventRec[eventLoc-1].eventdat2;
 
 				if (eventRec[eventLoc-1].eventdat6 != 0)
 					enemy[i].fixedmovey = eventRec[eventLoc-1].eventdat6;
@@ -4571,7 +4465,7 @@ void JE_eventSystem(void)
 		for (temp = 0; temp < 100; temp++)
 		{
 			if (enemyAvail[temp] != 1 &&
-			    (enemy[temp].linknum == eventRec[eventLoc-1].eventdat4 || eventRec[eventLoc-1].eventdat4 == 0))
+			    (enemyHot.linknum[temp] == eventRec[eventLoc-1].eventdat4 || eventRec[eventLoc-1].eventdat4 == 0))
 			{
 				if (eventRec[eventLoc-1].eventdat != -99)
 				{
@@ -4621,13 +4515,13 @@ void JE_eventSystem(void)
 	case 23: /* Sky Enemy on Bottom */
 		JE_createNewEventEnemy(0, 50, 0);
 		if (b > 0)
-			enemy[b-1].ey = 180 + eventRec[eventLoc-1].eventdat5;
+			enemyHot.ey[b-1] = 180 + eventRec[eventLoc-1].eventdat5;
 		break;
 
 	case 24: /* Enemy Global Animate */
 		for (temp = 0; temp < 100; temp++)
 		{
-			if (enemy[temp].linknum == eventRec[eventLoc-1].eventdat4)
+			if (enemyHot.linknum[temp] == eventRec[eventLoc-1].eventdat4)
 			{
 				enemy[temp].aniactive = 1;
 				enemy[temp].aniwhenfire = 0;
@@ -4661,7 +4555,7 @@ void JE_eventSystem(void)
 	case 25: /* Enemy Global Damage change */
 		for (temp = 0; temp < 100; temp++)
 		{
-			if (eventRec[eventLoc-1].eventdat4 == 0 || enemy[temp].linknum == eventRec[eventLoc-1].eventdat4)
+			if (eventRec[eventLoc-1].eventdat4 == 0 || enemyHot.linknum[temp] == eventRec[eventLoc-1].eventdat4)
 			{
 				if (galagaMode)
 					enemy[temp].armorleft = roundf(eventRec[eventLoc-1].eventdat * (difficultyLevel / 2));
@@ -4681,7 +4575,7 @@ void JE_eventSystem(void)
 
 		for (temp = 0; temp < 100; temp++)
 		{
-			if (eventRec[eventLoc-1].eventdat4 == 0 || enemy[temp].linknum == eventRec[eventLoc-1].eventdat4)
+			if (eventRec[eventLoc-1].eventdat4 == 0 || enemyHot.linknum[temp] == eventRec[eventLoc-1].eventdat4)
 			{
 				if (eventRec[eventLoc-1].eventdat != -99)
 					enemy[temp].exrev = eventRec[eventLoc-1].eventdat;
@@ -4716,7 +4610,7 @@ void JE_eventSystem(void)
 	case 31: /* Enemy Fire Override */
 		for (temp = 0; temp < 100; temp++)
 		{
-			if (eventRec[eventLoc-1].eventdat4 == 99 || enemy[temp].linknum == eventRec[eventLoc-1].eventdat4)
+			if (eventRec[eventLoc-1].eventdat4 == 99 || enemyHot.linknum[temp] == eventRec[eventLoc-1].eventdat4)
 			{
 				enemy[temp].freq[1-1] = eventRec[eventLoc-1].eventdat ;
 				enemy[temp].freq[2-1] = eventRec[eventLoc-1].eventdat2;
@@ -4737,7 +4631,7 @@ void JE_eventSystem(void)
 	case 32:  // create enemy
 		JE_createNewEventEnemy(0, 50, 0);
 		if (b > 0)
-			enemy[b-1].ey = 190;
+			enemyHot.ey[b-1] = 190;
 		break;
 
 	case 33: /* Enemy From other Enemies */
@@ -4763,7 +4657,7 @@ void JE_eventSystem(void)
 
 			for (temp = 0; temp < 100; temp++)
 			{
-				if (enemy[temp].linknum == eventRec[eventLoc-1].eventdat4)
+				if (enemyHot.linknum[temp] == eventRec[eventLoc-1].eventdat4)
 					enemy[temp].enemydie = eventRec[eventLoc-1].eventdat;
 			}
 		}
@@ -4808,8 +4702,8 @@ void JE_eventSystem(void)
 	case 39: /* Enemy Global Linknum Change */
 		for (temp = 0; temp < 100; temp++)
 		{
-			if (enemy[temp].linknum == eventRec[eventLoc-1].eventdat)
-				enemy[temp].linknum = eventRec[eventLoc-1].eventdat2;
+			if (enemyHot.linknum[temp] == eventRec[eventLoc-1].eventdat)
+				enemyHot.linknum[temp] = eventRec[eventLoc-1].eventdat2;
 		}
 		break;
 
@@ -4820,12 +4714,12 @@ void JE_eventSystem(void)
 	case 41:
 		if (eventRec[eventLoc-1].eventdat == 0)
 		{
-			memset(enemyAvail, 1, sizeof(enemyAvail));
+			free_all_enemies();
 		}
 		else
 		{
 			for (x = 0; x <= 24; x++)
-				enemyAvail[x] = 1;
+				set_enemy_avail(x, 1);
 		}
 		break;
 
@@ -4860,7 +4754,7 @@ void JE_eventSystem(void)
 			{
 				for (temp = 0; temp < 100; temp++)
 				{
-					if (enemy[temp].linknum == eventRec[eventLoc-1].eventdat4)
+					if (enemyHot.linknum[temp] == eventRec[eventLoc-1].eventdat4)
 						enemy[temp].enemydie = eventRec[eventLoc-1].eventdat;
 				}
 			}
@@ -4884,7 +4778,7 @@ void JE_eventSystem(void)
 	case 47: /* Enemy Global AccelRev */
 		for (temp = 0; temp < 100; temp++)
 		{
-			if (eventRec[eventLoc-1].eventdat4 == 0 || enemy[temp].linknum == eventRec[eventLoc-1].eventdat4)
+			if (eventRec[eventLoc-1].eventdat4 == 0 || enemyHot.linknum[temp] == eventRec[eventLoc-1].eventdat4)
 				enemy[temp].armorleft = eventRec[eventLoc-1].eventdat;
 		}
 		break;
@@ -4940,7 +4834,7 @@ void JE_eventSystem(void)
 
 		for (temp = 0; temp < 100; temp++)
 		{
-			if (eventRec[eventLoc-1].eventdat4 == 0 || enemy[temp].linknum == eventRec[eventLoc-1].eventdat4)
+			if (eventRec[eventLoc-1].eventdat4 == 0 || enemyHot.linknum[temp] == eventRec[eventLoc-1].eventdat4)
 			{
 				if (eventRec[eventLoc-1].eventdat != -99)
 					enemy[temp].xaccel = eventRec[eventLoc-1].eventdat;
@@ -4953,7 +4847,7 @@ void JE_eventSystem(void)
 	case 56: /* Ground2 Bottom */
 		JE_createNewEventEnemy(0, 75, 0);
 		if (b > 0)
-			enemy[b-1].ey = 190;
+			enemyHot.ey[b-1] = 190;
 		break;
 
 	case 57:
@@ -4964,7 +4858,7 @@ void JE_eventSystem(void)
 		// This implementation comes from ArcTyr, and may not be 100% accurate to Tyrian 2000
 		for (temp = 0; temp < 100; temp++)
 		{
-			if (eventRec[eventLoc-1].eventdat4 == 99 || enemy[temp].linknum == eventRec[eventLoc-1].eventdat4)
+			if (eventRec[eventLoc-1].eventdat4 == 99 || enemyHot.linknum[temp] == eventRec[eventLoc-1].eventdat4)
 				enemy[temp].launchtype = eventRec[eventLoc-1].eventdat;
 		}
 		break;
@@ -4977,18 +4871,18 @@ void JE_eventSystem(void)
 
 			for (temp = 0; temp < 100; temp++)
 			{
-				if (!(eventRec[eventLoc-1].eventdat4 == 0 || enemy[temp].linknum == eventRec[eventLoc-1].eventdat4))
+				if (!(eventRec[eventLoc-1].eventdat4 == 0 || enemyHot.linknum[temp] == eventRec[eventLoc-1].eventdat4))
 					continue;
 
 				const int enemy_offset = temp - (temp % 25);
 				b = JE_newEnemy(enemy_offset, eDatI, 0);
 				if (b != 0)
 				{
-					enemy[b-1].ex = enemy[temp].ex;
-					enemy[b-1].ey = enemy[temp].ey;
+					enemyHot.ex[b-1] = enemyHot.ex[temp];
+					enemyHot.ey[b-1] = enemyHot.ey[temp];
 				}
 
-				enemyAvail[temp] = 1;
+				set_enemy_avail(temp, 1);
 			}			
 		}
 		break;
@@ -4997,7 +4891,7 @@ void JE_eventSystem(void)
 	case 60: /*Assign Special Enemy*/
 		for (temp = 0; temp < 100; temp++)
 		{
-			if (enemy[temp].linknum == eventRec[eventLoc-1].eventdat4)
+			if (enemyHot.linknum[temp] == eventRec[eventLoc-1].eventdat4)
 			{
 				enemy[temp].special = true;
 				enemy[temp].flagnum = eventRec[eventLoc-1].eventdat;
@@ -5071,7 +4965,7 @@ void JE_eventSystem(void)
 		break;
 
 	case 71:
-		if (((((intptr_t)mapYPos - (intptr_t)&megaData1.mainmap) / sizeof(JE_byte *)) * 2) <= (unsigned)eventRec[eventLoc-1].eventdat2)
+		if (((mapYPos - &megaData1.mainmap[0][0]) * 2) <= (unsigned)eventRec[eventLoc-1].eventdat2)
 			JE_eventJump(eventRec[eventLoc-1].eventdat);
 		break;
 
@@ -5086,7 +4980,7 @@ void JE_eventSystem(void)
 	case 74: /* Enemy Global BounceParams */
 		for (temp = 0; temp < 100; temp++)
 		{
-			if (eventRec[eventLoc-1].eventdat4 == 0 || enemy[temp].linknum == eventRec[eventLoc-1].eventdat4)
+			if (eventRec[eventLoc-1].eventdat4 == 0 || enemyHot.linknum[temp] == eventRec[eventLoc-1].eventdat4)
 			{
 				if (eventRec[eventLoc-1].eventdat5 != -99)
 					enemy[temp].xminbounce = eventRec[eventLoc-1].eventdat5;
@@ -5109,9 +5003,9 @@ void JE_eventSystem(void)
 		for (temp = 0; temp < 100; temp++)
 		{
 			if (enemyAvail[temp] == 0 &&
-			    enemy[temp].eyc == 0 &&
-			    enemy[temp].linknum >= eventRec[eventLoc-1].eventdat &&
-			    enemy[temp].linknum <= eventRec[eventLoc-1].eventdat2)
+			    enemyHot.eyc[temp] == 0 &&
+			    enemyHot.linknum[temp] >= eventRec[eventLoc-1].eventdat &&
+			    enemyHot.linknum[temp] <= eventRec[eventLoc-1].eventdat2)
 			{
 				temp_no_clue = true;
 			}
@@ -5123,7 +5017,7 @@ void JE_eventSystem(void)
 			do
 			{
 				temp = (mt_rand() % (eventRec[eventLoc-1].eventdat2 + 1 - eventRec[eventLoc-1].eventdat)) + eventRec[eventLoc-1].eventdat;
-			} while (!(JE_searchFor(temp, &enemy_i) && enemy[enemy_i].eyc == 0));
+			} while (!(JE_searchFor(temp, &enemy_i) && enemyHot.eyc[enemy_i] == 0));
 
 			newPL[eventRec[eventLoc-1].eventdat3 - 80] = temp;
 		}
@@ -5203,7 +5097,7 @@ void JE_eventSystem(void)
 		{
 			for (temp = 0; temp < 100; temp++)
 			{
-				if (enemy[temp].linknum == eventRec[eventLoc-1].eventdat4)
+				if (enemyHot.linknum[temp] == eventRec[eventLoc-1].eventdat4)
 					enemy[temp].enemydie = eventRec[eventLoc-1].eventdat;
 			}
 		}
@@ -5314,9 +5208,9 @@ void draw_boss_bar(void)
 
 		unsigned int armor = 256;  // higher than armor max
 
-		for (unsigned int e = 0; e < COUNTOF(enemy); e++)  // find most damaged
+		for (unsigned int e = next_enemy_in_use(0, COUNTOF(enemy)); e < COUNTOF(enemy); e = next_enemy_in_use(e + 1, COUNTOF(enemy)))  // find most damaged
 		{
-			if (enemyAvail[e] != 1 && enemy[e].linknum == boss_bar[b].link_num)
+			if (enemyAvail[e] != 1 && enemyHot.linknum[e] == boss_bar[b].link_num)
 				if (enemy[e].armorleft < armor)
 					armor = enemy[e].armorleft;
 		}
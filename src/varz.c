@@ -31,11 +31,14 @@
 #include "nortsong.h"
 #include "nortvars.h"
 #include "opentyr.h"
+#include "profiler.h"
 #include "shots.h"
 #include "sprite.h"
 #include "vga256d.h"
 #include "video.h"
 
+#include <string.h>
+
 JE_integer tempDat, tempDat2, tempDat3;
 
 const JE_byte SANextShip[SA + 2] /* [0..SA + 1] */ = { 3, 8, 6, 2, 5, 1, 4, 10, 9, 7, 3 };
@@ -261,7 +264,19 @@ JE_boolean skipStarShowVGA;
 
 /*EnemyData*/
 JE_MultiEnemyType enemy;
+JE_EnemyHotType enemyHot;
 JE_EnemyAvailType enemyAvail;  /* values: 0: used, 1: free, 2: secret pick-up */
+Uint64 enemyInUse[2];  /* bit per slot that is not free in enemyAvail */
+Uint64 enemySpawned[2];  /* bit per slot taken since build_enemy_grid() */
+
+// Broadphase for player shots: which enemies are in each 32x32 cell of screen position.  The
+// edge cells also take everything further out.
+#define ENEMY_GRID_CELL 32
+#define ENEMY_GRID_X0 (-64)
+#define ENEMY_GRID_Y0 (-128)
+#define ENEMY_GRID_W 14
+#define ENEMY_GRID_H 11
+static Uint64 enemyGrid[ENEMY_GRID_H][ENEMY_GRID_W][2];
 JE_word enemyOffset;
 JE_word enemyOnScreen;
 JE_word superEnemy254Jump;
@@ -269,6 +284,7 @@ JE_word superEnemy254Jump;
 /*EnemyShotData*/
 JE_boolean fireButtonHeld;
 JE_boolean enemyShotAvail[ENEMY_SHOT_MAX]; /* [1..Enemyshotmax] */
+Uint64 enemyShotInUse[(ENEMY_SHOT_MAX + 63) / 64];  /* bit per slot that is taken in enemyShotAvail */
 EnemyShotType enemyShot[ENEMY_SHOT_MAX]; /* [1..Enemyshotmax]  */
 
 /* Player Shot Data */
@@ -299,6 +315,7 @@ JE_word neat;
 
 /*ExplosionData*/
 explosion_type explosions[MAX_EXPLOSIONS]; /* [1..ExplosionMax] */
+Uint64 explosionsInUse[(MAX_EXPLOSIONS + 63) / 64];  /* bit per slot with ttl left */
 JE_integer explosionFollowAmountX, explosionFollowAmountY;
 
 /*Repeating Explosions*/
@@ -318,8 +335,8 @@ JE_boolean doNotSaveBackup;
 JE_word x, y;
 JE_integer b;
 
-JE_byte **BKwrap1to, **BKwrap2to, **BKwrap3to,
-        **BKwrap1, **BKwrap2, **BKwrap3;
+JE_byte *BKwrap1to, *BKwrap2to, *BKwrap3to,
+        *BKwrap1, *BKwrap2, *BKwrap3;
 
 JE_shortint specialWeaponFilter, specialWeaponFreq;
 JE_word     specialWeaponWpn;
@@ -328,6 +345,72 @@ JE_boolean  linkToPlayer;
 JE_word shipGr, shipGr2;
 Sprite2_array *shipGrPtr, *shipGr2ptr;
 
+void free_all_enemies(void)
+{
+	memset(enemyAvail, 1, sizeof(enemyAvail));
+	memset(enemyInUse, 0, sizeof(enemyInUse));
+}
+
+void free_all_enemy_shots(void)
+{
+	for (uint i = 0; i < COUNTOF(enemyShotAvail); i++)
+		enemyShotAvail[i] = 1;
+	memset(enemyShotInUse, 0, sizeof(enemyShotInUse));
+}
+
+void free_all_explosions(void)
+{
+	memset(explosions, 0, sizeof(explosions));
+	memset(explosionsInUse, 0, sizeof(explosionsInUse));
+}
+
+static int enemy_grid_column(int x)
+{
+	if (x < ENEMY_GRID_X0)
+		return 0;
+	return MIN((x - ENEMY_GRID_X0) / ENEMY_GRID_CELL, ENEMY_GRID_W - 1);
+}
+
+static int enemy_grid_row(int y)
+{
+	if (y < ENEMY_GRID_Y0)
+		return 0;
+	return MIN((y - ENEMY_GRID_Y0) / ENEMY_GRID_CELL, ENEMY_GRID_H - 1);
+}
+
+// files the enemies by where they are now; enemies that appear afterwards are in enemySpawned
+void build_enemy_grid(void)
+{
+	memset(enemyGrid, 0, sizeof(enemyGrid));
+	memset(enemySpawned, 0, sizeof(enemySpawned));
+
+	for (unsigned int i = next_enemy_in_use(0, 100); i < 100; i = next_enemy_in_use(i + 1, 100))
+	{
+		const int column = enemy_grid_column(enemyHot.ex[i] + enemyHot.mapoffset[i]),
+		          row = enemy_grid_row(enemyHot.ey[i]);
+
+		enemyGrid[row][column][i / 64] |= (Uint64)1 << (i % 64);
+	}
+}
+
+// marks the enemies that might have a screen position inside x1..x2 by y1..y2
+void find_enemies_near(Uint64 candidates[2], int x1, int y1, int x2, int y2)
+{
+	candidates[0] = candidates[1] = 0;
+
+	const int column2 = enemy_grid_column(x2),
+	          row2 = enemy_grid_row(y2);
+
+	for (int row = enemy_grid_row(y1); row <= row2; ++row)
+	{
+		for (int column = enemy_grid_column(x1); column <= column2; ++column)
+		{
+			candidates[0] |= enemyGrid[row][column][0];
+			candidates[1] |= enemyGrid[row][column][1];
+		}
+	}
+}
+
 void JE_getShipInfo(void)
 {
 	JE_boolean extraShip, extraShip2;
@@ -449,6 +532,8 @@ void JE_tyrianHalt(JE_byte code)
 	deinit_audio();
 	deinit_video();
 	deinit_joysticks();
+	deinit_profiler();
+	print_frame_pacing_stats();
 
 	/* TODO: NETWORK */
 
@@ -458,11 +543,6 @@ void JE_tyrianHalt(JE_byte code)
 	free_sprite2s(&explosionSpriteSheet);
 	free_sprite2s(&destructSpriteSheet);
 
-	for (int i = 0; i < SOUND_COUNT; i++)
-	{
-		free(soundSamples[i]);
-	}
-
 	if (code != 9)
 	{
 		/*
@@ -521,7 +601,7 @@ void JE_specialComplete(JE_byte playerNum, JE_byte specialType)
 			break;
 		/*Repulsor*/
 		case 2:
-			for (temp = 0; temp < ENEMY_SHOT_MAX; temp++)
+			for (temp = next_enemy_shot_in_use(0); temp < ENEMY_SHOT_MAX; temp = next_enemy_shot_in_use(temp + 1))
 			{
 				if (!enemyShotAvail[temp])
 				{
@@ -550,15 +630,15 @@ void JE_specialComplete(JE_byte playerNum, JE_byte specialType)
 				if (enemyAvail[temp] != 1 && enemy[temp].scoreitem &&
 				    enemy[temp].evalue != 0)
 				{
-					if (player[0].x > enemy[temp].ex)
-						enemy[temp].exc++;
-					else if (player[0].x < enemy[temp].ex)
-						enemy[temp].exc--;
-
-					if (player[0].y > enemy[temp].ey)
-						enemy[temp].eyc++;
-					else if (player[0].y < enemy[temp].ey)
-						enemy[temp].eyc--;
+					if (player[0].x > enemyHot.ex[temp])
+						enemyHot.exc[temp]++;
+					else if (player[0].x < enemyHot.ex[temp])
+						enemyHot.exc[temp]--;
+
+					if (player[0].y > enemyHot.ey[temp])
+						enemyHot.eyc[temp]++;
+					else if (player[0].y < enemyHot.ey[temp])
+						enemyHot.eyc[temp]--;
 				}
 			}
 			break;
@@ -773,7 +853,7 @@ void JE_doSpecialShot(JE_byte playerNum, uint *armor, uint *shield)
 	if (astralDuration > 0)
 		astralDuration--;
 
-	shotAvail[MAX_PWEAPON-1] = 0;
+	set_shot_avail(MAX_PWEAPON-1, 0);
 	if (flareDuration > 1)
 	{
 		if (specialWeaponFilter != -99)
@@ -867,7 +947,7 @@ void JE_doSpecialShot(JE_byte playerNum, uint *armor, uint *shield)
 		zinglonDuration--;
 		if (zinglonDuration % 5 == 0)
 		{
-			shotAvail[MAX_PWEAPON-1] = 1;
+			set_shot_avail(MAX_PWEAPON-1, 1);
 		}
 	}
 }
@@ -936,29 +1016,26 @@ void JE_setupExplosion(signed int x, signed int y, signed int delta_y, unsigned
 
 	if (y > -16 && y < 190)
 	{
-		for (int i = 0; i < MAX_EXPLOSIONS; i++)
+		const unsigned int i = next_clear_slot(explosionsInUse, 0, MAX_EXPLOSIONS);
+		if (i < MAX_EXPLOSIONS)
 		{
-			if (explosions[i].ttl == 0)
+			explosions[i].x = x;
+			explosions[i].y = y;
+			if (type == 6)
 			{
-				explosions[i].x = x;
-				explosions[i].y = y;
-				if (type == 6)
-				{
-					explosions[i].y += 12;
-					explosions[i].x += 2;
-				}
-				else if (type == 98 || type == 198)
-				{
-					type = 6;
-				}
-				explosions[i].sprite = explosion_data[type].sprite;
-				explosions[i].ttl = explosion_data[type].ttl;
-				explosions[i].follow_player = follow_player;
-				explosions[i].fixed_position = fixed_position;
-				explosions[i].delta_x = 0;
-				explosions[i].delta_y = delta_y;
-				break;
+				explosions[i].y += 12;
+				explosions[i].x += 2;
+			}
+			else if (type == 98 || type == 198)
+			{
+				type = 6;
 			}
+			explosions[i].sprite = explosion_data[type].sprite;
+			set_explosion_ttl(i, explosion_data[type].ttl);
+			explosions[i].follow_player = follow_player;
+			explosions[i].fixed_position = fixed_position;
+			explosions[i].delta_x = 0;
+			explosions[i].delta_y = delta_y;
 		}
 	}
 }
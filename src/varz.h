@@ -19,6 +19,7 @@
 #ifndef VARZ_H
 #define VARZ_H
 
+#include "bitmask.h"
 #include "episodes.h"
 #include "opentyr.h"
 #include "player.h"
@@ -54,8 +55,6 @@ enum
 struct JE_SingleEnemyType
 {
 	JE_byte     fillbyte;
-	JE_integer  ex, ey;     /* POSITION */
-	JE_shortint exc, eyc;   /* CURRENT SPEED */
 	JE_shortint exca, eyca; /* RANDOM ACCELERATION */
 	JE_shortint excc, eycc; /* FIXED ACCELERATION WAITTIME */
 	JE_shortint exccw, eyccw;
@@ -64,8 +63,6 @@ struct JE_SingleEnemyType
 	JE_byte     enemycycle;
 	JE_byte     ani;
 	JE_word     egr[20]; /* [1..20] */
-	JE_byte     size;
-	JE_byte     linknum;
 	JE_byte     aniactive;
 	JE_byte     animax;
 	JE_byte     aniwhenfire;
@@ -94,7 +91,6 @@ struct JE_SingleEnemyType
 	JE_word     enemydie; /* Enemy created when this one dies */
 	JE_boolean  enemyground;
 	JE_byte     explonum;
-	JE_word     mapoffset;
 	JE_boolean  scoreitem;
 
 	JE_boolean  special;
@@ -114,15 +110,27 @@ struct JE_SingleEnemyType
 
 typedef struct JE_SingleEnemyType JE_MultiEnemyType[100]; /* [1..100] */
 
+// The fields of the enemies that the per-frame loops read for every enemy, kept apart from the
+// rest of JE_SingleEnemyType in dense arrays.  Indexed like enemy[].
+typedef struct
+{
+	JE_integer  ex[100], ey[100];   /* POSITION */
+	JE_shortint exc[100], eyc[100]; /* CURRENT SPEED */
+	JE_word     mapoffset[100];
+	JE_byte     size[100];
+	JE_byte     linknum[100];
+} JE_EnemyHotType;
+
 typedef JE_byte JE_DanCShape[24 * 28]; /* [1..(24*28) div 2] OF WORD */
 
 typedef JE_char JE_CharString[256]; /* [1..256] */
 
 typedef JE_byte JE_Map1Buffer[24 * 28 * 13 * 4]; /* [1..24*28*13*4] */
 
-typedef JE_byte *JE_MapType[300][14]; /* [1..300, 1..14] */
-typedef JE_byte *JE_MapType2[600][14]; /* [1..600, 1..14] */
-typedef JE_byte *JE_MapType3[600][15]; /* [1..600, 1..15] */
+// Map cells hold 1 + the index of their tile in the map's tiles, or 0 for no tile.
+typedef JE_byte JE_MapType[300][14]; /* [1..300, 1..14] */
+typedef JE_byte JE_MapType2[600][14]; /* [1..600, 1..14] */
+typedef JE_byte JE_MapType3[600][15]; /* [1..600, 1..15] */
 
 struct JE_EventRecType
 {
@@ -133,39 +141,26 @@ struct JE_EventRecType
 	JE_byte     eventdat4;
 };
 
+// The tiles are the distinct shapes that the map uses, one after another.
 struct JE_MegaDataType1
 {
 	JE_MapType mainmap;
-	struct
-	{
-		JE_DanCShape sh;
-	} shapes[72]; /* [0..71] */
-	JE_byte tempdat1;
-	/*JE_DanCShape filler;*/
+	JE_DanCShape tiles[72];
+	JE_byte tileCount;
 };
 
 struct JE_MegaDataType2
 {
 	JE_MapType2 mainmap;
-	struct
-	{
-		JE_byte nothing[3]; /* [1..3] */
-		JE_byte fill;
-		JE_DanCShape sh;
-	} shapes[71]; /* [0..70] */
-	JE_byte tempdat2;
+	JE_DanCShape tiles[71];
+	JE_byte tileCount;
 };
 
 struct JE_MegaDataType3
 {
 	JE_MapType3 mainmap;
-	struct
-	{
-		JE_byte nothing[3]; /* [1..3] */
-		JE_byte fill;
-		JE_DanCShape sh;
-	} shapes[70]; /* [0..69] */
-	JE_byte tempdat3;
+	JE_DanCShape tiles[70];
+	JE_byte tileCount;
 };
 
 typedef JE_byte JE_EnemyAvailType[100]; /* [1..100] */
@@ -280,14 +275,19 @@ extern JE_byte mapPlanet[5], mapSection[5];
 extern JE_boolean moveTyrianLogoUp;
 extern JE_boolean skipStarShowVGA;
 extern JE_MultiEnemyType enemy;
+extern JE_EnemyHotType enemyHot;
 extern JE_EnemyAvailType enemyAvail;
+extern Uint64 enemyInUse[2];
+extern Uint64 enemySpawned[2];
 extern JE_word enemyOffset;
 extern JE_word enemyOnScreen;
 extern JE_word superEnemy254Jump;
 extern explosion_type explosions[MAX_EXPLOSIONS];
+extern Uint64 explosionsInUse[(MAX_EXPLOSIONS + 63) / 64];
 extern JE_integer explosionFollowAmountX, explosionFollowAmountY;
 extern JE_boolean fireButtonHeld;
 extern JE_boolean enemyShotAvail[ENEMY_SHOT_MAX];
+extern Uint64 enemyShotInUse[(ENEMY_SHOT_MAX + 63) / 64];
 extern EnemyShotType enemyShot[ENEMY_SHOT_MAX];
 extern JE_byte zinglonDuration;
 extern JE_byte astralDuration;
@@ -315,7 +315,7 @@ extern JE_word tempW;
 extern JE_boolean doNotSaveBackup;
 extern JE_word x, y;
 extern JE_integer b;
-extern JE_byte **BKwrap1to, **BKwrap2to, **BKwrap3to, **BKwrap1, **BKwrap2, **BKwrap3;
+extern JE_byte *BKwrap1to, *BKwrap2to, *BKwrap3to, *BKwrap1, *BKwrap2, *BKwrap3;
 extern JE_shortint specialWeaponFilter, specialWeaponFreq;
 extern JE_word specialWeaponWpn;
 extern JE_boolean linkToPlayer;
@@ -328,6 +328,89 @@ static const int hud_sidekick_y[2][2] =
 	{ 108, 126 }, // two player HUD
 };
 
+void free_all_enemies(void);
+
+// enemyAvail is only changed through this, so that enemyInUse stays in step with it
+static inline void set_enemy_avail(unsigned int i, JE_byte avail)
+{
+	enemyAvail[i] = avail;
+
+	if (avail != 1)
+	{
+		enemyInUse[i / 64] |= (Uint64)1 << (i % 64);
+		enemySpawned[i / 64] |= (Uint64)1 << (i % 64);
+	}
+	else
+	{
+		enemyInUse[i / 64] &= ~((Uint64)1 << (i % 64));
+	}
+}
+
+// returns the first enemy slot from i up to end that is not free and is a candidate, or end
+// (candidates can be NULL for all of them)
+static inline unsigned int next_enemy_in(const Uint64 candidates[2], unsigned int i, unsigned int end)
+{
+	while (i < end)
+	{
+		Uint64 bits = enemyInUse[i / 64];
+		if (candidates != NULL)
+			bits &= candidates[i / 64] | enemySpawned[i / 64];
+		bits >>= i % 64;
+
+		if (bits != 0)
+		{
+#if defined(__GNUC__)
+			i += __builtin_ctzll(bits);
+#else
+			for (; (bits & 1) == 0; bits >>= 1)
+				++i;
+#endif
+			return i < end ? i : end;
+		}
+		i = (i / 64 + 1) * 64;
+	}
+	return end;
+}
+
+// returns the first enemy slot from i up to end that is not free, or end
+static inline unsigned int next_enemy_in_use(unsigned int i, unsigned int end)
+{
+	return next_enemy_in(NULL, i, end);
+}
+
+void free_all_enemy_shots(void);
+
+// enemyShotAvail is only changed through this, so that enemyShotInUse stays in step with it
+static inline void set_enemy_shot_avail(unsigned int i, JE_boolean avail)
+{
+	enemyShotAvail[i] = avail;
+	set_slot_bit(enemyShotInUse, i, !avail);
+}
+
+// returns the first enemy shot slot from i on that is not free, or ENEMY_SHOT_MAX
+static inline unsigned int next_enemy_shot_in_use(unsigned int i)
+{
+	return next_set_slot(enemyShotInUse, i, ENEMY_SHOT_MAX);
+}
+
+void free_all_explosions(void);
+
+// an explosion's ttl is only changed through this, so that explosionsInUse stays in step with it
+static inline void set_explosion_ttl(unsigned int i, unsigned int ttl)
+{
+	explosions[i].ttl = ttl;
+	set_slot_bit(explosionsInUse, i, ttl != 0);
+}
+
+// returns the first explosion slot from i on that is not free, or MAX_EXPLOSIONS
+static inline unsigned int next_explosion_in_use(unsigned int i)
+{
+	return next_set_slot(explosionsInUse, i, MAX_EXPLOSIONS);
+}
+
+void build_enemy_grid(void);
+void find_enemies_near(Uint64 candidates[2], int x1, int y1, int x2, int y2);
+
 void JE_getShipInfo(void);
 JE_word JE_SGr(JE_word ship, Sprite2_array **ptr);
 
@@ -21,6 +21,8 @@
 #include "keyboard.h"
 #include "opentyr.h"
 #include "palette.h"
+#include "profiler.h"
+#include "varz.h"
 #include "video_scale.h"
 
 #include <assert.h>
@@ -36,8 +38,27 @@ const char *const scaling_mode_names[ScalingMode_MAX] = {
 	"Fit 4:3",
 };
 
+const char *const renderer_backend_names[RendererBackend_MAX] = {
+	"Software",
+	"GPU Nearest",
+	"GPU Linear",
+};
+
+bool headless = false;
+unsigned int headless_frame_limit = 0;
+
+bool render_thread_enabled = false;
+
+// Running hash of every frame shown while headless, for comparing runs.
+static Uint32 headless_frame_hash = 2166136261u;  // FNV-1a offset basis
+static unsigned int headless_frame_count = 0;
+static bool headless_frame_limit_reached = false;
+
+static SDL_Surface *profiler_overlay_surface = NULL;
+
 int fullscreen_display;
 ScalingMode scaling_mode = SCALE_INTEGER;
+RendererBackend renderer_backend = RENDERER_SOFTWARE;
 static SDL_Rect last_output_rect = { 0, 0, vga_width, vga_height };
 
 SDL_Surface *VGAScreen, *VGAScreenSeg;
@@ -51,6 +72,50 @@ static SDL_Texture *main_window_texture = NULL;
 
 static ScalerFunction scaler_function;
 
+// Copy of the last frame that was scaled into the texture.  Comparing against it finds the
+// scanlines that changed, so that only those are rescaled and uploaded, and idle screens are
+// not redrawn at all.
+static Uint8 last_frame[vga_height][vga_width];
+static uint last_frame_palette_generation;
+static bool last_frame_valid = false;
+
+// Changed spans separated by fewer unchanged rows than this are scaled and uploaded together.
+#define DIRTY_SPAN_MERGE_GAP 8
+
+// A finished game screen and the palette it is shown with, as handed to the render thread.
+typedef struct
+{
+	Uint8 pixels[vga_height][vga_width];
+	Uint32 rgb_palette[256], yuv_palette[256];
+	uint palette_generation;
+} RenderFrame;
+
+#define RENDER_FRAME_NEW 4  // set in the mailbox until the render thread takes the frame
+
+// Optional thread that scales frames so that the game never waits on the scaler.  Of the three
+// frame slots the game fills one, the render thread scales one, and the mailbox holds the newest
+// finished one; each side swaps its slot with the mailbox, so frames that the render thread is
+// too slow for are dropped rather than queued.
+// The render thread scales into memory laid out like the texture.  SDL_Renderer may only be used
+// on the main thread, so that uploads the changed rows and presents them.  The mutex is held
+// around every use of the scaler state and the scaled output by either thread.
+static struct
+{
+	SDL_Thread *thread;
+	SDL_mutex *mutex;
+	SDL_sem *frame_ready;
+	SDL_atomic_t quit;
+
+	RenderFrame frames[3];
+	SDL_Surface *surfaces[3];  // wrap the frame pixels for the scalers
+	SDL_atomic_t mailbox;
+	int game_slot, render_slot;
+
+	Uint8 *scaled_pixels;  // scaler output, the size of the texture
+	int scaled_width, scaled_height, scaled_pitch;
+	int dirty_begin, dirty_end;  // game screen rows whose output is not uploaded yet
+} render;
+
 static void init_renderer(void);
 static void deinit_renderer(void);
 static void init_texture(void);
@@ -59,13 +124,40 @@ static void deinit_texture(void);
 static int window_get_display_index(void);
 static void window_center_in_display(int display_index);
 static void calc_dst_render_rect(SDL_Surface *src_surface, SDL_Rect *dst_rect);
-static void scale_and_flip(SDL_Surface *);
+static bool scale_frame(SDL_Surface *, const Uint32 *rgb, const Uint32 *yuv, uint generation, bool to_memory, int *out_begin, int *out_end);
+static void scale_rows(SDL_Surface *, bool to_memory, int first_row, int row_count);
+static void present_texture(bool changed);
+static void scale_and_flip(SDL_Surface *, const Uint32 *rgb, const Uint32 *yuv, uint generation);
+static void headless_hash_frame(SDL_Surface *);
+
+static void init_render_thread(void);
+static void deinit_render_thread(void);
+static int render_thread_main(void *data);
+static void publish_render_frame(void);
+static void present_render_output(void);
+static bool alloc_render_output(void);
+static void lock_scaler(void);
+static void unlock_scaler(void);
 
 void init_video(void)
 {
-	if (SDL_WasInit(SDL_INIT_VIDEO))
+	if (SDL_WasInit(SDL_INIT_VIDEO) || VGAScreenSeg != NULL)
 		return;
 
+	if (headless)
+	{
+		// Only the software surfaces the game renders to are needed; the pixel format is still
+		// used for building rgb_palette.
+		VGAScreen = VGAScreenSeg = SDL_CreateRGBSurface(0, vga_width, vga_height, 8, 0, 0, 0, 0);
+		VGAScreen2 = SDL_CreateRGBSurface(0, vga_width, vga_height, 8, 0, 0, 0, 0);
+		game_screen = SDL_CreateRGBSurface(0, vga_width, vga_height, 8, 0, 0, 0, 0);
+
+		main_window_tex_format = SDL_AllocFormat(SDL_PIXELFORMAT_RGB888);
+
+		JE_clr256(VGAScreen);
+		return;
+	}
+
 	if (SDL_InitSubSystem(SDL_INIT_VIDEO) == -1)
 	{
 		fprintf(stderr, "error: failed to initialize SDL video: %s\n", SDL_GetError());
@@ -101,6 +193,7 @@ void init_video(void)
 	reinit_fullscreen(fullscreen_display);
 	init_renderer();
 	init_texture();
+	init_scaler_threads();
 	init_scaler(scaler);
 
 	SDL_ShowWindow(main_window);
@@ -108,10 +201,33 @@ void init_video(void)
 	SDL_SetRenderDrawColor(main_window_renderer, 0, 0, 0, 255);
 	SDL_RenderClear(main_window_renderer);
 	SDL_RenderPresent(main_window_renderer);
+
+	if (render_thread_enabled)
+		init_render_thread();
 }
 
 void deinit_video(void)
 {
+	if (headless)
+	{
+		printf("headless: %u frames, frame hash %08x\n", headless_frame_count, headless_frame_hash);
+
+		SDL_FreeFormat(main_window_tex_format);
+		main_window_tex_format = NULL;
+
+		SDL_FreeSurface(VGAScreenSeg);
+		SDL_FreeSurface(VGAScreen2);
+		SDL_FreeSurface(game_screen);
+		VGAScreenSeg = NULL;
+		return;
+	}
+
+	deinit_render_thread();
+
+	SDL_FreeSurface(profiler_overlay_surface);
+	profiler_overlay_surface = NULL;
+
+	deinit_scaler_threads();
 	deinit_texture();
 	deinit_renderer();
 
@@ -144,6 +260,190 @@ static void deinit_renderer(void)
 	}
 }
 
+static void init_render_thread(void)
+{
+	render.mutex = SDL_CreateMutex();
+	render.frame_ready = SDL_CreateSemaphore(0);
+
+	for (int i = 0; i < 3; ++i)
+		render.surfaces[i] = SDL_CreateRGBSurfaceFrom(render.frames[i].pixels, vga_width, vga_height, 8, vga_width, 0, 0, 0, 0);
+
+	if (render.mutex == NULL || render.frame_ready == NULL ||
+	    render.surfaces[0] == NULL || render.surfaces[1] == NULL || render.surfaces[2] == NULL ||
+	    !alloc_render_output())
+	{
+		fprintf(stderr, "warning: failed to set up render thread: %s\n", SDL_GetError());
+		deinit_render_thread();
+		return;
+	}
+
+	render.game_slot = 0;
+	render.render_slot = 1;
+	SDL_AtomicSet(&render.mailbox, 2);
+	SDL_AtomicSet(&render.quit, 0);
+
+	render.thread = SDL_CreateThread(render_thread_main, "render", NULL);
+	if (render.thread == NULL)
+	{
+		fprintf(stderr, "warning: failed to create render thread: %s\n", SDL_GetError());
+		deinit_render_thread();
+	}
+}
+
+static void deinit_render_thread(void)
+{
+	if (render.thread != NULL)
+	{
+		SDL_AtomicSet(&render.quit, 1);
+		SDL_SemPost(render.frame_ready);
+		SDL_WaitThread(render.thread, NULL);
+		render.thread = NULL;
+	}
+
+	for (int i = 0; i < 3; ++i)
+	{
+		SDL_FreeSurface(render.surfaces[i]);
+		render.surfaces[i] = NULL;
+	}
+
+	if (render.frame_ready != NULL)
+		SDL_DestroySemaphore(render.frame_ready);
+	if (render.mutex != NULL)
+		SDL_DestroyMutex(render.mutex);
+
+	render.frame_ready = NULL;
+	render.mutex = NULL;
+
+	free(render.scaled_pixels);
+	render.scaled_pixels = NULL;
+}
+
+static int render_thread_main(void *data)
+{
+	(void)data;
+
+	for (; ; )
+	{
+		SDL_SemWait(render.frame_ready);
+
+		if (SDL_AtomicGet(&render.quit) != 0)
+			break;
+
+		// Only this thread clears the flag, so the frame is still there to be taken (or has
+		// been replaced by an even newer one).
+		if ((SDL_AtomicGet(&render.mailbox) & RENDER_FRAME_NEW) == 0)
+			continue;
+
+		const int mailbox = SDL_AtomicSet(&render.mailbox, render.render_slot);
+		SDL_MemoryBarrierAcquire();
+		render.render_slot = mailbox & ~RENDER_FRAME_NEW;
+
+		const RenderFrame *const frame = &render.frames[render.render_slot];
+
+		SDL_LockMutex(render.mutex);
+
+		int begin, end;
+		if (scale_frame(render.surfaces[render.render_slot], frame->rgb_palette, frame->yuv_palette, frame->palette_generation, true, &begin, &end))
+		{
+			// Add to the rows that the main thread has yet to upload.
+			if (render.dirty_end > render.dirty_begin)
+			{
+				begin = MIN(begin, render.dirty_begin);
+				end = MAX(end, render.dirty_end);
+			}
+			render.dirty_begin = begin;
+			render.dirty_end = end;
+		}
+
+		SDL_UnlockMutex(render.mutex);
+	}
+
+	return 0;
+}
+
+/** Hands the frame in the game's slot to the render thread and takes a free slot in return. */
+static void publish_render_frame(void)
+{
+	RenderFrame *const frame = &render.frames[render.game_slot];
+
+	memcpy(frame->rgb_palette, rgb_palette, sizeof(frame->rgb_palette));
+	memcpy(frame->yuv_palette, yuv_palette, sizeof(frame->yuv_palette));
+	frame->palette_generation = palette_generation;
+
+	SDL_MemoryBarrierRelease();
+	const int mailbox = SDL_AtomicSet(&render.mailbox, render.game_slot | RENDER_FRAME_NEW);
+	render.game_slot = mailbox & ~RENDER_FRAME_NEW;
+
+	SDL_SemPost(render.frame_ready);
+}
+
+/** Shows what the render thread has scaled since the last JE_showVGA(), so that the last frame
+ *  before the game goes idle is not left unshown.  Only called on the main thread. */
+void video_present_pending(void)
+{
+	if (render.thread != NULL)
+		present_render_output();
+}
+
+/** Uploads the rows that the render thread has scaled since the last call, and presents them.
+ *  Does not wait for the render thread if it is busy scaling; the rows are picked up next time. */
+static void present_render_output(void)
+{
+	bool changed = false;
+
+	if (SDL_TryLockMutex(render.mutex) == 0)
+	{
+		if (render.dirty_end > render.dirty_begin)
+		{
+			const int scale = render.scaled_width / vga_width;
+			const SDL_Rect rect = { 0, render.dirty_begin * scale, render.scaled_width, (render.dirty_end - render.dirty_begin) * scale };
+
+			SDL_UpdateTexture(main_window_texture, &rect, render.scaled_pixels + rect.y * render.scaled_pitch, render.scaled_pitch);
+
+			render.dirty_begin = 0;
+			render.dirty_end = 0;
+			changed = true;
+		}
+
+		SDL_UnlockMutex(render.mutex);
+	}
+
+	present_texture(changed);
+}
+
+/** Makes the render thread's output buffer match the texture.  Called with the mutex held, or
+ *  before the thread is started. */
+static bool alloc_render_output(void)
+{
+	int w, h;
+	SDL_QueryTexture(main_window_texture, NULL, NULL, &w, &h);
+
+	const int pitch = w * main_window_tex_format->BytesPerPixel;
+
+	free(render.scaled_pixels);
+	render.scaled_pixels = calloc(h, pitch);
+	render.scaled_width = w;
+	render.scaled_height = h;
+	render.scaled_pitch = pitch;
+
+	render.dirty_begin = 0;
+	render.dirty_end = 0;
+
+	return render.scaled_pixels != NULL;
+}
+
+static void lock_scaler(void)
+{
+	if (render.thread != NULL)
+		SDL_LockMutex(render.mutex);
+}
+
+static void unlock_scaler(void)
+{
+	if (render.thread != NULL)
+		SDL_UnlockMutex(render.mutex);
+}
+
 static void init_texture(void)
 {
 	assert(main_window_renderer != NULL);
@@ -153,6 +453,16 @@ static void init_texture(void)
 	int scaler_w = scalers[scaler].width;
 	int scaler_h = scalers[scaler].height;
 
+	// With a GPU backend the texture only holds the palette-expanded game screen and
+	// SDL_Renderer scales it to the window, so the upload is 1x regardless of scaler.
+	if (renderer_backend != RENDERER_SOFTWARE)
+	{
+		scaler_w = vga_width;
+		scaler_h = vga_height;
+
+		SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, renderer_backend == RENDERER_GPU_LINEAR ? "linear" : "nearest");
+	}
+
 	main_window_tex_format = SDL_AllocFormat(format);
 
 	main_window_texture = SDL_CreateTexture(main_window_renderer, format, SDL_TEXTUREACCESS_STREAMING, scaler_w, scaler_h);
@@ -199,11 +509,18 @@ void reinit_fullscreen(int new_display)
 {
 	fullscreen_display = new_display;
 
+	if (headless)
+		return;
+
 	if (fullscreen_display >= SDL_GetNumVideoDisplays())
 	{
 		fullscreen_display = 0;
 	}
 
+	lock_scaler();
+
+	last_frame_valid = false;
+
 	SDL_SetWindowFullscreen(main_window, SDL_FALSE);
 	SDL_SetWindowSize(main_window, scalers[scaler].width, scalers[scaler].height);
 
@@ -216,11 +533,10 @@ void reinit_fullscreen(int new_display)
 		window_center_in_display(fullscreen_display);
 
 		if (SDL_SetWindowFullscreen(main_window, SDL_WINDOW_FULLSCREEN_DESKTOP) != 0)
-		{
 			reinit_fullscreen(-1);
-			return;
-		}
 	}
+
+	unlock_scaler();
 }
 
 void video_on_win_resize(void)
@@ -228,9 +544,16 @@ void video_on_win_resize(void)
 	int w, h;
 	int scaler_w, scaler_h;
 
+	if (headless)
+		return;
+
 	// Tell video to reinit if the window was manually resized by the user.
 	// Also enforce a minimum size on the window.
 
+	lock_scaler();
+
+	last_frame_valid = false;
+
 	SDL_GetWindowSize(main_window, &w, &h);
 	scaler_w = scalers[scaler].width;
 	scaler_h = scalers[scaler].height;
@@ -242,10 +565,31 @@ void video_on_win_resize(void)
 
 		SDL_SetWindowSize(main_window, w, h);
 	}
+
+	unlock_scaler();
+}
+
+/** Redraws the window after it was uncovered, shown or restored, since the game screen may not
+ *  change again for a while. */
+void video_on_win_expose(void)
+{
+	if (headless)
+		return;
+
+	lock_scaler();
+
+	last_frame_valid = false;
+
+	unlock_scaler();
+
+	present_texture(true);
 }
 
 void toggle_fullscreen(void)
 {
+	if (headless)
+		return;
+
 	if (fullscreen_display != -1)
 		reinit_fullscreen(-1);
 	else
@@ -258,11 +602,27 @@ bool init_scaler(unsigned int new_scaler)
 	    h = scalers[new_scaler].height;
 	int bpp = main_window_tex_format->BitsPerPixel; // TODOSDL2
 
+	if (headless)
+	{
+		scaler = new_scaler;
+		return true;
+	}
+
+	lock_scaler();
+
 	scaler = new_scaler;
 
 	deinit_texture();
 	init_texture();
 
+	if (render.thread != NULL && !alloc_render_output())
+	{
+		fprintf(stderr, "error: failed to allocate render thread output\n");
+		exit(EXIT_FAILURE);
+	}
+
+	last_frame_valid = false;
+
 	if (fullscreen_display == -1)
 	{
 		// Changing scalers, when not in fullscreen mode, forces the window
@@ -271,19 +631,24 @@ bool init_scaler(unsigned int new_scaler)
 		window_center_in_display(window_get_display_index());
 	}
 
+	// GPU backends only need the palette expanded, which is what the 1x scaler does.
+	const uint texture_scaler = renderer_backend == RENDERER_SOFTWARE ? scaler : 0;
+
 	switch (bpp)
 	{
 	case 32:
-		scaler_function = scalers[scaler].scaler32;
+		scaler_function = scalers[texture_scaler].scaler32;
 		break;
 	case 16:
-		scaler_function = scalers[scaler].scaler16;
+		scaler_function = scalers[texture_scaler].scaler16;
 		break;
 	default:
 		scaler_function = NULL;
 		break;
 	}
 
+	unlock_scaler();
+
 	if (scaler_function == NULL)
 	{
 		assert(false);
@@ -306,6 +671,19 @@ bool set_scaling_mode_by_name(const char *name)
 	return false;
 }
 
+bool set_renderer_backend_by_name(const char *name)
+{
+	for (int i = 0; i < RendererBackend_MAX; ++i)
+	{
+		if (strcmp(name, renderer_backend_names[i]) == 0)
+		{
+			renderer_backend = i;
+			return true;
+		}
+	}
+	return false;
+}
+
 void JE_clr256(SDL_Surface *screen)
 {
 	SDL_FillRect(screen, NULL, 0);
@@ -313,7 +691,66 @@ void JE_clr256(SDL_Surface *screen)
 
 void JE_showVGA(void) 
 { 
-	scale_and_flip(VGAScreen); 
+	if (headless)
+	{
+		headless_hash_frame(VGAScreen);
+	}
+	else if (render.thread != NULL)
+	{
+		const Uint64 profile_start = profile_begin();
+		SDL_Surface *const surface = render.surfaces[render.game_slot];
+		for (int y = 0; y < vga_height; ++y)
+			memcpy((Uint8 *)surface->pixels + y * surface->pitch, (Uint8 *)VGAScreen->pixels + y * VGAScreen->pitch, vga_width);
+		if (profiler_overlay)
+			profile_draw_overlay(surface);
+		publish_render_frame();
+		present_render_output();
+		profile_end(PROFILE_SCALE_AND_FLIP, profile_start);
+	}
+	else if (profiler_overlay)
+	{
+		// Draw the overlay on a copy so that it doesn't end up in the game's own screen.
+		if (profiler_overlay_surface == NULL)
+			profiler_overlay_surface = SDL_CreateRGBSurface(0, vga_width, vga_height, 8, 0, 0, 0, 0);
+
+		const Uint64 profile_start = profile_begin();
+		memcpy(profiler_overlay_surface->pixels, VGAScreen->pixels, profiler_overlay_surface->h * profiler_overlay_surface->pitch);
+		profile_draw_overlay(profiler_overlay_surface);
+		scale_and_flip(profiler_overlay_surface, rgb_palette, yuv_palette, palette_generation);
+		profile_end(PROFILE_SCALE_AND_FLIP, profile_start);
+	}
+	else
+	{
+		const Uint64 profile_start = profile_begin();
+		scale_and_flip(VGAScreen, rgb_palette, yuv_palette, palette_generation);
+		profile_end(PROFILE_SCALE_AND_FLIP, profile_start);
+	}
+
+	profile_end_frame();
+
+	// Leave the same way as quitting from the menu, so the frame hash is reported on the way out.
+	if (headless_frame_limit_reached)
+		JE_tyrianHalt(0);
+}
+
+static void headless_hash_frame(SDL_Surface *src_surface)
+{
+	Uint32 hash = headless_frame_hash;
+
+	for (int y = 0; y < src_surface->h; ++y)
+	{
+		const Uint8 *const row = (Uint8 *)src_surface->pixels + y * src_surface->pitch;
+		for (int x = 0; x < src_surface->w; ++x)
+			hash = (hash ^ row[x]) * 16777619u;  // FNV-1a prime
+	}
+
+	for (int i = 0; i < 256; ++i)
+		hash = (hash ^ rgb_palette[i]) * 16777619u;
+
+	headless_frame_hash = hash;
+
+	if (++headless_frame_count == headless_frame_limit)
+		headless_frame_limit_reached = true;
 }
 
 static void calc_dst_render_rect(SDL_Surface *const src_surface, SDL_Rect *const dst_rect)
@@ -329,7 +766,8 @@ static void calc_dst_render_rect(SDL_Surface *const src_surface, SDL_Rect *const
 	switch (scaling_mode)
 	{
 	case SCALE_CENTER:
-		SDL_QueryTexture(main_window_texture, NULL, NULL, &dst_rect->w, &dst_rect->h);
+		dst_rect->w = scalers[scaler].width;
+		dst_rect->h = scalers[scaler].height;
 		break;
 	case SCALE_INTEGER:
 		dst_rect->w = src_surface->w;
@@ -379,16 +817,93 @@ static void calc_dst_render_rect(SDL_Surface *const src_surface, SDL_Rect *const
 	dst_rect->y = (win_h - dst_rect->h) / 2;
 }
 
-static void scale_and_flip(SDL_Surface *src_surface)
+/** Scales the rows of a frame that changed since the last one, into the texture or, if
+ *  \p to_memory, into the render thread's output.  Returns whether any changed, and if so the
+ *  game screen rows that were scaled. */
+static bool scale_frame(SDL_Surface *src_surface, const Uint32 *const rgb, const Uint32 *const yuv, const uint generation, const bool to_memory, int *const out_begin, int *const out_end)
 {
 	assert(src_surface->format->BitsPerPixel == 8);
-
-	// Do software scaling
 	assert(scaler_function != NULL);
-	scaler_function(src_surface, main_window_texture);
 
+	const bool redraw_all = !last_frame_valid || generation != last_frame_palette_generation;
+	bool changed = false;
+
+	if (redraw_all)
+	{
+		memcpy(scaler_rgb_palette, rgb, sizeof(scaler_rgb_palette));
+		memcpy(scaler_yuv_palette, yuv, sizeof(scaler_yuv_palette));
+	}
+
+	// Do software scaling of the scanlines that changed since the last frame.  Scalers read
+	// the neighboring rows, so a changed row also changes the output of the rows next to it.
+	int span_begin = 0, span_end = 0;
+
+	for (int y = 0; y < vga_height; ++y)
+	{
+		const Uint8 *const row = (Uint8 *)src_surface->pixels + y * src_surface->pitch;
+
+		if (!redraw_all && memcmp(row, last_frame[y], vga_width) == 0)
+			continue;
+
+		memcpy(last_frame[y], row, vga_width);
+
+		const int begin = MAX(y - 1, 0),
+		          end = MIN(y + 2, vga_height);
+
+		if (!changed)
+		{
+			*out_begin = begin;
+		}
+		*out_end = end;
+
+		if (span_end > span_begin && begin > span_end + DIRTY_SPAN_MERGE_GAP)
+		{
+			scale_rows(src_surface, to_memory, span_begin, span_end - span_begin);
+			span_begin = begin;
+		}
+		else if (span_end == span_begin)
+		{
+			span_begin = begin;
+		}
+		span_end = end;
+
+		changed = true;
+	}
+
+	if (span_end > span_begin)
+		scale_rows(src_surface, to_memory, span_begin, span_end - span_begin);
+
+	last_frame_palette_generation = generation;
+	last_frame_valid = true;
+
+	return changed;
+}
+
+static void scale_rows(SDL_Surface *src_surface, const bool to_memory, const int first_row, const int row_count)
+{
+	if (to_memory)
+	{
+		const int scale = render.scaled_width / vga_width;
+		Uint8 *const dst_pixels = render.scaled_pixels + first_row * scale * render.scaled_pitch;
+
+		run_scaler_to_pixels(scaler_function, src_surface, dst_pixels, render.scaled_pitch, render.scaled_width, first_row, row_count);
+	}
+	else
+	{
+		run_scaler(scaler_function, src_surface, main_window_texture, first_row, row_count);
+	}
+}
+
+/** Shows the texture in the window, unless neither it nor where it goes has changed. */
+static void present_texture(const bool changed)
+{
 	SDL_Rect dst_rect;
-	calc_dst_render_rect(src_surface, &dst_rect);
+	calc_dst_render_rect(VGAScreen, &dst_rect);
+
+	if (!changed &&
+	    dst_rect.x == last_output_rect.x && dst_rect.y == last_output_rect.y &&
+	    dst_rect.w == last_output_rect.w && dst_rect.h == last_output_rect.h)
+		return;
 
 	// Clear the window and blit the output texture to it
 	SDL_SetRenderDrawColor(main_window_renderer, 0, 0, 0, 255);
@@ -400,6 +915,14 @@ static void scale_and_flip(SDL_Surface *src_surface)
 	last_output_rect = dst_rect;
 }
 
+static void scale_and_flip(SDL_Surface *src_surface, const Uint32 *const rgb, const Uint32 *const yuv, const uint generation)
+{
+	int begin, end;
+	const bool changed = scale_frame(src_surface, rgb, yuv, generation, false, &begin, &end);
+
+	present_texture(changed);
+}
+
 /** Maps a specified point in game screen coordinates to window coordinates. */
 void mapScreenPointToWindow(Sint32 *const inout_x, Sint32 *const inout_y)
 {
@@ -34,10 +34,24 @@ typedef enum {
 	ScalingMode_MAX
 } ScalingMode;
 
+typedef enum {
+	RENDERER_SOFTWARE,     // palette expansion and scaling by the selected software scaler
+	RENDERER_GPU_NEAREST,  // palette expansion at 1x, scaling by SDL_Renderer
+	RENDERER_GPU_LINEAR,
+	RendererBackend_MAX
+} RendererBackend;
+
 extern const char *const scaling_mode_names[ScalingMode_MAX];
+extern const char *const renderer_backend_names[RendererBackend_MAX];
+
+extern bool headless;  // no window, no audio device, no frame pacing
+extern unsigned int headless_frame_limit;  // 0 means no limit
+
+extern bool render_thread_enabled;  // scale on a separate thread
 
 extern int fullscreen_display; // -1 means windowed
 extern ScalingMode scaling_mode;
+extern RendererBackend renderer_backend;
 
 extern SDL_Surface *VGAScreen, *VGAScreenSeg;
 extern SDL_Surface *game_screen;
@@ -49,15 +63,18 @@ extern SDL_PixelFormat *main_window_tex_format;
 void init_video(void);
 
 void video_on_win_resize(void);
+void video_on_win_expose(void);
 void reinit_fullscreen(int new_display);
 void toggle_fullscreen(void);
 bool init_scaler(unsigned int new_scaler);
 bool set_scaling_mode_by_name(const char *name);
+bool set_renderer_backend_by_name(const char *name);
 
 void deinit_video(void);
 
 void JE_clr256(SDL_Surface *);
 void JE_showVGA(void);
+void video_present_pending(void);
 
 void mapScreenPointToWindow(Sint32 *inout_x, Sint32 *inout_y);
 void mapWindowPointToScreen(Sint32 *inout_x, Sint32 *inout_y);
@@ -25,21 +25,55 @@
 #include "video.h"
 
 #include <assert.h>
+#include <stdio.h>
 #include <string.h>
 
-static void nn_32(SDL_Surface *src_surface, SDL_Texture *dst_texture);
-static void nn_16(SDL_Surface *src_surface, SDL_Texture *dst_texture);
+static void nn_32(SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count);
+static void nn_16(SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count);
 
-static void scale2x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture);
-static void scale2x_16(SDL_Surface *src_surface, SDL_Texture *dst_texture);
-static void scale3x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture);
-static void scale3x_16(SDL_Surface *src_surface, SDL_Texture *dst_texture);
+static void scale2x_32(SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count);
+static void scale2x_16(SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count);
+static void scale3x_32(SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count);
+static void scale3x_16(SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count);
 
-void hq2x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture);
-void hq3x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture);
-void hq4x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture);
+void hq2x_32(SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count);
+void hq3x_32(SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count);
+void hq4x_32(SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count);
+
+void init_hq_scalers(void);
+
+#define MAX_SCALER_THREADS 16
+
+// Persistent worker pool that scales horizontal bands of the source in parallel.  The thread
+// calling run_scaler() takes bands too, so no workers are started on a single-core machine.
+static struct
+{
+	SDL_mutex *mutex;
+	SDL_cond *work_cond, *done_cond;
+
+	SDL_Thread *threads[MAX_SCALER_THREADS];
+	int thread_count;
+	bool quit;
+
+	uint generation;
+	ScalerFunction function;
+	SDL_Surface *src_surface;
+	Uint8 *dst_pixels;
+	int dst_pitch, dst_width;
+	int first_row, row_count;
+
+	int band_count;
+	int next_band;
+	int bands_remaining;
+} scaler_pool;
+
+static int scaler_thread_main(void *data);
+static void scaler_pool_run_bands(void);
 
 uint scaler;
+int scaler_thread_count = 0;  // 0 means one thread per CPU
+
+Uint32 scaler_rgb_palette[256], scaler_yuv_palette[256];
 
 const struct Scalers scalers[] =
 {
@@ -67,28 +101,195 @@ void set_scaler_by_name(const char *name)
 	}
 }
 
-void nn_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
+void init_scaler_threads(void)
 {
-	Uint8 *src = src_surface->pixels, *src_temp;
-	Uint8 *dst, *dst_temp;
+	init_hq_scalers();
 
-	int src_pitch = src_surface->pitch;
-	int dst_pitch;
+	int thread_count = scaler_thread_count > 0 ? scaler_thread_count : SDL_GetCPUCount();
+	thread_count = MIN(thread_count, MAX_SCALER_THREADS + 1);
 
-	const int dst_Bpp = 4;         // dst_surface->format->BytesPerPixel
+	scaler_pool.quit = false;
+	scaler_pool.thread_count = 0;
+	scaler_pool.band_count = 1;
+
+	if (thread_count <= 1)
+		return;
+
+	scaler_pool.mutex = SDL_CreateMutex();
+	scaler_pool.work_cond = SDL_CreateCond();
+	scaler_pool.done_cond = SDL_CreateCond();
+
+	if (scaler_pool.mutex == NULL || scaler_pool.work_cond == NULL || scaler_pool.done_cond == NULL)
+	{
+		fprintf(stderr, "warning: failed to create scaler thread pool: %s\n", SDL_GetError());
+		deinit_scaler_threads();
+		return;
+	}
+
+	for (int i = 0; i < thread_count - 1; ++i)
+	{
+		SDL_Thread *thread = SDL_CreateThread(scaler_thread_main, "scaler", NULL);
+		if (thread == NULL)
+		{
+			fprintf(stderr, "warning: failed to create scaler thread: %s\n", SDL_GetError());
+			break;
+		}
+		scaler_pool.threads[scaler_pool.thread_count++] = thread;
+	}
+
+	// Two bands per thread evens out the cost differences between busy and flat parts of the screen.
+	scaler_pool.band_count = 2 * (scaler_pool.thread_count + 1);
+}
+
+void deinit_scaler_threads(void)
+{
+	if (scaler_pool.thread_count > 0)
+	{
+		SDL_LockMutex(scaler_pool.mutex);
+		scaler_pool.quit = true;
+		SDL_CondBroadcast(scaler_pool.work_cond);
+		SDL_UnlockMutex(scaler_pool.mutex);
+
+		for (int i = 0; i < scaler_pool.thread_count; ++i)
+			SDL_WaitThread(scaler_pool.threads[i], NULL);
+		scaler_pool.thread_count = 0;
+	}
+
+	if (scaler_pool.done_cond != NULL)
+		SDL_DestroyCond(scaler_pool.done_cond);
+	if (scaler_pool.work_cond != NULL)
+		SDL_DestroyCond(scaler_pool.work_cond);
+	if (scaler_pool.mutex != NULL)
+		SDL_DestroyMutex(scaler_pool.mutex);
+
+	scaler_pool.done_cond = scaler_pool.work_cond = NULL;
+	scaler_pool.mutex = NULL;
+	scaler_pool.band_count = 1;
+}
+
+static int scaler_thread_main(void *data)
+{
+	(void)data;
+
+	uint seen_generation = 0;
+
+	SDL_LockMutex(scaler_pool.mutex);
+
+	for (; ; )
+	{
+		while (!scaler_pool.quit && scaler_pool.generation == seen_generation)
+			SDL_CondWait(scaler_pool.work_cond, scaler_pool.mutex);
+
+		if (scaler_pool.quit)
+			break;
+
+		seen_generation = scaler_pool.generation;
+
+		scaler_pool_run_bands();
+	}
+
+	SDL_UnlockMutex(scaler_pool.mutex);
+
+	return 0;
+}
+
+// Takes bands until none are left.  Must be called with the pool mutex held; the mutex is
+// released while a band is being scaled.
+static void scaler_pool_run_bands(void)
+{
+	while (scaler_pool.next_band < scaler_pool.band_count)
+	{
+		const int band = scaler_pool.next_band++;
+		const int band_begin = scaler_pool.row_count * band / scaler_pool.band_count,
+		          band_end = scaler_pool.row_count * (band + 1) / scaler_pool.band_count;
+
+		SDL_UnlockMutex(scaler_pool.mutex);
+
+		if (band_end > band_begin)
+		{
+			const int scale = scaler_pool.dst_width / vga_width;
+			Uint8 *dst_pixels = scaler_pool.dst_pixels + band_begin * scale * scaler_pool.dst_pitch;
+
+			scaler_pool.function(scaler_pool.src_surface, dst_pixels, scaler_pool.dst_pitch, scaler_pool.dst_width, scaler_pool.first_row + band_begin, band_end - band_begin);
+		}
+
+		SDL_LockMutex(scaler_pool.mutex);
+
+		if (--scaler_pool.bands_remaining == 0)
+			SDL_CondSignal(scaler_pool.done_cond);
+	}
+}
+
+/** Scales source rows [first_row, first_row + row_count) into the matching part of the texture;
+ *  only that part of the texture is locked and uploaded. */
+void run_scaler(ScalerFunction scaler_function, SDL_Surface *src_surface, SDL_Texture *dst_texture, int first_row, int row_count)
+{
 	int dst_width, dst_height;
 	SDL_QueryTexture(dst_texture, NULL, NULL, &dst_width, &dst_height);
+
+	const int scale = dst_width / vga_width;
+	assert(scale == dst_height / vga_height);
+
+	const SDL_Rect dst_rect = { 0, first_row * scale, dst_width, row_count * scale };
+
+	void *dst_pixels;
+	int dst_pitch;
+	SDL_LockTexture(dst_texture, &dst_rect, &dst_pixels, &dst_pitch);
+
+	run_scaler_to_pixels(scaler_function, src_surface, dst_pixels, dst_pitch, dst_width, first_row, row_count);
+
+	SDL_UnlockTexture(dst_texture);
+}
+
+/** Like run_scaler(), but into memory rather than a texture.  \p dst_pixels points at the output
+ *  of \p first_row. */
+void run_scaler_to_pixels(ScalerFunction scaler_function, SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count)
+{
+	assert(first_row >= 0 && row_count > 0 && first_row + row_count <= vga_height);
+
+	if (scaler_pool.thread_count == 0)
+	{
+		scaler_function(src_surface, dst_pixels, dst_pitch, dst_width, first_row, row_count);
+	}
+	else
+	{
+		SDL_LockMutex(scaler_pool.mutex);
+
+		scaler_pool.function = scaler_function;
+		scaler_pool.src_surface = src_surface;
+		scaler_pool.dst_pixels = dst_pixels;
+		scaler_pool.dst_pitch = dst_pitch;
+		scaler_pool.dst_width = dst_width;
+		scaler_pool.first_row = first_row;
+		scaler_pool.row_count = row_count;
+		scaler_pool.next_band = 0;
+		scaler_pool.bands_remaining = scaler_pool.band_count;
+		++scaler_pool.generation;
+
+		SDL_CondBroadcast(scaler_pool.work_cond);
+
+		scaler_pool_run_bands();
+
+		while (scaler_pool.bands_remaining > 0)
+			SDL_CondWait(scaler_pool.done_cond, scaler_pool.mutex);
+
+		SDL_UnlockMutex(scaler_pool.mutex);
+	}
+}
+
+void nn_32(SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count)
+{
+	int src_pitch = src_surface->pitch;
+
+	const int dst_Bpp = 4;         // dst_surface->format->BytesPerPixel
 	
-	const int height = vga_height, // src_surface->h
-	          width = vga_width,   // src_surface->w
+	const int width = vga_width,   // src_surface->w
 	          scale = dst_width / width;
-	assert(scale == dst_height / height);
 
-	void* tmp_ptr;
-	SDL_LockTexture(dst_texture, NULL, &tmp_ptr, &dst_pitch);
-	dst = tmp_ptr;
+	Uint8 *src = (Uint8 *)src_surface->pixels + first_row * src_pitch, *src_temp;
+	Uint8 *dst = dst_pixels, *dst_temp;
 	
-	for (int y = height; y > 0; y--)
+	for (int y = row_count; y > 0; y--)
 	{
 		src_temp = src;
 		dst_temp = dst;
@@ -97,7 +298,7 @@ void nn_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 		{
 			for (int z = scale; z > 0; z--)
 			{
-				*(Uint32 *)dst = rgb_palette[*src];
+				*(Uint32 *)dst = scaler_rgb_palette[*src];
 				dst += dst_Bpp;
 			}
 			src++;
@@ -112,32 +313,21 @@ void nn_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 			dst += dst_pitch;
 		}
 	}
-
-	SDL_UnlockTexture(dst_texture);
 }
 
-void nn_16(SDL_Surface *src_surface, SDL_Texture *dst_texture)
+void nn_16(SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count)
 {
-	Uint8 *src = src_surface->pixels, *src_temp;
-	Uint8 *dst, *dst_temp;
-
 	int src_pitch = src_surface->pitch;
-	int dst_pitch;
 
 	const int dst_Bpp = 2;         // dst_surface->format->BytesPerPixel
-	int dst_width, dst_height;
-	SDL_QueryTexture(dst_texture, NULL, NULL, &dst_width, &dst_height);
 	
-	const int height = vga_height, // src_surface->h
-	          width = vga_width,   // src_surface->w
+	const int width = vga_width,   // src_surface->w
 	          scale = dst_width / width;
-	assert(scale == dst_height / height);
 
-	void* tmp_ptr;
-	SDL_LockTexture(dst_texture, NULL, &tmp_ptr, &dst_pitch);
-	dst = tmp_ptr;
+	Uint8 *src = (Uint8 *)src_surface->pixels + first_row * src_pitch, *src_temp;
+	Uint8 *dst = dst_pixels, *dst_temp;
 	
-	for (int y = height; y > 0; y--)
+	for (int y = row_count; y > 0; y--)
 	{
 		src_temp = src;
 		dst_temp = dst;
@@ -146,7 +336,7 @@ void nn_16(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 		{
 			for (int z = scale; z > 0; z--)
 			{
-				*(Uint16 *)dst = rgb_palette[*src];
+				*(Uint16 *)dst = scaler_rgb_palette[*src];
 				dst += dst_Bpp;
 			}
 			src++;
@@ -161,30 +351,25 @@ void nn_16(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 			dst += dst_pitch;
 		}
 	}
-
-	SDL_UnlockTexture(dst_texture);
 }
 
-void scale2x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
+void scale2x_32(SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count)
 {
-	Uint8 *src = src_surface->pixels, *src_temp;
-	Uint8 *dst, *dst_temp;
-
 	int src_pitch = src_surface->pitch;
-	int dst_pitch;
 
 	const int dst_Bpp = 4,         // dst_surface->format->BytesPerPixel
 	          height = vga_height, // src_surface->h
 	          width = vga_width;   // src_surface->w
 
-	void* tmp_ptr;
-	SDL_LockTexture(dst_texture, NULL, &tmp_ptr, &dst_pitch);
-	dst = tmp_ptr;
+	Uint8 *src = (Uint8 *)src_surface->pixels + first_row * src_pitch, *src_temp;
+	Uint8 *dst = dst_pixels, *dst_temp;
+
+	(void)dst_width;
 	
 	int prevline, nextline;
 	
 	Uint32 E0, E1, E2, E3, B, D, E, F, H;
-	for (int y = 0; y < height; y++)
+	for (int y = first_row; y < first_row + row_count; y++)
 	{
 		src_temp = src;
 		dst_temp = dst;
@@ -194,11 +379,11 @@ void scale2x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 		
 		for (int x = 0; x < width; x++)
 		{
-			B = rgb_palette[*(src + prevline)];
-			D = rgb_palette[*(x > 0 ? src - 1 : src)];
-			E = rgb_palette[*src];
-			F = rgb_palette[*(x < width - 1 ? src + 1 : src)];
-			H = rgb_palette[*(src + nextline)];
+			B = scaler_rgb_palette[*(src + prevline)];
+			D = scaler_rgb_palette[*(x > 0 ? src - 1 : src)];
+			E = scaler_rgb_palette[*src];
+			F = scaler_rgb_palette[*(x < width - 1 ? src + 1 : src)];
+			H = scaler_rgb_palette[*(src + nextline)];
 			
 			if (B != H && D != F)
 			{
@@ -224,30 +409,25 @@ void scale2x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 		src = src_temp + src_pitch;
 		dst = dst_temp + 2 * dst_pitch;
 	}
-
-	SDL_UnlockTexture(dst_texture);
 }
 
-void scale2x_16(SDL_Surface *src_surface, SDL_Texture *dst_texture)
+void scale2x_16(SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count)
 {
-	Uint8 *src = src_surface->pixels, *src_temp;
-	Uint8 *dst, *dst_temp;
-
 	int src_pitch = src_surface->pitch;
-	int dst_pitch;
 
 	const int dst_Bpp = 2,         // dst_surface->format->BytesPerPixel
 	          height = vga_height, // src_surface->h
 	          width = vga_width;   // src_surface->w
 
-	void* tmp_ptr;
-	SDL_LockTexture(dst_texture, NULL, &tmp_ptr, &dst_pitch);
-	dst = tmp_ptr;
+	Uint8 *src = (Uint8 *)src_surface->pixels + first_row * src_pitch, *src_temp;
+	Uint8 *dst = dst_pixels, *dst_temp;
+
+	(void)dst_width;
 	
 	int prevline, nextline;
 	
 	Uint16 E0, E1, E2, E3, B, D, E, F, H;
-	for (int y = 0; y < height; y++)
+	for (int y = first_row; y < first_row + row_count; y++)
 	{
 		src_temp = src;
 		dst_temp = dst;
@@ -257,11 +437,11 @@ void scale2x_16(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 		
 		for (int x = 0; x < width; x++)
 		{
-			B = rgb_palette[*(src + prevline)];
-			D = rgb_palette[*(x > 0 ? src - 1 : src)];
-			E = rgb_palette[*src];
-			F = rgb_palette[*(x < width - 1 ? src + 1 : src)];
-			H = rgb_palette[*(src + nextline)];
+			B = scaler_rgb_palette[*(src + prevline)];
+			D = scaler_rgb_palette[*(x > 0 ? src - 1 : src)];
+			E = scaler_rgb_palette[*src];
+			F = scaler_rgb_palette[*(x < width - 1 ? src + 1 : src)];
+			H = scaler_rgb_palette[*(src + nextline)];
 			
 			if (B != H && D != F)
 			{
@@ -287,30 +467,25 @@ void scale2x_16(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 		src = src_temp + src_pitch;
 		dst = dst_temp + 2 * dst_pitch;
 	}
-
-	SDL_UnlockTexture(dst_texture);
 }
 
-void scale3x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
+void scale3x_32(SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count)
 {
-	Uint8 *src = src_surface->pixels, *src_temp;
-	Uint8 *dst, *dst_temp;
-
 	int src_pitch = src_surface->pitch;
-	int dst_pitch;
 
 	const int dst_Bpp = 4,         // dst_surface->format->BytesPerPixel
 	          height = vga_height, // src_surface->h
 	          width = vga_width;   // src_surface->w
 
-	void* tmp_ptr;
-	SDL_LockTexture(dst_texture, NULL, &tmp_ptr, &dst_pitch);
-	dst = tmp_ptr;
+	Uint8 *src = (Uint8 *)src_surface->pixels + first_row * src_pitch, *src_temp;
+	Uint8 *dst = dst_pixels, *dst_temp;
+
+	(void)dst_width;
 	
 	int prevline, nextline;
 	
 	Uint32 E0, E1, E2, E3, E4, E5, E6, E7, E8, A, B, C, D, E, F, G, H, I;
-	for (int y = 0; y < height; y++)
+	for (int y = first_row; y < first_row + row_count; y++)
 	{
 		src_temp = src;
 		dst_temp = dst;
@@ -320,15 +495,15 @@ void scale3x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 		
 		for (int x = 0; x < width; x++)
 		{
-			A = rgb_palette[*(src + prevline - (x > 0 ? 1 : 0))];
-			B = rgb_palette[*(src + prevline)];
-			C = rgb_palette[*(src + prevline + (x < width - 1 ? 1 : 0))];
-			D = rgb_palette[*(src - (x > 0 ? 1 : 0))];
-			E = rgb_palette[*src];
-			F = rgb_palette[*(src + (x < width - 1 ? 1 : 0))];
-			G = rgb_palette[*(src + nextline - (x > 0 ? 1 : 0))];
-			H = rgb_palette[*(src + nextline)];
-			I = rgb_palette[*(src + nextline + (x < width - 1 ? 1 : 0))];
+			A = scaler_rgb_palette[*(src + prevline - (x > 0 ? 1 : 0))];
+			B = scaler_rgb_palette[*(src + prevline)];
+			C = scaler_rgb_palette[*(src + prevline + (x < width - 1 ? 1 : 0))];
+			D = scaler_rgb_palette[*(src - (x > 0 ? 1 : 0))];
+			E = scaler_rgb_palette[*src];
+			F = scaler_rgb_palette[*(src + (x < width - 1 ? 1 : 0))];
+			G = scaler_rgb_palette[*(src + nextline - (x > 0 ? 1 : 0))];
+			H = scaler_rgb_palette[*(src + nextline)];
+			I = scaler_rgb_palette[*(src + nextline + (x < width - 1 ? 1 : 0))];
 			
 			if (B != H && D != F)
 			{
@@ -364,30 +539,25 @@ void scale3x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 		src = src_temp + src_pitch;
 		dst = dst_temp + 3 * dst_pitch;
 	}
-
-	SDL_UnlockTexture(dst_texture);
 }
 
-void scale3x_16(SDL_Surface *src_surface, SDL_Texture *dst_texture)
+void scale3x_16(SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count)
 {
-	Uint8 *src = src_surface->pixels, *src_temp;
-	Uint8 *dst, *dst_temp;
-
 	int src_pitch = src_surface->pitch;
-	int dst_pitch;
 
 	const int dst_Bpp = 2,         // dst_surface->format->BytesPerPixel
 	          height = vga_height, // src_surface->h
 	          width = vga_width;   // src_surface->w
 
-	void* tmp_ptr;
-	SDL_LockTexture(dst_texture, NULL, &tmp_ptr, &dst_pitch);
-	dst = tmp_ptr;
+	Uint8 *src = (Uint8 *)src_surface->pixels + first_row * src_pitch, *src_temp;
+	Uint8 *dst = dst_pixels, *dst_temp;
+
+	(void)dst_width;
 	
 	int prevline, nextline;
 	
 	Uint16 E0, E1, E2, E3, E4, E5, E6, E7, E8, A, B, C, D, E, F, G, H, I;
-	for (int y = 0; y < height; y++)
+	for (int y = first_row; y < first_row + row_count; y++)
 	{
 		src_temp = src;
 		dst_temp = dst;
@@ -397,15 +567,15 @@ void scale3x_16(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 		
 		for (int x = 0; x < width; x++)
 		{
-			A = rgb_palette[*(src + prevline - (x > 0 ? 1 : 0))];
-			B = rgb_palette[*(src + prevline)];
-			C = rgb_palette[*(src + prevline + (x < width - 1 ? 1 : 0))];
-			D = rgb_palette[*(src - (x > 0 ? 1 : 0))];
-			E = rgb_palette[*src];
-			F = rgb_palette[*(src + (x < width - 1 ? 1 : 0))];
-			G = rgb_palette[*(src + nextline - (x > 0 ? 1 : 0))];
-			H = rgb_palette[*(src + nextline)];
-			I = rgb_palette[*(src + nextline + (x < width - 1 ? 1 : 0))];
+			A = scaler_rgb_palette[*(src + prevline - (x > 0 ? 1 : 0))];
+			B = scaler_rgb_palette[*(src + prevline)];
+			C = scaler_rgb_palette[*(src + prevline + (x < width - 1 ? 1 : 0))];
+			D = scaler_rgb_palette[*(src - (x > 0 ? 1 : 0))];
+			E = scaler_rgb_palette[*src];
+			F = scaler_rgb_palette[*(src + (x < width - 1 ? 1 : 0))];
+			G = scaler_rgb_palette[*(src + nextline - (x > 0 ? 1 : 0))];
+			H = scaler_rgb_palette[*(src + nextline)];
+			I = scaler_rgb_palette[*(src + nextline + (x < width - 1 ? 1 : 0))];
 			
 			if (B != H && D != F)
 			{
@@ -441,6 +611,4 @@ void scale3x_16(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 		src = src_temp + src_pitch;
 		dst = dst_temp + 3 * dst_pitch;
 	}
-
-	SDL_UnlockTexture(dst_texture);
 }
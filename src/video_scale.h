@@ -23,7 +23,10 @@
 
 #include "SDL.h"
 
-typedef void (*ScalerFunction)(SDL_Surface *src, SDL_Texture *dst);
+/** Scales source rows [first_row, first_row + row_count) into the destination pixels, which point
+ *  at the output of first_row.  Source rows just outside the band are read as neighbors but no
+ *  output outside the band is written, so disjoint bands can be scaled concurrently. */
+typedef void (*ScalerFunction)(SDL_Surface *src, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count);
 
 struct Scalers
 {
@@ -36,6 +39,17 @@ extern uint scaler;
 extern const struct Scalers scalers[];
 extern const uint scalers_count;
 
+extern int scaler_thread_count;
+
+// The palette the scalers expand with.  It is copied from rgb_palette and yuv_palette along with
+// the frame being scaled, so that the game can go on changing its palette while a frame is scaled.
+extern Uint32 scaler_rgb_palette[256], scaler_yuv_palette[256];
+
 void set_scaler_by_name(const char *name);
 
+void init_scaler_threads(void);
+void deinit_scaler_threads(void);
+void run_scaler(ScalerFunction scaler_function, SDL_Surface *src_surface, SDL_Texture *dst_texture, int first_row, int row_count);
+void run_scaler_to_pixels(ScalerFunction scaler_function, SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count);
+
 #endif /* VIDEO_SCALE_H */
@@ -21,9 +21,21 @@
  */
 #include "palette.h"
 #include "video.h"
+#include "video_scale.h"
 
+#include <assert.h>
 #include <stdlib.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HQ_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(HQ_USE_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HQ_USE_AVX2
+#include <immintrin.h>
+#endif
+
 void interp1(Uint32 *pc, Uint32 c1, Uint32 c2);
 void interp2(Uint32 *pc, Uint32 c1, Uint32 c2, Uint32 c3);
 void interp3(Uint32 *pc, Uint32 c1, Uint32 c2);
@@ -36,11 +48,12 @@ void interp9(Uint32 *pc, Uint32 c1, Uint32 c2, Uint32 c3);
 void interp10(Uint32 *pc, Uint32 c1, Uint32 c2, Uint32 c3);
 bool diff(unsigned int w1, unsigned int w2);
 
-void hq2x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture);
-void hq3x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture);
-void hq4x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture);
+void hq2x_32(SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count);
+void hq3x_32(SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count);
+void hq4x_32(SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count);
+
+void init_hq_scalers(void);
 
-static int   YUV1, YUV2;
 const  int   Ymask = 0x00FF0000;
 const  int   Umask = 0x0000FF00;
 const  int   Vmask = 0x000000FF;
@@ -121,13 +134,204 @@ inline void interp10(Uint32 *pc, Uint32 c1, Uint32 c2, Uint32 c3)
 
 inline bool diff(unsigned int w1, unsigned int w2)
 {
-	Uint32 YUV1 = yuv_palette[w1];
-	Uint32 YUV2 = yuv_palette[w2];
+	Uint32 YUV1 = scaler_yuv_palette[w1];
+	Uint32 YUV2 = scaler_yuv_palette[w2];
 	return ( ( abs((int)(YUV1 & Ymask) - (int)(YUV2 & Ymask)) > trY ) ||
 	         ( abs((int)(YUV1 & Umask) - (int)(YUV2 & Umask)) > trU ) ||
 	         ( abs((int)(YUV1 & Vmask) - (int)(YUV2 & Vmask)) > trV ) );
 }
 
+// The neighbor-difference pattern only depends on the YUV values of the 3x3 neighborhood, so it
+// is computed for a whole row at a time from edge-padded YUV rows.  Each neighbor is then just
+// an offset into one of the three rows, which lets the comparisons run in vector lanes.
+//
+//   yuv[0] = row above, yuv[1] = current row, yuv[2] = row below
+//   yuv[r][0] and yuv[r][width + 1] duplicate the edge pixels
+typedef void (*HqPatternFunction)(const Uint32 *const yuv[3], int width, Uint8 *patterns);
+
+static HqPatternFunction hq_row_patterns_function = NULL;
+
+static inline int diff_yuv(Uint32 yuv1, Uint32 yuv2)
+{
+	return ( ( abs((int)(yuv1 & Ymask) - (int)(yuv2 & Ymask)) > trY ) ||
+	         ( abs((int)(yuv1 & Umask) - (int)(yuv2 & Umask)) > trU ) ||
+	         ( abs((int)(yuv1 & Vmask) - (int)(yuv2 & Vmask)) > trV ) );
+}
+
+static void hq_patterns_range(const Uint32 *const yuv[3], int begin, int end, Uint8 *patterns)
+{
+	for (int i = begin; i < end; i++)
+	{
+		const Uint32 yuv5 = yuv[1][i + 1];
+
+		patterns[i] = (diff_yuv(yuv5, yuv[0][i    ]) << 0) |
+		              (diff_yuv(yuv5, yuv[0][i + 1]) << 1) |
+		              (diff_yuv(yuv5, yuv[0][i + 2]) << 2) |
+		              (diff_yuv(yuv5, yuv[1][i    ]) << 3) |
+		              (diff_yuv(yuv5, yuv[1][i + 2]) << 4) |
+		              (diff_yuv(yuv5, yuv[2][i    ]) << 5) |
+		              (diff_yuv(yuv5, yuv[2][i + 1]) << 6) |
+		              (diff_yuv(yuv5, yuv[2][i + 2]) << 7);
+	}
+}
+
+static void hq_row_patterns_scalar(const Uint32 *const yuv[3], int width, Uint8 *patterns)
+{
+	hq_patterns_range(yuv, 0, width, patterns);
+}
+
+#ifdef HQ_USE_SSE2
+static inline __m128i abs_diff_masked_sse2(__m128i yuv1, __m128i yuv2, __m128i mask)
+{
+	const __m128i d = _mm_sub_epi32(_mm_and_si128(yuv1, mask), _mm_and_si128(yuv2, mask));
+	const __m128i sign = _mm_srai_epi32(d, 31);
+	return _mm_sub_epi32(_mm_xor_si128(d, sign), sign);
+}
+
+static inline __m128i diff_yuv_sse2(__m128i yuv1, __m128i yuv2, int flag)
+{
+	const __m128i differs = _mm_or_si128(_mm_or_si128(
+		_mm_cmpgt_epi32(abs_diff_masked_sse2(yuv1, yuv2, _mm_set1_epi32(Ymask)), _mm_set1_epi32(trY)),
+		_mm_cmpgt_epi32(abs_diff_masked_sse2(yuv1, yuv2, _mm_set1_epi32(Umask)), _mm_set1_epi32(trU))),
+		_mm_cmpgt_epi32(abs_diff_masked_sse2(yuv1, yuv2, _mm_set1_epi32(Vmask)), _mm_set1_epi32(trV)));
+
+	return _mm_and_si128(differs, _mm_set1_epi32(flag));
+}
+
+static inline __m128i hq_patterns_sse2(const Uint32 *const yuv[3], int i)
+{
+	#define LOAD(row, x) _mm_loadu_si128((const __m128i *)&yuv[row][x])
+
+	const __m128i yuv5 = LOAD(1, i + 1);
+
+	__m128i pattern = diff_yuv_sse2(yuv5, LOAD(0, i    ), 1 << 0);
+	pattern = _mm_or_si128(pattern, diff_yuv_sse2(yuv5, LOAD(0, i + 1), 1 << 1));
+	pattern = _mm_or_si128(pattern, diff_yuv_sse2(yuv5, LOAD(0, i + 2), 1 << 2));
+	pattern = _mm_or_si128(pattern, diff_yuv_sse2(yuv5, LOAD(1, i    ), 1 << 3));
+	pattern = _mm_or_si128(pattern, diff_yuv_sse2(yuv5, LOAD(1, i + 2), 1 << 4));
+	pattern = _mm_or_si128(pattern, diff_yuv_sse2(yuv5, LOAD(2, i    ), 1 << 5));
+	pattern = _mm_or_si128(pattern, diff_yuv_sse2(yuv5, LOAD(2, i + 1), 1 << 6));
+	pattern = _mm_or_si128(pattern, diff_yuv_sse2(yuv5, LOAD(2, i + 2), 1 << 7));
+
+	#undef LOAD
+
+	return pattern;
+}
+
+static void hq_row_patterns_sse2(const Uint32 *const yuv[3], int width, Uint8 *patterns)
+{
+	int i = 0;
+
+	for (; i + 8 <= width; i += 8)
+	{
+		const __m128i lo = hq_patterns_sse2(yuv, i),
+		              hi = hq_patterns_sse2(yuv, i + 4);
+
+		// patterns fit in 8 bits, so packing never saturates
+		const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(lo, hi), _mm_setzero_si128());
+		_mm_storel_epi64((__m128i *)&patterns[i], packed);
+	}
+
+	hq_patterns_range(yuv, i, width, patterns);
+}
+#endif /* HQ_USE_SSE2 */
+
+#ifdef HQ_USE_AVX2
+#define HQ_TARGET_AVX2 __attribute__((target("avx2")))
+
+static inline HQ_TARGET_AVX2 __m256i abs_diff_masked_avx2(__m256i yuv1, __m256i yuv2, __m256i mask)
+{
+	const __m256i d = _mm256_sub_epi32(_mm256_and_si256(yuv1, mask), _mm256_and_si256(yuv2, mask));
+	return _mm256_abs_epi32(d);
+}
+
+static inline HQ_TARGET_AVX2 __m256i diff_yuv_avx2(__m256i yuv1, __m256i yuv2, int flag)
+{
+	const __m256i differs = _mm256_or_si256(_mm256_or_si256(
+		_mm256_cmpgt_epi32(abs_diff_masked_avx2(yuv1, yuv2, _mm256_set1_epi32(Ymask)), _mm256_set1_epi32(trY)),
+		_mm256_cmpgt_epi32(abs_diff_masked_avx2(yuv1, yuv2, _mm256_set1_epi32(Umask)), _mm256_set1_epi32(trU))),
+		_mm256_cmpgt_epi32(abs_diff_masked_avx2(yuv1, yuv2, _mm256_set1_epi32(Vmask)), _mm256_set1_epi32(trV)));
+
+	return _mm256_and_si256(differs, _mm256_set1_epi32(flag));
+}
+
+static inline HQ_TARGET_AVX2 __m256i hq_patterns_avx2(const Uint32 *const yuv[3], int i)
+{
+	#define LOAD(row, x) _mm256_loadu_si256((const __m256i *)&yuv[row][x])
+
+	const __m256i yuv5 = LOAD(1, i + 1);
+
+	__m256i pattern = diff_yuv_avx2(yuv5, LOAD(0, i    ), 1 << 0);
+	pattern = _mm256_or_si256(pattern, diff_yuv_avx2(yuv5, LOAD(0, i + 1), 1 << 1));
+	pattern = _mm256_or_si256(pattern, diff_yuv_avx2(yuv5, LOAD(0, i + 2), 1 << 2));
+	pattern = _mm256_or_si256(pattern, diff_yuv_avx2(yuv5, LOAD(1, i    ), 1 << 3));
+	pattern = _mm256_or_si256(pattern, diff_yuv_avx2(yuv5, LOAD(1, i + 2), 1 << 4));
+	pattern = _mm256_or_si256(pattern, diff_yuv_avx2(yuv5, LOAD(2, i    ), 1 << 5));
+	pattern = _mm256_or_si256(pattern, diff_yuv_avx2(yuv5, LOAD(2, i + 1), 1 << 6));
+	pattern = _mm256_or_si256(pattern, diff_yuv_avx2(yuv5, LOAD(2, i + 2), 1 << 7));
+
+	#undef LOAD
+
+	return pattern;
+}
+
+static HQ_TARGET_AVX2 void hq_row_patterns_avx2(const Uint32 *const yuv[3], int width, Uint8 *patterns)
+{
+	int i = 0;
+
+	for (; i + 16 <= width; i += 16)
+	{
+		const __m256i lo = hq_patterns_avx2(yuv, i),
+		              hi = hq_patterns_avx2(yuv, i + 8);
+
+		// AVX2 packs within 128-bit lanes, so the words end up interleaved; undo that with a
+		// cross-lane permute before storing.
+		const __m256i packed16 = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xd8);
+		const __m128i packed8 = _mm_packus_epi16(_mm256_castsi256_si128(packed16), _mm256_extracti128_si256(packed16, 1));
+		_mm_storeu_si128((__m128i *)&patterns[i], packed8);
+	}
+
+	hq_patterns_range(yuv, i, width, patterns);
+}
+#endif /* HQ_USE_AVX2 */
+
+/** Picks the fastest pattern kernel the CPU supports.  Must be called before any hqNx scaler runs. */
+void init_hq_scalers(void)
+{
+	hq_row_patterns_function = hq_row_patterns_scalar;
+
+#ifdef HQ_USE_SSE2
+	if (SDL_HasSSE2())
+		hq_row_patterns_function = hq_row_patterns_sse2;
+#endif
+#ifdef HQ_USE_AVX2
+	if (SDL_HasAVX2())
+		hq_row_patterns_function = hq_row_patterns_avx2;
+#endif
+}
+
+/** Computes the neighbor-difference pattern of every pixel in a source row. */
+static void hq_row_patterns(const Uint8 *src, int prevline, int nextline, int width, Uint8 *patterns)
+{
+	assert(width <= vga_width);
+	assert(hq_row_patterns_function != NULL);
+
+	Uint32 yuv_rows[3][vga_width + 2];
+	const Uint8 *const rows[3] = { src + prevline, src, src + nextline };
+
+	for (int r = 0; r < 3; r++)
+	{
+		for (int x = 0; x < width; x++)
+			yuv_rows[r][x + 1] = scaler_yuv_palette[rows[r][x]];
+
+		yuv_rows[r][0] = yuv_rows[r][1];
+		yuv_rows[r][width + 1] = yuv_rows[r][width];
+	}
+
+	const Uint32 *const yuv[3] = { yuv_rows[0], yuv_rows[1], yuv_rows[2] };
+	hq_row_patterns_function(yuv, width, patterns);
+}
+
 #define PIXEL00_0     *(Uint32 *)dst = c[5];
 #define PIXEL00_10    interp1((Uint32 *)dst, c[5], c[1]);
 #define PIXEL00_11    interp1((Uint32 *)dst, c[5], c[4]);
@@ -177,26 +381,24 @@ inline bool diff(unsigned int w1, unsigned int w2)
 #define PIXEL11_90    interp9((Uint32 *)(dst + dst_pitch + dst_Bpp), c[5], c[6], c[8]);
 #define PIXEL11_100   interp10((Uint32 *)(dst + dst_pitch + dst_Bpp), c[5], c[6], c[8]);
 
-void hq2x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
+void hq2x_32(SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count)
 {
-	Uint8 *src = src_surface->pixels, *src_temp;
-	Uint8 *dst, *dst_temp;
-
 	int src_pitch = src_surface->pitch;
-	int dst_pitch;
 
 	const int dst_Bpp = 4,         // dst_surface->format->BytesPerPixel
 	          height = vga_height, // src_surface->h
 	          width = vga_width;   // src_surface->w
 
-	void* tmp_ptr;
-	SDL_LockTexture(dst_texture, NULL, &tmp_ptr, &dst_pitch);
-	dst = tmp_ptr;
+	Uint8 *src = (Uint8 *)src_surface->pixels + first_row * src_pitch, *src_temp;
+	Uint8 *dst = dst_pixels, *dst_temp;
+
+	(void)dst_width;
 
 	int prevline, nextline;
 	
 	Uint32 w[10];
 	Uint32 c[10];
+	Uint8 patterns[vga_width];
 	
 	//   +----+----+----+
 	//   |    |    |    |
@@ -209,7 +411,7 @@ void hq2x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 	//   | w7 | w8 | w9 |
 	//   +----+----+----+
 	
-	for (int j = 0; j < height; j++)
+	for (int j = first_row; j < first_row + row_count; j++)
 	{
 		src_temp = src;
 		dst_temp = dst;
@@ -217,6 +419,8 @@ void hq2x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 		prevline = (j > 0) ? -width : 0;
 		nextline = (j < height - 1) ? width : 0;
 		
+		hq_row_patterns(src, prevline, nextline, width, patterns);
+		
 		for (int i = 0; i < width; i++)
 		{
 			w[2] = *(src + prevline);
@@ -249,29 +453,10 @@ void hq2x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 				w[9] = w[8];
 			}
 			
-			int pattern = 0;
-			int flag = 1;
-			
-			YUV1 = yuv_palette[w[5]];
+			const int pattern = patterns[i];
 			
 			for (int k=1; k<=9; k++)
-			{
-				if (k==5)
-					continue;
-				
-				if (w[k] != w[5])
-				{
-					YUV2 = yuv_palette[w[k]];
-					if ( ( abs((YUV1 & Ymask) - (YUV2 & Ymask)) > trY ) ||
-					     ( abs((YUV1 & Umask) - (YUV2 & Umask)) > trU ) ||
-					     ( abs((YUV1 & Vmask) - (YUV2 & Vmask)) > trV ) )
-					pattern |= flag;
-				}
-				flag <<= 1;
-			}
-			
-			for (int k=1; k<=9; k++)
-				c[k] = rgb_palette[w[k]] & 0xfcfcfcfc; // hq2x has a nasty inability to accept more than 6 bits for each component
+				c[k] = scaler_rgb_palette[w[k]] & 0xfcfcfcfc; // hq2x has a nasty inability to accept more than 6 bits for each component
 			
 			switch (pattern)
 			{
@@ -2923,8 +3108,6 @@ void hq2x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 		src = src_temp + src_pitch;
 		dst = dst_temp + 2 * dst_pitch;
 	}
-
-	SDL_UnlockTexture(dst_texture);
 }
 
 #define PIXEL00_1M  interp1((Uint32 *)dst, c[5], c[1]);
@@ -2981,26 +3164,24 @@ void hq2x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 #define PIXEL22_5   interp5((Uint32 *)(dst + 2 * dst_pitch + 2 * dst_Bpp), c[6], c[8]);
 #define PIXEL22_C   *(Uint32 *)(dst + 2 * dst_pitch + 2 * dst_Bpp) = c[5];
 
-void hq3x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
+void hq3x_32(SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count)
 {
-	Uint8 *src = src_surface->pixels, *src_temp;
-	Uint8 *dst, *dst_temp;
-
 	int src_pitch = src_surface->pitch;
-	int dst_pitch;
 
 	const int dst_Bpp = 4,         // dst_surface->format->BytesPerPixel
 	          height = vga_height, // src_surface->h
 	          width = vga_width;   // src_surface->w
 
-	void* tmp_ptr;
-	SDL_LockTexture(dst_texture, NULL, &tmp_ptr, &dst_pitch);
-	dst = tmp_ptr;
+	Uint8 *src = (Uint8 *)src_surface->pixels + first_row * src_pitch, *src_temp;
+	Uint8 *dst = dst_pixels, *dst_temp;
+
+	(void)dst_width;
 	
 	int prevline, nextline;
 	
 	Uint32 w[10];
 	Uint32 c[10];
+	Uint8 patterns[vga_width];
 	
 	//   +----+----+----+
 	//   |    |    |    |
@@ -3013,7 +3194,7 @@ void hq3x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 	//   | w7 | w8 | w9 |
 	//   +----+----+----+
 	
-	for (int j = 0; j < height; j++)
+	for (int j = first_row; j < first_row + row_count; j++)
 	{
 		src_temp = src;
 		dst_temp = dst;
@@ -3021,6 +3202,8 @@ void hq3x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 		prevline = (j > 0) ? -width : 0;
 		nextline = (j < height - 1) ? width : 0;
 		
+		hq_row_patterns(src, prevline, nextline, width, patterns);
+		
 		for (int i = 0; i < width; i++)
 		{
 			w[2] = *(src + prevline);
@@ -3053,29 +3236,10 @@ void hq3x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 				w[9] = w[8];
 			}
 			
-			int pattern = 0;
-			int flag = 1;
-			
-			YUV1 = yuv_palette[w[5]];
+			const int pattern = patterns[i];
 			
 			for (int k=1; k<=9; k++)
-			{
-				if (k==5)
-					continue;
-				
-				if (w[k] != w[5])
-				{
-					YUV2 = yuv_palette[w[k]];
-					if ( ( abs((YUV1 & Ymask) - (YUV2 & Ymask)) > trY ) ||
-					     ( abs((YUV1 & Umask) - (YUV2 & Umask)) > trU ) ||
-					     ( abs((YUV1 & Vmask) - (YUV2 & Vmask)) > trV ) )
-					pattern |= flag;
-				}
-				flag <<= 1;
-			}
-			
-			for (int k=1; k<=9; k++)
-				c[k] = rgb_palette[w[k]] & 0xfcfcfcfc; // hq3x has a nasty inability to accept more than 6 bits for each component
+				c[k] = scaler_rgb_palette[w[k]] & 0xfcfcfcfc; // hq3x has a nasty inability to accept more than 6 bits for each component
 			
 			switch (pattern)
 			{
@@ -6700,8 +6864,6 @@ void hq3x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 		src = src_temp + src_pitch;
 		dst = dst_temp + 3 * dst_pitch;
 	}
-
-	SDL_UnlockTexture(dst_texture);
 }
 
 #define PIXEL4_00_0     *(Uint32 *)(dst) = c[5];
@@ -6845,26 +7007,24 @@ void hq3x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 #define PIXEL4_33_81    interp8((Uint32 *)(dst + 3 * dst_pitch + 3 * dst_Bpp), c[5], c[6]);
 #define PIXEL4_33_82    interp8((Uint32 *)(dst + 3 * dst_pitch + 3 * dst_Bpp), c[5], c[8]);
 
-void hq4x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
+void hq4x_32(SDL_Surface *src_surface, void *dst_pixels, int dst_pitch, int dst_width, int first_row, int row_count)
 {
-	Uint8 *src = src_surface->pixels, *src_temp;
-	Uint8 *dst, *dst_temp;
-
 	int src_pitch = src_surface->pitch;
-	int dst_pitch;
 
 	const int dst_Bpp = 4,         // dst_surface->format->BytesPerPixel
 	          height = vga_height, // src_surface->h
 	          width = vga_width;   // src_surface->w
 
-	void* tmp_ptr;
-	SDL_LockTexture(dst_texture, NULL, &tmp_ptr, &dst_pitch);
-	dst = tmp_ptr;
+	Uint8 *src = (Uint8 *)src_surface->pixels + first_row * src_pitch, *src_temp;
+	Uint8 *dst = dst_pixels, *dst_temp;
+
+	(void)dst_width;
 	
 	int prevline, nextline;
 	
 	Uint32 w[10];
 	Uint32 c[10];
+	Uint8 patterns[vga_width];
 	
 	//   +----+----+----+
 	//   |    |    |    |
@@ -6877,7 +7037,7 @@ void hq4x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 	//   | w7 | w8 | w9 |
 	//   +----+----+----+
 	
-	for (int j = 0; j < height; j++)
+	for (int j = first_row; j < first_row + row_count; j++)
 	{
 		src_temp = src;
 		dst_temp = dst;
@@ -6885,6 +7045,8 @@ void hq4x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 		prevline = (j > 0) ? -width : 0;
 		nextline = (j < height - 1) ? width : 0;
 		
+		hq_row_patterns(src, prevline, nextline, width, patterns);
+		
 		for (int i = 0; i < width; i++)
 		{
 			w[2] = *(src + prevline);
@@ -6917,29 +7079,10 @@ void hq4x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 				w[9] = w[8];
 			}
 			
-			int pattern = 0;
-			int flag = 1;
-			
-			YUV1 = yuv_palette[w[5]];
-			
-			for (int k=1; k<=9; k++)
-			{
-				if (k==5)
-					continue;
-				
-				if (w[k] != w[5])
-				{
-					YUV2 = yuv_palette[w[k]];
-					if ( ( abs((YUV1 & Ymask) - (YUV2 & Ymask)) > trY ) ||
-					     ( abs((YUV1 & Umask) - (YUV2 & Umask)) > trU ) ||
-					     ( abs((YUV1 & Vmask) - (YUV2 & Vmask)) > trV ) )
-					pattern |= flag;
-				}
-				flag <<= 1;
-			}
+			const int pattern = patterns[i];
 			
 			for (int k=1; k<=9; k++)
-				c[k] = rgb_palette[w[k]] & 0xfcfcfcfc; // hq4x has a nasty inability to accept more than 6 bits for each component
+				c[k] = scaler_rgb_palette[w[k]] & 0xfcfcfcfc; // hq4x has a nasty inability to accept more than 6 bits for each component
 			
 			switch (pattern)
 			{
@@ -11923,6 +12066,4 @@ void hq4x_32(SDL_Surface *src_surface, SDL_Texture *dst_texture)
 		src = src_temp + src_pitch;
 		dst = dst_temp + 4 * dst_pitch;
 	}
-
-	SDL_UnlockTexture(dst_texture);
 }
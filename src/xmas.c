@@ -22,6 +22,7 @@
 #include "joystick.h"
 #include "keyboard.h"
 #include "mouse.h"
+#include "nortsong.h"
 #include "palette.h"
 #include "sprite.h"
 #include "vga256d.h"
@@ -149,7 +150,7 @@ bool xmas_prompt(void)
 			JE_showVGA();
 			JE_mouseReplace();
 
-			SDL_Delay(16);
+			sleep_ticks(16);
 
 			Uint16 oldMouseX = mouse_x;
 			Uint16 oldMouseY = mouse_y;